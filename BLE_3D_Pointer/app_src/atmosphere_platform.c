@@ -4,11 +4,50 @@
 #include "../gpio/gpio_onsemi.h"
 #include "../i2c/i2c_onsemi.h"
 #include "../block/block_onsemi.h"
+#include "../block/block_onsemi_flash.h"
 #include "../filesystem/filesystem_crastfs.h"
+#include "../ble/ble_stream.h"
+#include "../ble/ble_broadcast.h"
+#include "../sensorlog/sensorlog.h"
+#include "../bhi160/bhi160.h"
 
 void ATMO_BtnCb( void *data )
 {
 	ATMO_PLATFORM_DebugPrint( "BUTTON PRESSED\r\n" );
+	ATMO_ONSEMI_BLE_AdvertisingBoost();
+}
+
+// Orientation history in 16 x 2 kB sectors of main flash at 0x156000, below the
+// block journal (sections.ld keeps both out of FLASH), read back over the
+// streaming service. Off unless ATMO_SENSORLOG_ENABLE is defined, since it
+// keeps erasing flash for as long as the device runs.
+//
+// At about 5.5 bytes per sample a sector holds roughly 370 samples, so one
+// sample every ATMO_SENSORLOG_INTERVAL_MS erases a sector every
+// 370 x ATMO_SENSORLOG_INTERVAL_MS and each sector once per 16 of those. At the
+// default of 10 s that is a sector erase per hour and about 530 erases of each
+// sector per year, 1 s is ten times that. Check the result against the erase
+// endurance of the flash before lowering the interval. The erase runs in the
+// sensor callback that fills a sector and stalls it for the duration.
+#ifndef ATMO_SENSORLOG_INTERVAL_MS
+#define ATMO_SENSORLOG_INTERVAL_MS (10000)
+#endif
+
+#if ATMO_SENSORLOG_INTERVAL_MS > 0xFFFF
+#error "ATMO_SENSORLOG_INTERVAL_MS must fit in the sensor log's 16 bit minIntervalMs"
+#endif
+
+static void ATMO_StreamRateCb( uint8_t sensorId, uint16_t rateHz )
+{
+	// Other consumers still need the sensor once the stream stops
+	BHI160_SetSampleRate( ( BHI160_Sensor_t )sensorId, ( rateHz != 0 ) ? rateHz : BHI160_DEFAULT_SAMPLE_RATE );
+}
+
+static void ATMO_SensorSampleCb( uint8_t sensor, int16_t x, int16_t y, int16_t z )
+{
+	ATMO_BLE_STREAM_PushSample( sensor, x, y, z );
+	ATMO_BLE_BROADCAST_PushSample( sensor, x, y, z );
+	ATMO_SENSORLOG_PushSample( sensor, x, y, z );
 }
 
 void ATMO_PLATFORM_Init()
@@ -20,15 +59,48 @@ void ATMO_PLATFORM_Init()
 	ATMO_ONSEMI_BLE_AddDriverInstance( &handle );
 	ATMO_BLE_PeripheralInit( handle );
 
+	ATMO_BLE_STREAM_Config_t streamConfig;
+	streamConfig.bleInstance = handle;
+	streamConfig.rateHandler = ATMO_StreamRateCb;
+	streamConfig.defaultRateHz = 50;
+	ATMO_BLE_STREAM_Init( &streamConfig );
+
+	ATMO_BLE_BROADCAST_Config_t broadcastConfig;
+	broadcastConfig.bleInstance = handle;
+	broadcastConfig.companyId = 0xFFFF;
+	broadcastConfig.refreshIntervalMs = ATMO_BLE_BROADCAST_DEFAULT_REFRESH_MS;
+	broadcastConfig.orientationSensorId = BHI160_Sensor_Orientation;
+	broadcastConfig.motionSensorId = BHI160_Sensor_Acceleration;
+	broadcastConfig.motionThreshold = 800;
+	ATMO_BLE_BROADCAST_Init( &broadcastConfig );
+
+	BHI160_RegisterRawDataCallback( ATMO_SensorSampleCb );
+
 	ATMO_ONSEMI_I2C_AddDriverInstance( &handle );
 	ATMO_I2C_Init( 0 );
 
 	ATMO_ONSEMI_GPIO_AddDriverInstance( &handle );
 	ATMO_GPIO_Init( 0 );
+	ATMO_GPIO_RegisterInterruptCallback( 0, PIN_BUTTON0, ATMO_GPIO_InterruptTrigger_FallingEdge, ATMO_BtnCb );
 
 	ATMO_ONSEMI_BLOCK_AddDriverInstance( &handle );
 	ATMO_BLOCK_Init( 0 );
 
+#ifdef ATMO_SENSORLOG_ENABLE
+	ATMO_BLOCK_DeviceInfo_t logDevice;
+	ATMO_ONSEMI_FLASH_BLOCK_AddDriverInstance( &handle );
+	ATMO_BLOCK_Init( handle );
+	ATMO_BLOCK_GetDeviceInfo( handle, &logDevice );
+
+	ATMO_SENSORLOG_Config_t logConfig;
+	logConfig.blockInstance = handle;
+	logConfig.firstBlock = 0;
+	logConfig.numBlocks = logDevice.blockCount;
+	logConfig.sensorId = BHI160_Sensor_Orientation;
+	logConfig.minIntervalMs = ATMO_SENSORLOG_INTERVAL_MS;
+	ATMO_SENSORLOG_Init( &logConfig );
+#endif
+
 	ATMO_CRASTFS_FILESYSTEM_AddDriverInstance( &handle );
 	ATMO_FILESYSTEM_Init( 0, 0 );
 
@@ -48,6 +120,10 @@ void ATMO_PLATFORM_Init()
 void ATMO_PLATFORM_PostInit()
 {
 	ATMO_CLOUD_Init( 0, true );
+
+#ifdef ATMO_BLE_BROADCAST_ENABLE
+	ATMO_BLE_BROADCAST_SetEnabled( true );
+#endif
 }
 
 void ATMO_PLATFORM_DelayMilliseconds( uint32_t milliseconds )
@@ -82,7 +158,7 @@ void ATMO_Unlock()
 
 uint64_t ATMO_PLATFORM_UptimeMs()
 {
-	return 0;
+	return HAL_Time();
 }
 
 uint32_t ATMO_PLATFORM_GetBattLevel()
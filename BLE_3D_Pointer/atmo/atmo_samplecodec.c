@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ * @file    atmo_samplecodec.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Delta coding of 3-axis sensor samples
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "atmo_samplecodec.h"
+
+static uint32_t _ATMO_SAMPLECODEC_ZigZag( int32_t value )
+{
+	return ( ( uint32_t )value << 1 ) ^ ( uint32_t )( value >> 31 );
+}
+
+static int32_t _ATMO_SAMPLECODEC_UnZigZag( uint32_t value )
+{
+	return ( int32_t )( value >> 1 ) ^ -( int32_t )( value & 1 );
+}
+
+void ATMO_SAMPLECODEC_Reset( ATMO_SAMPLECODEC_State_t *state, uint32_t baseTimeMs )
+{
+	state->prev.timeMs = baseTimeMs;
+	state->prev.x = 0;
+	state->prev.y = 0;
+	state->prev.z = 0;
+}
+
+unsigned int ATMO_SAMPLECODEC_Encode( ATMO_SAMPLECODEC_State_t *state, const ATMO_SAMPLECODEC_Sample_t *sample, uint8_t *buf, unsigned int bufSize )
+{
+	uint32_t fields[4];
+	unsigned int len = 0;
+	unsigned int i;
+
+	fields[0] = sample->timeMs - state->prev.timeMs;
+	fields[1] = _ATMO_SAMPLECODEC_ZigZag( ( int32_t )sample->x - state->prev.x );
+	fields[2] = _ATMO_SAMPLECODEC_ZigZag( ( int32_t )sample->y - state->prev.y );
+	fields[3] = _ATMO_SAMPLECODEC_ZigZag( ( int32_t )sample->z - state->prev.z );
+
+	// Only measure first when the longest encoding might not fit
+	if ( bufSize < ATMO_SAMPLECODEC_MAX_SAMPLE_LEN )
+	{
+		for ( i = 0; i < 4; i++ )
+		{
+			len += ATMO_VALUECODEC_EncodeVarint( fields[i], NULL );
+		}
+
+		if ( len > bufSize )
+		{
+			return 0;
+		}
+
+		len = 0;
+	}
+
+	for ( i = 0; i < 4; i++ )
+	{
+		len += ATMO_VALUECODEC_EncodeVarint( fields[i], &buf[len] );
+	}
+
+	state->prev = *sample;
+	return len;
+}
+
+unsigned int ATMO_SAMPLECODEC_Decode( ATMO_SAMPLECODEC_State_t *state, const uint8_t *buf, unsigned int bufLen, ATMO_SAMPLECODEC_Sample_t *sample )
+{
+	uint32_t fields[4];
+	unsigned int len = 0;
+	unsigned int i;
+
+	for ( i = 0; i < 4; i++ )
+	{
+		unsigned int fieldLen = ATMO_VALUECODEC_DecodeVarint( &buf[len], bufLen - len, &fields[i] );
+
+		// Axis differences are 17 bits once zigzag coded
+		if ( fieldLen == 0 || ( i > 0 && fields[i] > 0x1FFFF ) )
+		{
+			return 0;
+		}
+
+		len += fieldLen;
+	}
+
+	sample->timeMs = state->prev.timeMs + fields[0];
+	sample->x = ( int16_t )( state->prev.x + _ATMO_SAMPLECODEC_UnZigZag( fields[1] ) );
+	sample->y = ( int16_t )( state->prev.y + _ATMO_SAMPLECODEC_UnZigZag( fields[2] ) );
+	sample->z = ( int16_t )( state->prev.z + _ATMO_SAMPLECODEC_UnZigZag( fields[3] ) );
+
+	state->prev = *sample;
+	return len;
+}
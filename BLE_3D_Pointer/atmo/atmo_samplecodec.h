@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * @file    atmo_samplecodec.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Delta coding of 3-axis sensor samples
+ *
+ * Streaming codec for timestamped samples of three signed 16-bit axes, as
+ * delivered by the BHI160. Every sample is coded against the previous one as
+ *
+ * < Time Delta ms (varint) >< dx >< dy >< dz (zigzag varint each) >
+ *
+ * with the varints of atmo_valuecodec.h. A block of samples starts from the
+ * reference set by ATMO_SAMPLECODEC_Reset (all axes 0 at a base time), so
+ * every block decodes on its own and readers can start at any block. Axes
+ * that change by less than 64 between samples take one byte, a slowly moving
+ * sensor about 4 bytes per sample against 10 bytes as raw values and 16 bytes
+ * as a timestamp plus an ATMO_3dFloatVector_t.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_SAMPLECODEC__H
+#define __ATMO_SAMPLECODEC__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "core.h"
+#include "atmo_valuecodec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+// A zigzag coded 16 bit difference takes up to 3 varint bytes
+#define ATMO_SAMPLECODEC_MAX_SAMPLE_LEN ( ATMO_VALUECODEC_MAX_VARINT_LEN + ( 3 * 3 ) )
+#define ATMO_SAMPLECODEC_MIN_SAMPLE_LEN (4)
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+typedef struct
+{
+	uint32_t timeMs;
+	int16_t x;
+	int16_t y;
+	int16_t z;
+} ATMO_SAMPLECODEC_Sample_t;
+
+/**
+ * Encoder or decoder state, the last sample of the current block.
+ */
+typedef struct
+{
+	ATMO_SAMPLECODEC_Sample_t prev;
+} ATMO_SAMPLECODEC_State_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Start a new block. Encoder and decoder must reset with the same base time.
+ *
+ * @param[out] state
+ * @param[in] baseTimeMs - Time the first sample is coded against, for instance a timestamp already in a frame header
+ */
+void ATMO_SAMPLECODEC_Reset( ATMO_SAMPLECODEC_State_t *state, uint32_t baseTimeMs );
+
+/**
+ * Encode a sample. Time is coded modulo 2^32, samples going back in time still
+ * decode correctly but take the longest encoding.
+ *
+ * @param[in,out] state
+ * @param[in] sample
+ * @param[out] buf
+ * @param[in] bufSize
+ * @return number of bytes, 0 if the sample doesn't fit (the state is left unchanged)
+ */
+unsigned int ATMO_SAMPLECODEC_Encode( ATMO_SAMPLECODEC_State_t *state, const ATMO_SAMPLECODEC_Sample_t *sample, uint8_t *buf, unsigned int bufSize );
+
+/**
+ * Decode a sample.
+ *
+ * @param[in,out] state
+ * @param[in] buf
+ * @param[in] bufLen
+ * @param[out] sample
+ * @return number of bytes consumed, 0 if the sample is truncated or malformed
+ */
+unsigned int ATMO_SAMPLECODEC_Decode( ATMO_SAMPLECODEC_State_t *state, const uint8_t *buf, unsigned int bufLen, ATMO_SAMPLECODEC_Sample_t *sample );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_SAMPLECODEC__H */
@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ * @file    atmo_samplecodec_bench.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Sample codec benchmark
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "atmo_samplecodec_bench.h"
+#include "../app_src/atmosphere_platform.h"
+
+static uint32_t _ATMO_SAMPLECODEC_BENCH_UptimeMs( void )
+{
+	return ( uint32_t )ATMO_PLATFORM_UptimeMs();
+}
+
+ATMO_Status_t ATMO_SAMPLECODEC_BENCH_Run( const ATMO_SAMPLECODEC_BENCH_Config_t *config, ATMO_SAMPLECODEC_BENCH_Results_t *results )
+{
+	if ( config == NULL || results == NULL || config->samples == NULL || config->buf == NULL ||
+	        config->blockSize < ATMO_SAMPLECODEC_MAX_SAMPLE_LEN )
+	{
+		return ATMO_Status_InvalidInput;
+	}
+
+	ATMO_SAMPLECODEC_BENCH_Counter_t counter = ( config->counter != NULL ) ? config->counter : _ATMO_SAMPLECODEC_BENCH_UptimeMs;
+	uint32_t next = 0;
+
+	memset( results, 0, sizeof( *results ) );
+	results->rawBytes = config->numSamples * ATMO_SAMPLECODEC_BENCH_RAW_SAMPLE_LEN;
+	results->floatBytes = config->numSamples * ATMO_SAMPLECODEC_BENCH_FLOAT_SAMPLE_LEN;
+	results->match = true;
+
+	while ( next < config->numSamples )
+	{
+		ATMO_SAMPLECODEC_State_t state;
+		uint32_t first = next;
+		uint32_t blockLen = 0;
+		unsigned int len;
+
+		// Blocks start at the time of their first sample, like a frame with its timestamp in the header
+		uint32_t start = counter();
+		ATMO_SAMPLECODEC_Reset( &state, config->samples[first].timeMs );
+
+		while ( next < config->numSamples &&
+		        ( len = ATMO_SAMPLECODEC_Encode( &state, &config->samples[next], &config->buf[blockLen], config->blockSize - blockLen ) ) > 0 )
+		{
+			blockLen += len;
+			next++;
+		}
+
+		results->encodeTicks += counter() - start;
+
+		// Timed on its own, then decoded again to check the result
+		ATMO_SAMPLECODEC_Sample_t sample;
+		uint32_t pos = 0;
+		uint32_t i;
+
+		start = counter();
+		ATMO_SAMPLECODEC_Reset( &state, config->samples[first].timeMs );
+
+		for ( i = first; i < next; i++ )
+		{
+			pos += ATMO_SAMPLECODEC_Decode( &state, &config->buf[pos], blockLen - pos, &sample );
+		}
+
+		results->decodeTicks += counter() - start;
+
+		ATMO_SAMPLECODEC_Reset( &state, config->samples[first].timeMs );
+		pos = 0;
+
+		for ( i = first; i < next; i++ )
+		{
+			const ATMO_SAMPLECODEC_Sample_t *expected = &config->samples[i];
+
+			len = ATMO_SAMPLECODEC_Decode( &state, &config->buf[pos], blockLen - pos, &sample );
+			pos += len;
+
+			if ( len == 0 || sample.timeMs != expected->timeMs || sample.x != expected->x || sample.y != expected->y || sample.z != expected->z )
+			{
+				results->match = false;
+			}
+		}
+
+		results->numBlocks++;
+		results->encodedBytes += blockLen;
+		results->blockBytes += config->blockSize;
+	}
+
+	return ATMO_Status_Success;
+}
@@ -0,0 +1,109 @@
+/**
+ ******************************************************************************
+ * @file    atmo_samplecodec_bench.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Sample codec benchmark header file
+ *
+ * Runs a recorded trace through the sample codec the way the sensor log and
+ * the streaming service use it: the trace is cut into blocks of at most
+ * blockSize bytes, each starting from a reset. Reports the encoded size
+ * against the raw and float representations, and the encode and decode time
+ * in units of a caller supplied counter (a cycle counter on the target, a
+ * time stamp counter on a host) so cycles per sample are ticks / numSamples.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_SAMPLECODEC_BENCH__H
+#define __ATMO_SAMPLECODEC_BENCH__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "atmo_samplecodec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+// Timestamp and three int16 values
+#define ATMO_SAMPLECODEC_BENCH_RAW_SAMPLE_LEN ( 4 + ( 3 * 2 ) )
+
+// Timestamp and an ATMO_3dFloatVector_t
+#define ATMO_SAMPLECODEC_BENCH_FLOAT_SAMPLE_LEN ( 4 + ( 3 * 4 ) )
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+/**
+ * Free running counter, for instance the DWT cycle counter.
+ */
+typedef uint32_t ( *ATMO_SAMPLECODEC_BENCH_Counter_t )( void );
+
+typedef struct
+{
+	const ATMO_SAMPLECODEC_Sample_t *samples; /**< Recorded trace */
+	uint32_t numSamples;
+	uint8_t *buf; /**< Scratch buffer of blockSize bytes */
+	uint32_t blockSize; /**< Bytes per independently decodable block, like a log chunk or a frame payload */
+	ATMO_SAMPLECODEC_BENCH_Counter_t counter; /**< NULL to count uptime milliseconds */
+} ATMO_SAMPLECODEC_BENCH_Config_t;
+
+typedef struct
+{
+	uint32_t numBlocks;
+	uint32_t encodedBytes; /**< Bytes used in the blocks */
+	uint32_t blockBytes; /**< Bytes taken by the blocks, including what was left unused at their end */
+	uint32_t rawBytes;
+	uint32_t floatBytes;
+	uint32_t encodeTicks;
+	uint32_t decodeTicks;
+	ATMO_BOOL_t match; /**< Every sample decoded to its original */
+} ATMO_SAMPLECODEC_BENCH_Results_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Encode and decode the trace once and check it round trips.
+ *
+ * @param[in] config
+ * @param[out] results
+ * @return ATMO_Status_t
+ */
+ATMO_Status_t ATMO_SAMPLECODEC_BENCH_Run( const ATMO_SAMPLECODEC_BENCH_Config_t *config, ATMO_SAMPLECODEC_BENCH_Results_t *results );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_SAMPLECODEC_BENCH__H */
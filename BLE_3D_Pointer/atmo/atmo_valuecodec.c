@@ -0,0 +1,443 @@
+/**
+ ******************************************************************************
+ * @file    atmo_valuecodec.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Compact binary encoding of ATMO_Value_t
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "atmo_valuecodec.h"
+#include "../app_src/atmosphere_platform.h"
+
+/**
+ * Append bytes if the buffer has room. With a NULL buffer only the length is counted.
+ */
+static ATMO_BOOL_t _ATMO_VALUECODEC_Put( uint8_t *buf, unsigned int bufSize, unsigned int *pos, const void *data, unsigned int len )
+{
+	if ( buf != NULL )
+	{
+		if ( len > bufSize - *pos )
+		{
+			return false;
+		}
+
+		memcpy( &buf[*pos], data, len );
+	}
+
+	*pos += len;
+	return true;
+}
+
+static ATMO_BOOL_t _ATMO_VALUECODEC_PutVarint( uint8_t *buf, unsigned int bufSize, unsigned int *pos, uint32_t value )
+{
+	uint8_t varint[ATMO_VALUECODEC_MAX_VARINT_LEN];
+	unsigned int len = ATMO_VALUECODEC_EncodeVarint( value, varint );
+	return _ATMO_VALUECODEC_Put( buf, bufSize, pos, varint, len );
+}
+
+/**
+ * Copy a fixed size field in little endian order.
+ */
+static ATMO_BOOL_t _ATMO_VALUECODEC_PutLittleEndian( uint8_t *buf, unsigned int bufSize, unsigned int *pos, const void *data, unsigned int len )
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	uint8_t swapped[8];
+	unsigned int i;
+
+	for ( i = 0; i < len; i++ )
+	{
+		swapped[i] = ( ( const uint8_t * )data )[len - 1 - i];
+	}
+
+	return _ATMO_VALUECODEC_Put( buf, bufSize, pos, swapped, len );
+#else
+	return _ATMO_VALUECODEC_Put( buf, bufSize, pos, data, len );
+#endif
+}
+
+static void _ATMO_VALUECODEC_GetLittleEndian( void *data, const uint8_t *buf, unsigned int len )
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	unsigned int i;
+
+	for ( i = 0; i < len; i++ )
+	{
+		( ( uint8_t * )data )[i] = buf[len - 1 - i];
+	}
+
+#else
+	memcpy( data, buf, len );
+#endif
+}
+
+unsigned int ATMO_VALUECODEC_EncodeVarint( uint32_t value, uint8_t *buf )
+{
+	unsigned int len = 0;
+
+	do
+	{
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+
+		if ( value != 0 )
+		{
+			byte |= 0x80;
+		}
+
+		if ( buf != NULL )
+		{
+			buf[len] = byte;
+		}
+
+		len++;
+	}
+	while ( value != 0 );
+
+	return len;
+}
+
+unsigned int ATMO_VALUECODEC_DecodeVarint( const uint8_t *buf, unsigned int bufLen, uint32_t *value )
+{
+	uint32_t result = 0;
+	unsigned int i;
+
+	for ( i = 0; i < bufLen && i < ATMO_VALUECODEC_MAX_VARINT_LEN; i++ )
+	{
+		result |= ( uint32_t )( buf[i] & 0x7F ) << ( 7 * i );
+
+		if ( ( buf[i] & 0x80 ) == 0 )
+		{
+			// The last group of a 32 bit value only has 4 bits
+			if ( i == ATMO_VALUECODEC_MAX_VARINT_LEN - 1 && buf[i] > 0x0F )
+			{
+				return 0;
+			}
+
+			*value = result;
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+ATMO_Status_t ATMO_VALUECODEC_Encode( ATMO_Value_t *value, uint8_t *buf, unsigned int bufSize, unsigned int *encodedLen )
+{
+	unsigned int pos = 0;
+	ATMO_BOOL_t fits = true;
+
+	if ( value == NULL || encodedLen == NULL || value->type == 0 || value->type >= ATMO_DATATYPE_MAX )
+	{
+		return ATMO_Status_InvalidInput;
+	}
+
+	uint8_t type = value->type;
+	fits = _ATMO_VALUECODEC_Put( buf, bufSize, &pos, &type, 1 );
+
+	switch ( value->type )
+	{
+		case ATMO_DATATYPE_VOID:
+		{
+			break;
+		}
+
+		case ATMO_DATATYPE_CHAR:
+		case ATMO_DATATYPE_BOOL:
+		{
+			uint8_t byte = 0;
+
+			if ( value->type == ATMO_DATATYPE_CHAR )
+			{
+				byte = *( ( char * )value->data );
+			}
+			else
+			{
+				byte = *( ( ATMO_BOOL_t * )value->data ) ? 1 : 0;
+			}
+
+			fits = fits && _ATMO_VALUECODEC_Put( buf, bufSize, &pos, &byte, 1 );
+			break;
+		}
+
+		case ATMO_DATATYPE_INT:
+		{
+			int32_t data = 0;
+			memcpy( &data, value->data, sizeof( int ) );
+
+			// Zigzag keeps small negative numbers short
+			uint32_t zigzag = ( ( uint32_t )data << 1 ) ^ ( uint32_t )( data >> 31 );
+			fits = fits && _ATMO_VALUECODEC_PutVarint( buf, bufSize, &pos, zigzag );
+			break;
+		}
+
+		case ATMO_DATATYPE_UNSIGNED_INT:
+		{
+			uint32_t data = 0;
+			memcpy( &data, value->data, sizeof( unsigned int ) );
+			fits = fits && _ATMO_VALUECODEC_PutVarint( buf, bufSize, &pos, data );
+			break;
+		}
+
+		case ATMO_DATATYPE_FLOAT:
+		{
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, value->data, sizeof( float ) );
+			break;
+		}
+
+		case ATMO_DATATYPE_DOUBLE:
+		{
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, value->data, sizeof( double ) );
+			break;
+		}
+
+		case ATMO_DATATYPE_STRING:
+		case ATMO_DATATYPE_BINARY:
+		{
+			uint32_t len = value->size;
+
+			// The terminator isn't sent
+			if ( value->type == ATMO_DATATYPE_STRING )
+			{
+				len = strlen( ( char * )value->data );
+			}
+
+			fits = fits && _ATMO_VALUECODEC_PutVarint( buf, bufSize, &pos, len );
+			fits = fits && _ATMO_VALUECODEC_Put( buf, bufSize, &pos, value->data, len );
+			break;
+		}
+
+		case ATMO_DATATYPE_3D_VECTOR_FLOAT:
+		{
+			// The value data isn't necessarily aligned
+			ATMO_3dFloatVector_t vector;
+			memcpy( &vector, value->data, sizeof( vector ) );
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, &vector.x, sizeof( float ) );
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, &vector.y, sizeof( float ) );
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, &vector.z, sizeof( float ) );
+			break;
+		}
+
+		case ATMO_DATATYPE_3D_VECTOR_DOUBLE:
+		{
+			// The value data isn't necessarily aligned
+			ATMO_3dDoubleVector_t vector;
+			memcpy( &vector, value->data, sizeof( vector ) );
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, &vector.x, sizeof( double ) );
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, &vector.y, sizeof( double ) );
+			fits = fits && _ATMO_VALUECODEC_PutLittleEndian( buf, bufSize, &pos, &vector.z, sizeof( double ) );
+			break;
+		}
+
+		default:
+		{
+			return ATMO_Status_InvalidInput;
+		}
+	}
+
+	if ( !fits )
+	{
+		return ATMO_Status_OutOfMemory;
+	}
+
+	*encodedLen = pos;
+	return ATMO_Status_Success;
+}
+
+ATMO_Status_t ATMO_VALUECODEC_Decode( ATMO_Value_t *value, const uint8_t *buf, unsigned int bufLen, unsigned int *decodedLen )
+{
+	unsigned int pos = 1;
+	ATMO_Status_t status = ATMO_Status_Success;
+
+	if ( value == NULL || buf == NULL || decodedLen == NULL || bufLen < 1 )
+	{
+		return ATMO_Status_InvalidInput;
+	}
+
+	switch ( buf[0] )
+	{
+		case ATMO_DATATYPE_VOID:
+		{
+			status = ATMO_CreateValueVoid( value );
+			break;
+		}
+
+		case ATMO_DATATYPE_CHAR:
+		case ATMO_DATATYPE_BOOL:
+		{
+			if ( bufLen < pos + 1 )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			if ( buf[0] == ATMO_DATATYPE_CHAR )
+			{
+				status = ATMO_CreateValueChar( value, ( char )buf[pos] );
+			}
+			else
+			{
+				status = ATMO_CreateValueBool( value, buf[pos] != 0 );
+			}
+
+			pos++;
+			break;
+		}
+
+		case ATMO_DATATYPE_INT:
+		case ATMO_DATATYPE_UNSIGNED_INT:
+		{
+			uint32_t data = 0;
+			unsigned int len = ATMO_VALUECODEC_DecodeVarint( &buf[pos], bufLen - pos, &data );
+
+			if ( len == 0 )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			if ( buf[0] == ATMO_DATATYPE_INT )
+			{
+				status = ATMO_CreateValueInt( value, ( int )( ( data >> 1 ) ^ ( ~( data & 1 ) + 1 ) ) );
+			}
+			else
+			{
+				status = ATMO_CreateValueUnsignedInt( value, data );
+			}
+
+			pos += len;
+			break;
+		}
+
+		case ATMO_DATATYPE_FLOAT:
+		{
+			float data = 0;
+
+			if ( bufLen < pos + sizeof( float ) )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			_ATMO_VALUECODEC_GetLittleEndian( &data, &buf[pos], sizeof( float ) );
+			status = ATMO_CreateValueFloat( value, data );
+			pos += sizeof( float );
+			break;
+		}
+
+		case ATMO_DATATYPE_DOUBLE:
+		{
+			double data = 0;
+
+			if ( bufLen < pos + sizeof( double ) )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			_ATMO_VALUECODEC_GetLittleEndian( &data, &buf[pos], sizeof( double ) );
+			status = ATMO_CreateValueDouble( value, data );
+			pos += sizeof( double );
+			break;
+		}
+
+		case ATMO_DATATYPE_STRING:
+		case ATMO_DATATYPE_BINARY:
+		{
+			uint32_t len = 0;
+			unsigned int lenLen = ATMO_VALUECODEC_DecodeVarint( &buf[pos], bufLen - pos, &len );
+
+			if ( lenLen == 0 || len > bufLen - pos - lenLen )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			pos += lenLen;
+
+			if ( buf[0] == ATMO_DATATYPE_BINARY )
+			{
+				status = ATMO_CreateValueBinary( value, &buf[pos], len );
+			}
+			else
+			{
+				char str[len + 1];
+				memcpy( str, &buf[pos], len );
+				str[len] = 0;
+				status = ATMO_CreateValueString( value, str );
+			}
+
+			pos += len;
+			break;
+		}
+
+		case ATMO_DATATYPE_3D_VECTOR_FLOAT:
+		{
+			ATMO_3dFloatVector_t vector;
+
+			if ( bufLen < pos + ( 3 * sizeof( float ) ) )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			_ATMO_VALUECODEC_GetLittleEndian( &vector.x, &buf[pos], sizeof( float ) );
+			_ATMO_VALUECODEC_GetLittleEndian( &vector.y, &buf[pos + sizeof( float )], sizeof( float ) );
+			_ATMO_VALUECODEC_GetLittleEndian( &vector.z, &buf[pos + ( 2 * sizeof( float ) )], sizeof( float ) );
+			status = ATMO_CreateValue3dVectorFloat( value, &vector );
+			pos += 3 * sizeof( float );
+			break;
+		}
+
+		case ATMO_DATATYPE_3D_VECTOR_DOUBLE:
+		{
+			ATMO_3dDoubleVector_t vector;
+
+			if ( bufLen < pos + ( 3 * sizeof( double ) ) )
+			{
+				return ATMO_Status_InvalidInput;
+			}
+
+			_ATMO_VALUECODEC_GetLittleEndian( &vector.x, &buf[pos], sizeof( double ) );
+			_ATMO_VALUECODEC_GetLittleEndian( &vector.y, &buf[pos + sizeof( double )], sizeof( double ) );
+			_ATMO_VALUECODEC_GetLittleEndian( &vector.z, &buf[pos + ( 2 * sizeof( double ) )], sizeof( double ) );
+			status = ATMO_CreateValue3dVectorDouble( value, &vector );
+			pos += 3 * sizeof( double );
+			break;
+		}
+
+		default:
+		{
+			return ATMO_Status_InvalidInput;
+		}
+	}
+
+	if ( status != ATMO_Status_Success )
+	{
+		return status;
+	}
+
+	*decodedLen = pos;
+	return ATMO_Status_Success;
+}
@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ * @file    atmo_valuecodec.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Compact binary encoding of ATMO_Value_t
+ *
+ * Every value is encoded as < Type (1 Byte) >< Payload >, the type being the
+ * ATMO_DATATYPE value. Multi-byte fields are little endian, varints are
+ * unsigned LEB128 (7 bits per byte, least significant group first).
+ *
+ * VOID:             no payload
+ * CHAR, BOOL:       1 Byte
+ * INT:              zigzag varint
+ * UNSIGNED_INT:     varint
+ * FLOAT:            4 Bytes IEEE 754
+ * DOUBLE:           8 Bytes IEEE 754
+ * STRING, BINARY:   < Length (varint) >< Bytes >, strings without NULL terminator
+ * 3D_VECTOR_FLOAT:  3 x 4 Bytes (x, y, z)
+ * 3D_VECTOR_DOUBLE: 3 x 8 Bytes (x, y, z)
+ *
+ * Lists are not encoded, the core only has them without ATMO_SLIM_STACK.
+ *
+ * Containers that carry encoded values start with < Version (1 Byte) >, see
+ * ATMO_VALUECODEC_VERSION. New types may be added within a version, changes
+ * to existing encodings require a new version.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_VALUECODEC__H
+#define __ATMO_VALUECODEC__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+#define ATMO_VALUECODEC_VERSION (0x01)
+
+// Longest varint for a 32 bit value
+#define ATMO_VALUECODEC_MAX_VARINT_LEN (5)
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Encode a varint.
+ *
+ * @param[in] value
+ * @param[out] buf - Can be NULL to only get the length
+ * @return number of bytes
+ */
+unsigned int ATMO_VALUECODEC_EncodeVarint( uint32_t value, uint8_t *buf );
+
+/**
+ * Decode a varint.
+ *
+ * @param[in] buf
+ * @param[in] bufLen
+ * @param[out] value
+ * @return number of bytes consumed, 0 if the varint is truncated or too long
+ */
+unsigned int ATMO_VALUECODEC_DecodeVarint( const uint8_t *buf, unsigned int bufLen, uint32_t *value );
+
+/**
+ * Encode a value.
+ *
+ * @param[in] value
+ * @param[out] buf - Can be NULL to only get the length
+ * @param[in] bufSize
+ * @param[out] encodedLen
+ * @return OutOfMemory if the buffer is too small, InvalidInput for unknown types and lists
+ */
+ATMO_Status_t ATMO_VALUECODEC_Encode( ATMO_Value_t *value, uint8_t *buf, unsigned int bufSize, unsigned int *encodedLen );
+
+/**
+ * Decode a value.
+ *
+ * @param[out] value - Initialized value, overwritten
+ * @param[in] buf
+ * @param[in] bufLen
+ * @param[out] decodedLen - Number of bytes consumed
+ * @return InvalidInput if the data is malformed or truncated
+ */
+ATMO_Status_t ATMO_VALUECODEC_Decode( ATMO_Value_t *value, const uint8_t *buf, unsigned int bufLen, unsigned int *decodedLen );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_VALUECODEC__H */
@@ -52,6 +52,8 @@ void BMI160_AccelDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor )
 void BMI160_GyroDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor );
 
 static BHI160_Config_t _BHI160_Config;
+static BHI160_RawDataCallback_t _BHI160_RawDataCallback = NULL;
+static uint32_t _BHI160_ReadyTimeMs = 0;
 
 static ATMO_3dFloatVector_t _BMI160_AccData, _BMI160_GyroData, _BMI160_MagData;
 
@@ -95,6 +97,11 @@ void BMI160_MagDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor )
 	_BMI160_MagData.x = data->data_vector.x / 32768.0f * 360.0f;
 	_BMI160_MagData.y = data->data_vector.y / 32768.0f * 360.0f;
 	_BMI160_MagData.z = data->data_vector.z / 32768.0f * 360.0f;
+
+	if ( _BHI160_RawDataCallback != NULL )
+	{
+		_BHI160_RawDataCallback( BHI160_Sensor_Orientation, data->data_vector.x, data->data_vector.y, data->data_vector.z );
+	}
 }
 
 void BMI160_AccDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor )
@@ -102,6 +109,11 @@ void BMI160_AccDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor )
 	_BMI160_AccData.x = data->data_vector.x / 32768.0f * bhi160_accel_dyn_range;
 	_BMI160_AccData.y = data->data_vector.y / 32768.0f * bhi160_accel_dyn_range;
 	_BMI160_AccData.z = data->data_vector.z / 32768.0f * bhi160_accel_dyn_range;
+
+	if ( _BHI160_RawDataCallback != NULL )
+	{
+		_BHI160_RawDataCallback( BHI160_Sensor_Acceleration, data->data_vector.x, data->data_vector.y, data->data_vector.z );
+	}
 }
 
 void BMI160_GyroDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor )
@@ -109,6 +121,11 @@ void BMI160_GyroDataCb( bhy_data_generic_t *data, bhy_virtual_sensor_t sensor )
 	_BMI160_GyroData.x = data->data_vector.x / 32768.0f * bhi160_gyro_dyn_range;
 	_BMI160_GyroData.y = data->data_vector.y / 32768.0f * bhi160_gyro_dyn_range;
 	_BMI160_GyroData.z = data->data_vector.z / 32768.0f * bhi160_gyro_dyn_range;
+
+	if ( _BHI160_RawDataCallback != NULL )
+	{
+		_BHI160_RawDataCallback( BHI160_Sensor_Gyro, data->data_vector.x, data->data_vector.y, data->data_vector.z );
+	}
 }
 
 static void _BHI160_FifoRoutine( void *arg )
@@ -168,6 +185,7 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 
 	bhy_set_driver_instance( config->i2cInstance );
 
+	uint64_t startMs = ATMO_PLATFORM_UptimeMs();
 	int32_t retval = bhy_driver_init( bhy1_fw );
 
 	if ( retval != BHY_SUCCESS )
@@ -176,6 +194,8 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 		return false;
 	}
 
+	ATMO_PLATFORM_DebugPrint( "BHI160 firmware uploaded in %d ms\r\n", ( int )( ATMO_PLATFORM_UptimeMs() - startMs ) );
+
 	// Wait for reset
 	while ( ATMO_GPIO_Read( config->gpioInstance, config->intPin ) == ATMO_GPIO_PinState_High )
 	{
@@ -187,7 +207,8 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 
 	}
 
-	ATMO_PLATFORM_DebugPrint( "BHI160 Reset Complete\r\n" );
+	_BHI160_ReadyTimeMs = ( uint32_t )( ATMO_PLATFORM_UptimeMs() - startMs );
+	ATMO_PLATFORM_DebugPrint( "BHI160 Reset Complete, ready in %d ms\r\n", ( int )_BHI160_ReadyTimeMs );
 
 	// Register for interrupts
 	//ATMO_GPIO_RegisterInterruptCallback(config->gpioInstance, config->intPin, ATMO_GPIO_InterruptTrigger_RisingEdge, _BHI160_FifoRoutine);
@@ -223,7 +244,7 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 		return false;
 	}
 
-	retval = _BHI160_EnableSensor( BHI160_NDOF_S_ORIENTATION, BMI160_MagDataCb, 5 );
+	retval = _BHI160_EnableSensor( BHI160_NDOF_S_ORIENTATION, BMI160_MagDataCb, BHI160_DEFAULT_SAMPLE_RATE );
 
 	if ( retval != BHY_SUCCESS )
 	{
@@ -231,7 +252,7 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 		return false;
 	}
 
-	retval = _BHI160_EnableSensor( BHI160_NDOF_S_LINEAR_ACCELERATION, BMI160_AccDataCb, 5 );
+	retval = _BHI160_EnableSensor( BHI160_NDOF_S_LINEAR_ACCELERATION, BMI160_AccDataCb, BHI160_DEFAULT_SAMPLE_RATE );
 
 	if ( retval != BHY_SUCCESS )
 	{
@@ -239,7 +260,7 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 		return false;
 	}
 
-	retval = _BHI160_EnableSensor( BHI160_NDOF_S_RATE_OF_ROTATION, BMI160_GyroDataCb, 5 );
+	retval = _BHI160_EnableSensor( BHI160_NDOF_S_RATE_OF_ROTATION, BMI160_GyroDataCb, BHI160_DEFAULT_SAMPLE_RATE );
 
 	if ( retval != BHY_SUCCESS )
 	{
@@ -262,6 +283,39 @@ ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config )
 	return true;
 }
 
+ATMO_BOOL_t BHI160_SetSampleRate( BHI160_Sensor_t sensor, uint16_t sampleRateHz )
+{
+	static const enum BHI160_NDOF_Sensor virtualSensors[BHI160_Sensor_NumSensors] =
+	{
+		BHI160_NDOF_S_LINEAR_ACCELERATION,
+		BHI160_NDOF_S_RATE_OF_ROTATION,
+		BHI160_NDOF_S_ORIENTATION
+	};
+
+	if ( sensor >= BHI160_Sensor_NumSensors )
+	{
+		return false;
+	}
+
+	if ( sampleRateHz == 0 )
+	{
+		return bhy_disable_virtual_sensor( virtualSensors[sensor], VS_WAKEUP ) == BHY_SUCCESS;
+	}
+
+	return bhy_enable_virtual_sensor( virtualSensors[sensor], VS_WAKEUP,
+	                                  sampleRateHz, 0, VS_FLUSH_NONE, 0, 0 ) == BHY_SUCCESS;
+}
+
+uint32_t BHI160_GetReadyTimeMs( void )
+{
+	return _BHI160_ReadyTimeMs;
+}
+
+void BHI160_RegisterRawDataCallback( BHI160_RawDataCallback_t cb )
+{
+	_BHI160_RawDataCallback = cb;
+}
+
 ATMO_BOOL_t BHI160_GetData( ATMO_3dFloatVector_t *acceleration, ATMO_3dFloatVector_t *gyro, ATMO_3dFloatVector_t *mag )
 {
 	if ( acceleration != NULL )
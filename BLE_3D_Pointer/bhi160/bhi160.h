@@ -3,6 +3,8 @@
 
 #include "../app_src/atmosphere_platform.h"
 
+#define BHI160_DEFAULT_SAMPLE_RATE 5
+
 typedef struct
 {
 	ATMO_DriverInstanceHandle_t i2cInstance;
@@ -10,7 +12,28 @@ typedef struct
 	ATMO_GPIO_Device_Pin_t intPin;
 } BHI160_Config_t;
 
+typedef enum
+{
+	BHI160_Sensor_Acceleration = 0,
+	BHI160_Sensor_Gyro,
+	BHI160_Sensor_Orientation,
+	BHI160_Sensor_NumSensors,
+} BHI160_Sensor_t;
+
+/**
+ * Called with every raw (unscaled int16) sample parsed from the BHI160 FIFO
+ */
+typedef void ( *BHI160_RawDataCallback_t )( uint8_t sensor, int16_t x, int16_t y, int16_t z );
+
 ATMO_BOOL_t BHI160_Init( BHI160_Config_t *config );
 ATMO_BOOL_t BHI160_GetData( ATMO_3dFloatVector_t *acceleration, ATMO_3dFloatVector_t *gyro, ATMO_3dFloatVector_t *mag );
+ATMO_BOOL_t BHI160_SetSampleRate( BHI160_Sensor_t sensor, uint16_t sampleRateHz );
+void BHI160_RegisterRawDataCallback( BHI160_RawDataCallback_t cb );
+
+/**
+ * Time from the start of the firmware upload until the BHI160 came out of
+ * reset running it, 0 until BHI160_Init got that far
+ */
+uint32_t BHI160_GetReadyTimeMs( void );
 
 #endif
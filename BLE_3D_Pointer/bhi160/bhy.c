@@ -1377,7 +1377,8 @@ BHY_RETURN_FUNCTION_TYPE bhy_initialize_from_rom( const u8 *memory, const u32 v_
     u32 v_crc_host_u32 = BHY_INIT_VALUE;
     u32 write_data = BHY_INIT_VALUE;
     u8 data_from_mem[BHY_SIGNATURE_MEM_LEN];
-    u8 data_byte[BHY_RAM_WRITE_LENGTH_API];
+    /* kept off the stack, the upload chunk is larger than the other buffers */
+    static u8 data_byte[BHY_RAM_UPLOAD_LENGTH];
     u32 read_index_u8 = BHY_INIT_VALUE;
     u32 reverse_index_u32 = BHY_INIT_VALUE;
     u32 reverse_block_index_u32 = BHY_INIT_VALUE;
@@ -1472,7 +1473,7 @@ BHY_RETURN_FUNCTION_TYPE bhy_initialize_from_rom( const u8 *memory, const u32 v_
         com_rslt += bhy_write_reg(BHY_I2C_REG_UPLOAD_0_ADDR, &v_upload_addr, BHY_GEN_READ_WRITE_LENGTH);
         com_rslt += bhy_write_reg(BHY_I2C_REG_UPLOAD_1_ADDR, &v_upload_addr, BHY_GEN_READ_WRITE_LENGTH);
         /* write the chip control register as 0x02*/
-        write_length = data_to_process / BHY_RAM_WRITE_LENGTH_API;
+        write_length = data_to_process / BHY_RAM_UPLOAD_LENGTH;
         read_index_u8 = BHY_INIT_VALUE;
 
         /* write the memory of data */
@@ -1483,8 +1484,8 @@ BHY_RETURN_FUNCTION_TYPE bhy_initialize_from_rom( const u8 *memory, const u32 v_
             for (read_index_u8 = BHY_INIT_VALUE; read_index_u8 <= write_length; read_index_u8++)
             {
                 packet_length = (read_index_u8 == write_length) ?
-                (data_to_process % BHY_RAM_WRITE_LENGTH_API) / BHY_RAM_WRITE_LENGTH :
-                BHY_RAM_WRITE_LENGTH_API / BHY_RAM_WRITE_LENGTH;
+                (data_to_process % BHY_RAM_UPLOAD_LENGTH) / BHY_RAM_WRITE_LENGTH :
+                BHY_RAM_UPLOAD_LENGTH / BHY_RAM_WRITE_LENGTH;
 
                 /*reverse the data*/
                 for (reverse_block_index_u32 = 1; reverse_block_index_u32 <=packet_length ;reverse_block_index_u32++)
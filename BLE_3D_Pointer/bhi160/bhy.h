@@ -1372,6 +1372,11 @@ struct cus_version_t
 #define BHY_SIGNATURE_LENGTH                        (16)
 #define BHY_RAM_WRITE_LENGTH                        (4)
 #define BHY_RAM_WRITE_LENGTH_API                    (32)
+/*! bytes per write to the upload data register by bhy_initialize_from_rom, */
+/*! a multiple of BHY_RAM_WRITE_LENGTH */
+#ifndef BHY_RAM_UPLOAD_LENGTH
+#define BHY_RAM_UPLOAD_LENGTH                       (128)
+#endif
 #define BHY_CHIP_CTRL_ENABLE_1                      (0x02)
 #define BHY_CHIP_CTRL_ENABLE_2                      (0x01)
 #define BHY_UPLOAD_DATA                             (0x00)
@@ -57,32 +57,161 @@
 #include "bhy_uc_driver_config.h"
 
 #include <stdio.h>
+#include <BDK.h>
 
 
 
 /********************************************************************************/
 /*                                STATIC VARIABLES                              */
 /********************************************************************************/
+/* longest wait for one upload chunk to get onto the bus and through it, a     */
+/* 129 byte chunk takes about 13 ms even at 100 kHz                            */
+#ifndef BHY_UPLOAD_TIMEOUT_MS
+#define BHY_UPLOAD_TIMEOUT_MS (100)
+#endif
+
 static struct bhy_t bhy;
 static ATMO_DriverInstanceHandle_t _BHY_SUPPORT_I2CInstance;
+
+/* register address followed by one upload chunk, two of them so the next */
+/* chunk can be prepared while the previous one is still on the bus        */
+static uint8_t _BHY_SUPPORT_UploadBuffer[2][BHY_RAM_UPLOAD_LENGTH + 1];
+static uint8_t _BHY_SUPPORT_UploadBufferIndex = 0;
+static bool _BHY_SUPPORT_BulkUpload = false;
+static int32_t _BHY_SUPPORT_SavedBusSpeed;
+static volatile bool _BHY_SUPPORT_UploadPending = false;
+static volatile bool _BHY_SUPPORT_UploadFailed = false;
 //static uint8_t *version = BHY_MCU_REFERENCE_VERSION;
 
 /********************************************************************************/
 /*                         EXTERN FUNCTION DECLARATIONS                         */
 /********************************************************************************/
+/* called from the I2C ISR once an upload chunk is on the bus */
+static void bhy_upload_done(ATMO_I2C_Status_t status, void *arg)
+{
+    /* a chunk that was given up on already counts as failed */
+    if (!_BHY_SUPPORT_UploadPending)
+    {
+        return;
+    }
+
+    if (status != ATMO_I2C_Status_Success)
+    {
+        _BHY_SUPPORT_UploadFailed = true;
+    }
+
+    _BHY_SUPPORT_UploadPending = false;
+}
+
+/* waits for the upload chunk in flight, if any, and reports its result */
+static int8_t bhy_upload_wait(void)
+{
+    uint64_t deadline = ATMO_PLATFORM_UptimeMs() + BHY_UPLOAD_TIMEOUT_MS;
+
+    while (_BHY_SUPPORT_UploadPending)
+    {
+        if (ATMO_PLATFORM_UptimeMs() >= deadline)
+        {
+            /* the upload is lost either way, a late callback is ignored */
+            _BHY_SUPPORT_UploadPending = false;
+            _BHY_SUPPORT_UploadFailed = false;
+            return ATMO_I2C_Status_Timeout;
+        }
+    }
+
+    if (_BHY_SUPPORT_UploadFailed)
+    {
+        _BHY_SUPPORT_UploadFailed = false;
+        return ATMO_I2C_Status_Fail;
+    }
+
+    return ATMO_I2C_Status_Success;
+}
+
+static enum HAL_I2C_BusSpeed bhy_hal_bus_speed(int32_t arm_bus_speed)
+{
+    switch (arm_bus_speed)
+    {
+    case ARM_I2C_BUS_SPEED_FAST:
+        return HAL_I2C_BUS_SPEED_FAST;
+    case ARM_I2C_BUS_SPEED_FAST_PLUS:
+        return HAL_I2C_BUS_SPEED_FAST_PLUS;
+    default:
+        return HAL_I2C_BUS_SPEED_STANDARD;
+    }
+}
+
 static int8_t sensor_i2c_write(uint8_t addr, uint8_t reg, uint8_t *p_buf, uint16_t size)
 {
-    int32_t status;
+    int8_t status;
+    uint8_t *write_data;
+    uint64_t deadline;
+
+    if (!_BHY_SUPPORT_BulkUpload || (reg != BHY_I2C_REG_UPLOAD_DATA_ADDR))
+    {
+        /* keep the order of accesses, the chunk in flight goes out first */
+        status = bhy_upload_wait();
+
+        if (status != ATMO_I2C_Status_Success)
+        {
+            return status;
+        }
+
+        return ATMO_I2C_MasterWrite(_BHY_SUPPORT_I2CInstance, addr, &reg, 1, p_buf, size, 0);
+    }
 
-    uint8_t write_data[size + 1];
+    if (size > BHY_RAM_UPLOAD_LENGTH)
+    {
+        return ATMO_I2C_Status_Invalid;
+    }
+
+    /* the caller reuses its buffer for the next chunk, so this one is copied */
+    write_data = _BHY_SUPPORT_UploadBuffer[_BHY_SUPPORT_UploadBufferIndex];
     write_data[0] = reg;
     memcpy(&write_data[1], p_buf, size);
 
-    return ATMO_I2C_MasterWrite(_BHY_SUPPORT_I2CInstance, addr, NULL, 0, write_data, size + 1, 0);
+    status = bhy_upload_wait();
+
+    if (status != ATMO_I2C_Status_Success)
+    {
+        return status;
+    }
+
+    _BHY_SUPPORT_UploadPending = true;
+    deadline = ATMO_PLATFORM_UptimeMs() + BHY_UPLOAD_TIMEOUT_MS;
+
+    /* the bus may still be finishing the previous chunk's stop condition */
+    while ((status = ATMO_I2C_MasterWriteAsync(_BHY_SUPPORT_I2CInstance, addr, &write_data[0], 1, &write_data[1], size,
+                                               &bhy_upload_done, NULL)) == ATMO_I2C_Status_Busy)
+    {
+        if (ATMO_PLATFORM_UptimeMs() >= deadline)
+        {
+            status = ATMO_I2C_Status_Timeout;
+            break;
+        }
+    }
+
+    if (status != ATMO_I2C_Status_Success)
+    {
+        _BHY_SUPPORT_UploadPending = false;
+        return status;
+    }
+
+    /* the next chunk goes to the other buffer while this one is sent */
+    _BHY_SUPPORT_UploadBufferIndex ^= 1;
+
+    return ATMO_I2C_Status_Success;
 }
 
 static int8_t sensor_i2c_read(uint8_t addr, uint8_t reg, uint8_t *p_buf, uint16_t size)
 {
+    int8_t status = bhy_upload_wait();
+
+    if (status != ATMO_I2C_Status_Success)
+    {
+        return status;
+    }
+
 	return ATMO_I2C_MasterRead(_BHY_SUPPORT_I2CInstance, addr, &reg, 1, p_buf, size, 0);
 }
 
@@ -143,6 +272,31 @@ void bhy_set_driver_instance(ATMO_DriverInstanceHandle_t i2cInstance)
     _BHY_SUPPORT_I2CInstance = i2cInstance;
 }
 
+/*!
+ * @brief switches to the bulk upload, see bhy_support.h
+ */
+void bhy_bulk_upload_begin(void)
+{
+    _BHY_SUPPORT_SavedBusSpeed = HAL_I2C_GetBusSpeed();
+    HAL_I2C_SetBusSpeed(HAL_I2C_BUS_SPEED_FAST_PLUS);
+
+    _BHY_SUPPORT_UploadFailed = false;
+    _BHY_SUPPORT_BulkUpload = true;
+}
+
+/*!
+ * @brief leaves the bulk upload, see bhy_support.h
+ */
+int8_t bhy_bulk_upload_end(void)
+{
+    int8_t status = bhy_upload_wait();
+
+    _BHY_SUPPORT_BulkUpload = false;
+    HAL_I2C_SetBusSpeed(bhy_hal_bus_speed(_BHY_SUPPORT_SavedBusSpeed));
+
+    return status;
+}
+
 /*!
  * @brief provides the mcu reference code version
  */
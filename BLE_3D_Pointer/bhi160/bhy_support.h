@@ -107,5 +107,22 @@ void bhy_printf (const char * string);
 
 void bhy_set_driver_instance(ATMO_DriverInstanceHandle_t i2cInstance);
 
+/*!
+* @brief        Switches the bus to Fast-mode Plus and sends the following writes to
+*               the upload data register as asynchronous transfers, double buffered
+*               so the next chunk is prepared while the previous one is on the bus.
+*               Any other register access waits for the chunk in flight first. Each
+*               wait gives up after BHY_UPLOAD_TIMEOUT_MS and reports a timeout.
+*
+*/
+void bhy_bulk_upload_begin(void);
+
+/*!
+* @brief        Waits for the last upload chunk and restores the bus speed
+*
+* @retval       0 if every upload chunk was sent completely and in time
+*/
+int8_t bhy_bulk_upload_end(void);
+
 
 #endif /* BHY_SUPPORT_H_ */
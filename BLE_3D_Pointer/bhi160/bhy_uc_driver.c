@@ -163,8 +163,25 @@ BHY_RETURN_FUNCTION_TYPE bhy_driver_init(const uint8_t *bhy_fw_data)
     {
         bhy_initialize_support();
 
-        /* downloads the ram patch to the BHy */
-        result += bhy_initialize_from_rom(bhy_fw_data, /*bhy_fw_len*/tmp_fw_len);
+        /* downloads the ram patch to the BHy, the CRC check at the end tells */
+        /* whether it arrived intact. The last attempt falls back to blocking */
+        /* writes at the configured bus speed                                 */
+        if (init_retry_count > 1)
+        {
+            bhy_bulk_upload_begin();
+            result = bhy_initialize_from_rom(bhy_fw_data, /*bhy_fw_len*/tmp_fw_len);
+
+            /* a chunk that failed or timed out after the last register access */
+            /* is only reported here                                            */
+            if (bhy_bulk_upload_end() != 0 && result == BHY_SUCCESS)
+            {
+                result = BHY_ERROR;
+            }
+        }
+        else
+        {
+            result = bhy_initialize_from_rom(bhy_fw_data, /*bhy_fw_len*/tmp_fw_len);
+        }
 
         if (result == BHY_SUCCESS)
         {
@@ -315,6 +315,21 @@ ATMO_BLE_Status_t ATMO_BLE_GATTSRegisterCharacteristicCallback( ATMO_DriverInsta
 	return _ATMO_BLE_Instances[instance].instance->GATTSRegisterCharacteristicCallback( _ATMO_BLE_Instances[instance].instanceData, handle, event, cbFunc );
 }
 
+ATMO_BLE_Status_t ATMO_BLE_GATTSRegisterWriteCommandHandler( ATMO_DriverInstanceHandle_t instance, ATMO_BLE_Handle_t handle, ATMO_BLE_WriteCommandHandler_t handler )
+{
+	if ( !( instance < _ATMO_BLE_NumInstances ) )
+	{
+		return ATMO_BLE_Status_Invalid;
+	}
+
+	if ( _ATMO_BLE_Instances[instance].instance->GATTSRegisterWriteCommandHandler == NULL )
+	{
+		return ATMO_BLE_Status_NotSupported;
+	}
+
+	return _ATMO_BLE_Instances[instance].instance->GATTSRegisterWriteCommandHandler( _ATMO_BLE_Instances[instance].instanceData, handle, handler );
+}
+
 ATMO_BLE_Status_t ATMO_BLE_GATTSRegisterCharacteristicAbilityHandle( ATMO_DriverInstanceHandle_t instance, ATMO_BLE_Handle_t handle,
         ATMO_BLE_Characteristic_Event_t event, unsigned int abilityHandler )
 {
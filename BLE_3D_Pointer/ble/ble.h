@@ -236,6 +236,14 @@ typedef enum
 	ATMO_BLE_Characteristic_NumEvents
 } ATMO_BLE_Characteristic_Event_t;
 
+/**
+ * Handler for writes to a characteristic that bypass the regular write event dispatch.
+ *
+ * The handler runs directly in the BLE stack context. The data pointer refers to the
+ * stack's receive buffer and is only valid for the duration of the call.
+ */
+typedef void ( *ATMO_BLE_WriteCommandHandler_t )( ATMO_BLE_Handle_t handle, const uint8_t *data, uint16_t length );
+
 typedef struct ATMO_BLE_DriverInstance_t ATMO_BLE_DriverInstance_t;
 
 struct ATMO_BLE_DriverInstance_t
@@ -263,6 +271,7 @@ struct ATMO_BLE_DriverInstance_t
 	ATMO_BLE_Status_t ( *GATTSSendNotify )( ATMO_DriverInstanceData_t *instanceData, ATMO_BLE_Handle_t handle, uint16_t size, uint8_t *value );
 	ATMO_BLE_Status_t ( *RegisterEventCallback )( ATMO_DriverInstanceData_t *instanceData, ATMO_BLE_Event_t event, ATMO_Callback_t cb );
 	ATMO_BLE_Status_t ( *RegisterEventAbilityHandle )( ATMO_DriverInstanceData_t *instanceData, ATMO_BLE_Event_t event, unsigned int abilityHandle );
+	ATMO_BLE_Status_t ( *GATTSRegisterWriteCommandHandler )( ATMO_DriverInstanceData_t *instanceData, ATMO_BLE_Handle_t handle, ATMO_BLE_WriteCommandHandler_t handler );
 };
 
 /* Exported Function Prototypes -----------------------------------------------*/
@@ -426,6 +435,20 @@ ATMO_BLE_Status_t ATMO_BLE_GATTSRegisterCharacteristicCallback( ATMO_DriverInsta
  */
 ATMO_BLE_Status_t ATMO_BLE_GATTSRegisterCharacteristicAbilityHandle( ATMO_DriverInstanceHandle_t instance, ATMO_BLE_Handle_t handle, ATMO_BLE_Characteristic_Event_t event, unsigned int abilityHandler );
 
+/**
+ * Register a fast path handler for writes to a characteristic.
+ *
+ * Intended for characteristics written with Write Without Response at a high rate. Writes to
+ * the characteristic are handed to the handler without copying, logging or queueing, and the
+ * characteristic value and Written event are not updated. Pass NULL to remove the handler.
+ *
+ * @param instance
+ * @param handle
+ * @param handler
+ * @return ATMO_BLE_Status_t
+ */
+ATMO_BLE_Status_t ATMO_BLE_GATTSRegisterWriteCommandHandler( ATMO_DriverInstanceHandle_t instance, ATMO_BLE_Handle_t handle, ATMO_BLE_WriteCommandHandler_t handler );
+
 /**
  * This routine writes to a characteristic in the GATTDB.
  *
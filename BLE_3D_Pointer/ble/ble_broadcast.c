@@ -0,0 +1,177 @@
+/**
+ ******************************************************************************
+ * @file    ble_broadcast.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - BLE sensor snapshot broadcast
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+#include "ble_broadcast.h"
+#include "../app_src/atmosphere_platform.h"
+
+static ATMO_BLE_BROADCAST_Config_t __ATMO_BLE_BROADCAST_Config;
+static ATMO_BOOL_t __ATMO_BLE_BROADCAST_Initialized = false;
+static ATMO_BOOL_t __ATMO_BLE_BROADCAST_Enabled = false;
+static uint32_t __ATMO_BLE_BROADCAST_LastRefreshMs = 0;
+static uint8_t __ATMO_BLE_BROADCAST_Counter = 0;
+
+// Latest snapshot, the motion flag is latched until the next refresh
+static int16_t __ATMO_BLE_BROADCAST_Orientation[3];
+static ATMO_BOOL_t __ATMO_BLE_BROADCAST_OrientationValid = false;
+static ATMO_BOOL_t __ATMO_BLE_BROADCAST_Motion = false;
+
+static void __ATMO_BLE_BROADCAST_PutU16( uint8_t *buf, uint16_t val )
+{
+	buf[0] = val & 0xFF;
+	buf[1] = ( val >> 8 ) & 0xFF;
+}
+
+static void __ATMO_BLE_BROADCAST_Refresh( void )
+{
+	uint8_t payload[ATMO_BLE_BROADCAST_PAYLOAD_LEN];
+	uint8_t flags = 0;
+
+	if ( __ATMO_BLE_BROADCAST_Motion )
+	{
+		flags |= ATMO_BLE_BROADCAST_FLAG_MOTION;
+	}
+
+	if ( __ATMO_BLE_BROADCAST_OrientationValid )
+	{
+		flags |= ATMO_BLE_BROADCAST_FLAG_ORIENTATION_VALID;
+	}
+
+	__ATMO_BLE_BROADCAST_PutU16( &payload[0], __ATMO_BLE_BROADCAST_Config.companyId );
+	payload[2] = ATMO_BLE_BROADCAST_VERSION;
+	payload[3] = flags;
+	__ATMO_BLE_BROADCAST_PutU16( &payload[4], ( uint16_t )__ATMO_BLE_BROADCAST_Orientation[0] );
+	__ATMO_BLE_BROADCAST_PutU16( &payload[6], ( uint16_t )__ATMO_BLE_BROADCAST_Orientation[1] );
+	__ATMO_BLE_BROADCAST_PutU16( &payload[8], ( uint16_t )__ATMO_BLE_BROADCAST_Orientation[2] );
+	payload[10] = ( uint8_t )ATMO_PLATFORM_GetBattLevel();
+	payload[11] = __ATMO_BLE_BROADCAST_Counter++;
+
+	ATMO_BLE_AdvertisingData_t advData;
+	advData.length = sizeof( payload );
+	advData.payload = payload;
+	ATMO_BLE_GAPAdverertisingSetManufacturerData( __ATMO_BLE_BROADCAST_Config.bleInstance, &advData );
+
+	__ATMO_BLE_BROADCAST_Motion = false;
+}
+
+static void __ATMO_BLE_BROADCAST_Tick( void *data )
+{
+	if ( !__ATMO_BLE_BROADCAST_Enabled )
+	{
+		return;
+	}
+
+	uint32_t now = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+
+	if ( ( now - __ATMO_BLE_BROADCAST_LastRefreshMs ) >= __ATMO_BLE_BROADCAST_Config.refreshIntervalMs )
+	{
+		__ATMO_BLE_BROADCAST_LastRefreshMs = now;
+		__ATMO_BLE_BROADCAST_Refresh();
+	}
+}
+
+ATMO_BLE_BROADCAST_Status_t ATMO_BLE_BROADCAST_Init( ATMO_BLE_BROADCAST_Config_t *config )
+{
+	if ( config == NULL )
+	{
+		return ATMO_BLE_BROADCAST_Status_Invalid;
+	}
+
+	memcpy( &__ATMO_BLE_BROADCAST_Config, config, sizeof( __ATMO_BLE_BROADCAST_Config ) );
+
+	if ( __ATMO_BLE_BROADCAST_Config.refreshIntervalMs == 0 )
+	{
+		__ATMO_BLE_BROADCAST_Config.refreshIntervalMs = ATMO_BLE_BROADCAST_DEFAULT_REFRESH_MS;
+	}
+
+	if ( !__ATMO_BLE_BROADCAST_Initialized )
+	{
+		ATMO_AddTickCallback( __ATMO_BLE_BROADCAST_Tick );
+		__ATMO_BLE_BROADCAST_Initialized = true;
+	}
+
+	return ATMO_BLE_BROADCAST_Status_Success;
+}
+
+ATMO_BLE_BROADCAST_Status_t ATMO_BLE_BROADCAST_SetEnabled( ATMO_BOOL_t enabled )
+{
+	if ( !__ATMO_BLE_BROADCAST_Initialized )
+	{
+		return ATMO_BLE_BROADCAST_Status_Fail;
+	}
+
+	__ATMO_BLE_BROADCAST_Enabled = enabled;
+
+	if ( enabled )
+	{
+		__ATMO_BLE_BROADCAST_LastRefreshMs = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+		__ATMO_BLE_BROADCAST_Refresh();
+		return ATMO_BLE_BROADCAST_Status_Success;
+	}
+
+	ATMO_BLE_AdvertisingData_t advData;
+	advData.length = 0;
+	advData.payload = NULL;
+
+	if ( ATMO_BLE_GAPAdverertisingSetManufacturerData( __ATMO_BLE_BROADCAST_Config.bleInstance, &advData ) != ATMO_BLE_Status_Success )
+	{
+		return ATMO_BLE_BROADCAST_Status_Fail;
+	}
+
+	return ATMO_BLE_BROADCAST_Status_Success;
+}
+
+void ATMO_BLE_BROADCAST_PushSample( uint8_t sensorId, int16_t x, int16_t y, int16_t z )
+{
+	if ( !__ATMO_BLE_BROADCAST_Enabled )
+	{
+		return;
+	}
+
+	if ( sensorId == __ATMO_BLE_BROADCAST_Config.orientationSensorId )
+	{
+		__ATMO_BLE_BROADCAST_Orientation[0] = x;
+		__ATMO_BLE_BROADCAST_Orientation[1] = y;
+		__ATMO_BLE_BROADCAST_Orientation[2] = z;
+		__ATMO_BLE_BROADCAST_OrientationValid = true;
+	}
+	else if ( sensorId == __ATMO_BLE_BROADCAST_Config.motionSensorId )
+	{
+		uint32_t magnitude = ( x < 0 ? -( int32_t )x : x ) + ( y < 0 ? -( int32_t )y : y ) + ( z < 0 ? -( int32_t )z : z );
+
+		if ( magnitude >= __ATMO_BLE_BROADCAST_Config.motionThreshold )
+		{
+			__ATMO_BLE_BROADCAST_Motion = true;
+		}
+	}
+}
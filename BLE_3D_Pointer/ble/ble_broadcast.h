@@ -0,0 +1,121 @@
+/**
+ ******************************************************************************
+ * @file    ble_broadcast.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - BLE sensor snapshot broadcast header file
+ *
+ * When enabled, a compact sensor snapshot is placed into the manufacturer
+ * specific data of the advertisement and refreshed periodically, so passive
+ * scanners can read any number of devices without connecting.
+ *
+ * Payload (all fields little endian):
+ *
+ * < Company ID (2 Bytes) >< Version (1 Byte) >< Flags (1 Byte) >
+ * < Heading (2 Bytes) >< Pitch (2 Bytes) >< Roll (2 Bytes) >
+ * < Battery % (1 Byte) >< Counter (1 Byte) >
+ *
+ * Orientation is signed 16-bit with 360/32768 degrees per LSB. The counter is
+ * incremented with every refresh so listeners can drop duplicates.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_BLE_BROADCAST__H
+#define __ATMO_BLE_BROADCAST__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "../atmo/core.h"
+#include "ble.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+#define ATMO_BLE_BROADCAST_VERSION (0x01)
+#define ATMO_BLE_BROADCAST_PAYLOAD_LEN (12)
+#define ATMO_BLE_BROADCAST_DEFAULT_REFRESH_MS (1000)
+
+#define ATMO_BLE_BROADCAST_FLAG_MOTION (0x01)
+#define ATMO_BLE_BROADCAST_FLAG_ORIENTATION_VALID (0x02)
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+typedef enum
+{
+	ATMO_BLE_BROADCAST_Status_Success              = 0x00u,  /**< Operation was successful */
+	ATMO_BLE_BROADCAST_Status_Fail                 = 0x01u,  /**< Operation failed */
+	ATMO_BLE_BROADCAST_Status_Invalid              = 0x02u,  /**< Invalid argument */
+} ATMO_BLE_BROADCAST_Status_t;
+
+typedef struct
+{
+	ATMO_DriverInstanceHandle_t bleInstance;
+	uint16_t companyId;
+	uint32_t refreshIntervalMs;
+	uint8_t orientationSensorId;  /**< Sensor ID of orientation samples passed to ATMO_BLE_BROADCAST_PushSample */
+	uint8_t motionSensorId;       /**< Sensor ID of linear acceleration samples passed to ATMO_BLE_BROADCAST_PushSample */
+	uint16_t motionThreshold;     /**< Sum of absolute raw acceleration axes that counts as motion */
+} ATMO_BLE_BROADCAST_Config_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Initialize the broadcast. It is disabled until ATMO_BLE_BROADCAST_SetEnabled is called.
+ *
+ * @param[in] config
+ * @return ATMO_BLE_BROADCAST_Status_t
+ */
+ATMO_BLE_BROADCAST_Status_t ATMO_BLE_BROADCAST_Init( ATMO_BLE_BROADCAST_Config_t *config );
+
+/**
+ * Enable or disable the broadcast. Disabling removes the snapshot from the advertisement.
+ *
+ * @param[in] enabled
+ * @return ATMO_BLE_BROADCAST_Status_t
+ */
+ATMO_BLE_BROADCAST_Status_t ATMO_BLE_BROADCAST_SetEnabled( ATMO_BOOL_t enabled );
+
+/**
+ * Hand a raw sensor sample to the broadcast. Samples of unknown sensors are ignored.
+ *
+ * @param[in] sensorId
+ * @param[in] x
+ * @param[in] y
+ * @param[in] z
+ */
+void ATMO_BLE_BROADCAST_PushSample( uint8_t sensorId, int16_t x, int16_t y, int16_t z );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_BLE_BROADCAST__H */
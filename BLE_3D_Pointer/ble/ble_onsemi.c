@@ -29,7 +29,8 @@ const ATMO_BLE_DriverInstance_t onsemiBleDriverInstance =
 	ATMO_ONSEMI_BLE_GATTSSendIndicate,
 	ATMO_ONSEMI_BLE_GATTSSendNotify,
 	ATMO_ONSEMI_BLE_RegisterEventCallback,
-	ATMO_ONSEMI_BLE_RegisterEventAbilityHandle
+	ATMO_ONSEMI_BLE_RegisterEventAbilityHandle,
+	ATMO_ONSEMI_BLE_GATTSRegisterWriteCommandHandler
 };
 
 static ATMO_Callback_t _ATMO_ONSEMI_BLE_EventCallbacks[ATMO_BLE_EVENT_NumEvents][ATMO_ONSEMI_BLE_MAX_ABILITIES_PER_EVENT];
@@ -41,11 +42,68 @@ static uint8_t _ATMO_ONSEMI_BLE_NumEventAbilities[ATMO_BLE_EVENT_NumEvents] = {0
 static char _ATMO_ONSEMI_BLE_LocalName[6] = {0};
 static ATMO_UUID_t _ATMO_ONSEMI_BLE_PrimaryUuid;
 
-static bool _ATMO_ONSEMI_BLE_Advertising = false;
+/* Adaptive advertising schedule */
+static bool _ATMO_ONSEMI_BLE_AdvEnabled = false;
+static bool _ATMO_ONSEMI_BLE_AdvRunning = false;
+static bool _ATMO_ONSEMI_BLE_AdvCancelling = false;
+static bool _ATMO_ONSEMI_BLE_AdvRestart = false;
+static ATMO_ONSEMI_BLE_AdvProfile_t _ATMO_ONSEMI_BLE_AdvProfile = { ATMO_ONSEMI_BLE_AdvPhase_Off, 0, 0 };
+static uint16_t _ATMO_ONSEMI_BLE_AdvSlowInterval = ATMO_ONSEMI_BLE_ADV_SLOW_INTERVAL;
+
+static void _ATMO_ONSEMI_BLE_AdvTick( void *data );
+
+/* Broadcast payload, replaces the service UUID in the advertising data while set */
+static uint8_t _ATMO_ONSEMI_BLE_ManufacturerData[ATMO_ONSEMI_BLE_MAX_MANUFACTURER_DATA_LEN];
+static uint8_t _ATMO_ONSEMI_BLE_ManufacturerDataLen = 0;
+
+/* Central of the last connection, target of directed advertising */
+static struct
+{
+	bool valid;
+	uint8_t addr[BD_ADDR_LEN];
+	uint8_t addrType;
+} _ATMO_ONSEMI_BLE_LastCentral;
 static bool _ATMO_ONSEMI_BLE_InitComplete = false;
 
 static bool _ATMO_ONSEMI_Connected = false;
 
+/* Notifications handed to GATTC that have not been completed yet */
+static uint8_t _ATMO_ONSEMI_BLE_PendingNotifications = 0;
+static uint16_t _ATMO_ONSEMI_BLE_NotifySeqNum = 0;
+
+/* Fast path write handlers, keyed by attribute handle of the characteristic value */
+typedef struct
+{
+	uint16_t attHandle;
+	ATMO_BLE_WriteCommandHandler_t handler;
+} _ATMO_ONSEMI_BLE_WriteCommandHandler_t;
+
+static _ATMO_ONSEMI_BLE_WriteCommandHandler_t _ATMO_ONSEMI_BLE_WriteCommandHandlers[ATMO_ONSEMI_BLE_MAX_WRITE_COMMAND_HANDLERS];
+static uint8_t _ATMO_ONSEMI_BLE_NumWriteCommandHandlers = 0;
+
+/*
+ * GATTC queues prepared writes itself and only asks for the attribute info of every chunk.
+ * The handles are mirrored here in the same order. An execute write delivers the queued
+ * chunks back to back as write requests with offsets, which are reassembled so the
+ * characteristic value is only ever updated with the complete value. A buffer is taken
+ * when the first chunk of a handle is executed and committed with its last queued chunk,
+ * so a cancelled queue never holds one. ATT requests are serialized, so any other request
+ * after the first executed chunk means the execute is over.
+ */
+typedef struct
+{
+	bool used;
+	uint16_t attHandle;
+	uint16_t length;
+	uint8_t data[ATMO_ONSEMI_BLE_LONG_WRITE_BUFFER_SIZE];
+} _ATMO_ONSEMI_BLE_LongWrite_t;
+
+static _ATMO_ONSEMI_BLE_LongWrite_t _ATMO_ONSEMI_BLE_LongWrites[ATMO_ONSEMI_BLE_NUM_LONG_WRITE_BUFFERS];
+
+static uint16_t _ATMO_ONSEMI_BLE_PrepareQueue[ATMO_ONSEMI_BLE_MAX_PREPARED_WRITES];
+static uint8_t _ATMO_ONSEMI_BLE_PrepareQueueLen = 0;
+static uint8_t _ATMO_ONSEMI_BLE_PrepareQueueHead = 0;
+
 ATMO_Status_t ATMO_ONSEMI_BLE_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
 {
 	static ATMO_DriverInstanceData_t driverInstanceData;
@@ -121,6 +179,17 @@ static _ATMO_ONSEMI_BLE_Characteristic_t *_ATMO_BLE_ONSEMI_GetCharFromHandle( ui
 	return NULL;
 }
 
+static _ATMO_ONSEMI_BLE_Characteristic_t *_ATMO_BLE_ONSEMI_GetCharFromCccHandle( uint32_t handle )
+{
+	// The CCC descriptor directly follows the characteristic value
+	if ( handle == 0 )
+	{
+		return NULL;
+	}
+
+	return _ATMO_BLE_ONSEMI_GetCharFromHandle( handle - 1 );
+}
+
 static void _ATMO_BLE_ONSEMI_DispatchCharEvent( ATMO_BLE_Characteristic_Event_t event, _ATMO_ONSEMI_BLE_Characteristic_t *characteristic, ATMO_Value_t *data )
 {
 	for ( unsigned int i = 0; i < characteristic->numAbilities[event]; i++ )
@@ -134,13 +203,158 @@ static void _ATMO_BLE_ONSEMI_DispatchCharEvent( ATMO_BLE_Characteristic_Event_t
 	}
 }
 
+static _ATMO_ONSEMI_BLE_LongWrite_t *_ATMO_BLE_ONSEMI_LongWriteFind( uint16_t attHandle )
+{
+	for ( unsigned int i = 0; i < ATMO_ONSEMI_BLE_NUM_LONG_WRITE_BUFFERS; i++ )
+	{
+		if ( _ATMO_ONSEMI_BLE_LongWrites[i].used && _ATMO_ONSEMI_BLE_LongWrites[i].attHandle == attHandle )
+		{
+			return &_ATMO_ONSEMI_BLE_LongWrites[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void _ATMO_BLE_ONSEMI_LongWriteCommit( _ATMO_ONSEMI_BLE_LongWrite_t *longWrite )
+{
+	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( longWrite->attHandle - 1 );
+
+	longWrite->used = false;
+
+	if ( characteristic == NULL )
+	{
+		return;
+	}
+
+	memcpy( characteristic->data, longWrite->data, longWrite->length );
+	characteristic->currentLength = longWrite->length;
+
+	// Values larger than ATMO_STATIC_SIZE arrive as a void value, use ATMO_BLE_GATTSGetCharacteristicValue to fetch them
+	ATMO_Value_t atmoVal;
+	ATMO_InitValue( &atmoVal );
+	ATMO_CreateValueBinary( &atmoVal, characteristic->data, characteristic->currentLength );
+	_ATMO_BLE_ONSEMI_DispatchCharEvent( ATMO_BLE_Characteristic_Written, characteristic, &atmoVal );
+	ATMO_FreeValue( &atmoVal );
+}
+
+static _ATMO_ONSEMI_BLE_LongWrite_t *_ATMO_BLE_ONSEMI_LongWriteAcquire( uint16_t attHandle )
+{
+	_ATMO_ONSEMI_BLE_LongWrite_t *longWrite = _ATMO_BLE_ONSEMI_LongWriteFind( attHandle );
+
+	for ( unsigned int i = 0; longWrite == NULL && i < ATMO_ONSEMI_BLE_NUM_LONG_WRITE_BUFFERS; i++ )
+	{
+		if ( !_ATMO_ONSEMI_BLE_LongWrites[i].used )
+		{
+			longWrite = &_ATMO_ONSEMI_BLE_LongWrites[i];
+			longWrite->used = true;
+			longWrite->attHandle = attHandle;
+			longWrite->length = 0;
+		}
+	}
+
+	return longWrite;
+}
+
+static void _ATMO_BLE_ONSEMI_PrepareQueueReset( void )
+{
+	_ATMO_ONSEMI_BLE_PrepareQueueLen = 0;
+	_ATMO_ONSEMI_BLE_PrepareQueueHead = 0;
+
+	for ( unsigned int i = 0; i < ATMO_ONSEMI_BLE_NUM_LONG_WRITE_BUFFERS; i++ )
+	{
+		_ATMO_ONSEMI_BLE_LongWrites[i].used = false;
+	}
+}
+
+/*
+ * The execute delivered fewer chunks than mirrored, the missing ones were prepared before
+ * a cancel that is not reported by the stack. Every executed chunk was confirmed, so the
+ * values are complete.
+ */
+static void _ATMO_BLE_ONSEMI_PrepareQueueFinish( void )
+{
+	if ( _ATMO_ONSEMI_BLE_PrepareQueueHead == 0 )
+	{
+		return;
+	}
+
+	for ( unsigned int i = 0; i < ATMO_ONSEMI_BLE_NUM_LONG_WRITE_BUFFERS; i++ )
+	{
+		if ( _ATMO_ONSEMI_BLE_LongWrites[i].used )
+		{
+			_ATMO_BLE_ONSEMI_LongWriteCommit( &_ATMO_ONSEMI_BLE_LongWrites[i] );
+		}
+	}
+
+	_ATMO_BLE_ONSEMI_PrepareQueueReset();
+}
+
+static bool _ATMO_BLE_ONSEMI_PrepareQueueHasPending( uint16_t attHandle )
+{
+	for ( unsigned int i = _ATMO_ONSEMI_BLE_PrepareQueueHead; i < _ATMO_ONSEMI_BLE_PrepareQueueLen; i++ )
+	{
+		if ( _ATMO_ONSEMI_BLE_PrepareQueue[i] == attHandle )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Reassemble one executed chunk, returns the ATT status for the write confirmation */
+static uint8_t _ATMO_BLE_ONSEMI_LongWriteExecute( struct gattc_write_req_ind const *param )
+{
+	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( param->handle - 1 );
+	_ATMO_ONSEMI_BLE_LongWrite_t *longWrite = _ATMO_BLE_ONSEMI_LongWriteAcquire( param->handle );
+	uint8_t status = GAP_ERR_NO_ERROR;
+
+	_ATMO_ONSEMI_BLE_PrepareQueueHead++;
+
+	if ( characteristic == NULL || longWrite == NULL )
+	{
+		status = ATT_ERR_INVALID_HANDLE;
+	}
+	else if ( param->offset > characteristic->maxLength )
+	{
+		status = ATT_ERR_INVALID_OFFSET;
+	}
+	else if ( ( param->offset + param->length ) > characteristic->maxLength )
+	{
+		status = ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN;
+	}
+	else
+	{
+		memcpy( &longWrite->data[param->offset], param->value, param->length );
+
+		if ( ( param->offset + param->length ) > longWrite->length )
+		{
+			longWrite->length = param->offset + param->length;
+		}
+
+		if ( !_ATMO_BLE_ONSEMI_PrepareQueueHasPending( param->handle ) )
+		{
+			_ATMO_BLE_ONSEMI_LongWriteCommit( longWrite );
+		}
+	}
+
+	// A failed chunk aborts the execute, the rest of the queue is discarded by the stack
+	if ( status != GAP_ERR_NO_ERROR || _ATMO_ONSEMI_BLE_PrepareQueueHead >= _ATMO_ONSEMI_BLE_PrepareQueueLen )
+	{
+		_ATMO_BLE_ONSEMI_PrepareQueueReset();
+	}
+
+	return status;
+}
+
 static int _ATMO_BLE_ONSEMI_ReadReqInd( ke_msg_id_t const msg_id,
                                         struct gattc_read_req_ind const *param, ke_task_id_t const dest_id,
                                         ke_task_id_t const src_id )
 {
 	uint8_t status = GAP_ERR_NO_ERROR;
 	uint8_t *val_ptr = NULL;
-	uint8_t val_len = 0;
+	uint16_t val_len = 0;
 	uint16_t att_num = 0;
 	struct gattc_read_cfm *cfm;
 
@@ -151,19 +365,35 @@ static int _ATMO_BLE_ONSEMI_ReadReqInd( ke_msg_id_t const msg_id,
 		return KE_MSG_CONSUMED;
 	}
 
+	_ATMO_BLE_ONSEMI_PrepareQueueFinish();
+
 	att_num = param->handle - 1;
 
 	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( att_num );
+	_ATMO_ONSEMI_BLE_Characteristic_t *cccCharacteristic = NULL;
 
 	if ( characteristic == NULL )
 	{
-		status = ATT_ERR_INVALID_HANDLE;
+		cccCharacteristic = _ATMO_BLE_ONSEMI_GetCharFromCccHandle( att_num );
+
+		if ( cccCharacteristic == NULL )
+		{
+			status = ATT_ERR_INVALID_HANDLE;
+		}
 	}
 
 	if ( status == GAP_ERR_NO_ERROR )
 	{
-		val_ptr = characteristic->data;
-		val_len = characteristic->currentLength;
+		if ( characteristic != NULL )
+		{
+			val_ptr = characteristic->data;
+			val_len = characteristic->currentLength;
+		}
+		else
+		{
+			val_ptr = ( uint8_t * )&cccCharacteristic->cccValue;
+			val_len = sizeof( cccCharacteristic->cccValue );
+		}
 	}
 
 	cfm = KE_MSG_ALLOC_DYN( GATTC_READ_CFM, KE_BUILD_ID( TASK_GATTC, conidx ),
@@ -199,25 +429,101 @@ static int _ATMO_BLE_ONSEMI_WriteReqInd( ke_msg_id_t const msg_id,
 		return KE_MSG_CONSUMED;
 	}
 
+	/* Chunk of an executed prepared write, they arrive in the order they were queued */
+	if ( _ATMO_ONSEMI_BLE_PrepareQueueLen > 0 )
+	{
+		/* Entries ahead of the first executed chunk were prepared before a cancel */
+		for ( unsigned int i = 0; _ATMO_ONSEMI_BLE_PrepareQueueHead == 0 && i < _ATMO_ONSEMI_BLE_PrepareQueueLen; i++ )
+		{
+			if ( _ATMO_ONSEMI_BLE_PrepareQueue[i] == param->handle )
+			{
+				memmove( _ATMO_ONSEMI_BLE_PrepareQueue, &_ATMO_ONSEMI_BLE_PrepareQueue[i], ( _ATMO_ONSEMI_BLE_PrepareQueueLen - i ) * sizeof( uint16_t ) );
+				_ATMO_ONSEMI_BLE_PrepareQueueLen -= i;
+				break;
+			}
+		}
+
+		if ( _ATMO_ONSEMI_BLE_PrepareQueue[_ATMO_ONSEMI_BLE_PrepareQueueHead] == param->handle )
+		{
+			cfm = KE_MSG_ALLOC( GATTC_WRITE_CFM, KE_BUILD_ID( TASK_GATTC, conidx ),
+			                    TASK_APP, gattc_write_cfm );
+			cfm->handle = param->handle;
+			cfm->status = _ATMO_BLE_ONSEMI_LongWriteExecute( param );
+			ke_msg_send( cfm );
+
+			return KE_MSG_CONSUMED;
+		}
+
+		/* A plain write, the queue was cancelled or has already been executed */
+		_ATMO_BLE_ONSEMI_PrepareQueueFinish();
+		_ATMO_BLE_ONSEMI_PrepareQueueReset();
+	}
+
+	/* Fast path: hand the payload straight to the registered handler */
+	if ( param->offset == 0 )
+	{
+		for ( unsigned int i = 0; i < _ATMO_ONSEMI_BLE_NumWriteCommandHandlers; i++ )
+		{
+			if ( _ATMO_ONSEMI_BLE_WriteCommandHandlers[i].attHandle == param->handle )
+			{
+				_ATMO_ONSEMI_BLE_WriteCommandHandlers[i].handler( param->handle - 1, param->value, param->length );
+
+				/* GATTC still expects a confirmation to release the request, nothing is sent over the air for write commands */
+				cfm = KE_MSG_ALLOC( GATTC_WRITE_CFM, KE_BUILD_ID( TASK_GATTC, conidx ),
+				                    TASK_APP, gattc_write_cfm );
+				cfm->handle = param->handle;
+				cfm->status = GAP_ERR_NO_ERROR;
+				ke_msg_send( cfm );
+
+				return KE_MSG_CONSUMED;
+			}
+		}
+	}
+
+	att_num = param->handle - 1;
+
 	/* Check that offset is valid */
 	if ( param->offset != 0 )
 	{
 		status = ATT_ERR_INVALID_OFFSET;
 	}
 
-	att_num = param->handle - 1;
-
 	ATMO_PLATFORM_DebugPrint( "Write request for handle %d\r\n", att_num );
 
 	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( att_num );
+	_ATMO_ONSEMI_BLE_Characteristic_t *cccCharacteristic = NULL;
 
 	if ( characteristic == NULL )
 	{
-		ATMO_PLATFORM_DebugPrint("Unable to find characteristic matching handle %d\r\n", att_num);
-		status = ATT_ERR_INVALID_HANDLE;
+		cccCharacteristic = _ATMO_BLE_ONSEMI_GetCharFromCccHandle( att_num );
+
+		if ( cccCharacteristic == NULL )
+		{
+			ATMO_PLATFORM_DebugPrint("Unable to find characteristic matching handle %d\r\n", att_num);
+			status = ATT_ERR_INVALID_HANDLE;
+		}
 	}
 
-	if ( status == GAP_ERR_NO_ERROR )
+	if ( status == GAP_ERR_NO_ERROR && cccCharacteristic != NULL )
+	{
+		if ( param->length != sizeof( cccCharacteristic->cccValue ) )
+		{
+			status = ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN;
+		}
+		else
+		{
+			memcpy( &cccCharacteristic->cccValue, param->value, sizeof( cccCharacteristic->cccValue ) );
+
+			ATMO_Value_t atmoVal;
+			ATMO_InitValue( &atmoVal );
+			ATMO_CreateValueUnsignedInt( &atmoVal, cccCharacteristic->cccValue );
+			_ATMO_BLE_ONSEMI_DispatchCharEvent( ( cccCharacteristic->cccValue & ( ATT_CCC_START_NTF | ATT_CCC_START_IND ) ) ?
+			                                    ATMO_BLE_Characteristic_Subscribed : ATMO_BLE_Characteristic_Unsubscribed,
+			                                    cccCharacteristic, &atmoVal );
+			ATMO_FreeValue( &atmoVal );
+		}
+	}
+	else if ( status == GAP_ERR_NO_ERROR )
 	{
 		if ( param->length > characteristic->maxLength )
 		{
@@ -250,16 +556,77 @@ static int _ATMO_BLE_ONSEMI_WriteReqInd( ke_msg_id_t const msg_id,
 }
 
 static int _ATMO_BLE_ONSEMI_AttInfoReqInd( ke_msg_id_t const msg_id,
-        struct gattc_read_req_ind const *param, ke_task_id_t const dest_id,
+        struct gattc_att_info_req_ind const *param, ke_task_id_t const dest_id,
         ke_task_id_t const src_id )
 {
+	uint8_t status = GAP_ERR_NO_ERROR;
+	uint16_t length = 0;
+	int conidx = BDK_BLE_GetConIdx();
+	struct gattc_att_info_cfm *cfm;
+
+	if ( conidx == INVALID_DEV_IDX )
+	{
+		return KE_MSG_CONSUMED;
+	}
+
+	/* Requested by GATTC for every prepared write */
+	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( param->handle - 1 );
+
+	if ( characteristic != NULL )
+	{
+		length = characteristic->currentLength;
+
+		if ( characteristic->maxLength > ATMO_ONSEMI_BLE_LONG_WRITE_BUFFER_SIZE )
+		{
+			status = ATT_ERR_INSUFF_RESOURCE;
+		}
+		else
+		{
+			/* A prepare after executed chunks starts a new queue */
+			_ATMO_BLE_ONSEMI_PrepareQueueFinish();
+
+			/* The client cancels its queue on the error, entries left from earlier cancels go with it */
+			if ( _ATMO_ONSEMI_BLE_PrepareQueueLen >= ATMO_ONSEMI_BLE_MAX_PREPARED_WRITES )
+			{
+				status = ATT_ERR_PREPARE_QUEUE_FULL;
+				_ATMO_BLE_ONSEMI_PrepareQueueReset();
+			}
+			else
+			{
+				_ATMO_ONSEMI_BLE_PrepareQueue[_ATMO_ONSEMI_BLE_PrepareQueueLen++] = param->handle;
+			}
+		}
+	}
+	else if ( _ATMO_BLE_ONSEMI_GetCharFromCccHandle( param->handle - 1 ) != NULL )
+	{
+		length = sizeof( uint16_t );
+	}
+	else
+	{
+		status = ATT_ERR_INVALID_HANDLE;
+	}
+
+	cfm = KE_MSG_ALLOC( GATTC_ATT_INFO_CFM, KE_BUILD_ID( TASK_GATTC, conidx ),
+	                    TASK_APP, gattc_att_info_cfm );
 
+	cfm->handle = param->handle;
+	cfm->length = length;
+	cfm->status = status;
+
+	ke_msg_send( cfm );
+
+	return KE_MSG_CONSUMED;
 }
 
 static int _ATMO_BLE_ONSEMI_CmpEvt( ke_msg_id_t const msg_id,
                                     struct gattc_cmp_evt const *param, ke_task_id_t const dest_id,
                                     ke_task_id_t const src_id )
 {
+	if ( param->operation == GATTC_NOTIFY && _ATMO_ONSEMI_BLE_PendingNotifications > 0 )
+	{
+		_ATMO_ONSEMI_BLE_PendingNotifications--;
+	}
+
 	return KE_MSG_CONSUMED;
 }
 
@@ -281,6 +648,7 @@ void ATMO_ONSEMI_BLE_SyncDb()
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_PeripheralInit( ATMO_DriverInstanceData_t *instance )
 {
+	ATMO_AddTickCallback( _ATMO_ONSEMI_BLE_AdvTick );
 	return ATMO_BLE_Status_Success;
 }
 
@@ -354,9 +722,42 @@ ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_SetInitComplete()
 	return ATMO_BLE_Status_Success;
 }
 
-ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_GAPAdvertisingStartPriv( ATMO_BLE_AdvertisingParams_t *params )
+static void _ATMO_ONSEMI_BLE_MakeAdvData( uint8_t *advData, uint8_t *advDataLen, uint8_t *scanRspData, uint8_t *scanRspDataLen )
 {
-	ATMO_PLATFORM_DebugPrint( "STARTING ADV\r\n" );
+	size_t nameLen = strlen( _ATMO_ONSEMI_BLE_LocalName );
+	uint8_t *uuidData = advData;
+	uint8_t *uuidDataLen = advDataLen;
+
+	/* Set advertisement packet data (Complete Local Name). */
+	*advDataLen = 0;
+	advData[( *advDataLen )++] = 1 + nameLen;
+	advData[( *advDataLen )++] = GAP_AD_TYPE_COMPLETE_NAME;
+	memcpy( &advData[*advDataLen], _ATMO_ONSEMI_BLE_LocalName, nameLen );
+	*advDataLen += nameLen;
+
+	*scanRspDataLen = 0;
+
+	/* Broadcast payload goes into the advertisement so passive scanners see it, the UUID moves to the scan response */
+	if ( _ATMO_ONSEMI_BLE_ManufacturerDataLen > 0 )
+	{
+		advData[( *advDataLen )++] = 1 + _ATMO_ONSEMI_BLE_ManufacturerDataLen;
+		advData[( *advDataLen )++] = GAP_AD_TYPE_MANU_SPECIFIC_DATA;
+		memcpy( &advData[*advDataLen], _ATMO_ONSEMI_BLE_ManufacturerData, _ATMO_ONSEMI_BLE_ManufacturerDataLen );
+		*advDataLen += _ATMO_ONSEMI_BLE_ManufacturerDataLen;
+
+		uuidData = scanRspData;
+		uuidDataLen = scanRspDataLen;
+	}
+
+	uuidData[( *uuidDataLen )++] = 17;
+	uuidData[( *uuidDataLen )++] = GAP_AD_TYPE_MORE_128_BIT_UUID;
+	memcpy( &uuidData[*uuidDataLen], _ATMO_ONSEMI_BLE_PrimaryUuid.data, 16 );
+	*uuidDataLen += 16;
+}
+
+ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_GAPAdvertisingStartPriv( ATMO_ONSEMI_BLE_AdvPhase_t phase, uint16_t interval )
+{
+	ATMO_PLATFORM_DebugPrint( "STARTING ADV phase %d interval %d\r\n", phase, interval );
 
 	/* Prepare the GAPM_START_ADVERTISE_CMD message */
 	struct gapm_start_advertise_cmd *cmd;
@@ -367,79 +768,218 @@ ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_GAPAdvertisingStartPriv( ATMO_BLE_Advertising
 	cmd->op.addr_src = GAPM_STATIC_ADDR;
 	cmd->channel_map = ADV_ALL_CHNLS_EN;
 
-	cmd->intv_min = 64;
-	cmd->intv_max = 64;
+	cmd->intv_min = interval;
+	cmd->intv_max = interval;
 
-	cmd->op.code = GAPM_ADV_UNDIRECT;
 	cmd->op.state = 0;
+
+	if ( phase == ATMO_ONSEMI_BLE_AdvPhase_Directed )
+	{
+		/* Low duty cycle directed advertising, only the last central can connect */
+		cmd->op.code = GAPM_ADV_DIRECT_LDC;
+		memcpy( cmd->info.direct.addr.addr, _ATMO_ONSEMI_BLE_LastCentral.addr, BD_ADDR_LEN );
+		cmd->info.direct.addr_type = _ATMO_ONSEMI_BLE_LastCentral.addrType;
+
+		ke_msg_send( cmd );
+		return ATMO_BLE_Status_Success;
+	}
+
+	cmd->op.code = GAPM_ADV_UNDIRECT;
 	cmd->info.host.mode = GAP_GEN_DISCOVERABLE;
 	cmd->info.host.adv_filt_policy = ADV_ALLOW_SCAN_ANY_CON_ANY;
 
-	/* Set advertisement packet data (Complete Local Name). */
-	uint32_t currentIndex = 0;
-	cmd->info.host.adv_data[currentIndex++] = 1 + strlen( _ATMO_ONSEMI_BLE_LocalName );
-	cmd->info.host.adv_data[currentIndex++] = GAP_AD_TYPE_COMPLETE_NAME;
-	memcpy( &cmd->info.host.adv_data[currentIndex], _ATMO_ONSEMI_BLE_LocalName, strlen( _ATMO_ONSEMI_BLE_LocalName ) );
-	currentIndex += strlen( _ATMO_ONSEMI_BLE_LocalName );
+	_ATMO_ONSEMI_BLE_MakeAdvData( cmd->info.host.adv_data, &cmd->info.host.adv_data_len,
+	                              cmd->info.host.scan_rsp_data, &cmd->info.host.scan_rsp_data_len );
 
-	cmd->info.host.adv_data[currentIndex++] = 17;
-	cmd->info.host.adv_data[currentIndex++] = GAP_AD_TYPE_MORE_128_BIT_UUID;
-	memcpy( &cmd->info.host.adv_data[currentIndex], _ATMO_ONSEMI_BLE_PrimaryUuid.data, 16 );
-	currentIndex += 16;
-	cmd->info.host.adv_data_len = currentIndex;
+	/* Send the message */
+	ke_msg_send( cmd );
+	return ATMO_BLE_Status_Success;
+}
 
-	/* Set Scan Response packet data (Manufacturer Specific Data). */
-	cmd->info.host.scan_rsp_data_len = 0;
+ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_GAPAdvertisingStopPriv( void )
+{
+	struct gapm_cancel_cmd *cmd;
+
+	cmd = KE_MSG_ALLOC( GAPM_CANCEL_CMD, TASK_GAPM, TASK_APP, gapm_cancel_cmd );
+
+	cmd->operation = GAPM_CANCEL;
 
-	/* Send the message */
 	ke_msg_send( cmd );
 	return ATMO_BLE_Status_Success;
 }
 
-ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GAPAdvertisingStart( ATMO_DriverInstanceData_t *instance, ATMO_BLE_AdvertisingParams_t *params )
+static void _ATMO_ONSEMI_BLE_AdvApply( void )
 {
-	if(!_ATMO_ONSEMI_BLE_InitComplete)
+	// GAPM only runs one advertising operation, a running one is cancelled and restarted on completion
+	if ( _ATMO_ONSEMI_BLE_AdvRunning )
 	{
-		return ATMO_BLE_Status_Success;
+		_ATMO_ONSEMI_BLE_AdvRestart = true;
+
+		if ( !_ATMO_ONSEMI_BLE_AdvCancelling )
+		{
+			_ATMO_ONSEMI_BLE_AdvCancelling = true;
+			_ATMO_ONSEMI_BLE_GAPAdvertisingStopPriv();
+		}
+
+		return;
 	}
 
-	if ( _ATMO_ONSEMI_BLE_Advertising )
+	_ATMO_ONSEMI_BLE_AdvRunning = true;
+	_ATMO_ONSEMI_BLE_GAPAdvertisingStartPriv( _ATMO_ONSEMI_BLE_AdvProfile.phase, _ATMO_ONSEMI_BLE_AdvProfile.interval );
+}
+
+static void _ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_t phase )
+{
+	// Directed advertising needs an identity address, resolvable private addresses change between connections
+	if ( phase == ATMO_ONSEMI_BLE_AdvPhase_Directed && !_ATMO_ONSEMI_BLE_LastCentral.valid )
 	{
-		// Stop first
-		ATMO_ONSEMI_BLE_GAPAdvertisingStop(NULL);
-		return ATMO_BLE_Status_Success;
+		phase = ATMO_ONSEMI_BLE_AdvPhase_Fast;
 	}
 
-	_ATMO_ONSEMI_BLE_GAPAdvertisingStartPriv( params );
+	_ATMO_ONSEMI_BLE_AdvProfile.phase = phase;
+	_ATMO_ONSEMI_BLE_AdvProfile.phaseStartMs = HAL_Time();
 
-	_ATMO_ONSEMI_BLE_Advertising = true;
-	return ATMO_BLE_Status_Success;
+	switch ( phase )
+	{
+		case ATMO_ONSEMI_BLE_AdvPhase_Directed:
+			_ATMO_ONSEMI_BLE_AdvProfile.interval = ATMO_ONSEMI_BLE_ADV_DIRECTED_INTERVAL;
+			break;
+
+		case ATMO_ONSEMI_BLE_AdvPhase_Fast:
+			_ATMO_ONSEMI_BLE_AdvProfile.interval = ATMO_ONSEMI_BLE_ADV_FAST_INTERVAL;
+			break;
+
+		case ATMO_ONSEMI_BLE_AdvPhase_Reduced:
+			_ATMO_ONSEMI_BLE_AdvProfile.interval = ATMO_ONSEMI_BLE_ADV_REDUCED_INTERVAL;
+			break;
+
+		case ATMO_ONSEMI_BLE_AdvPhase_Slow:
+			_ATMO_ONSEMI_BLE_AdvProfile.interval = _ATMO_ONSEMI_BLE_AdvSlowInterval;
+			break;
+
+		default:
+			_ATMO_ONSEMI_BLE_AdvProfile.interval = 0;
+			return;
+	}
+
+	_ATMO_ONSEMI_BLE_AdvApply();
 }
 
-ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_GAPAdvertisingStopPriv( )
+static void _ATMO_ONSEMI_BLE_AdvTick( void *data )
 {
-	struct gapm_cancel_cmd *cmd;
+	if ( !_ATMO_ONSEMI_BLE_AdvEnabled || _ATMO_ONSEMI_Connected )
+	{
+		return;
+	}
 
-	cmd = KE_MSG_ALLOC( GAPM_CANCEL_CMD, TASK_GAPM, TASK_APP, gapm_cancel_cmd );
+	uint32_t elapsed = HAL_Time() - _ATMO_ONSEMI_BLE_AdvProfile.phaseStartMs;
 
-	cmd->operation = GAPM_CANCEL;
+	switch ( _ATMO_ONSEMI_BLE_AdvProfile.phase )
+	{
+		case ATMO_ONSEMI_BLE_AdvPhase_Directed:
+			if ( elapsed >= ATMO_ONSEMI_BLE_ADV_DIRECTED_DURATION_MS )
+			{
+				_ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_Fast );
+			}
 
-	ke_msg_send( cmd );
+			break;
+
+		case ATMO_ONSEMI_BLE_AdvPhase_Fast:
+			if ( elapsed >= ATMO_ONSEMI_BLE_ADV_FAST_DURATION_MS )
+			{
+				_ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_Reduced );
+			}
+
+			break;
+
+		case ATMO_ONSEMI_BLE_AdvPhase_Reduced:
+			if ( elapsed >= ATMO_ONSEMI_BLE_ADV_REDUCED_DURATION_MS )
+			{
+				_ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_Slow );
+			}
+
+			break;
+
+		default:
+			break;
+	}
+}
+
+void _ATMO_ONSEMI_BLE_AdvertisingComplete( uint8_t operation, uint8_t status )
+{
+	_ATMO_ONSEMI_BLE_AdvRunning = false;
+	_ATMO_ONSEMI_BLE_AdvCancelling = false;
+
+	if ( _ATMO_ONSEMI_BLE_AdvRestart )
+	{
+		_ATMO_ONSEMI_BLE_AdvRestart = false;
+
+		if ( _ATMO_ONSEMI_BLE_AdvEnabled && !_ATMO_ONSEMI_Connected )
+		{
+			_ATMO_ONSEMI_BLE_AdvApply();
+		}
+	}
+}
+
+void _ATMO_ONSEMI_BLE_SetLastCentral( const uint8_t *addr, uint8_t addrType )
+{
+	// Public or static random address (two most significant bits set)
+	_ATMO_ONSEMI_BLE_LastCentral.valid = ( addrType == ADDR_PUBLIC ) || ( ( addr[BD_ADDR_LEN - 1] & 0xC0 ) == 0xC0 );
+	memcpy( _ATMO_ONSEMI_BLE_LastCentral.addr, addr, BD_ADDR_LEN );
+	_ATMO_ONSEMI_BLE_LastCentral.addrType = addrType;
+}
+
+void ATMO_ONSEMI_BLE_AdvertisingBoost( void )
+{
+	if ( !_ATMO_ONSEMI_BLE_AdvEnabled || _ATMO_ONSEMI_Connected )
+	{
+		return;
+	}
+
+	_ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_Directed );
+}
+
+void ATMO_ONSEMI_BLE_GetAdvertisingProfile( ATMO_ONSEMI_BLE_AdvProfile_t *profile )
+{
+	if ( profile != NULL )
+	{
+		memcpy( profile, &_ATMO_ONSEMI_BLE_AdvProfile, sizeof( _ATMO_ONSEMI_BLE_AdvProfile ) );
+	}
+}
+
+ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GAPAdvertisingStart( ATMO_DriverInstanceData_t *instance, ATMO_BLE_AdvertisingParams_t *params )
+{
+	if ( params != NULL && params->advertisingInterval != 0 )
+	{
+		// The requested interval is used once the burst is over
+		uint32_t interval = ( ( uint32_t )params->advertisingInterval * 8 ) / 5;
+		_ATMO_ONSEMI_BLE_AdvSlowInterval = ( interval > 0x4000 ) ? 0x4000 : ( interval < ATMO_ONSEMI_BLE_ADV_FAST_INTERVAL ? ATMO_ONSEMI_BLE_ADV_FAST_INTERVAL : interval );
+	}
+
+	_ATMO_ONSEMI_BLE_AdvEnabled = true;
+
+	if ( !_ATMO_ONSEMI_BLE_InitComplete || _ATMO_ONSEMI_Connected )
+	{
+		return ATMO_BLE_Status_Success;
+	}
+
+	_ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_Directed );
 	return ATMO_BLE_Status_Success;
 }
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GAPAdvertisingStop( ATMO_DriverInstanceData_t *instance )
 {
-	_ATMO_ONSEMI_BLE_Advertising = false;
-	return ATMO_BLE_Status_Success;
+	_ATMO_ONSEMI_BLE_AdvEnabled = false;
+	_ATMO_ONSEMI_BLE_AdvRestart = false;
+	_ATMO_ONSEMI_BLE_AdvProfile.phase = ATMO_ONSEMI_BLE_AdvPhase_Off;
+	_ATMO_ONSEMI_BLE_AdvProfile.interval = 0;
 
-	if(!_ATMO_ONSEMI_BLE_Advertising)
+	if ( _ATMO_ONSEMI_BLE_AdvRunning && !_ATMO_ONSEMI_BLE_AdvCancelling )
 	{
-		return ATMO_BLE_Status_Success; 
+		_ATMO_ONSEMI_BLE_AdvCancelling = true;
+		_ATMO_ONSEMI_BLE_GAPAdvertisingStopPriv();
 	}
 
-	BDK_BLE_AdvertisingStop();
-	_ATMO_ONSEMI_BLE_Advertising = false;
 	return ATMO_BLE_Status_Success;
 }
 
@@ -452,7 +992,35 @@ ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GAPSetAdvertisedServiceUUID( ATMO_DriverInstan
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GAPAdverertisingSetManufacturerData( ATMO_DriverInstanceData_t *instance, ATMO_BLE_AdvertisingData_t *data )
 {
-	return ATMO_BLE_Status_NotSupported;
+	if ( data == NULL || data->length > ATMO_ONSEMI_BLE_MAX_MANUFACTURER_DATA_LEN || ( data->length > 0 && data->payload == NULL ) )
+	{
+		return ATMO_BLE_Status_Invalid;
+	}
+
+	if ( data->length > 0 )
+	{
+		memcpy( _ATMO_ONSEMI_BLE_ManufacturerData, data->payload, data->length );
+	}
+
+	_ATMO_ONSEMI_BLE_ManufacturerDataLen = data->length;
+
+	// Directed advertising carries no data, the next undirected phase picks it up
+	if ( !_ATMO_ONSEMI_BLE_AdvRunning || _ATMO_ONSEMI_BLE_AdvCancelling || _ATMO_ONSEMI_BLE_AdvProfile.phase == ATMO_ONSEMI_BLE_AdvPhase_Directed )
+	{
+		return ATMO_BLE_Status_Success;
+	}
+
+	/* Update the data of the running advertisement without restarting it */
+	struct gapm_update_advertise_data_cmd *cmd;
+
+	cmd = KE_MSG_ALLOC( GAPM_UPDATE_ADVERTISE_DATA_CMD, TASK_GAPM, TASK_APP,
+	                    gapm_update_advertise_data_cmd );
+	cmd->operation = GAPM_UPDATE_ADVERTISE_DATA;
+
+	_ATMO_ONSEMI_BLE_MakeAdvData( cmd->adv_data, &cmd->adv_data_len, cmd->scan_rsp_data, &cmd->scan_rsp_data_len );
+
+	ke_msg_send( cmd );
+	return ATMO_BLE_Status_Success;
 }
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GAPPairingCfg( ATMO_DriverInstanceData_t *instance, ATMO_BLE_PairingCfg_t *config )
@@ -519,7 +1087,22 @@ ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSAddCharacteristic( ATMO_DriverInstanceDat
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSGetCharacteristicValue( ATMO_DriverInstanceData_t *instance, ATMO_BLE_Handle_t handle, uint8_t *valueBuf, uint32_t valueBufLen, uint32_t *valueLen )
 {
-	return ATMO_BLE_Status_NotSupported;
+	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( handle );
+
+	if ( characteristic == NULL || valueBuf == NULL || valueLen == NULL )
+	{
+		return ATMO_BLE_Status_Fail;
+	}
+
+	if ( valueBufLen < characteristic->currentLength )
+	{
+		*valueLen = characteristic->currentLength;
+		return ATMO_BLE_Status_Invalid;
+	}
+
+	memcpy( valueBuf, characteristic->data, characteristic->currentLength );
+	*valueLen = characteristic->currentLength;
+	return ATMO_BLE_Status_Success;
 }
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSRegisterCharacteristicCallback( ATMO_DriverInstanceData_t *instance,  ATMO_BLE_Handle_t handle, ATMO_BLE_Characteristic_Event_t event, ATMO_Callback_t cbFunc )
@@ -540,6 +1123,51 @@ ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSRegisterCharacteristicCallback( ATMO_Driv
 	return ATMO_BLE_Status_Success;
 }
 
+ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSRegisterWriteCommandHandler( ATMO_DriverInstanceData_t *instance, ATMO_BLE_Handle_t handle, ATMO_BLE_WriteCommandHandler_t handler )
+{
+	if ( _ATMO_BLE_ONSEMI_GetCharFromHandle( handle ) == NULL )
+	{
+		return ATMO_BLE_Status_Fail;
+	}
+
+	uint16_t attHandle = handle + 1;
+
+	for ( unsigned int i = 0; i < _ATMO_ONSEMI_BLE_NumWriteCommandHandlers; i++ )
+	{
+		if ( _ATMO_ONSEMI_BLE_WriteCommandHandlers[i].attHandle != attHandle )
+		{
+			continue;
+		}
+
+		if ( handler != NULL )
+		{
+			_ATMO_ONSEMI_BLE_WriteCommandHandlers[i].handler = handler;
+		}
+		else
+		{
+			_ATMO_ONSEMI_BLE_WriteCommandHandlers[i] = _ATMO_ONSEMI_BLE_WriteCommandHandlers[--_ATMO_ONSEMI_BLE_NumWriteCommandHandlers];
+		}
+
+		return ATMO_BLE_Status_Success;
+	}
+
+	if ( handler == NULL )
+	{
+		return ATMO_BLE_Status_Success;
+	}
+
+	if ( _ATMO_ONSEMI_BLE_NumWriteCommandHandlers >= ATMO_ONSEMI_BLE_MAX_WRITE_COMMAND_HANDLERS )
+	{
+		return ATMO_BLE_Status_Fail;
+	}
+
+	_ATMO_ONSEMI_BLE_WriteCommandHandlers[_ATMO_ONSEMI_BLE_NumWriteCommandHandlers].attHandle = attHandle;
+	_ATMO_ONSEMI_BLE_WriteCommandHandlers[_ATMO_ONSEMI_BLE_NumWriteCommandHandlers].handler = handler;
+	_ATMO_ONSEMI_BLE_NumWriteCommandHandlers++;
+
+	return ATMO_BLE_Status_Success;
+}
+
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSRegisterCharacteristicAbilityHandle( ATMO_DriverInstanceData_t *instance, ATMO_BLE_Handle_t handle, ATMO_BLE_Characteristic_Event_t event, unsigned int abilityHandler )
 {
 	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( handle );
@@ -584,6 +1212,48 @@ ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSSendIndicate( ATMO_DriverInstanceData_t *
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSSendNotify( ATMO_DriverInstanceData_t *instance, ATMO_BLE_Handle_t handle, uint16_t size, uint8_t *value )
 {
+	int conidx = BDK_BLE_GetConIdx();
+	struct gattc_send_evt_cmd *cmd;
+	_ATMO_ONSEMI_BLE_Characteristic_t *characteristic = _ATMO_BLE_ONSEMI_GetCharFromHandle( handle );
+
+	if ( characteristic == NULL )
+	{
+		return ATMO_BLE_Status_Fail;
+	}
+
+	if ( value != NULL )
+	{
+		if ( size > characteristic->maxLength )
+		{
+			return ATMO_BLE_Status_Invalid;
+		}
+
+		memcpy( characteristic->data, value, size );
+		characteristic->currentLength = size;
+	}
+
+	if ( conidx == INVALID_DEV_IDX || !( characteristic->cccValue & ATT_CCC_START_NTF ) )
+	{
+		return ATMO_BLE_Status_Invalid;
+	}
+
+	// Bound the number of queued notifications so a fast producer can't drain the kernel heap
+	if ( _ATMO_ONSEMI_BLE_PendingNotifications >= ATMO_ONSEMI_BLE_MAX_PENDING_NOTIFICATIONS )
+	{
+		return ATMO_BLE_Status_Busy;
+	}
+
+	cmd = KE_MSG_ALLOC_DYN( GATTC_SEND_EVT_CMD, KE_BUILD_ID( TASK_GATTC, conidx ),
+	                        TASK_APP, gattc_send_evt_cmd, characteristic->currentLength );
+	cmd->handle = characteristic->handle + 1;
+	cmd->operation = GATTC_NOTIFY;
+	cmd->seq_num = _ATMO_ONSEMI_BLE_NotifySeqNum++;
+	cmd->length = characteristic->currentLength;
+	memcpy( cmd->value, characteristic->data, characteristic->currentLength );
+
+	ke_msg_send( cmd );
+	_ATMO_ONSEMI_BLE_PendingNotifications++;
+
 	return ATMO_BLE_Status_Success;
 }
 
@@ -616,10 +1286,35 @@ void ATMO_ONSEMI_BLE_DispatchEvent( ATMO_BLE_Event_t event )
 	if(event == ATMO_BLE_EVENT_Connected)
 	{
 		_ATMO_ONSEMI_Connected = true;
+
+		// The controller stops advertising once connected
+		_ATMO_ONSEMI_BLE_AdvRestart = false;
+		_ATMO_ONSEMI_BLE_AdvProfile.phase = ATMO_ONSEMI_BLE_AdvPhase_Off;
+		_ATMO_ONSEMI_BLE_AdvProfile.interval = 0;
 	}
 	else if(event == ATMO_BLE_EVENT_Disconnected)
 	{
 		_ATMO_ONSEMI_Connected = false;
+		_ATMO_ONSEMI_BLE_PendingNotifications = 0;
+
+		// Executed chunks were confirmed, prepared ones are discarded by the stack on disconnect
+		_ATMO_BLE_ONSEMI_PrepareQueueFinish();
+		_ATMO_BLE_ONSEMI_PrepareQueueReset();
+
+		// Subscriptions do not survive the connection
+		for ( unsigned int i = 0; i < _ATMO_ONSEMI_BLE_NumServices; i++ )
+		{
+			for ( unsigned int j = 0; j < _ATMO_ONSEMI_BLE_Services[i].numCharacteristics; j++ )
+			{
+				_ATMO_ONSEMI_BLE_Services[i].characteristicDesc[j].cccValue = 0;
+			}
+		}
+
+		// Fast reconnect burst, unless the application takes over advertising from the event callbacks
+		if ( _ATMO_ONSEMI_BLE_AdvEnabled )
+		{
+			_ATMO_ONSEMI_BLE_AdvEnterPhase( ATMO_ONSEMI_BLE_AdvPhase_Directed );
+		}
 	}
 
 	for ( unsigned int i = 0; i < _ATMO_ONSEMI_BLE_NumEventAbilities[event]; i++ )
@@ -51,6 +51,27 @@ extern "C" {
 
 /* Exported Types ------------------------------------------------------------*/
 
+/**
+ * Phases of the advertising schedule. Every (re)start of advertising begins with a
+ * burst (directed towards the last central if possible), then steps back to the slow
+ * interval requested by the application.
+ */
+typedef enum
+{
+	ATMO_ONSEMI_BLE_AdvPhase_Off,
+	ATMO_ONSEMI_BLE_AdvPhase_Directed,
+	ATMO_ONSEMI_BLE_AdvPhase_Fast,
+	ATMO_ONSEMI_BLE_AdvPhase_Reduced,
+	ATMO_ONSEMI_BLE_AdvPhase_Slow,
+} ATMO_ONSEMI_BLE_AdvPhase_t;
+
+typedef struct
+{
+	ATMO_ONSEMI_BLE_AdvPhase_t phase;
+	uint16_t interval;        /**< Current advertising interval in units of 0.625 ms */
+	uint32_t phaseStartMs;    /**< Time the current phase was entered */
+} ATMO_ONSEMI_BLE_AdvProfile_t;
+
 ATMO_Status_t ATMO_ONSEMI_BLE_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber );
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_PeripheralInit( ATMO_DriverInstanceData_t *instance );
@@ -99,12 +120,30 @@ ATMO_BLE_Status_t ATMO_ONSEMI_BLE_RegisterEventCallback( ATMO_DriverInstanceData
 
 ATMO_BLE_Status_t ATMO_ONSEMI_BLE_RegisterEventAbilityHandle( ATMO_DriverInstanceData_t *instance, ATMO_BLE_Event_t event, unsigned int abilityHandle );
 
+ATMO_BLE_Status_t ATMO_ONSEMI_BLE_GATTSRegisterWriteCommandHandler( ATMO_DriverInstanceData_t *instance, ATMO_BLE_Handle_t handle, ATMO_BLE_WriteCommandHandler_t handler );
+
 void ATMO_ONSEMI_BLE_SyncDb();
 
 void ATMO_ONSEMI_BLE_DispatchEvent( ATMO_BLE_Event_t event );
 
 ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_SetInitComplete();
 
+/**
+ * Restart the advertising schedule with a burst, e.g. on user interaction.
+ */
+void ATMO_ONSEMI_BLE_AdvertisingBoost( void );
+
+/**
+ * Get the current advertising phase and interval, e.g. to correlate with a power profile.
+ */
+void ATMO_ONSEMI_BLE_GetAdvertisingProfile( ATMO_ONSEMI_BLE_AdvProfile_t *profile );
+
+void _ATMO_ONSEMI_BLE_AdvertisingComplete( uint8_t operation, uint8_t status );
+
+void _ATMO_ONSEMI_BLE_SetLastCentral( const uint8_t *addr, uint8_t addrType );
+
+ATMO_BLE_Status_t _ATMO_ONSEMI_BLE_GAPAdvertisingStopPriv( void );
+
 
 #ifdef __cplusplus
 }
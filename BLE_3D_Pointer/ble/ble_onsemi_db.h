@@ -40,15 +40,39 @@
 
 #define ATMO_ONSEMI_BLE_MAX_ABILITIES_PER_EVENT 5
 
+#define ATMO_ONSEMI_BLE_MAX_PENDING_NOTIFICATIONS 4
+
+#define ATMO_ONSEMI_BLE_MAX_WRITE_COMMAND_HANDLERS 4
+
+/* Reassembly buffers for prepared (long) writes */
+#define ATMO_ONSEMI_BLE_NUM_LONG_WRITE_BUFFERS 2
+#define ATMO_ONSEMI_BLE_LONG_WRITE_BUFFER_SIZE 256
+
+/* Prepared chunks queued across all characteristics, a full buffer takes 15 at the default MTU */
+#define ATMO_ONSEMI_BLE_MAX_PREPARED_WRITES 32
+
+/* Manufacturer specific data payload (including company ID) that still fits next to the local name */
+#define ATMO_ONSEMI_BLE_MAX_MANUFACTURER_DATA_LEN 18
+
+/* Adaptive advertising schedule. Intervals are in units of 0.625 ms, durations in ms. */
+#define ATMO_ONSEMI_BLE_ADV_DIRECTED_INTERVAL 32
+#define ATMO_ONSEMI_BLE_ADV_DIRECTED_DURATION_MS 2000
+#define ATMO_ONSEMI_BLE_ADV_FAST_INTERVAL 32
+#define ATMO_ONSEMI_BLE_ADV_FAST_DURATION_MS 30000
+#define ATMO_ONSEMI_BLE_ADV_REDUCED_INTERVAL 244
+#define ATMO_ONSEMI_BLE_ADV_REDUCED_DURATION_MS 60000
+#define ATMO_ONSEMI_BLE_ADV_SLOW_INTERVAL 1636
+
 typedef struct {
     uint8_t *data;
-    uint8_t maxLength;
-    uint8_t currentLength;
+    uint16_t maxLength;
+    uint16_t currentLength;
     uint8_t handle;
     ATMO_AbilityHandle_t ability[ATMO_BLE_Characteristic_NumEvents][ATMO_ONSEMI_BLE_MAX_ABILITIES_PER_EVENT];
     uint8_t numAbilities[ATMO_BLE_Characteristic_NumEvents];
     ATMO_Callback_t callbacks[ATMO_BLE_Characteristic_NumEvents][ATMO_ONSEMI_BLE_MAX_ABILITIES_PER_EVENT];
     uint8_t numCallbacks[ATMO_BLE_Characteristic_NumEvents];
+    uint16_t cccValue;
 } _ATMO_ONSEMI_BLE_Characteristic_t;
 
 /**
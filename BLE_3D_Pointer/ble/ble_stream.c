@@ -0,0 +1,752 @@
+/**
+ ******************************************************************************
+ * @file    ble_stream.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - BLE sensor streaming service
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "ble_stream.h"
+#include "../app_src/atmosphere_platform.h"
+#include "../sensorlog/sensorlog.h"
+#include "../atmo/atmo_samplecodec.h"
+
+typedef struct
+{
+	ATMO_BOOL_t enabled;
+	ATMO_BOOL_t primed;
+	uint16_t rateHz;
+	uint32_t lastSampleMs;
+	uint32_t frameStartMs;
+	uint8_t numSamples;
+	uint8_t frameUsed; /**< Bytes of the frame filled, header included */
+	ATMO_SAMPLECODEC_State_t codec;
+	uint8_t frame[ATMO_BLE_STREAM_MAX_FRAME_LEN];
+} __ATMO_BLE_STREAM_Sensor_t;
+
+typedef struct
+{
+	ATMO_BOOL_t active;
+	uint8_t sensorId;
+	uint32_t toMs;
+	ATMO_SENSORLOG_Cursor_t cursor;
+	ATMO_BOOL_t hasHeld;
+	ATMO_SENSORLOG_Sample_t held; /**< Read already, but too far from the start of the previous frame */
+	uint16_t frameLen; /**< Frame waiting for room in the notification queue, 0 if none */
+	uint16_t sequence; /**< Sequence of the next log frame, restarts at 0 for every read */
+	uint32_t samplesSent;
+	uint8_t frame[ATMO_BLE_STREAM_MAX_FRAME_LEN];
+} __ATMO_BLE_STREAM_LogRead_t;
+
+static ATMO_BLE_STREAM_Config_t __ATMO_BLE_STREAM_Config;
+static ATMO_BLE_Handle_t __ATMO_BLE_STREAM_ServiceHandle;
+static ATMO_BLE_Handle_t __ATMO_BLE_STREAM_DataHandle;
+static ATMO_BLE_Handle_t __ATMO_BLE_STREAM_ControlHandle;
+
+static ATMO_BOOL_t __ATMO_BLE_STREAM_Initialized = false;
+static ATMO_BOOL_t __ATMO_BLE_STREAM_Subscribed = false;
+static uint8_t __ATMO_BLE_STREAM_FrameLen = ATMO_BLE_STREAM_DEFAULT_FRAME_LEN;
+static uint16_t __ATMO_BLE_STREAM_MaxLatencyMs = ATMO_BLE_STREAM_DEFAULT_MAX_LATENCY_MS;
+static ATMO_BLE_STREAM_Encoding_t __ATMO_BLE_STREAM_Encoding = ATMO_BLE_STREAM_Encoding_Raw;
+static ATMO_BLE_STREAM_Stats_t __ATMO_BLE_STREAM_Stats;
+
+static __ATMO_BLE_STREAM_Sensor_t __ATMO_BLE_STREAM_Sensors[ATMO_BLE_STREAM_MAX_SENSORS];
+static __ATMO_BLE_STREAM_LogRead_t __ATMO_BLE_STREAM_LogRead;
+
+static void __ATMO_BLE_STREAM_PutU16( uint8_t *buf, uint16_t val )
+{
+	buf[0] = val & 0xFF;
+	buf[1] = ( val >> 8 ) & 0xFF;
+}
+
+static void __ATMO_BLE_STREAM_PutU32( uint8_t *buf, uint32_t val )
+{
+	buf[0] = val & 0xFF;
+	buf[1] = ( val >> 8 ) & 0xFF;
+	buf[2] = ( val >> 16 ) & 0xFF;
+	buf[3] = ( val >> 24 ) & 0xFF;
+}
+
+/**
+ * @return true if frames of this length hold at least one sample, of the log read too if one is running
+ */
+static ATMO_BOOL_t __ATMO_BLE_STREAM_FrameLenValid( uint32_t frameLen, ATMO_BLE_STREAM_Encoding_t encoding )
+{
+	if ( frameLen > ATMO_BLE_STREAM_MAX_FRAME_LEN )
+	{
+		return false;
+	}
+
+	if ( encoding == ATMO_BLE_STREAM_Encoding_Delta )
+	{
+		return frameLen >= ATMO_BLE_STREAM_MIN_DELTA_FRAME_LEN;
+	}
+
+	if ( __ATMO_BLE_STREAM_LogRead.active )
+	{
+		return frameLen >= ( ATMO_BLE_STREAM_HEADER_LEN + ATMO_BLE_STREAM_LOG_SAMPLE_LEN );
+	}
+
+	return frameLen >= ( ATMO_BLE_STREAM_HEADER_LEN + ATMO_BLE_STREAM_SAMPLE_LEN );
+}
+
+/**
+ * @return smallest sample that can still be added to a frame
+ */
+static uint8_t __ATMO_BLE_STREAM_MinSampleLen( void )
+{
+	return ( __ATMO_BLE_STREAM_Encoding == ATMO_BLE_STREAM_Encoding_Delta ) ? ATMO_SAMPLECODEC_MIN_SAMPLE_LEN : ATMO_BLE_STREAM_SAMPLE_LEN;
+}
+
+/**
+ * Add a sample to a live frame.
+ *
+ * @return false if the sample doesn't fit
+ */
+static ATMO_BOOL_t __ATMO_BLE_STREAM_AddSample( __ATMO_BLE_STREAM_Sensor_t *sensor, const ATMO_SAMPLECODEC_Sample_t *sample )
+{
+	uint8_t *out = &sensor->frame[sensor->frameUsed];
+	unsigned int room = __ATMO_BLE_STREAM_FrameLen - sensor->frameUsed;
+
+	if ( sensor->numSamples == 0 )
+	{
+		sensor->frameStartMs = sample->timeMs;
+		ATMO_SAMPLECODEC_Reset( &sensor->codec, sample->timeMs );
+	}
+
+	if ( __ATMO_BLE_STREAM_Encoding == ATMO_BLE_STREAM_Encoding_Delta )
+	{
+		unsigned int len = ATMO_SAMPLECODEC_Encode( &sensor->codec, sample, out, room );
+
+		if ( len == 0 )
+		{
+			return false;
+		}
+
+		sensor->frameUsed += len;
+	}
+	else
+	{
+		if ( room < ATMO_BLE_STREAM_SAMPLE_LEN )
+		{
+			return false;
+		}
+
+		__ATMO_BLE_STREAM_PutU16( &out[0], ( uint16_t )sample->x );
+		__ATMO_BLE_STREAM_PutU16( &out[2], ( uint16_t )sample->y );
+		__ATMO_BLE_STREAM_PutU16( &out[4], ( uint16_t )sample->z );
+		sensor->frameUsed += ATMO_BLE_STREAM_SAMPLE_LEN;
+	}
+
+	sensor->numSamples++;
+	return true;
+}
+
+static void __ATMO_BLE_STREAM_FlushSensor( uint8_t sensorId )
+{
+	__ATMO_BLE_STREAM_Sensor_t *sensor = &__ATMO_BLE_STREAM_Sensors[sensorId];
+
+	if ( sensor->numSamples == 0 )
+	{
+		return;
+	}
+
+	// The sequence number is consumed even if the frame can't be sent so the central sees the loss
+	__ATMO_BLE_STREAM_PutU16( &sensor->frame[0], __ATMO_BLE_STREAM_Stats.nextSequence++ );
+	sensor->frame[2] = sensorId;
+
+	if ( __ATMO_BLE_STREAM_Encoding == ATMO_BLE_STREAM_Encoding_Delta )
+	{
+		sensor->frame[2] |= ATMO_BLE_STREAM_DELTA_FRAME_FLAG;
+	}
+
+	sensor->frame[3] = sensor->numSamples;
+	__ATMO_BLE_STREAM_PutU32( &sensor->frame[4], sensor->frameStartMs );
+
+	uint16_t frameLen = sensor->frameUsed;
+	sensor->numSamples = 0;
+	sensor->frameUsed = ATMO_BLE_STREAM_HEADER_LEN;
+
+	if ( __ATMO_BLE_STREAM_Subscribed &&
+	        ATMO_BLE_GATTSSendNotify( __ATMO_BLE_STREAM_Config.bleInstance, __ATMO_BLE_STREAM_DataHandle, frameLen, sensor->frame ) == ATMO_BLE_Status_Success )
+	{
+		__ATMO_BLE_STREAM_Stats.framesSent++;
+	}
+	else
+	{
+		__ATMO_BLE_STREAM_Stats.framesDropped++;
+	}
+}
+
+static void __ATMO_BLE_STREAM_SetRate( uint8_t sensorId, uint16_t rateHz )
+{
+	if ( __ATMO_BLE_STREAM_Config.rateHandler != NULL )
+	{
+		__ATMO_BLE_STREAM_Config.rateHandler( sensorId, rateHz );
+	}
+}
+
+static void __ATMO_BLE_STREAM_SendResponse( uint8_t *data, uint16_t dataLen );
+
+/**
+ * Fill the log frame with the next samples of the requested range.
+ *
+ * @return frame length, 0 once the range is done
+ */
+static uint16_t __ATMO_BLE_STREAM_BuildLogFrame( void )
+{
+	__ATMO_BLE_STREAM_LogRead_t *logRead = &__ATMO_BLE_STREAM_LogRead;
+	ATMO_BOOL_t delta = ( __ATMO_BLE_STREAM_Encoding == ATMO_BLE_STREAM_Encoding_Delta );
+	ATMO_SAMPLECODEC_State_t codec;
+	uint16_t frameLen = ATMO_BLE_STREAM_HEADER_LEN;
+	uint8_t numSamples = 0;
+	uint32_t firstMs = 0;
+
+	while ( __ATMO_BLE_STREAM_FrameLen - frameLen >= ( delta ? ATMO_SAMPLECODEC_MIN_SAMPLE_LEN : ATMO_BLE_STREAM_LOG_SAMPLE_LEN ) )
+	{
+		ATMO_SENSORLOG_Sample_t sample;
+		uint32_t numRead = 0;
+
+		if ( logRead->hasHeld )
+		{
+			sample = logRead->held;
+			logRead->hasHeld = false;
+		}
+		else if ( ATMO_SENSORLOG_Read( &logRead->cursor, logRead->toMs, &sample, 1, &numRead ) != ATMO_SENSORLOG_Status_Success )
+		{
+			break;
+		}
+
+		if ( numSamples == 0 )
+		{
+			firstMs = sample.timeMs;
+			ATMO_SAMPLECODEC_Reset( &codec, firstMs );
+		}
+
+		uint8_t *out = &logRead->frame[frameLen];
+		unsigned int len = 0;
+
+		if ( delta )
+		{
+			len = ATMO_SAMPLECODEC_Encode( &codec, &sample, out, __ATMO_BLE_STREAM_FrameLen - frameLen );
+		}
+		else if ( sample.timeMs - firstMs <= 0xFFFF )
+		{
+			__ATMO_BLE_STREAM_PutU16( &out[0], ( uint16_t )( sample.timeMs - firstMs ) );
+			__ATMO_BLE_STREAM_PutU16( &out[2], ( uint16_t )sample.x );
+			__ATMO_BLE_STREAM_PutU16( &out[4], ( uint16_t )sample.y );
+			__ATMO_BLE_STREAM_PutU16( &out[6], ( uint16_t )sample.z );
+			len = ATMO_BLE_STREAM_LOG_SAMPLE_LEN;
+		}
+
+		if ( len == 0 )
+		{
+			// The sample doesn't fit, it starts the next frame
+			logRead->held = sample;
+			logRead->hasHeld = true;
+			break;
+		}
+
+		frameLen += len;
+		numSamples++;
+	}
+
+	if ( numSamples == 0 )
+	{
+		return 0;
+	}
+
+	__ATMO_BLE_STREAM_PutU16( &logRead->frame[0], logRead->sequence++ );
+	logRead->frame[2] = logRead->sensorId | ATMO_BLE_STREAM_LOG_FRAME_FLAG | ( delta ? ATMO_BLE_STREAM_DELTA_FRAME_FLAG : 0 );
+	logRead->frame[3] = numSamples;
+	__ATMO_BLE_STREAM_PutU32( &logRead->frame[4], firstMs );
+
+	return frameLen;
+}
+
+static void __ATMO_BLE_STREAM_FinishLogRead( ATMO_BLE_STREAM_Status_t status )
+{
+	uint8_t response[6];
+
+	__ATMO_BLE_STREAM_LogRead.active = false;
+
+	response[0] = ATMO_BLE_STREAM_Command_ReadLog;
+	response[1] = status;
+	__ATMO_BLE_STREAM_PutU32( &response[2], __ATMO_BLE_STREAM_LogRead.samplesSent );
+	__ATMO_BLE_STREAM_SendResponse( response, sizeof( response ) );
+}
+
+/**
+ * Queue log frames until the notification queue is full.
+ */
+static void __ATMO_BLE_STREAM_PumpLogRead( void )
+{
+	__ATMO_BLE_STREAM_LogRead_t *logRead = &__ATMO_BLE_STREAM_LogRead;
+
+	while ( logRead->active )
+	{
+		if ( !__ATMO_BLE_STREAM_Subscribed )
+		{
+			__ATMO_BLE_STREAM_FinishLogRead( ATMO_BLE_STREAM_Status_Fail );
+			return;
+		}
+
+		if ( logRead->frameLen == 0 )
+		{
+			logRead->frameLen = __ATMO_BLE_STREAM_BuildLogFrame();
+
+			if ( logRead->frameLen == 0 )
+			{
+				__ATMO_BLE_STREAM_FinishLogRead( ATMO_BLE_STREAM_Status_Success );
+				return;
+			}
+		}
+
+		ATMO_BLE_Status_t status = ATMO_BLE_GATTSSendNotify( __ATMO_BLE_STREAM_Config.bleInstance, __ATMO_BLE_STREAM_DataHandle, logRead->frameLen, logRead->frame );
+
+		// Try the same frame again on the next tick
+		if ( status == ATMO_BLE_Status_Busy )
+		{
+			return;
+		}
+
+		if ( status != ATMO_BLE_Status_Success )
+		{
+			__ATMO_BLE_STREAM_FinishLogRead( ATMO_BLE_STREAM_Status_Fail );
+			return;
+		}
+
+		__ATMO_BLE_STREAM_Stats.framesSent++;
+		logRead->samplesSent += logRead->frame[3];
+		logRead->frameLen = 0;
+	}
+}
+
+static void __ATMO_BLE_STREAM_Tick( void *data )
+{
+	uint32_t now = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+
+	for ( uint8_t i = 0; i < ATMO_BLE_STREAM_MAX_SENSORS; i++ )
+	{
+		__ATMO_BLE_STREAM_Sensor_t *sensor = &__ATMO_BLE_STREAM_Sensors[i];
+
+		if ( sensor->enabled && sensor->numSamples > 0 && ( now - sensor->frameStartMs ) >= __ATMO_BLE_STREAM_MaxLatencyMs )
+		{
+			__ATMO_BLE_STREAM_FlushSensor( i );
+		}
+	}
+
+	__ATMO_BLE_STREAM_PumpLogRead();
+}
+
+static void __ATMO_BLE_STREAM_SendResponse( uint8_t *data, uint16_t dataLen )
+{
+	ATMO_BLE_GATTSSetCharacteristic( __ATMO_BLE_STREAM_Config.bleInstance, __ATMO_BLE_STREAM_ControlHandle, dataLen, data, NULL );
+	ATMO_BLE_GATTSSendNotify( __ATMO_BLE_STREAM_Config.bleInstance, __ATMO_BLE_STREAM_ControlHandle, dataLen, data );
+}
+
+static void __ATMO_BLE_STREAM_ControlWrittenCallback( void *value )
+{
+	ATMO_Value_t *currentValue = ( ATMO_Value_t * )value;
+
+	if ( currentValue == NULL || currentValue->type != ATMO_DATATYPE_BINARY )
+	{
+		return;
+	}
+
+	ATMO_BLE_STREAM_HandleCommand( ( const uint8_t * )currentValue->data, currentValue->size );
+}
+
+/* Fast path, runs in the BLE stack context without a copy into an ATMO_Value_t */
+static void __ATMO_BLE_STREAM_ControlWriteCommand( ATMO_BLE_Handle_t handle, const uint8_t *data, uint16_t length )
+{
+	ATMO_BLE_STREAM_HandleCommand( data, length );
+}
+
+static void __ATMO_BLE_STREAM_SubscribedCallback( void *value )
+{
+	__ATMO_BLE_STREAM_Subscribed = true;
+}
+
+static void __ATMO_BLE_STREAM_UnsubscribedCallback( void *value )
+{
+	__ATMO_BLE_STREAM_Subscribed = false;
+}
+
+static void __ATMO_BLE_STREAM_DisconnectedCallback( void *value )
+{
+	__ATMO_BLE_STREAM_Subscribed = false;
+	ATMO_BLE_STREAM_StopAll();
+}
+
+ATMO_BLE_STREAM_Status_t ATMO_BLE_STREAM_Init( ATMO_BLE_STREAM_Config_t *config )
+{
+	if ( config == NULL )
+	{
+		return ATMO_BLE_STREAM_Status_Invalid;
+	}
+
+	memcpy( &__ATMO_BLE_STREAM_Config, config, sizeof( __ATMO_BLE_STREAM_Config ) );
+	memset( __ATMO_BLE_STREAM_Sensors, 0, sizeof( __ATMO_BLE_STREAM_Sensors ) );
+	memset( &__ATMO_BLE_STREAM_LogRead, 0, sizeof( __ATMO_BLE_STREAM_LogRead ) );
+	memset( &__ATMO_BLE_STREAM_Stats, 0, sizeof( __ATMO_BLE_STREAM_Stats ) );
+
+	for ( uint8_t i = 0; i < ATMO_BLE_STREAM_MAX_SENSORS; i++ )
+	{
+		__ATMO_BLE_STREAM_Sensors[i].rateHz = config->defaultRateHz;
+		__ATMO_BLE_STREAM_Sensors[i].frameUsed = ATMO_BLE_STREAM_HEADER_LEN;
+	}
+
+	if ( ATMO_BLE_GATTSAddService( config->bleInstance, &__ATMO_BLE_STREAM_ServiceHandle, ATMO_BLE_STREAM_SERVICE_UUID ) != ATMO_BLE_Status_Success )
+	{
+		return ATMO_BLE_STREAM_Status_Fail;
+	}
+
+	if ( ATMO_BLE_GATTSAddCharacteristic(
+	            config->bleInstance,
+	            &__ATMO_BLE_STREAM_DataHandle,
+	            __ATMO_BLE_STREAM_ServiceHandle,
+	            ATMO_BLE_STREAM_DATA_CHARACTERISTIC_UUID,
+	            ATMO_BLE_Property_Read | ATMO_BLE_Property_Notify, ATMO_BLE_Permission_Read, ATMO_BLE_STREAM_MAX_FRAME_LEN ) != ATMO_BLE_Status_Success )
+	{
+		return ATMO_BLE_STREAM_Status_Fail;
+	}
+
+	if ( ATMO_BLE_GATTSAddCharacteristic(
+	            config->bleInstance,
+	            &__ATMO_BLE_STREAM_ControlHandle,
+	            __ATMO_BLE_STREAM_ServiceHandle,
+	            ATMO_BLE_STREAM_CONTROL_CHARACTERISTIC_UUID,
+	            ATMO_BLE_Property_Read | ATMO_BLE_Property_Write | ATMO_BLE_Property_WriteWithoutResponse | ATMO_BLE_Property_Notify,
+	            ATMO_BLE_Permission_Read | ATMO_BLE_Permission_Write, ATMO_BLE_STREAM_CONTROL_LEN ) != ATMO_BLE_Status_Success )
+	{
+		return ATMO_BLE_STREAM_Status_Fail;
+	}
+
+	ATMO_BLE_GATTSRegisterCharacteristicCallback( config->bleInstance, __ATMO_BLE_STREAM_ControlHandle,
+	        ATMO_BLE_Characteristic_Written, __ATMO_BLE_STREAM_ControlWrittenCallback );
+
+	// Drivers without a write command fast path keep dispatching through the written callback
+	ATMO_BLE_GATTSRegisterWriteCommandHandler( config->bleInstance, __ATMO_BLE_STREAM_ControlHandle, __ATMO_BLE_STREAM_ControlWriteCommand );
+
+	ATMO_BLE_GATTSRegisterCharacteristicCallback( config->bleInstance, __ATMO_BLE_STREAM_DataHandle,
+	        ATMO_BLE_Characteristic_Subscribed, __ATMO_BLE_STREAM_SubscribedCallback );
+	ATMO_BLE_GATTSRegisterCharacteristicCallback( config->bleInstance, __ATMO_BLE_STREAM_DataHandle,
+	        ATMO_BLE_Characteristic_Unsubscribed, __ATMO_BLE_STREAM_UnsubscribedCallback );
+	ATMO_BLE_RegisterEventCallback( config->bleInstance, ATMO_BLE_EVENT_Disconnected, __ATMO_BLE_STREAM_DisconnectedCallback );
+
+	ATMO_AddTickCallback( __ATMO_BLE_STREAM_Tick );
+
+	__ATMO_BLE_STREAM_Initialized = true;
+
+	return ATMO_BLE_STREAM_Status_Success;
+}
+
+void ATMO_BLE_STREAM_PushSample( uint8_t sensorId, int16_t x, int16_t y, int16_t z )
+{
+	if ( !__ATMO_BLE_STREAM_Initialized || sensorId >= ATMO_BLE_STREAM_MAX_SENSORS )
+	{
+		return;
+	}
+
+	__ATMO_BLE_STREAM_Sensor_t *sensor = &__ATMO_BLE_STREAM_Sensors[sensorId];
+
+	if ( !sensor->enabled )
+	{
+		return;
+	}
+
+	uint32_t now = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+
+	// Decimate down to the requested rate, allowing a quarter period of jitter
+	if ( sensor->primed && sensor->rateHz > 0 )
+	{
+		uint32_t periodMs = 1000 / sensor->rateHz;
+
+		if ( ( now - sensor->lastSampleMs ) + ( periodMs / 4 ) < periodMs )
+		{
+			return;
+		}
+	}
+
+	sensor->primed = true;
+	sensor->lastSampleMs = now;
+
+	ATMO_SAMPLECODEC_Sample_t sample = { now, x, y, z };
+
+	// A frame that is too full for this sample goes out first, any sample fits an empty one
+	if ( !__ATMO_BLE_STREAM_AddSample( sensor, &sample ) )
+	{
+		__ATMO_BLE_STREAM_FlushSensor( sensorId );
+		__ATMO_BLE_STREAM_AddSample( sensor, &sample );
+	}
+
+	if ( __ATMO_BLE_STREAM_FrameLen - sensor->frameUsed < __ATMO_BLE_STREAM_MinSampleLen() )
+	{
+		__ATMO_BLE_STREAM_FlushSensor( sensorId );
+	}
+}
+
+ATMO_BLE_STREAM_Status_t ATMO_BLE_STREAM_HandleCommand( const uint8_t *data, uint32_t dataLen )
+{
+	uint8_t response[14] = {0};
+	uint16_t responseLen = 2;
+	ATMO_BLE_STREAM_Status_t status = ATMO_BLE_STREAM_Status_Success;
+
+	if ( data == NULL || dataLen < 1 )
+	{
+		return ATMO_BLE_STREAM_Status_Invalid;
+	}
+
+	response[0] = data[0];
+
+	switch ( data[0] )
+	{
+		case ATMO_BLE_STREAM_Command_Start:
+		case ATMO_BLE_STREAM_Command_Stop:
+		{
+			if ( dataLen < 2 )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			ATMO_BOOL_t enable = ( data[0] == ATMO_BLE_STREAM_Command_Start );
+
+			for ( uint8_t i = 0; i < ATMO_BLE_STREAM_MAX_SENSORS; i++ )
+			{
+				if ( !( data[1] & ( 1 << i ) ) || __ATMO_BLE_STREAM_Sensors[i].enabled == enable )
+				{
+					continue;
+				}
+
+				if ( !enable )
+				{
+					__ATMO_BLE_STREAM_FlushSensor( i );
+				}
+
+				__ATMO_BLE_STREAM_Sensors[i].enabled = enable;
+				__ATMO_BLE_STREAM_Sensors[i].primed = false;
+				__ATMO_BLE_STREAM_SetRate( i, enable ? __ATMO_BLE_STREAM_Sensors[i].rateHz : 0 );
+			}
+
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_SetRate:
+		{
+			if ( dataLen < 4 || data[1] >= ATMO_BLE_STREAM_MAX_SENSORS )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			uint16_t rateHz = data[2] | ( data[3] << 8 );
+
+			if ( rateHz == 0 || rateHz > 1000 )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			__ATMO_BLE_STREAM_Sensors[data[1]].rateHz = rateHz;
+
+			if ( __ATMO_BLE_STREAM_Sensors[data[1]].enabled )
+			{
+				__ATMO_BLE_STREAM_SetRate( data[1], rateHz );
+			}
+
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_SetFrameLen:
+		{
+			if ( dataLen < 2 || !__ATMO_BLE_STREAM_FrameLenValid( data[1], __ATMO_BLE_STREAM_Encoding ) )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			// Pending frames were filled for the old length
+			for ( uint8_t i = 0; i < ATMO_BLE_STREAM_MAX_SENSORS; i++ )
+			{
+				__ATMO_BLE_STREAM_FlushSensor( i );
+			}
+
+			__ATMO_BLE_STREAM_FrameLen = data[1];
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_SetMaxLatency:
+		{
+			if ( dataLen < 3 )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			__ATMO_BLE_STREAM_MaxLatencyMs = data[1] | ( data[2] << 8 );
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_GetStats:
+		{
+			__ATMO_BLE_STREAM_PutU16( &response[2], __ATMO_BLE_STREAM_Stats.nextSequence );
+			__ATMO_BLE_STREAM_PutU32( &response[4], __ATMO_BLE_STREAM_Stats.framesSent );
+			__ATMO_BLE_STREAM_PutU32( &response[8], __ATMO_BLE_STREAM_Stats.framesDropped );
+			responseLen = 12;
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_ReadLog:
+		{
+			__ATMO_BLE_STREAM_LogRead_t *logRead = &__ATMO_BLE_STREAM_LogRead;
+			ATMO_SENSORLOG_Info_t info;
+
+			if ( !ATMO_SENSORLOG_IsEnabled() )
+			{
+				status = ATMO_BLE_STREAM_Status_NotSupported;
+				break;
+			}
+
+			if ( dataLen < 9 || ( __ATMO_BLE_STREAM_Encoding == ATMO_BLE_STREAM_Encoding_Raw &&
+			                      __ATMO_BLE_STREAM_FrameLen < ( ATMO_BLE_STREAM_HEADER_LEN + ATMO_BLE_STREAM_LOG_SAMPLE_LEN ) ) )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			// Samples still collected in RAM belong to the range too
+			ATMO_SENSORLOG_Flush();
+			ATMO_SENSORLOG_GetInfo( &info );
+
+			memset( logRead, 0, sizeof( *logRead ) );
+			logRead->sensorId = info.sensorId;
+			logRead->toMs = data[5] | ( data[6] << 8 ) | ( data[7] << 16 ) | ( ( uint32_t )data[8] << 24 );
+
+			ATMO_SENSORLOG_Status_t seekStatus = ATMO_SENSORLOG_Seek( data[1] | ( data[2] << 8 ) | ( data[3] << 16 ) | ( ( uint32_t )data[4] << 24 ), &logRead->cursor );
+
+			if ( seekStatus != ATMO_SENSORLOG_Status_Success && seekStatus != ATMO_SENSORLOG_Status_NoData )
+			{
+				status = ATMO_BLE_STREAM_Status_Fail;
+				break;
+			}
+
+			// An empty range finishes with no samples on the next tick
+			logRead->active = true;
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_StopLog:
+		{
+			__ATMO_BLE_STREAM_LogRead.active = false;
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_SetEncoding:
+		{
+			if ( dataLen < 2 || data[1] > ATMO_BLE_STREAM_Encoding_Delta ||
+			        !__ATMO_BLE_STREAM_FrameLenValid( __ATMO_BLE_STREAM_FrameLen, ( ATMO_BLE_STREAM_Encoding_t )data[1] ) )
+			{
+				status = ATMO_BLE_STREAM_Status_Invalid;
+				break;
+			}
+
+			// Pending frames were filled with the old encoding
+			for ( uint8_t i = 0; i < ATMO_BLE_STREAM_MAX_SENSORS; i++ )
+			{
+				__ATMO_BLE_STREAM_FlushSensor( i );
+			}
+
+			// A log frame waiting for the queue goes out as built, the next one uses the new encoding
+			__ATMO_BLE_STREAM_Encoding = ( ATMO_BLE_STREAM_Encoding_t )data[1];
+			break;
+		}
+
+		case ATMO_BLE_STREAM_Command_GetLogInfo:
+		{
+			ATMO_SENSORLOG_Info_t info;
+
+			if ( !ATMO_SENSORLOG_IsEnabled() )
+			{
+				status = ATMO_BLE_STREAM_Status_NotSupported;
+				break;
+			}
+
+			ATMO_SENSORLOG_GetInfo( &info );
+			__ATMO_BLE_STREAM_PutU32( &response[2], info.oldestMs );
+			__ATMO_BLE_STREAM_PutU32( &response[6], info.newestMs );
+			__ATMO_BLE_STREAM_PutU32( &response[10], info.nowMs );
+			responseLen = 14;
+			break;
+		}
+
+		default:
+		{
+			status = ATMO_BLE_STREAM_Status_NotSupported;
+			break;
+		}
+	}
+
+	response[1] = status;
+
+	if ( __ATMO_BLE_STREAM_Initialized )
+	{
+		__ATMO_BLE_STREAM_SendResponse( response, responseLen );
+	}
+
+	return status;
+}
+
+void ATMO_BLE_STREAM_StopAll( void )
+{
+	__ATMO_BLE_STREAM_LogRead.active = false;
+
+	for ( uint8_t i = 0; i < ATMO_BLE_STREAM_MAX_SENSORS; i++ )
+	{
+		__ATMO_BLE_STREAM_Sensor_t *sensor = &__ATMO_BLE_STREAM_Sensors[i];
+
+		sensor->numSamples = 0;
+		sensor->frameUsed = ATMO_BLE_STREAM_HEADER_LEN;
+		sensor->primed = false;
+
+		if ( sensor->enabled )
+		{
+			sensor->enabled = false;
+			__ATMO_BLE_STREAM_SetRate( i, 0 );
+		}
+	}
+}
+
+void ATMO_BLE_STREAM_GetStats( ATMO_BLE_STREAM_Stats_t *stats )
+{
+	if ( stats != NULL )
+	{
+		memcpy( stats, &__ATMO_BLE_STREAM_Stats, sizeof( __ATMO_BLE_STREAM_Stats ) );
+	}
+}
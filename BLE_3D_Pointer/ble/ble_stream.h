@@ -0,0 +1,220 @@
+/**
+ ******************************************************************************
+ * @file    ble_stream.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - BLE sensor streaming service header file
+ *
+ * The streaming service pushes batches of raw sensor samples to a connected
+ * central using notifications on the data characteristic
+ * "a5d30c10-3c7e-4d2a-9b61-2f8e0b7c4e11". Streams are controlled by writing
+ * to the control characteristic "a5d30c10-3c7e-4d2a-9b61-2f8e0b7c4e12".
+ *
+ * Every notification carries exactly one frame (all fields little endian):
+ *
+ * < Sequence (2 Bytes) >< Sensor ID (1 Byte) >< Sample Count (1 Byte) >
+ * < First Sample Timestamp ms (4 Bytes) >< Samples (Sample Count * 6 Bytes) >
+ *
+ * Each sample is three signed 16-bit values (x, y, z) exactly as delivered by
+ * the sensor. The sequence number is shared by all sensors and is incremented
+ * for every frame produced, including frames the device had to drop locally,
+ * so a gap in the sequence seen by the central is the end-to-end frame loss.
+ *
+ * Control commands:
+ *
+ * Start:        < 0x01 >< Sensor Mask (1 Byte) >
+ * Stop:         < 0x02 >< Sensor Mask (1 Byte) >
+ * Set Rate:     < 0x03 >< Sensor ID (1 Byte) >< Rate Hz (2 Bytes) >
+ * Set Frame:    < 0x04 >< Max Frame Length (1 Byte) >
+ * Set Latency:  < 0x05 >< Max Frame Latency ms (2 Bytes) >
+ * Get Stats:    < 0x06 >
+ * Read Log:     < 0x07 >< From ms (4 Bytes) >< To ms (4 Bytes) >
+ * Stop Log:     < 0x08 >
+ * Get Log Info: < 0x09 >
+ * Set Encoding: < 0x0A >< Encoding (1 Byte) >
+ *
+ * The control characteristic is updated (and notified) with
+ * < Command (1 Byte) >< Status (1 Byte) > after every command. Get Stats
+ * additionally appends < Next Sequence (2 Bytes) >< Frames Sent (4 Bytes) >
+ * < Frames Dropped (4 Bytes) >, Get Log Info < Oldest ms (4 Bytes) >
+ * < Newest ms (4 Bytes) >< Now ms (4 Bytes) > in log time (see sensorlog.h).
+ *
+ * Read Log streams the samples of the sensor log between two log times on the
+ * data characteristic as fast as the link takes them: frames are queued until
+ * the notification queue is full and retried, never dropped. Log frames have
+ * the same header with bit 7 of the sensor ID set and their own sequence
+ * number, starting at 0 for every read, so they don't disturb the loss count
+ * of the live streams. Each sample is
+ * < Time Offset ms (2 Bytes) >< x (2 Bytes) >< y (2 Bytes) >< z (2 Bytes) >
+ * relative to the first sample timestamp. Once the range is sent the control
+ * characteristic is updated with < 0x07 >< Status (1 Byte) >< Samples Sent (4 Bytes) >.
+ * Live streams keep running during a read.
+ *
+ * Set Encoding selects how samples are carried: 0 as above, 1 delta coded with
+ * atmo_samplecodec.h (bit 6 of the sensor ID set). Delta coded frames fill up
+ * to the frame length with samples coded against the first sample timestamp
+ * of the frame and zero, so every frame decodes on its own and carries the
+ * time of every sample. It needs a frame length of at least 18 bytes.
+ *
+ * The frame length defaults to 20 bytes (default ATT MTU). A central that
+ * negotiated a larger MTU should raise it with Set Frame to batch more
+ * samples per notification.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_BLE_STREAM__H
+#define __ATMO_BLE_STREAM__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "../atmo/core.h"
+#include "ble.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+#define ATMO_BLE_STREAM_SERVICE_UUID "a5d30c10-3c7e-4d2a-9b61-2f8e0b7c4e10"
+#define ATMO_BLE_STREAM_DATA_CHARACTERISTIC_UUID "a5d30c10-3c7e-4d2a-9b61-2f8e0b7c4e11"
+#define ATMO_BLE_STREAM_CONTROL_CHARACTERISTIC_UUID "a5d30c10-3c7e-4d2a-9b61-2f8e0b7c4e12"
+
+#define ATMO_BLE_STREAM_MAX_SENSORS (3)
+#define ATMO_BLE_STREAM_HEADER_LEN (8)
+#define ATMO_BLE_STREAM_SAMPLE_LEN (6)
+#define ATMO_BLE_STREAM_LOG_SAMPLE_LEN (8)
+#define ATMO_BLE_STREAM_LOG_FRAME_FLAG (0x80)
+#define ATMO_BLE_STREAM_DELTA_FRAME_FLAG (0x40)
+
+// The first sample of a delta coded frame is coded against its own time and zero
+#define ATMO_BLE_STREAM_MIN_DELTA_FRAME_LEN ( ATMO_BLE_STREAM_HEADER_LEN + 1 + ( 3 * 3 ) )
+#define ATMO_BLE_STREAM_MAX_FRAME_LEN (128)
+#define ATMO_BLE_STREAM_CONTROL_LEN (20)
+#define ATMO_BLE_STREAM_DEFAULT_FRAME_LEN (20)
+#define ATMO_BLE_STREAM_DEFAULT_MAX_LATENCY_MS (50)
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+typedef enum
+{
+	ATMO_BLE_STREAM_Status_Success              = 0x00u,  /**< Operation was successful */
+	ATMO_BLE_STREAM_Status_Fail                 = 0x01u,  /**< Operation failed */
+	ATMO_BLE_STREAM_Status_Invalid              = 0x02u,  /**< Invalid argument */
+	ATMO_BLE_STREAM_Status_NotSupported         = 0x03u,  /**< Command not supported */
+} ATMO_BLE_STREAM_Status_t;
+
+typedef enum
+{
+	ATMO_BLE_STREAM_Command_Start = 0x01,
+	ATMO_BLE_STREAM_Command_Stop = 0x02,
+	ATMO_BLE_STREAM_Command_SetRate = 0x03,
+	ATMO_BLE_STREAM_Command_SetFrameLen = 0x04,
+	ATMO_BLE_STREAM_Command_SetMaxLatency = 0x05,
+	ATMO_BLE_STREAM_Command_GetStats = 0x06,
+	ATMO_BLE_STREAM_Command_ReadLog = 0x07,
+	ATMO_BLE_STREAM_Command_StopLog = 0x08,
+	ATMO_BLE_STREAM_Command_GetLogInfo = 0x09,
+	ATMO_BLE_STREAM_Command_SetEncoding = 0x0A,
+} ATMO_BLE_STREAM_Command_t;
+
+typedef enum
+{
+	ATMO_BLE_STREAM_Encoding_Raw = 0x00,
+	ATMO_BLE_STREAM_Encoding_Delta = 0x01,
+} ATMO_BLE_STREAM_Encoding_t;
+
+/**
+ * Called when the central requests a new sample rate for a sensor so the
+ * source can be reconfigured. A rate of 0 means the stream was stopped.
+ */
+typedef void ( *ATMO_BLE_STREAM_RateHandler_t )( uint8_t sensorId, uint16_t rateHz );
+
+typedef struct
+{
+	ATMO_DriverInstanceHandle_t bleInstance;
+	ATMO_BLE_STREAM_RateHandler_t rateHandler;
+	uint16_t defaultRateHz;
+} ATMO_BLE_STREAM_Config_t;
+
+typedef struct
+{
+	uint16_t nextSequence;
+	uint32_t framesSent;
+	uint32_t framesDropped;
+} ATMO_BLE_STREAM_Stats_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Register the streaming service and its characteristics with the BLE driver.
+ *
+ * @param[in] config
+ * @return ATMO_BLE_STREAM_Status_t
+ */
+ATMO_BLE_STREAM_Status_t ATMO_BLE_STREAM_Init( ATMO_BLE_STREAM_Config_t *config );
+
+/**
+ * Hand a single raw sample to the streaming service. Samples of sensors that
+ * are not streaming are ignored, others are decimated to the requested rate
+ * and batched into frames.
+ *
+ * @param[in] sensorId
+ * @param[in] x
+ * @param[in] y
+ * @param[in] z
+ */
+void ATMO_BLE_STREAM_PushSample( uint8_t sensorId, int16_t x, int16_t y, int16_t z );
+
+/**
+ * Execute a control command as if it was written to the control characteristic.
+ *
+ * @param[in] data
+ * @param[in] dataLen
+ * @return ATMO_BLE_STREAM_Status_t
+ */
+ATMO_BLE_STREAM_Status_t ATMO_BLE_STREAM_HandleCommand( const uint8_t *data, uint32_t dataLen );
+
+/**
+ * Stop all streams and log reads and discard any partially filled frames.
+ */
+void ATMO_BLE_STREAM_StopAll( void );
+
+/**
+ * Get the frame counters of the streaming service.
+ *
+ * @param[out] stats
+ */
+void ATMO_BLE_STREAM_GetStats( ATMO_BLE_STREAM_Stats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_BLE_STREAM__H */
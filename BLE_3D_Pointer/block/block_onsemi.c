@@ -14,18 +14,85 @@ ATMO_BLOCK_DriverInstance_t ONSEMIBlockDriverInstance =
 };
 
 #define ATMO_ONSEMI_NVRAM_SIZE 256
+#define ATMO_ONSEMI_NVRAM_WORDS ( ATMO_ONSEMI_NVRAM_SIZE / 4 )
 
 // #define ATMO_ONSEMI_BLOCK_DBG
 
 typedef struct
 {
-	unsigned int 	sysInfo[4]; // Built in sysinfo that needs to remain
 	uint8_t atmoData[ATMO_ONSEMI_NVRAM_SIZE];
 } _ATMO_ONSEMI_FlashData_t;
 
+// Where the data lived before the journal, only read to migrate it
 #define ATMO_ONSEMI_DATA_BASE 0x00080200
 
+// The block is stored as a journal of word updates spread over the last main
+// flash sectors (kept out of the FLASH region in sections.ld), so a sync never
+// erases anything that holds the only copy of the data. Each sector starts with
+// < Magic (4 Bytes) >< Generation (4 Bytes) >
+// followed by one word pair per record:
+// < Data (4 Bytes) >< Word Index (1 Byte) >< Flags (1 Byte) >< CRC16 (2 Bytes) >
+// A sync appends a record for every word that changed, the last one flagged as
+// the commit. Records after the last commit (a sync cut short) are ignored, so
+// a sync is applied completely or not at all. Once the active sector
+// is full the whole block is written to the next sector, and its header is
+// written last with the next generation. At boot the valid header with the
+// newest generation wins and its records are replayed in order. Words without
+// a record read as 0xFF, like erased flash.
+#ifndef ATMO_ONSEMI_JOURNAL_BASE
+#define ATMO_ONSEMI_JOURNAL_BASE 0x0015E000
+#endif
+
+#ifndef ATMO_ONSEMI_JOURNAL_NUM_SECTORS
+#define ATMO_ONSEMI_JOURNAL_NUM_SECTORS (2)
+#endif
+
+#define ATMO_ONSEMI_FLASH_SECTOR_SIZE (2048)
+#define ATMO_ONSEMI_JOURNAL_MAGIC (0x4E4A5441) // "ATJN"
+#define ATMO_ONSEMI_JOURNAL_SLOTS ( ATMO_ONSEMI_FLASH_SECTOR_SIZE / 8 ) // Including the header
+#define ATMO_ONSEMI_JOURNAL_ERASED (0xFFFFFFFF)
+#define ATMO_ONSEMI_JOURNAL_FLAG_COMMIT (0x01)
+
+#if ATMO_ONSEMI_JOURNAL_NUM_SECTORS < 2
+#error "The journal needs at least two sectors to compact without losing data"
+#endif
+
+#if ATMO_ONSEMI_NVRAM_WORDS >= ATMO_ONSEMI_JOURNAL_SLOTS
+#error "A compacted block must fit in one journal sector"
+#endif
+
+// A sync (ATMO_BLOCK_Sync) writes the journal before it returns, callers rely on
+// the data surviving a reset once it did. Data that was only programmed is
+// written once the oldest unsynced change is this old, or before the device goes
+// to sleep, so a burst of programs costs a single journal write. 0 leaves
+// programmed data in RAM until the next sync.
+#ifndef ATMO_ONSEMI_BLOCK_SYNC_DELAY_MS
+#define ATMO_ONSEMI_BLOCK_SYNC_DELAY_MS (500)
+#endif
+
+typedef struct
+{
+	ATMO_BOOL_t mounted;
+	ATMO_BOOL_t needsCompact; /**< A sync failed part way, only a compaction brings the journal back in line */
+	uint8_t activeSector;
+	uint32_t generation;
+	uint16_t nextSlot; /**< First free record slot in the active sector */
+	uint32_t synced[ATMO_ONSEMI_NVRAM_WORDS]; /**< Block contents as stored in the journal */
+} _ATMO_ONSEMI_Journal_t;
+
+typedef struct
+{
+	uint8_t dirtyFirst; /**< First word that differs from the journal, dirtyFirst > dirtyLast when clean */
+	uint8_t dirtyLast;
+	ATMO_BOOL_t syncPending;
+	uint32_t syncRequestedMs;
+} _ATMO_ONSEMI_Shadow_t;
+
 static _ATMO_ONSEMI_FlashData_t _ATMO_ONSEMI_FlashData = {0};
+static _ATMO_ONSEMI_Journal_t _ATMO_ONSEMI_Journal;
+static _ATMO_ONSEMI_Shadow_t _ATMO_ONSEMI_Shadow = { ATMO_ONSEMI_NVRAM_WORDS - 1, 0, false, 0 };
+
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_Mount( uint8_t *data );
 
 ATMO_Status_t ATMO_ONSEMI_BLOCK_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
 {
@@ -38,6 +105,7 @@ ATMO_Status_t ATMO_ONSEMI_BLOCK_AddDriverInstance( ATMO_DriverInstanceHandle_t *
 	return ATMO_BLOCK_AddDriverInstance( &ONSEMIBlockDriverInstance, &driver, instanceNumber );
 }
 
+#ifdef ATMO_ONSEMI_BLOCK_DBG
 static void _ATMO_ONSEMI_BLOCK_MemDump()
 {
 	ATMO_PLATFORM_DebugPrint( "FLASH DATA\r\n" );
@@ -55,6 +123,7 @@ static void _ATMO_ONSEMI_BLOCK_MemDump()
 		ATMO_PLATFORM_DebugPrint( "\r\n" );
 	}
 }
+#endif
 
 static void _ATMO_ONSEMI_BLOCK_RegCb( void *data )
 {
@@ -62,13 +131,29 @@ static void _ATMO_ONSEMI_BLOCK_RegCb( void *data )
 	ATMO_PLATFORM_DebugPrint( "SYNCING FLASH\r\n" );
 	_ATMO_ONSEMI_BLOCK_MemDump();
 #endif
-	ATMO_ONSEMI_BLOCK_Sync( NULL );
+	// The registration has to survive a reset, don't leave it to the deferred sync
+	ATMO_ONSEMI_BLOCK_Flush();
+}
+
+static void _ATMO_ONSEMI_BLOCK_SyncTick( void *data )
+{
+	if ( _ATMO_ONSEMI_Shadow.syncPending && ( uint32_t )ATMO_PLATFORM_UptimeMs() - _ATMO_ONSEMI_Shadow.syncRequestedMs >= ATMO_ONSEMI_BLOCK_SYNC_DELAY_MS )
+	{
+		ATMO_ONSEMI_BLOCK_Flush();
+	}
 }
 
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Init( ATMO_DriverInstanceData_t *instance )
 {
 	// Sync with nvram
-	memcpy( ( void * )_ATMO_ONSEMI_FlashData.atmoData, ( void * ) ATMO_ONSEMI_DATA_BASE, ATMO_ONSEMI_NVRAM_SIZE );
+	if ( !_ATMO_ONSEMI_JOURNAL_Mount( _ATMO_ONSEMI_FlashData.atmoData ) )
+	{
+		ATMO_PLATFORM_DebugPrint( "Error mounting journal\r\n" );
+	}
+
+	_ATMO_ONSEMI_Shadow.dirtyFirst = ATMO_ONSEMI_NVRAM_WORDS - 1;
+	_ATMO_ONSEMI_Shadow.dirtyLast = 0;
+	_ATMO_ONSEMI_Shadow.syncPending = false;
 
 #ifdef ATMO_ONSEMI_BLOCK_DBG
 	_ATMO_ONSEMI_BLOCK_MemDump();
@@ -78,12 +163,16 @@ ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Init( ATMO_DriverInstanceData_t *instance
 
 	ATMO_CLOUD_RegisterRegistrationSetCallback( _ATMO_ONSEMI_BLOCK_RegCb );
 
+#if ATMO_ONSEMI_BLOCK_SYNC_DELAY_MS > 0
+	ATMO_AddTickCallback( _ATMO_ONSEMI_BLOCK_SyncTick );
+#endif
+
 	return ATMO_BLOCK_Status_Success;
 }
 
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Read( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
 {
-	if ( block != 0 || ( offset + size ) >= ATMO_ONSEMI_NVRAM_SIZE )
+	if ( block != 0 || offset > ATMO_ONSEMI_NVRAM_SIZE || size > ATMO_ONSEMI_NVRAM_SIZE - offset )
 	{
 		return ATMO_BLOCK_Status_Fail;
 	}
@@ -105,96 +194,377 @@ ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Read( ATMO_DriverInstanceData_t *instance,
 	return ATMO_BLOCK_Status_Success;
 }
 
-static FlashStatus _ATMO_ONSEMI_BLOCK_ResetFlash()
+static uint16_t _ATMO_ONSEMI_JOURNAL_Crc( uint8_t index, uint8_t flags, uint32_t data )
 {
-	FlashStatus flash_result;
-	/// Store NVR1 data
-	memcpy( ( void * )_ATMO_ONSEMI_FlashData.sysInfo, ( void * ) SYS_INFO_START_ADDR, 4 );
+	uint8_t bytes[6] = { index, flags, data & 0xFF, ( data >> 8 ) & 0xFF, ( data >> 16 ) & 0xFF, data >> 24 };
+	uint16_t crc = 0xFFFF;
+	unsigned int i, bit;
 
-	/// Erase NVR1
-	// Write enable NVR1
-	FLASH->NVR_CTRL = ( NVR1_WRITE_ENABLE | NVR2_WRITE_DISABLE |
-	                    NVR3_WRITE_DISABLE );
-	FLASH->NVR_WRITE_UNLOCK = FLASH_NVR_KEY;
-	// Erase NVR1
-	flash_result = Flash_EraseSector( SYS_INFO_START_ADDR );
+	// CRC-16/CCITT
+	for ( i = 0; i < sizeof( bytes ); i++ )
+	{
+		crc ^= ( uint16_t )bytes[i] << 8;
+
+		for ( bit = 0; bit < 8; bit++ )
+		{
+			crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : ( crc << 1 );
+		}
+	}
+
+	return crc;
+}
+
+static uint32_t _ATMO_ONSEMI_JOURNAL_SectorAddr( uint8_t sector )
+{
+	return ATMO_ONSEMI_JOURNAL_BASE + ( sector * ATMO_ONSEMI_FLASH_SECTOR_SIZE );
+}
+
+static void _ATMO_ONSEMI_JOURNAL_ReadPair( uint8_t sector, uint16_t slot, uint32_t *w1, uint32_t *w2 )
+{
+	const volatile uint32_t *pair = ( const volatile uint32_t * )( uintptr_t )( _ATMO_ONSEMI_JOURNAL_SectorAddr( sector ) + ( slot * 8 ) );
+	*w1 = pair[0];
+	*w2 = pair[1];
+}
+
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_WritePair( uint8_t sector, uint16_t slot, uint32_t w1, uint32_t w2 )
+{
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_ENABLE | MAIN_MIDDLE_W_ENABLE | MAIN_HIGH_W_ENABLE );
+	FLASH->MAIN_WRITE_UNLOCK = FLASH_MAIN_KEY;
+
+	FlashStatus flash_result = Flash_WriteWordPair( _ATMO_ONSEMI_JOURNAL_SectorAddr( sector ) + ( slot * 8 ), w1, w2 );
+
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_DISABLE | MAIN_MIDDLE_W_DISABLE | MAIN_HIGH_W_DISABLE );
 
 	if ( flash_result != FLASH_ERR_NONE )
 	{
-		ATMO_PLATFORM_DebugPrint( "Error erasing sector\r\n" );
-		return flash_result;
+		ATMO_PLATFORM_DebugPrint( "Error writing journal %d slot %d\r\n", flash_result, slot );
+		return false;
 	}
 
-	/// Restore NVR1 data and add new address
-	// Restore SYS_INFO_START_ADDR
-	flash_result = Flash_WriteBuffer( SYS_INFO_START_ADDR, 4, _ATMO_ONSEMI_FlashData.sysInfo );
+	return true;
+}
+
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_EraseSector( uint8_t sector )
+{
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_ENABLE | MAIN_MIDDLE_W_ENABLE | MAIN_HIGH_W_ENABLE );
+	FLASH->MAIN_WRITE_UNLOCK = FLASH_MAIN_KEY;
+
+	FlashStatus flash_result = Flash_EraseSector( _ATMO_ONSEMI_JOURNAL_SectorAddr( sector ) );
+
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_DISABLE | MAIN_MIDDLE_W_DISABLE | MAIN_HIGH_W_DISABLE );
 
 	if ( flash_result != FLASH_ERR_NONE )
 	{
-		ATMO_PLATFORM_DebugPrint( "Error writing sys info to sector\r\n" );
-		return flash_result;
+		ATMO_PLATFORM_DebugPrint( "Error erasing journal sector %d\r\n", flash_result );
+		return false;
 	}
 
-	// TODO: lock writing again?
+	return true;
+}
 
-	/// Return success
-#ifdef ATMO_ONSEMI_BLOCK_DBG
-	ATMO_PLATFORM_DebugPrint( "Sector erased\r\n" );
-#endif
-	return ( FLASH_ERR_NONE );
+static uint32_t _ATMO_ONSEMI_JOURNAL_GetWord( const uint8_t *data, unsigned int index )
+{
+	const uint8_t *pData = &data[index * 4];
+	return ( uint32_t )pData[3] << 24 | ( uint32_t )pData[2] << 16 | ( uint32_t )pData[1] << 8 | pData[0];
+}
+
+static void _ATMO_ONSEMI_JOURNAL_SetWord( uint8_t *data, unsigned int index, uint32_t word )
+{
+	uint8_t *pData = &data[index * 4];
+	pData[0] = word & 0xFF;
+	pData[1] = ( word >> 8 ) & 0xFF;
+	pData[2] = ( word >> 16 ) & 0xFF;
+	pData[3] = word >> 24;
+}
+
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_WriteRecord( uint8_t sector, uint16_t slot, uint8_t index, uint8_t flags, uint32_t data )
+{
+	uint32_t w2 = index | ( ( uint32_t )flags << 8 ) | ( ( uint32_t )_ATMO_ONSEMI_JOURNAL_Crc( index, flags, data ) << 16 );
+	return _ATMO_ONSEMI_JOURNAL_WritePair( sector, slot, data, w2 );
+}
+
+/**
+ * Write the whole block to the next sector and make it the active one. The old
+ * sector stays valid until the new header is written.
+ */
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_Compact( const uint8_t *data )
+{
+	uint8_t sector = ( _ATMO_ONSEMI_Journal.activeSector + 1 ) % ATMO_ONSEMI_JOURNAL_NUM_SECTORS;
+	uint16_t slot = 1;
+	unsigned int i;
+
+	if ( !_ATMO_ONSEMI_JOURNAL_EraseSector( sector ) )
+	{
+		return false;
+	}
+
+	// The header makes these records valid, they all count as committed
+	for ( i = 0; i < ATMO_ONSEMI_NVRAM_WORDS; i++ )
+	{
+		uint32_t word = _ATMO_ONSEMI_JOURNAL_GetWord( data, i );
+
+		if ( word == ATMO_ONSEMI_JOURNAL_ERASED )
+		{
+			continue;
+		}
+
+		if ( !_ATMO_ONSEMI_JOURNAL_WriteRecord( sector, slot++, i, ATMO_ONSEMI_JOURNAL_FLAG_COMMIT, word ) )
+		{
+			return false;
+		}
+	}
+
+	if ( !_ATMO_ONSEMI_JOURNAL_WritePair( sector, 0, ATMO_ONSEMI_JOURNAL_MAGIC, _ATMO_ONSEMI_Journal.generation + 1 ) )
+	{
+		return false;
+	}
+
+	_ATMO_ONSEMI_Journal.activeSector = sector;
+	_ATMO_ONSEMI_Journal.generation++;
+	_ATMO_ONSEMI_Journal.nextSlot = slot;
+	_ATMO_ONSEMI_Journal.needsCompact = false;
+
+	for ( i = 0; i < ATMO_ONSEMI_NVRAM_WORDS; i++ )
+	{
+		_ATMO_ONSEMI_Journal.synced[i] = _ATMO_ONSEMI_JOURNAL_GetWord( data, i );
+	}
+
+	return true;
+}
+
+/**
+ * Find the newest journal generation and replay it into data. Without a journal
+ * the data is migrated from its old location in NVR1.
+ */
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_Mount( uint8_t *data )
+{
+	ATMO_BOOL_t found = false;
+	uint8_t sector;
+	uint16_t slot;
+	unsigned int i;
+
+	for ( sector = 0; sector < ATMO_ONSEMI_JOURNAL_NUM_SECTORS; sector++ )
+	{
+		uint32_t magic, generation;
+		_ATMO_ONSEMI_JOURNAL_ReadPair( sector, 0, &magic, &generation );
+
+		if ( magic != ATMO_ONSEMI_JOURNAL_MAGIC || generation == ATMO_ONSEMI_JOURNAL_ERASED )
+		{
+			continue;
+		}
+
+		if ( !found || ( int32_t )( generation - _ATMO_ONSEMI_Journal.generation ) > 0 )
+		{
+			found = true;
+			_ATMO_ONSEMI_Journal.activeSector = sector;
+			_ATMO_ONSEMI_Journal.generation = generation;
+		}
+	}
+
+	_ATMO_ONSEMI_Journal.mounted = false;
+
+	if ( !found )
+	{
+		// First boot with the journal, carry over whatever the old sync left in NVR1
+		memcpy( ( void * )data, ( void * ) ATMO_ONSEMI_DATA_BASE, ATMO_ONSEMI_NVRAM_SIZE );
+		_ATMO_ONSEMI_Journal.activeSector = ATMO_ONSEMI_JOURNAL_NUM_SECTORS - 1;
+		_ATMO_ONSEMI_Journal.generation = 0;
+
+		if ( !_ATMO_ONSEMI_JOURNAL_Compact( data ) )
+		{
+			return false;
+		}
+
+		_ATMO_ONSEMI_Journal.mounted = true;
+		return true;
+	}
+
+	uint16_t lastCommit = 0;
+	_ATMO_ONSEMI_Journal.nextSlot = 1;
+
+	// Find the end of the log and the last complete sync. A torn record fails its CRC, the slot stays used.
+	for ( slot = 1; slot < ATMO_ONSEMI_JOURNAL_SLOTS; slot++ )
+	{
+		uint32_t w1, w2;
+		_ATMO_ONSEMI_JOURNAL_ReadPair( _ATMO_ONSEMI_Journal.activeSector, slot, &w1, &w2 );
+
+		if ( w1 == ATMO_ONSEMI_JOURNAL_ERASED && w2 == ATMO_ONSEMI_JOURNAL_ERASED )
+		{
+			continue;
+		}
+
+		_ATMO_ONSEMI_Journal.nextSlot = slot + 1;
+
+		uint8_t index = w2 & 0xFF;
+		uint8_t flags = ( w2 >> 8 ) & 0xFF;
+
+		if ( index < ATMO_ONSEMI_NVRAM_WORDS && ( flags & ATMO_ONSEMI_JOURNAL_FLAG_COMMIT ) && ( w2 >> 16 ) == _ATMO_ONSEMI_JOURNAL_Crc( index, flags, w1 ) )
+		{
+			lastCommit = slot;
+		}
+	}
+
+	memset( data, 0xFF, ATMO_ONSEMI_NVRAM_SIZE );
+
+	for ( slot = 1; slot <= lastCommit; slot++ )
+	{
+		uint32_t w1, w2;
+		_ATMO_ONSEMI_JOURNAL_ReadPair( _ATMO_ONSEMI_Journal.activeSector, slot, &w1, &w2 );
+
+		uint8_t index = w2 & 0xFF;
+		uint8_t flags = ( w2 >> 8 ) & 0xFF;
+
+		if ( index < ATMO_ONSEMI_NVRAM_WORDS && ( w2 >> 16 ) == _ATMO_ONSEMI_JOURNAL_Crc( index, flags, w1 ) )
+		{
+			_ATMO_ONSEMI_JOURNAL_SetWord( data, index, w1 );
+		}
+	}
+
+	// Records of an unfinished sync would count as part of the next commit, get rid of them first
+	_ATMO_ONSEMI_Journal.needsCompact = ( _ATMO_ONSEMI_Journal.nextSlot != lastCommit + 1 );
+
+	for ( i = 0; i < ATMO_ONSEMI_NVRAM_WORDS; i++ )
+	{
+		_ATMO_ONSEMI_Journal.synced[i] = _ATMO_ONSEMI_JOURNAL_GetWord( data, i );
+	}
+
+	_ATMO_ONSEMI_Journal.mounted = true;
+	return true;
 }
 
-static ATMO_BLOCK_Status_t _ATMO_ONSEMI_BLOCK_SyncFlash()
+static ATMO_BOOL_t _ATMO_ONSEMI_JOURNAL_Sync( const uint8_t *data, unsigned int first, unsigned int last )
+{
+	unsigned int numChanged = 0;
+	unsigned int lastChanged = 0;
+	unsigned int i;
+
+	if ( !_ATMO_ONSEMI_Journal.mounted || _ATMO_ONSEMI_Journal.needsCompact )
+	{
+		if ( !_ATMO_ONSEMI_JOURNAL_Compact( data ) )
+		{
+			return false;
+		}
+
+		_ATMO_ONSEMI_Journal.mounted = true;
+		return true;
+	}
+
+	// Words outside first..last are known to match the journal
+	for ( i = first; i <= last; i++ )
+	{
+		if ( _ATMO_ONSEMI_JOURNAL_GetWord( data, i ) != _ATMO_ONSEMI_Journal.synced[i] )
+		{
+			numChanged++;
+			lastChanged = i;
+		}
+	}
+
+	if ( numChanged == 0 )
+	{
+		return true;
+	}
+
+	// Don't start a sync that can't finish in this sector, a compaction writes everything anyway
+	if ( _ATMO_ONSEMI_Journal.nextSlot + numChanged > ATMO_ONSEMI_JOURNAL_SLOTS )
+	{
+		return _ATMO_ONSEMI_JOURNAL_Compact( data );
+	}
+
+	for ( i = first; i <= lastChanged; i++ )
+	{
+		uint32_t word = _ATMO_ONSEMI_JOURNAL_GetWord( data, i );
+
+		if ( word == _ATMO_ONSEMI_Journal.synced[i] )
+		{
+			continue;
+		}
+
+		// Even a failed program may have touched the slot, never reuse it
+		uint16_t slot = _ATMO_ONSEMI_Journal.nextSlot++;
+
+		if ( !_ATMO_ONSEMI_JOURNAL_WriteRecord( _ATMO_ONSEMI_Journal.activeSector, slot, i, ( i == lastChanged ) ? ATMO_ONSEMI_JOURNAL_FLAG_COMMIT : 0, word ) )
+		{
+			_ATMO_ONSEMI_Journal.needsCompact = true;
+			return false;
+		}
+	}
+
+	for ( i = first; i <= last; i++ )
+	{
+		_ATMO_ONSEMI_Journal.synced[i] = _ATMO_ONSEMI_JOURNAL_GetWord( data, i );
+	}
+
+	return true;
+}
+
+static ATMO_BOOL_t _ATMO_ONSEMI_BLOCK_SyncFlash()
 {
 #ifdef ATMO_ONSEMI_BLOCK_DBG
 	ATMO_PLATFORM_DebugPrint( "Sync flash\r\n" );
 #endif
 
-	if ( _ATMO_ONSEMI_BLOCK_ResetFlash() != FLASH_ERR_NONE )
+	if ( _ATMO_ONSEMI_Shadow.dirtyFirst > _ATMO_ONSEMI_Shadow.dirtyLast && _ATMO_ONSEMI_Journal.mounted && !_ATMO_ONSEMI_Journal.needsCompact )
 	{
-		return ATMO_BLOCK_Status_Fail;
+		// Shadow matches the journal, no need to even look at flash
+		return true;
+	}
+
+	if ( !_ATMO_ONSEMI_JOURNAL_Sync( _ATMO_ONSEMI_FlashData.atmoData, _ATMO_ONSEMI_Shadow.dirtyFirst, _ATMO_ONSEMI_Shadow.dirtyLast ) )
+	{
+		return false;
 	}
 
+	_ATMO_ONSEMI_Shadow.dirtyFirst = ATMO_ONSEMI_NVRAM_WORDS - 1;
+	_ATMO_ONSEMI_Shadow.dirtyLast = 0;
+
 #ifdef ATMO_ONSEMI_BLOCK_DBG
-	ATMO_PLATFORM_DebugPrint( "Flash erased\r\n" );
+	ATMO_PLATFORM_DebugPrint( "Write success, generation %d slot %d\r\n", _ATMO_ONSEMI_Journal.generation, _ATMO_ONSEMI_Journal.nextSlot );
 #endif
 
-// Write to flash
-	// Copied from flashwrite.h in bdk lighting example
-	/// Erase NVR1
-	// Write enable NVR1
-	FLASH->NVR_CTRL = ( NVR1_WRITE_ENABLE | NVR2_WRITE_DISABLE |
-	                    NVR3_WRITE_DISABLE );
-	FLASH->NVR_WRITE_UNLOCK = FLASH_NVR_KEY;
+	return true;
+}
+
+/**
+ * Copy into the shadow and widen the dirty range by the words that actually changed.
+ */
+static void _ATMO_ONSEMI_BLOCK_Write( uint32_t offset, const uint8_t *buffer, uint8_t fill, uint32_t size )
+{
+	uint8_t *pData = &_ATMO_ONSEMI_FlashData.atmoData[offset];
+	uint32_t i;
 
-	// I think we can only write in certain sized chunks
-	for ( unsigned int i = 0; i < ATMO_ONSEMI_NVRAM_SIZE; i += 8 )
+	for ( i = 0; i < size; i++ )
 	{
-#ifdef ATMO_ONSEMI_BLOCK_DBG
-		ATMO_PLATFORM_DebugPrint( "Syncing %d percent\r\n", ( i * 100 ) / ATMO_ONSEMI_NVRAM_SIZE );
-#endif
-		// Write word pair
-		uint32_t w1, w2;
-		uint8_t *pData = &_ATMO_ONSEMI_FlashData.atmoData[i];
-		w1 = pData[3] << 24 | pData[2] << 16 | pData[1] << 8 | pData[0];
-		w2 = pData[7] << 24 | pData[6] << 16 | pData[5] << 8 | pData[4];
-		FlashStatus flash_result = Flash_WriteWordPair( ATMO_ONSEMI_DATA_BASE + i, w1, w2 );
+		uint8_t byte = ( buffer != NULL ) ? buffer[i] : fill;
 
-		if ( flash_result != FLASH_ERR_NONE )
+		if ( pData[i] == byte )
 		{
-			ATMO_PLATFORM_DebugPrint( "Error writing sector %d offset %d\r\n", flash_result, i );
-			return ATMO_BLOCK_Status_Fail;
+			continue;
 		}
-	}
 
-	// lock writing to flash again
-	FLASH->NVR_CTRL = ( NVR1_WRITE_DISABLE |
-	                    NVR2_WRITE_DISABLE |
-	                    NVR3_WRITE_DISABLE );
+		pData[i] = byte;
 
-	ATMO_PLATFORM_DebugPrint( "Write success\r\n" );
+#if ATMO_ONSEMI_BLOCK_SYNC_DELAY_MS > 0
 
-	return ATMO_BLOCK_Status_Success;
+		if ( !_ATMO_ONSEMI_Shadow.syncPending )
+		{
+			_ATMO_ONSEMI_Shadow.syncPending = true;
+			_ATMO_ONSEMI_Shadow.syncRequestedMs = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+		}
+
+#endif
+
+		uint8_t word = ( offset + i ) / 4;
+
+		if ( word < _ATMO_ONSEMI_Shadow.dirtyFirst )
+		{
+			_ATMO_ONSEMI_Shadow.dirtyFirst = word;
+		}
+
+		if ( word > _ATMO_ONSEMI_Shadow.dirtyLast )
+		{
+			_ATMO_ONSEMI_Shadow.dirtyLast = word;
+		}
+	}
 }
 
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Erase( ATMO_DriverInstanceData_t *instance, uint32_t block )
@@ -206,26 +576,38 @@ ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Erase( ATMO_DriverInstanceData_t *instance
 
 	ATMO_PLATFORM_DebugPrint("BLOCK ERASE\r\n");
 
-	memset( _ATMO_ONSEMI_FlashData.atmoData, 0x0, ATMO_ONSEMI_NVRAM_SIZE );
+	_ATMO_ONSEMI_BLOCK_Write( 0, NULL, 0x0, ATMO_ONSEMI_NVRAM_SIZE );
 
 	return ATMO_BLOCK_Status_Success;
 }
 
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Program( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
 {
-	if ( block != 0 || ( offset + size ) >= ATMO_ONSEMI_NVRAM_SIZE )
+	if ( block != 0 || offset > ATMO_ONSEMI_NVRAM_SIZE || size > ATMO_ONSEMI_NVRAM_SIZE - offset )
 	{
 		return ATMO_BLOCK_Status_Fail;
 	}
 
-	memcpy( &_ATMO_ONSEMI_FlashData.atmoData[offset], buffer, size );
+	_ATMO_ONSEMI_BLOCK_Write( offset, ( const uint8_t * )buffer, 0, size );
 
 	return ATMO_BLOCK_Status_Success;
 }
 
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Sync( ATMO_DriverInstanceData_t *instance )
 {
-	_ATMO_ONSEMI_BLOCK_SyncFlash();
+	return ATMO_ONSEMI_BLOCK_Flush();
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Flush( void )
+{
+	if ( !_ATMO_ONSEMI_BLOCK_SyncFlash() )
+	{
+		// Try again after another delay rather than on every tick
+		_ATMO_ONSEMI_Shadow.syncRequestedMs = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+		return ATMO_BLOCK_Status_Fail;
+	}
+
+	_ATMO_ONSEMI_Shadow.syncPending = false;
 	return ATMO_BLOCK_Status_Success;
 }
 
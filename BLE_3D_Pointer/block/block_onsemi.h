@@ -28,6 +28,15 @@ ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Erase( ATMO_DriverInstanceData_t *instance
 
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Sync( ATMO_DriverInstanceData_t *instance );
 
+/**
+ * Write everything programmed so far to flash right away instead of waiting for
+ * the deferred write. Same as a sync, for callers that don't go through the
+ * block driver, and before anything that may lose RAM, like deep sleep.
+ *
+ * @return ATMO_BLOCK_Status_t
+ */
+ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_Flush( void );
+
 ATMO_BLOCK_Status_t ATMO_ONSEMI_BLOCK_GetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info );
 
 
@@ -0,0 +1,174 @@
+/**
+ ******************************************************************************
+ * @file    block_onsemi_flash.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - RSL10 main flash block device
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "block_onsemi_flash.h"
+#include <rsl10_flash_rom.h>
+#include <rsl10_flash.h>
+
+ATMO_BLOCK_DriverInstance_t ONSEMIFlashBlockDriverInstance =
+{
+	ATMO_ONSEMI_FLASH_BLOCK_Init,
+	ATMO_ONSEMI_FLASH_BLOCK_Read,
+	ATMO_ONSEMI_FLASH_BLOCK_Program,
+	ATMO_ONSEMI_FLASH_BLOCK_Erase,
+	ATMO_ONSEMI_FLASH_BLOCK_Sync,
+	ATMO_ONSEMI_FLASH_BLOCK_GetDeviceInfo
+};
+
+// The sectors right below the block journal (see block_onsemi.c). Both ranges
+// are kept out of the FLASH region in sections.ld, keep them in line.
+#ifndef ATMO_ONSEMI_FLASH_BLOCK_BASE
+#define ATMO_ONSEMI_FLASH_BLOCK_BASE 0x00156000
+#endif
+
+#ifndef ATMO_ONSEMI_FLASH_BLOCK_NUM_SECTORS
+#define ATMO_ONSEMI_FLASH_BLOCK_NUM_SECTORS (16)
+#endif
+
+#define ATMO_ONSEMI_FLASH_BLOCK_SECTOR_SIZE (2048)
+#define ATMO_ONSEMI_FLASH_BLOCK_PROG_SIZE (8)
+
+ATMO_Status_t ATMO_ONSEMI_FLASH_BLOCK_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
+{
+	static ATMO_DriverInstanceData_t driver;
+	driver.name = "";
+	driver.initialized = false;
+	driver.instanceNumber = *instanceNumber;
+	driver.argument = NULL;
+
+	return ATMO_BLOCK_AddDriverInstance( &ONSEMIFlashBlockDriverInstance, &driver, instanceNumber );
+}
+
+static uint32_t _ATMO_ONSEMI_FLASH_BLOCK_Addr( uint32_t block, uint32_t offset )
+{
+	return ATMO_ONSEMI_FLASH_BLOCK_BASE + ( block * ATMO_ONSEMI_FLASH_BLOCK_SECTOR_SIZE ) + offset;
+}
+
+static ATMO_BOOL_t _ATMO_ONSEMI_FLASH_BLOCK_InRange( uint32_t block, uint32_t offset, uint32_t size )
+{
+	return block < ATMO_ONSEMI_FLASH_BLOCK_NUM_SECTORS && offset <= ATMO_ONSEMI_FLASH_BLOCK_SECTOR_SIZE &&
+	       size <= ATMO_ONSEMI_FLASH_BLOCK_SECTOR_SIZE - offset;
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Init( ATMO_DriverInstanceData_t *instance )
+{
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Read( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	if ( !_ATMO_ONSEMI_FLASH_BLOCK_InRange( block, offset, size ) )
+	{
+		return ATMO_BLOCK_Status_Invalid;
+	}
+
+	// Main flash is memory mapped
+	memcpy( buffer, ( const void * )_ATMO_ONSEMI_FLASH_BLOCK_Addr( block, offset ), size );
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Program( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	if ( !_ATMO_ONSEMI_FLASH_BLOCK_InRange( block, offset, size ) ||
+	        ( offset % ATMO_ONSEMI_FLASH_BLOCK_PROG_SIZE ) != 0 || ( size % ATMO_ONSEMI_FLASH_BLOCK_PROG_SIZE ) != 0 )
+	{
+		return ATMO_BLOCK_Status_Invalid;
+	}
+
+	const uint8_t *data = ( const uint8_t * )buffer;
+	FlashStatus flash_result = FLASH_ERR_NONE;
+
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_ENABLE | MAIN_MIDDLE_W_ENABLE | MAIN_HIGH_W_ENABLE );
+	FLASH->MAIN_WRITE_UNLOCK = FLASH_MAIN_KEY;
+
+	for ( uint32_t i = 0; i < size && flash_result == FLASH_ERR_NONE; i += ATMO_ONSEMI_FLASH_BLOCK_PROG_SIZE )
+	{
+		uint32_t w1, w2;
+
+		// The buffer doesn't have to be word aligned
+		memcpy( &w1, &data[i], sizeof( w1 ) );
+		memcpy( &w2, &data[i + 4], sizeof( w2 ) );
+		flash_result = Flash_WriteWordPair( _ATMO_ONSEMI_FLASH_BLOCK_Addr( block, offset + i ), w1, w2 );
+	}
+
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_DISABLE | MAIN_MIDDLE_W_DISABLE | MAIN_HIGH_W_DISABLE );
+
+	if ( flash_result != FLASH_ERR_NONE )
+	{
+		ATMO_PLATFORM_DebugPrint( "Error programming flash block %d: %d\r\n", block, flash_result );
+		return ATMO_BLOCK_Status_Fail;
+	}
+
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Erase( ATMO_DriverInstanceData_t *instance, uint32_t block )
+{
+	if ( block >= ATMO_ONSEMI_FLASH_BLOCK_NUM_SECTORS )
+	{
+		return ATMO_BLOCK_Status_Invalid;
+	}
+
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_ENABLE | MAIN_MIDDLE_W_ENABLE | MAIN_HIGH_W_ENABLE );
+	FLASH->MAIN_WRITE_UNLOCK = FLASH_MAIN_KEY;
+
+	FlashStatus flash_result = Flash_EraseSector( _ATMO_ONSEMI_FLASH_BLOCK_Addr( block, 0 ) );
+
+	FLASH->MAIN_CTRL = ( MAIN_LOW_W_DISABLE | MAIN_MIDDLE_W_DISABLE | MAIN_HIGH_W_DISABLE );
+
+	if ( flash_result != FLASH_ERR_NONE )
+	{
+		ATMO_PLATFORM_DebugPrint( "Error erasing flash block %d: %d\r\n", block, flash_result );
+		return ATMO_BLOCK_Status_Fail;
+	}
+
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Sync( ATMO_DriverInstanceData_t *instance )
+{
+	// Nothing is cached
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_GetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info )
+{
+	info->blockCount = ATMO_ONSEMI_FLASH_BLOCK_NUM_SECTORS;
+	info->blockSize = ATMO_ONSEMI_FLASH_BLOCK_SECTOR_SIZE;
+	info->progSize = ATMO_ONSEMI_FLASH_BLOCK_PROG_SIZE;
+	info->readSize = 1;
+	return ATMO_BLOCK_Status_Success;
+}
@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * @file    block_onsemi_flash.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - RSL10 main flash block device header file
+ *
+ * Exposes a range of main flash sectors (kept out of the FLASH region in
+ * sections.ld) as a block device with one block per 2K sector. Programs go
+ * straight to flash a word pair at a time, so offsets and sizes must be
+ * multiples of 8 and a location can only be programmed once per erase.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_ONSEMI_FLASH_BLOCK__H
+#define __ATMO_ONSEMI_FLASH_BLOCK__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "../app_src/atmosphere_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+ATMO_Status_t ATMO_ONSEMI_FLASH_BLOCK_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber );
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Init( ATMO_DriverInstanceData_t *instance );
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Read( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size );
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Program( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size );
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Erase( ATMO_DriverInstanceData_t *instance, uint32_t block );
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_Sync( ATMO_DriverInstanceData_t *instance );
+
+ATMO_BLOCK_Status_t ATMO_ONSEMI_FLASH_BLOCK_GetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_ONSEMI_FLASH_BLOCK__H */
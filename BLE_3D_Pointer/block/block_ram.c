@@ -0,0 +1,191 @@
+/**
+ ******************************************************************************
+ * @file    block_ram.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - RAM backed block device
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "block_ram.h"
+
+#ifndef ATMO_RAM_BLOCK_NUM_INSTANCES
+#define ATMO_RAM_BLOCK_NUM_INSTANCES (1)
+#endif
+
+static const ATMO_BLOCK_DriverInstance_t RAMBlockDriverInstance =
+{
+	ATMO_RAM_BLOCK_Init,
+	ATMO_RAM_BLOCK_Read,
+	ATMO_RAM_BLOCK_Program,
+	ATMO_RAM_BLOCK_Erase,
+	ATMO_RAM_BLOCK_Sync,
+	ATMO_RAM_BLOCK_GetDeviceInfo
+};
+
+static ATMO_DriverInstanceData_t _ATMO_RAM_BLOCK_Instances[ATMO_RAM_BLOCK_NUM_INSTANCES];
+static ATMO_RAM_BLOCK_Config_t _ATMO_RAM_BLOCK_PrivData[ATMO_RAM_BLOCK_NUM_INSTANCES];
+static unsigned int _ATMO_RAM_BLOCK_NumInstances = 0;
+
+ATMO_Status_t ATMO_RAM_BLOCK_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber, uint8_t *buf, uint32_t blockSize, uint32_t blockCount )
+{
+	ATMO_RAM_BLOCK_Config_t config = { 0 };
+	config.buf = buf;
+	config.blockSize = blockSize;
+	config.blockCount = blockCount;
+	config.progSize = 1;
+	config.readSize = 1;
+
+	return ATMO_RAM_BLOCK_AddDriverInstanceConfig( instanceNumber, &config );
+}
+
+ATMO_Status_t ATMO_RAM_BLOCK_AddDriverInstanceConfig( ATMO_DriverInstanceHandle_t *instanceNumber, const ATMO_RAM_BLOCK_Config_t *config )
+{
+	if ( _ATMO_RAM_BLOCK_NumInstances >= ATMO_RAM_BLOCK_NUM_INSTANCES || config->buf == NULL )
+	{
+		return ATMO_Status_OutOfMemory;
+	}
+
+	if ( config->progSize == 0 || config->readSize == 0 || ( config->blockSize % config->progSize ) != 0 || ( config->blockSize % config->readSize ) != 0 )
+	{
+		return ATMO_Status_InvalidInput;
+	}
+
+	ATMO_DriverInstanceData_t *driver = &_ATMO_RAM_BLOCK_Instances[_ATMO_RAM_BLOCK_NumInstances];
+	ATMO_RAM_BLOCK_Config_t *priv = &_ATMO_RAM_BLOCK_PrivData[_ATMO_RAM_BLOCK_NumInstances];
+
+	memcpy( priv, config, sizeof( ATMO_RAM_BLOCK_Config_t ) );
+
+	driver->name = "RAM Block";
+	driver->initialized = false;
+	driver->instanceNumber = _ATMO_RAM_BLOCK_NumInstances;
+	driver->argument = priv;
+
+	_ATMO_RAM_BLOCK_NumInstances++;
+
+	return ATMO_BLOCK_AddDriverInstance( &RAMBlockDriverInstance, driver, instanceNumber );
+}
+
+static ATMO_BOOL_t _ATMO_RAM_BLOCK_InRange( ATMO_RAM_BLOCK_Config_t *priv, uint32_t block, uint32_t offset, uint32_t size, uint32_t unit )
+{
+	return ( block < priv->blockCount && offset <= priv->blockSize && size <= ( priv->blockSize - offset ) &&
+	         ( offset % unit ) == 0 && ( size % unit ) == 0 );
+}
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Init( ATMO_DriverInstanceData_t *instance )
+{
+	instance->initialized = true;
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Read( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	ATMO_RAM_BLOCK_Config_t *priv = ( ATMO_RAM_BLOCK_Config_t * )instance->argument;
+
+	if ( !_ATMO_RAM_BLOCK_InRange( priv, block, offset, size, priv->readSize ) )
+	{
+		return ATMO_BLOCK_Status_Invalid;
+	}
+
+	memcpy( buffer, &priv->buf[( block * priv->blockSize ) + offset], size );
+
+	if ( priv->stats != NULL )
+	{
+		priv->stats->numReads++;
+		priv->stats->bytesRead += size;
+		priv->stats->busyUs += priv->readLatencyUs;
+	}
+
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Program( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	ATMO_RAM_BLOCK_Config_t *priv = ( ATMO_RAM_BLOCK_Config_t * )instance->argument;
+
+	if ( !_ATMO_RAM_BLOCK_InRange( priv, block, offset, size, priv->progSize ) )
+	{
+		return ATMO_BLOCK_Status_Invalid;
+	}
+
+	if ( priv->stats != NULL )
+	{
+		priv->stats->numPrograms++;
+		priv->stats->bytesProgrammed += size;
+		priv->stats->busyUs += ( uint64_t )priv->progLatencyUs * ( size / priv->progSize );
+	}
+
+	// Programming can only clear bits, same as flash
+	uint8_t *dst = &priv->buf[( block * priv->blockSize ) + offset];
+	const uint8_t *src = ( const uint8_t * )buffer;
+	uint32_t i;
+
+	for ( i = 0; i < size; i++ )
+	{
+		dst[i] &= src[i];
+	}
+
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Erase( ATMO_DriverInstanceData_t *instance, uint32_t block )
+{
+	ATMO_RAM_BLOCK_Config_t *priv = ( ATMO_RAM_BLOCK_Config_t * )instance->argument;
+
+	if ( block >= priv->blockCount )
+	{
+		return ATMO_BLOCK_Status_Invalid;
+	}
+
+	if ( priv->stats != NULL )
+	{
+		priv->stats->numErases++;
+		priv->stats->busyUs += priv->eraseLatencyUs;
+	}
+
+	memset( &priv->buf[block * priv->blockSize], 0xFF, priv->blockSize );
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Sync( ATMO_DriverInstanceData_t *instance )
+{
+	return ATMO_BLOCK_Status_Success;
+}
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_GetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info )
+{
+	ATMO_RAM_BLOCK_Config_t *priv = ( ATMO_RAM_BLOCK_Config_t * )instance->argument;
+
+	info->blockCount = priv->blockCount;
+	info->blockSize = priv->blockSize;
+	info->progSize = priv->progSize;
+	info->readSize = priv->readSize;
+	return ATMO_BLOCK_Status_Success;
+}
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * @file    block_ram.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - RAM backed block device header file
+ *
+ * Block driver on top of a caller supplied buffer. Erased blocks read back as
+ * 0xFF like NOR flash. Used to run block based storage (cloud event log,
+ * filesystems) on the host or from retention RAM. Raise
+ * NUMBER_OF_BLOCK_DRIVER_INSTANCES when it is used next to another block driver.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_RAM_BLOCK__H
+#define __ATMO_RAM_BLOCK__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "block.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+/**
+ * Operation counters, kept up to date by the driver when provided in the config.
+ * Useful to compare the traffic a filesystem generates against what it was asked to store.
+ */
+typedef struct
+{
+	uint32_t numReads;
+	uint32_t numPrograms;
+	uint32_t numErases;
+	uint32_t bytesRead;
+	uint32_t bytesProgrammed;
+	uint64_t busyUs; /**< Time the modelled flash part would have spent, from the configured latencies */
+} ATMO_RAM_BLOCK_Stats_t;
+
+typedef struct
+{
+	uint8_t *buf; /**< blockSize * blockCount bytes. On a host this can be an mmap'd (sparse) file to keep the contents */
+	uint32_t blockSize;
+	uint32_t blockCount;
+	uint32_t progSize; /**< Programs must be aligned to and a multiple of this */
+	uint32_t readSize; /**< Reads must be aligned to and a multiple of this */
+	uint32_t readLatencyUs; /**< Per read operation */
+	uint32_t progLatencyUs; /**< Per progSize unit programmed */
+	uint32_t eraseLatencyUs; /**< Per block erased */
+	ATMO_RAM_BLOCK_Stats_t *stats; /**< Optional */
+} ATMO_RAM_BLOCK_Config_t;
+
+/**
+ * Add a RAM block device. The buffer must hold blockSize * blockCount bytes and stay valid.
+ *
+ * @param[out] instanceNumber
+ * @param[in] buf
+ * @param[in] blockSize
+ * @param[in] blockCount
+ * @return status
+ */
+ATMO_Status_t ATMO_RAM_BLOCK_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber, uint8_t *buf, uint32_t blockSize, uint32_t blockCount );
+
+/**
+ * Add a RAM block device that models the geometry and timing of a flash part.
+ * The config is copied.
+ *
+ * @param[out] instanceNumber
+ * @param[in] config
+ * @return status
+ */
+ATMO_Status_t ATMO_RAM_BLOCK_AddDriverInstanceConfig( ATMO_DriverInstanceHandle_t *instanceNumber, const ATMO_RAM_BLOCK_Config_t *config );
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Init( ATMO_DriverInstanceData_t *instance );
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Read( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size );
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Program( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size );
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Erase( ATMO_DriverInstanceData_t *instance, uint32_t block );
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_Sync( ATMO_DriverInstanceData_t *instance );
+
+ATMO_BLOCK_Status_t ATMO_RAM_BLOCK_GetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_RAM_BLOCK__H */
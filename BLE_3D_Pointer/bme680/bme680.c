@@ -9,14 +9,7 @@ static uint16_t _BLE680_Meas_Delay_Ms = 0;
 
 static int8_t BME680_I2C_Write( uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len )
 {
-	uint8_t status;
-
-	uint8_t writeData[len + 1];
-
-	writeData[0] = reg_addr;
-	memcpy( &writeData[1], reg_data, len );
-
-	return ATMO_I2C_MasterWrite( _BME680_PrivConfig.i2cInstance, dev_id, NULL, 0, writeData, len + 1, 0 ) == ATMO_I2C_Status_Success ? 0 : 1;
+	return ATMO_I2C_MasterWrite( _BME680_PrivConfig.i2cInstance, dev_id, &reg_addr, 1, reg_data, len, 0 ) == ATMO_I2C_Status_Success ? 0 : 1;
 }
 
 static int8_t BME680_I2C_Read( uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t len )
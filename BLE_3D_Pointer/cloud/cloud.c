@@ -69,6 +69,24 @@ ATMO_DriverInstanceData_t *cloudInstancesData[NUMBER_OF_CLOUD_DRIVER_INSTANCES];
 
 static uint16_t _ATMO_CLOUD_ExtraSettings = 0;
 
+// Last registration written to the filesystem, so setting the same one again doesn't write
+static ATMO_CLOUD_RegistrationInfo_t savedRegInfo;
+static ATMO_BOOL_t savedRegInfoValid = false;
+
+/**
+ * Everything ATMO_CLOUD_InitFilesystemData needs from the filesystem, read in one pass.
+ */
+typedef struct
+{
+	ATMO_BOOL_t hasBuildUuid;
+	char buildUuid[ATMO_CLOUD_UUID_STR_LENGTH + 1];
+	ATMO_BOOL_t hasProjectUuid;
+	char projectUuid[ATMO_CLOUD_UUID_STR_LENGTH + 1];
+	ATMO_BOOL_t otaComplete;
+	ATMO_BOOL_t hasRegistration;
+	ATMO_CLOUD_RegistrationInfo_t registration;
+} ATMO_CLOUD_StoredState_Priv_t;
+
 typedef struct
 {
 	ATMO_Value_t value;
@@ -188,41 +206,42 @@ static void __ATMO_CLOUD_SaveProjectUuid( unsigned int fsHandle, char *projectUu
 	return;
 }
 
-static ATMO_BOOL_t __ATMO_CLOUD_IsSameProject( unsigned int fsHandle )
-{
-	char uuid[strlen( ATMO_GLOBALS_PROJECTUUID ) + 1];
-
-	if ( !__ATMO_CLOUD_GetProjectUuid( fsHandle, uuid ) )
-	{
-		return false;
-	}
-
-	return strcmp( uuid, ATMO_GLOBALS_PROJECTUUID ) == 0;
-}
-
-
-static ATMO_BOOL_t __ATMO_CLOUD_IsBootAfterOta( unsigned int fsHandle )
+static ATMO_BOOL_t __ATMO_CLOUD_GetOtaComplete( unsigned int fsHandle )
 {
 	ATMO_FILESYSTEM_File_t file;
-	ATMO_BOOL_t isBootAfterOta = false;
+	ATMO_BOOL_t otaComplete = false;
 
 	if ( ATMO_FILESYSTEM_FileOpen( fsHandle, &file, "ota_complete", ATMO_RDONLY ) == ATMO_FILESYSTEM_Status_Success )
 	{
-		if ( ATMO_FILESYSTEM_FileRead( fsHandle, &file, &isBootAfterOta, sizeof( isBootAfterOta ) ) != ATMO_FILESYSTEM_Status_Success )
+		if ( ATMO_FILESYSTEM_FileRead( fsHandle, &file, &otaComplete, sizeof( otaComplete ) ) != ATMO_FILESYSTEM_Status_Success )
 		{
-			isBootAfterOta = false;
+			otaComplete = false;
 		}
 
 		ATMO_FILESYSTEM_FileClose( fsHandle, &file );
 	}
 
-	return isBootAfterOta && __ATMO_CLOUD_IsSameProject( fsHandle );
+	return otaComplete;
+}
+
+static ATMO_BOOL_t __ATMO_CLOUD_RegistrationEqual( const ATMO_CLOUD_RegistrationInfo_t *a, const ATMO_CLOUD_RegistrationInfo_t *b )
+{
+	return ( !a->registered == !b->registered ) &&
+	       memcmp( a->uuid, b->uuid, sizeof( a->uuid ) ) == 0 &&
+	       memcmp( a->token, b->token, sizeof( a->token ) ) == 0 &&
+	       memcmp( a->url, b->url, sizeof( a->url ) ) == 0;
 }
 
 static ATMO_CLOUD_Status_t __ATMO_CLOUD_SaveRegToFileSystem( ATMO_CLOUD_RegistrationInfo_t *registration )
 {
 	ATMO_FILESYSTEM_File_t file;
 
+	// Set on every boot and by every provisioning step, mostly unchanged
+	if ( savedRegInfoValid && __ATMO_CLOUD_RegistrationEqual( registration, &savedRegInfo ) )
+	{
+		return ATMO_CLOUD_Status_Success;
+	}
+
 	if ( ATMO_FILESYSTEM_FileOpen( _filesystemInstanceHandle, &file, "registrationInfo",
 	                               ATMO_RDWR | ATMO_CREAT | ATMO_TRUNC ) != ATMO_FILESYSTEM_Status_Success )
 	{
@@ -233,11 +252,15 @@ static ATMO_CLOUD_Status_t __ATMO_CLOUD_SaveRegToFileSystem( ATMO_CLOUD_Registra
 	                                sizeof( ATMO_CLOUD_RegistrationInfo_t ) ) != ATMO_FILESYSTEM_Status_Success )
 	{
 		ATMO_FILESYSTEM_FileClose( _filesystemInstanceHandle, &file );
+		savedRegInfoValid = false;
 		return ATMO_CLOUD_Status_Fail;
 	}
 
 	ATMO_FILESYSTEM_FileClose( _filesystemInstanceHandle, &file );
 
+	memcpy( &savedRegInfo, registration, sizeof( savedRegInfo ) );
+	savedRegInfoValid = true;
+
 	return ATMO_CLOUD_Status_Success;
 }
 
@@ -268,6 +291,18 @@ ATMO_CLOUD_Status_t __ATMO_CLOUD_ReadRegFromFileSystem( ATMO_CLOUD_RegistrationI
 	return status;
 }
 
+static void __ATMO_CLOUD_LoadStoredState( unsigned int fsHandle, ATMO_CLOUD_StoredState_Priv_t *state )
+{
+	memset( state, 0, sizeof( *state ) );
+
+	state->hasBuildUuid = __ATMO_CLOUD_GetBuildUuid( fsHandle, state->buildUuid );
+	state->hasProjectUuid = __ATMO_CLOUD_GetProjectUuid( fsHandle, state->projectUuid );
+	state->otaComplete = __ATMO_CLOUD_GetOtaComplete( fsHandle );
+
+	ATMO_CLOUD_InitRegistrationInfo( &state->registration );
+	state->hasRegistration = ( __ATMO_CLOUD_ReadRegFromFileSystem( &state->registration ) == ATMO_CLOUD_Status_Success );
+}
+
 
 ATMO_Status_t ATMO_CLOUD_AddDriverInstance( const ATMO_CLOUD_DriverInstance_t *driverInstance,
         ATMO_DriverInstanceData_t *driverInstanceData, ATMO_DriverInstanceHandle_t *instanceNumber )
@@ -336,15 +371,21 @@ uint16_t ATMO_CLOUD_GetExtraRequiredSettings()
 
 ATMO_CLOUD_Status_t ATMO_CLOUD_InitFilesystemData( ATMO_DriverInstanceHandle_t filesystemDriverHandle )
 {
-	char storedBuildUuid[ATMO_CLOUD_UUID_STR_LENGTH + 1] = {0};
+	ATMO_CLOUD_StoredState_Priv_t stored;
 	ATMO_BOOL_t buildUuidMatch = false;
 	ATMO_BOOL_t bootAfterOta = false;
 
 	ATMO_BOOL_t wipeFlash = false;
 
 	_filesystemInstanceHandle = filesystemDriverHandle;
+	savedRegInfoValid = false;
 
-	if ( !__ATMO_CLOUD_GetBuildUuid( filesystemDriverHandle, storedBuildUuid ) )
+	// Everything below decides from this copy, nothing is read twice
+	__ATMO_CLOUD_LoadStoredState( filesystemDriverHandle, &stored );
+
+	ATMO_BOOL_t projectUuidMatch = stored.hasProjectUuid && strcmp( stored.projectUuid, ATMO_GLOBALS_PROJECTUUID ) == 0;
+
+	if ( !stored.hasBuildUuid )
 	{
 #ifndef ATMO_SLIM_STACK
 		ATMO_PLATFORM_DebugPrint( "Wiping Flash: Error retrieving build UUID\r\n" );
@@ -354,10 +395,10 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_InitFilesystemData( ATMO_DriverInstanceHandle_t f
 	else
 	{
 #ifndef ATMO_SLIM_STACK
-		ATMO_PLATFORM_DebugPrint( "Stored Build UUID: %s\r\nCurrent Build UUID: %s\r\n", storedBuildUuid, ATMO_GLOBALS_BUILDUUID );
+		ATMO_PLATFORM_DebugPrint( "Stored Build UUID: %s\r\nCurrent Build UUID: %s\r\n", stored.buildUuid, ATMO_GLOBALS_BUILDUUID );
 #endif
-		buildUuidMatch = strcmp( storedBuildUuid, ATMO_GLOBALS_BUILDUUID ) == 0;
-		bootAfterOta = __ATMO_CLOUD_IsBootAfterOta( filesystemDriverHandle );
+		buildUuidMatch = strcmp( stored.buildUuid, ATMO_GLOBALS_BUILDUUID ) == 0;
+		bootAfterOta = stored.otaComplete && projectUuidMatch;
 #ifndef ATMO_SLIM_STACK
 		ATMO_PLATFORM_DebugPrint( "Uuid Match %d Boot After OTA: %d\r\n", buildUuidMatch, bootAfterOta );
 #endif
@@ -371,17 +412,14 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_InitFilesystemData( ATMO_DriverInstanceHandle_t f
 		}
 	}
 
-	char storedProjectUuid[ATMO_CLOUD_UUID_STR_LENGTH + 1];
-
-	if ( !__ATMO_CLOUD_GetProjectUuid( filesystemDriverHandle, storedProjectUuid ) )
+	if ( !stored.hasProjectUuid )
 	{
 		ATMO_PLATFORM_DebugPrint( "Error getting Project UUID" );
 		wipeFlash = true;
 	}
-
-	if ( strcmp( storedProjectUuid, ATMO_GLOBALS_PROJECTUUID ) != 0 )
+	else if ( !projectUuidMatch )
 	{
-		ATMO_PLATFORM_DebugPrint( "Project UUID Mismatch. Stored: %s Expected: %s\r\n", storedProjectUuid, ATMO_GLOBALS_PROJECTUUID );
+		ATMO_PLATFORM_DebugPrint( "Project UUID Mismatch. Stored: %s Expected: %s\r\n", stored.projectUuid, ATMO_GLOBALS_PROJECTUUID );
 		wipeFlash = true;
 	}
 
@@ -389,6 +427,9 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_InitFilesystemData( ATMO_DriverInstanceHandle_t f
 	{
 		ATMO_PLATFORM_DebugPrint( "Wiping Flash\r\n" );
 		ATMO_FILESYSTEM_Wipe( filesystemDriverHandle );
+
+		stored.hasRegistration = false;
+		ATMO_CLOUD_InitRegistrationInfo( &stored.registration );
 	}
 	else
 	{
@@ -413,22 +454,30 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_InitFilesystemData( ATMO_DriverInstanceHandle_t f
 		ATMO_InitValue( &configOptions[i].value );
 	}
 
-	ATMO_PLATFORM_DebugPrint( "Saving project UUID\r\n" );
-	__ATMO_CLOUD_SaveProjectUuid( filesystemDriverHandle, ATMO_GLOBALS_PROJECTUUID );
+	// Rewriting identical UUIDs on every boot only costs flash writes
+	if ( wipeFlash )
+	{
+		ATMO_PLATFORM_DebugPrint( "Saving project UUID\r\n" );
+		__ATMO_CLOUD_SaveProjectUuid( filesystemDriverHandle, ATMO_GLOBALS_PROJECTUUID );
+	}
 
-	ATMO_PLATFORM_DebugPrint( "Saving build UUID\r\n" );
-	__ATMO_CLOUD_SaveBuildUuid( filesystemDriverHandle, ATMO_GLOBALS_BUILDUUID );
+	if ( wipeFlash || !buildUuidMatch )
+	{
+		ATMO_PLATFORM_DebugPrint( "Saving build UUID\r\n" );
+		__ATMO_CLOUD_SaveBuildUuid( filesystemDriverHandle, ATMO_GLOBALS_BUILDUUID );
+	}
 
 	ATMO_PLATFORM_DebugPrint( "Saved build UUID project UUID\r\n" );
 
 	ATMO_CLOUD_InitRegistrationInfo( &currentRegInfo );
 
-	ATMO_CLOUD_RegistrationInfo_t regInfo;
-	ATMO_CLOUD_InitRegistrationInfo( &regInfo );
-
-	ATMO_CLOUD_Status_t regReadStatus = __ATMO_CLOUD_ReadRegFromFileSystem( &regInfo );
-
-	if ( regReadStatus != ATMO_CLOUD_Status_Success )
+	if ( stored.hasRegistration )
+	{
+		// Already on the filesystem, only a change needs writing back
+		memcpy( &savedRegInfo, &stored.registration, sizeof( savedRegInfo ) );
+		savedRegInfoValid = true;
+	}
+	else
 	{
 #ifndef ATMO_SLIM_STACK
 		ATMO_PLATFORM_DebugPrint( "Error reading registration from FS. Clearning.\r\n" );
@@ -437,10 +486,10 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_InitFilesystemData( ATMO_DriverInstanceHandle_t f
 	}
 
 #ifndef ATMO_SLIM_STACK
-	ATMO_PLATFORM_DebugPrint( "Device Registered: %d\r\n", regInfo.registered );
+	ATMO_PLATFORM_DebugPrint( "Device Registered: %d\r\n", stored.registration.registered );
 #endif
 
-	ATMO_CLOUD_SetRegistration( &regInfo );
+	ATMO_CLOUD_SetRegistration( &stored.registration );
 
 
 	return ATMO_CLOUD_Status_Success;
@@ -500,6 +549,7 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_ClearRegistration()
 {
 	ATMO_FILESYSTEM_Remove( _filesystemInstanceHandle, "registrationInfo" );
 	ATMO_FILESYSTEM_Remove( _filesystemInstanceHandle, "cloudUrl" );
+	savedRegInfoValid = false;
 	ATMO_CLOUD_InitRegistrationInfo( &currentRegInfo );
 	return ATMO_CLOUD_Status_Success;
 }
@@ -0,0 +1,658 @@
+/**
+ ******************************************************************************
+ * @file    cloud_eventlog.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Persistent cloud event log
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "cloud_eventlog.h"
+
+#define ATMO_CLOUD_EVENTLOG_MAGIC (0x4C455441) // "ATEL"
+#define ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN (8)
+#define ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN (8)
+#define ATMO_CLOUD_EVENTLOG_MAX_PAYLOAD_LEN (ATMO_CLOUD_EVENTLOG_MAX_NAME_LEN + ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN)
+#define ATMO_CLOUD_EVENTLOG_MAX_RECORD_LEN (ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN + ATMO_CLOUD_EVENTLOG_MAX_PAYLOAD_LEN)
+
+typedef enum
+{
+	ATMO_CLOUD_EVENTLOG_Type_Event = 0x01,
+	ATMO_CLOUD_EVENTLOG_Type_Ack = 0x02,
+} ATMO_CLOUD_EVENTLOG_Type_t;
+
+typedef struct
+{
+	uint16_t len;
+	uint8_t type;
+	uint32_t seq;
+} ATMO_CLOUD_EVENTLOG_RecordHeader_t;
+
+typedef struct
+{
+	ATMO_BOOL_t enabled;
+	ATMO_CLOUD_EVENTLOG_Config_t config;
+	uint32_t blockSize;
+	uint32_t progSize;
+	uint32_t headBlock;
+	uint32_t headOffset;
+	uint32_t headBlockSeq;
+	uint32_t nextSeq;
+	uint32_t ackedSeq;
+	ATMO_CLOUD_EVENTLOG_Cursor_t tail; /**< Nothing before this is pending */
+	uint32_t numPending;
+	uint32_t numDropped;
+} ATMO_CLOUD_EVENTLOG_State_t;
+
+static ATMO_CLOUD_EVENTLOG_State_t _ATMO_CLOUD_EVENTLOG_State;
+
+// Records are built and checked here, the payload follows the header
+static uint8_t _ATMO_CLOUD_EVENTLOG_RecordBuf[ATMO_CLOUD_EVENTLOG_MAX_RECORD_LEN];
+
+static void _ATMO_CLOUD_EVENTLOG_PutU32( uint8_t *buf, uint32_t value )
+{
+	buf[0] = value & 0xFF;
+	buf[1] = ( value >> 8 ) & 0xFF;
+	buf[2] = ( value >> 16 ) & 0xFF;
+	buf[3] = ( value >> 24 ) & 0xFF;
+}
+
+static uint32_t _ATMO_CLOUD_EVENTLOG_GetU32( const uint8_t *buf )
+{
+	return ( uint32_t )buf[0] | ( ( uint32_t )buf[1] << 8 ) | ( ( uint32_t )buf[2] << 16 ) | ( ( uint32_t )buf[3] << 24 );
+}
+
+static uint8_t _ATMO_CLOUD_EVENTLOG_Crc8( uint8_t crc, const uint8_t *data, uint32_t len )
+{
+	uint32_t i;
+	unsigned int bit;
+
+	for ( i = 0; i < len; i++ )
+	{
+		crc ^= data[i];
+
+		for ( bit = 0; bit < 8; bit++ )
+		{
+			crc = ( crc & 0x80 ) ? ( uint8_t )( ( crc << 1 ) ^ 0x07 ) : ( uint8_t )( crc << 1 );
+		}
+	}
+
+	return crc;
+}
+
+/**
+ * CRC of a record in the record buffer, covering everything but the CRC byte itself.
+ */
+static uint8_t _ATMO_CLOUD_EVENTLOG_RecordCrc( uint16_t payloadLen )
+{
+	uint8_t crc = _ATMO_CLOUD_EVENTLOG_Crc8( 0xFF, _ATMO_CLOUD_EVENTLOG_RecordBuf, 3 );
+	return _ATMO_CLOUD_EVENTLOG_Crc8( crc, &_ATMO_CLOUD_EVENTLOG_RecordBuf[4], ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN - 4 + payloadLen );
+}
+
+static uint32_t _ATMO_CLOUD_EVENTLOG_RecordSize( uint16_t payloadLen )
+{
+	uint32_t progSize = _ATMO_CLOUD_EVENTLOG_State.progSize;
+	return ( ( ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN + payloadLen + progSize - 1 ) / progSize ) * progSize;
+}
+
+static uint32_t _ATMO_CLOUD_EVENTLOG_NextBlock( uint32_t block )
+{
+	return ( block + 1 ) % _ATMO_CLOUD_EVENTLOG_State.config.numBlocks;
+}
+
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_BlockRead( uint32_t block, uint32_t offset, void *buf, uint32_t size )
+{
+	ATMO_CLOUD_EVENTLOG_Config_t *config = &_ATMO_CLOUD_EVENTLOG_State.config;
+	return ATMO_BLOCK_Read( config->blockInstance, config->firstBlock + block, offset, buf, size ) == ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_BlockProgram( uint32_t block, uint32_t offset, void *buf, uint32_t size )
+{
+	ATMO_CLOUD_EVENTLOG_Config_t *config = &_ATMO_CLOUD_EVENTLOG_State.config;
+	return ATMO_BLOCK_Program( config->blockInstance, config->firstBlock + block, offset, buf, size ) == ATMO_BLOCK_Status_Success;
+}
+
+/**
+ * Read the block sequence of a block.
+ *
+ * @return false if the block doesn't hold a log block header
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_ReadBlockHeader( uint32_t block, uint32_t *blockSeq )
+{
+	uint8_t header[ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN];
+
+	if ( !_ATMO_CLOUD_EVENTLOG_BlockRead( block, 0, header, sizeof( header ) ) ||
+	        _ATMO_CLOUD_EVENTLOG_GetU32( header ) != ATMO_CLOUD_EVENTLOG_MAGIC )
+	{
+		return false;
+	}
+
+	*blockSeq = _ATMO_CLOUD_EVENTLOG_GetU32( &header[4] );
+	return true;
+}
+
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_StartBlock( uint32_t block, uint32_t blockSeq )
+{
+	ATMO_CLOUD_EVENTLOG_Config_t *config = &_ATMO_CLOUD_EVENTLOG_State.config;
+	uint8_t header[ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN];
+
+	if ( ATMO_BLOCK_Erase( config->blockInstance, config->firstBlock + block ) != ATMO_BLOCK_Status_Success )
+	{
+		return false;
+	}
+
+	_ATMO_CLOUD_EVENTLOG_PutU32( header, ATMO_CLOUD_EVENTLOG_MAGIC );
+	_ATMO_CLOUD_EVENTLOG_PutU32( &header[4], blockSeq );
+
+	if ( !_ATMO_CLOUD_EVENTLOG_BlockProgram( block, 0, header, sizeof( header ) ) )
+	{
+		return false;
+	}
+
+	_ATMO_CLOUD_EVENTLOG_State.headBlock = block;
+	_ATMO_CLOUD_EVENTLOG_State.headBlockSeq = blockSeq;
+	_ATMO_CLOUD_EVENTLOG_State.headOffset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+	return true;
+}
+
+/**
+ * Read and check the record at a position. The payload ends up in the record buffer.
+ *
+ * @return false if there is no intact record at the position
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_ReadRecord( uint32_t block, uint32_t offset, ATMO_CLOUD_EVENTLOG_RecordHeader_t *header )
+{
+	uint8_t *buf = _ATMO_CLOUD_EVENTLOG_RecordBuf;
+	uint32_t blockSize = _ATMO_CLOUD_EVENTLOG_State.blockSize;
+
+	if ( offset + ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN > blockSize ||
+	        !_ATMO_CLOUD_EVENTLOG_BlockRead( block, offset, buf, ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN ) )
+	{
+		return false;
+	}
+
+	header->len = buf[0] | ( buf[1] << 8 );
+	header->type = buf[2];
+	header->seq = _ATMO_CLOUD_EVENTLOG_GetU32( &buf[4] );
+
+	if ( ( header->type != ATMO_CLOUD_EVENTLOG_Type_Event && header->type != ATMO_CLOUD_EVENTLOG_Type_Ack ) ||
+	        header->len > ATMO_CLOUD_EVENTLOG_MAX_PAYLOAD_LEN ||
+	        offset + ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN + header->len > blockSize )
+	{
+		return false;
+	}
+
+	if ( header->len > 0 && !_ATMO_CLOUD_EVENTLOG_BlockRead( block, offset + ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN, &buf[ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN], header->len ) )
+	{
+		return false;
+	}
+
+	return _ATMO_CLOUD_EVENTLOG_RecordCrc( header->len ) == buf[3];
+}
+
+/**
+ * Read the record at the cursor and move the cursor past it, following the
+ * log into the next block at the end of a block.
+ *
+ * @return false at the end of the log
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_Next( ATMO_CLOUD_EVENTLOG_Cursor_t *cursor, ATMO_CLOUD_EVENTLOG_RecordHeader_t *header )
+{
+	while ( true )
+	{
+		if ( _ATMO_CLOUD_EVENTLOG_ReadRecord( cursor->block, cursor->offset, header ) )
+		{
+			cursor->offset += _ATMO_CLOUD_EVENTLOG_RecordSize( header->len );
+			return true;
+		}
+
+		if ( cursor->block == _ATMO_CLOUD_EVENTLOG_State.headBlock )
+		{
+			return false;
+		}
+
+		cursor->block = _ATMO_CLOUD_EVENTLOG_NextBlock( cursor->block );
+		cursor->offset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+	}
+}
+
+/**
+ * Write the record in the record buffer at the head. The caller makes sure it fits.
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_EVENTLOG_WriteRecord( ATMO_CLOUD_EVENTLOG_Type_t type, uint32_t seq, uint16_t payloadLen )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+	uint8_t *buf = _ATMO_CLOUD_EVENTLOG_RecordBuf;
+	uint32_t size = _ATMO_CLOUD_EVENTLOG_RecordSize( payloadLen );
+
+	buf[0] = payloadLen & 0xFF;
+	buf[1] = ( payloadLen >> 8 ) & 0xFF;
+	buf[2] = type;
+	_ATMO_CLOUD_EVENTLOG_PutU32( &buf[4], seq );
+	buf[3] = _ATMO_CLOUD_EVENTLOG_RecordCrc( payloadLen );
+
+	// Padding stays erased
+	memset( &buf[ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN + payloadLen], 0xFF, size - ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN - payloadLen );
+
+	if ( !_ATMO_CLOUD_EVENTLOG_BlockProgram( state->headBlock, state->headOffset, buf, size ) )
+	{
+		return false;
+	}
+
+	state->headOffset += size;
+	return ATMO_BLOCK_Sync( state->config.blockInstance ) == ATMO_BLOCK_Status_Success;
+}
+
+/**
+ * Move the head to the next block, making room according to the retention policy.
+ */
+static ATMO_CLOUD_EVENTLOG_Status_t _ATMO_CLOUD_EVENTLOG_Rotate( void )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+	uint32_t next = _ATMO_CLOUD_EVENTLOG_NextBlock( state->headBlock );
+
+	if ( state->numPending == 0 )
+	{
+		state->tail.block = next;
+		state->tail.offset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+	}
+	else if ( state->tail.block == next )
+	{
+		if ( state->config.policy == ATMO_CLOUD_EVENTLOG_Policy_RejectNew )
+		{
+			return ATMO_CLOUD_EVENTLOG_Status_Full;
+		}
+
+		// Treat the undelivered events of the oldest block as delivered, the log just forgets them
+		ATMO_CLOUD_EVENTLOG_RecordHeader_t header;
+		uint32_t offset = state->tail.offset;
+
+		while ( _ATMO_CLOUD_EVENTLOG_ReadRecord( next, offset, &header ) )
+		{
+			if ( header.type == ATMO_CLOUD_EVENTLOG_Type_Event && header.seq > state->ackedSeq )
+			{
+				state->ackedSeq = header.seq;
+				state->numPending--;
+				state->numDropped++;
+			}
+
+			offset += _ATMO_CLOUD_EVENTLOG_RecordSize( header.len );
+		}
+
+		state->tail.block = _ATMO_CLOUD_EVENTLOG_NextBlock( next );
+		state->tail.offset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+	}
+
+	if ( !_ATMO_CLOUD_EVENTLOG_StartBlock( next, state->headBlockSeq + 1 ) )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Fail;
+	}
+
+	// Older blocks holding acknowledgements may get erased from now on
+	if ( state->ackedSeq > 0 && !_ATMO_CLOUD_EVENTLOG_WriteRecord( ATMO_CLOUD_EVENTLOG_Type_Ack, state->ackedSeq, 0 ) )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Fail;
+	}
+
+	return ATMO_CLOUD_EVENTLOG_Status_Success;
+}
+
+/**
+ * Make sure a record fits at the head.
+ */
+static ATMO_CLOUD_EVENTLOG_Status_t _ATMO_CLOUD_EVENTLOG_Reserve( uint16_t payloadLen )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+
+	if ( state->headOffset + _ATMO_CLOUD_EVENTLOG_RecordSize( payloadLen ) <= state->blockSize )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Success;
+	}
+
+	return _ATMO_CLOUD_EVENTLOG_Rotate();
+}
+
+/**
+ * Rebuild the state from the blocks after a reset.
+ */
+static ATMO_CLOUD_EVENTLOG_Status_t _ATMO_CLOUD_EVENTLOG_Mount( void )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+	uint32_t numBlocks = state->config.numBlocks;
+	ATMO_BOOL_t found = false;
+	uint32_t blockSeq = 0;
+	uint32_t i;
+
+	state->nextSeq = 1;
+	state->ackedSeq = 0;
+	state->numPending = 0;
+
+	// The head is the block written last
+	for ( i = 0; i < numBlocks; i++ )
+	{
+		if ( _ATMO_CLOUD_EVENTLOG_ReadBlockHeader( i, &blockSeq ) && ( !found || ( int32_t )( blockSeq - state->headBlockSeq ) > 0 ) )
+		{
+			found = true;
+			state->headBlock = i;
+			state->headBlockSeq = blockSeq;
+		}
+	}
+
+	if ( !found )
+	{
+		state->tail.block = 0;
+		state->tail.offset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+		return _ATMO_CLOUD_EVENTLOG_StartBlock( 0, 0 ) ? ATMO_CLOUD_EVENTLOG_Status_Success : ATMO_CLOUD_EVENTLOG_Status_Fail;
+	}
+
+	// Blocks are written in order, walk back to the oldest one still in sequence
+	uint32_t oldest = state->headBlock;
+	uint32_t oldestSeq = state->headBlockSeq;
+
+	for ( i = 1; i < numBlocks; i++ )
+	{
+		uint32_t prev = ( oldest + numBlocks - 1 ) % numBlocks;
+
+		if ( !_ATMO_CLOUD_EVENTLOG_ReadBlockHeader( prev, &blockSeq ) || blockSeq != oldestSeq - 1 )
+		{
+			break;
+		}
+
+		oldest = prev;
+		oldestSeq = blockSeq;
+	}
+
+	ATMO_CLOUD_EVENTLOG_Cursor_t cursor = { oldest, ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN };
+	ATMO_CLOUD_EVENTLOG_RecordHeader_t header;
+
+	state->headOffset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+
+	while ( _ATMO_CLOUD_EVENTLOG_Next( &cursor, &header ) )
+	{
+		if ( header.type == ATMO_CLOUD_EVENTLOG_Type_Ack )
+		{
+			state->ackedSeq = ( header.seq > state->ackedSeq ) ? header.seq : state->ackedSeq;
+		}
+		else if ( header.seq >= state->nextSeq )
+		{
+			state->nextSeq = header.seq + 1;
+		}
+
+		if ( cursor.block == state->headBlock )
+		{
+			state->headOffset = cursor.offset;
+		}
+	}
+
+	if ( state->ackedSeq >= state->nextSeq )
+	{
+		state->nextSeq = state->ackedSeq + 1;
+	}
+
+	// A write was cut short, the rest of the head block can't be programmed reliably
+	uint8_t lenBytes[2] = {0};
+
+	if ( state->headOffset + ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN <= state->blockSize &&
+	        ( !_ATMO_CLOUD_EVENTLOG_BlockRead( state->headBlock, state->headOffset, lenBytes, sizeof( lenBytes ) ) ||
+	          lenBytes[0] != 0xFF || lenBytes[1] != 0xFF ) )
+	{
+		state->headOffset = state->blockSize;
+	}
+
+	// Find the first event that still has to be delivered
+	cursor.block = oldest;
+	cursor.offset = ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN;
+	state->tail = cursor;
+
+	ATMO_BOOL_t tailFound = false;
+	ATMO_CLOUD_EVENTLOG_Cursor_t before = cursor;
+
+	while ( _ATMO_CLOUD_EVENTLOG_Next( &cursor, &header ) )
+	{
+		if ( header.type == ATMO_CLOUD_EVENTLOG_Type_Event && header.seq > state->ackedSeq )
+		{
+			if ( !tailFound )
+			{
+				state->tail = before;
+				tailFound = true;
+			}
+
+			state->numPending++;
+		}
+
+		before = cursor;
+	}
+
+	if ( !tailFound )
+	{
+		state->tail = cursor;
+	}
+
+	return ATMO_CLOUD_EVENTLOG_Status_Success;
+}
+
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Init( const ATMO_CLOUD_EVENTLOG_Config_t *config )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+	ATMO_BLOCK_DeviceInfo_t info;
+
+	memset( state, 0, sizeof( *state ) );
+
+	if ( config == NULL || config->numBlocks < 2 ||
+	        ATMO_BLOCK_GetDeviceInfo( config->blockInstance, &info ) != ATMO_BLOCK_Status_Success ||
+	        config->firstBlock + config->numBlocks > info.blockCount || info.progSize == 0 )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Invalid;
+	}
+
+	memcpy( &state->config, config, sizeof( state->config ) );
+	state->blockSize = info.blockSize;
+	state->progSize = info.progSize;
+
+	// The largest event and the acknowledgement opening a block must fit in an empty block
+	if ( ATMO_CLOUD_EVENTLOG_BLOCK_HEADER_LEN + _ATMO_CLOUD_EVENTLOG_RecordSize( 0 ) + _ATMO_CLOUD_EVENTLOG_RecordSize( ATMO_CLOUD_EVENTLOG_MAX_PAYLOAD_LEN ) > info.blockSize )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Invalid;
+	}
+
+	ATMO_CLOUD_EVENTLOG_Status_t status = _ATMO_CLOUD_EVENTLOG_Mount();
+	state->enabled = ( status == ATMO_CLOUD_EVENTLOG_Status_Success );
+	return status;
+}
+
+ATMO_BOOL_t ATMO_CLOUD_EVENTLOG_IsEnabled( void )
+{
+	return _ATMO_CLOUD_EVENTLOG_State.enabled;
+}
+
+ATMO_BOOL_t ATMO_CLOUD_EVENTLOG_IsEmpty( void )
+{
+	return _ATMO_CLOUD_EVENTLOG_State.numPending == 0;
+}
+
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Append( const char *name, const char *data, uint32_t *seq )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+
+	if ( !state->enabled || name == NULL )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Invalid;
+	}
+
+	uint16_t nameLen = strnlen( name, ATMO_CLOUD_EVENTLOG_MAX_NAME_LEN - 1 );
+	uint16_t dataLen = ( data == NULL ) ? 0 : strnlen( data, ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN - 1 );
+	uint16_t payloadLen = nameLen + 1 + dataLen;
+
+	ATMO_CLOUD_EVENTLOG_Status_t status = _ATMO_CLOUD_EVENTLOG_Reserve( payloadLen );
+
+	if ( status != ATMO_CLOUD_EVENTLOG_Status_Success )
+	{
+		return status;
+	}
+
+	// Rotating may have used the record buffer, fill it in afterwards
+	uint8_t *payload = &_ATMO_CLOUD_EVENTLOG_RecordBuf[ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN];
+	memcpy( payload, name, nameLen );
+	payload[nameLen] = 0;
+
+	if ( dataLen > 0 )
+	{
+		memcpy( &payload[nameLen + 1], data, dataLen );
+	}
+
+	if ( !_ATMO_CLOUD_EVENTLOG_WriteRecord( ATMO_CLOUD_EVENTLOG_Type_Event, state->nextSeq, payloadLen ) )
+	{
+		// Don't write over whatever made it into the block
+		state->headOffset = state->blockSize;
+		return ATMO_CLOUD_EVENTLOG_Status_Fail;
+	}
+
+	if ( seq != NULL )
+	{
+		*seq = state->nextSeq;
+	}
+
+	state->nextSeq++;
+	state->numPending++;
+	return ATMO_CLOUD_EVENTLOG_Status_Success;
+}
+
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Begin( ATMO_CLOUD_EVENTLOG_Cursor_t *cursor )
+{
+	if ( !_ATMO_CLOUD_EVENTLOG_State.enabled || cursor == NULL )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Invalid;
+	}
+
+	*cursor = _ATMO_CLOUD_EVENTLOG_State.tail;
+	return ATMO_CLOUD_EVENTLOG_Status_Success;
+}
+
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Read( ATMO_CLOUD_EVENTLOG_Cursor_t *cursor, ATMO_CLOUD_EVENTLOG_Record_t *record )
+{
+	ATMO_CLOUD_EVENTLOG_RecordHeader_t header;
+
+	if ( !_ATMO_CLOUD_EVENTLOG_State.enabled || cursor == NULL || record == NULL )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Invalid;
+	}
+
+	while ( _ATMO_CLOUD_EVENTLOG_Next( cursor, &header ) )
+	{
+		if ( header.type != ATMO_CLOUD_EVENTLOG_Type_Event || header.seq <= _ATMO_CLOUD_EVENTLOG_State.ackedSeq )
+		{
+			continue;
+		}
+
+		const char *payload = ( const char * )&_ATMO_CLOUD_EVENTLOG_RecordBuf[ATMO_CLOUD_EVENTLOG_RECORD_HEADER_LEN];
+		uint16_t nameLen = strnlen( payload, header.len );
+		uint16_t dataLen = ( nameLen < header.len ) ? header.len - nameLen - 1 : 0;
+
+		if ( nameLen >= ATMO_CLOUD_EVENTLOG_MAX_NAME_LEN || dataLen >= ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN )
+		{
+			continue;
+		}
+
+		record->seq = header.seq;
+		memcpy( record->name, payload, nameLen );
+		record->name[nameLen] = 0;
+		memcpy( record->data, &payload[nameLen + 1], dataLen );
+		record->data[dataLen] = 0;
+		record->hasData = ( dataLen > 0 );
+		return ATMO_CLOUD_EVENTLOG_Status_Success;
+	}
+
+	return ATMO_CLOUD_EVENTLOG_Status_NoData;
+}
+
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Ack( uint32_t seq )
+{
+	ATMO_CLOUD_EVENTLOG_State_t *state = &_ATMO_CLOUD_EVENTLOG_State;
+
+	if ( !state->enabled || seq >= state->nextSeq )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Invalid;
+	}
+
+	if ( seq <= state->ackedSeq )
+	{
+		return ATMO_CLOUD_EVENTLOG_Status_Success;
+	}
+
+	state->ackedSeq = seq;
+
+	// Move the tail up to the first event that is still pending
+	ATMO_CLOUD_EVENTLOG_Cursor_t cursor = state->tail;
+	ATMO_CLOUD_EVENTLOG_Cursor_t before = cursor;
+	ATMO_CLOUD_EVENTLOG_RecordHeader_t header;
+
+	while ( _ATMO_CLOUD_EVENTLOG_Next( &cursor, &header ) )
+	{
+		if ( header.type == ATMO_CLOUD_EVENTLOG_Type_Event )
+		{
+			if ( header.seq > seq )
+			{
+				cursor = before;
+				break;
+			}
+
+			if ( state->numPending > 0 )
+			{
+				state->numPending--;
+			}
+		}
+
+		before = cursor;
+	}
+
+	state->tail = cursor;
+
+	// One acknowledgement record for the whole batch, a new block starts with it anyway
+	if ( state->headOffset + _ATMO_CLOUD_EVENTLOG_RecordSize( 0 ) > state->blockSize )
+	{
+		return _ATMO_CLOUD_EVENTLOG_Rotate();
+	}
+
+	if ( !_ATMO_CLOUD_EVENTLOG_WriteRecord( ATMO_CLOUD_EVENTLOG_Type_Ack, seq, 0 ) )
+	{
+		state->headOffset = state->blockSize;
+		return ATMO_CLOUD_EVENTLOG_Status_Fail;
+	}
+
+	return ATMO_CLOUD_EVENTLOG_Status_Success;
+}
+
+void ATMO_CLOUD_EVENTLOG_GetStats( ATMO_CLOUD_EVENTLOG_Stats_t *stats )
+{
+	stats->numPending = _ATMO_CLOUD_EVENTLOG_State.numPending;
+	stats->numDropped = _ATMO_CLOUD_EVENTLOG_State.numDropped;
+	stats->nextSeq = _ATMO_CLOUD_EVENTLOG_State.nextSeq;
+	stats->ackedSeq = _ATMO_CLOUD_EVENTLOG_State.ackedSeq;
+}
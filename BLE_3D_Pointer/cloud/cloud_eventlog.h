@@ -0,0 +1,197 @@
+/**
+ ******************************************************************************
+ * @file    cloud_eventlog.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Persistent cloud event log header file
+ *
+ * Store-and-forward log for cloud events that could not be sent right away.
+ * Events are appended with increasing sequence numbers to a range of blocks
+ * of any ATMO_BLOCK device, replayed in order once the cloud is reachable and
+ * released with one acknowledgement per uploaded batch.
+ *
+ * Every block starts with < Magic (4 Bytes) >< Block Sequence (4 Bytes) >,
+ * followed by records (all fields little endian):
+ *
+ * < Payload Length (2 Bytes) >< Type (1 Byte) >< CRC-8 (1 Byte) >< Sequence (4 Bytes) >
+ * < Payload >
+ *
+ * Event payloads are the event name and the data string, separated by a NULL.
+ * Acknowledgement records carry no payload, their sequence is the last event
+ * that was delivered. Every new block starts with an acknowledgement record so
+ * the delivery state survives the oldest block being erased.
+ *
+ * The log needs at least two blocks. Once it is full the retention policy
+ * decides whether the oldest undelivered block is dropped or new events are
+ * rejected (back-pressure to the caller).
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_CLOUD_EVENTLOG__H
+#define __ATMO_CLOUD_EVENTLOG__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "../atmo/core.h"
+#include "../block/block.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+#ifndef ATMO_CLOUD_EVENTLOG_MAX_NAME_LEN
+#define ATMO_CLOUD_EVENTLOG_MAX_NAME_LEN (32)
+#endif
+
+#ifndef ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN
+#define ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN (64)
+#endif
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+typedef enum
+{
+	ATMO_CLOUD_EVENTLOG_Status_Success              = 0x00u,  /**< Operation was successful */
+	ATMO_CLOUD_EVENTLOG_Status_Fail                 = 0x01u,  /**< Operation failed */
+	ATMO_CLOUD_EVENTLOG_Status_Invalid              = 0x02u,  /**< Invalid argument or log not initialized */
+	ATMO_CLOUD_EVENTLOG_Status_Full                 = 0x03u,  /**< No room left and the policy rejects new events */
+	ATMO_CLOUD_EVENTLOG_Status_NoData               = 0x04u,  /**< No more undelivered events */
+} ATMO_CLOUD_EVENTLOG_Status_t;
+
+typedef enum
+{
+	ATMO_CLOUD_EVENTLOG_Policy_DropOldest, /**< Erase the oldest block, undelivered events in it are lost */
+	ATMO_CLOUD_EVENTLOG_Policy_RejectNew, /**< Keep everything and fail new appends until events are acknowledged */
+} ATMO_CLOUD_EVENTLOG_Policy_t;
+
+typedef struct
+{
+	ATMO_DriverInstanceHandle_t blockInstance;
+	uint32_t firstBlock; /**< First block of the device used by the log */
+	uint32_t numBlocks; /**< Number of blocks used by the log, at least 2 */
+	ATMO_CLOUD_EVENTLOG_Policy_t policy;
+} ATMO_CLOUD_EVENTLOG_Config_t;
+
+/**
+ * Read position within the log.
+ */
+typedef struct
+{
+	uint32_t block;
+	uint32_t offset;
+} ATMO_CLOUD_EVENTLOG_Cursor_t;
+
+typedef struct
+{
+	uint32_t seq;
+	ATMO_BOOL_t hasData;
+	char name[ATMO_CLOUD_EVENTLOG_MAX_NAME_LEN];
+	char data[ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN];
+} ATMO_CLOUD_EVENTLOG_Record_t;
+
+typedef struct
+{
+	uint32_t numPending; /**< Events not acknowledged yet */
+	uint32_t numDropped; /**< Events dropped by the retention policy since init */
+	uint32_t nextSeq;
+	uint32_t ackedSeq;
+} ATMO_CLOUD_EVENTLOG_Stats_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Mount the log, formatting the block range if it doesn't hold a log yet.
+ *
+ * @param[in] config
+ * @return status
+ */
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Init( const ATMO_CLOUD_EVENTLOG_Config_t *config );
+
+/**
+ * @return true if the log was initialized successfully
+ */
+ATMO_BOOL_t ATMO_CLOUD_EVENTLOG_IsEnabled( void );
+
+/**
+ * @return true if every logged event was acknowledged
+ */
+ATMO_BOOL_t ATMO_CLOUD_EVENTLOG_IsEmpty( void );
+
+/**
+ * Append an event.
+ *
+ * @param[in] name - Event name
+ * @param[in] data - Event data as a string, can be NULL
+ * @param[out] seq - Sequence number of the event, can be NULL
+ * @return Full if the log is full and the policy rejects new events
+ */
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Append( const char *name, const char *data, uint32_t *seq );
+
+/**
+ * Get a cursor at the oldest event that wasn't acknowledged.
+ *
+ * @param[out] cursor
+ * @return status
+ */
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Begin( ATMO_CLOUD_EVENTLOG_Cursor_t *cursor );
+
+/**
+ * Read the event at the cursor and advance it. Reading doesn't remove events,
+ * they stay in the log until acknowledged.
+ *
+ * @param[in,out] cursor
+ * @param[out] record
+ * @return NoData once there are no more events
+ */
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Read( ATMO_CLOUD_EVENTLOG_Cursor_t *cursor, ATMO_CLOUD_EVENTLOG_Record_t *record );
+
+/**
+ * Acknowledge every event up to and including a sequence number.
+ *
+ * @param[in] seq
+ * @return status
+ */
+ATMO_CLOUD_EVENTLOG_Status_t ATMO_CLOUD_EVENTLOG_Ack( uint32_t seq );
+
+/**
+ * @param[out] stats
+ */
+void ATMO_CLOUD_EVENTLOG_GetStats( ATMO_CLOUD_EVENTLOG_Stats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_CLOUD_EVENTLOG__H */
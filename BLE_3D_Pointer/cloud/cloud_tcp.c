@@ -41,8 +41,10 @@
 #include "../datetime/datetime.h"
 #include "../wifi/wifi.h"
 #include "cloud_provisioner.h"
+#include "cloud_eventlog.h"
 #include "../base64/atmo_base64.h"
 #include "../atmo/core.h"
+#include "../atmo/atmo_valuecodec.h"
 #include "../tcpserver/tcpserver.h"
 #include "../http/http.h"
 #include "../interval/interval.h"
@@ -53,6 +55,12 @@
 
 #define ATMO_MAX_NUM_CLOUD_TCP_INSTANCES (2)
 
+// The poll response is scanned as it arrives, only one {"name":..,"command":..}
+// entry is held at a time. Longer entries are skipped.
+#ifndef ATMO_CLOUD_TCP_COMMAND_ENTRY_MAX_LEN
+#define ATMO_CLOUD_TCP_COMMAND_ENTRY_MAX_LEN (128)
+#endif
+
 static const ATMO_CLOUD_DriverInstance_t cloudTcpDriverInstance =
 {
 	ATMO_CLOUD_TCP_Init,
@@ -60,6 +68,20 @@ static const ATMO_CLOUD_DriverInstance_t cloudTcpDriverInstance =
 	ATMO_CLOUD_TCP_PopCommand
 };
 
+/**
+ * Position of the command poll response scanner within the JSON body.
+ */
+typedef struct
+{
+	uint8_t depth;
+	ATMO_BOOL_t inString;
+	ATMO_BOOL_t escaped;
+	ATMO_BOOL_t overflow;
+	uint16_t entryLen;
+	unsigned int numCommands;
+	char entry[ATMO_CLOUD_TCP_COMMAND_ENTRY_MAX_LEN + 1];
+} ATMO_CLOUD_TCP_CommandScanner_t;
+
 typedef struct
 {
 	ATMO_DriverInstanceData_t instance;
@@ -71,6 +93,22 @@ typedef struct
 	ATMO_DriverType_t networkType;
 	ATMO_RingBuffer_t eventQueue;
 	uint32_t instanceNum;
+	uint64_t lastCommandCheck;
+	uint32_t lastCommandWaitMs; /**< Long poll wait of the last successful command poll */
+	uint32_t commandPollWaitMs; /**< Long poll wait of the command poll in flight */
+	ATMO_BOOL_t commandPollInFlight;
+	ATMO_BOOL_t commandPopAllUnsupported;
+	unsigned int nextCommand; /**< Next command to pop on servers that only pop one at a time */
+	ATMO_CLOUD_TCP_CommandScanner_t commandScanner;
+	uint32_t replayLastSeq; /**< Last logged event in the upload in flight */
+	uint64_t replayRetryMs; /**< Don't replay the event log before this uptime */
+	ATMO_DriverInstanceHandle_t cloudInstance;
+	ATMO_CLOUD_TCP_Metrics_t metrics;
+	uint64_t retryAtMs; /**< Back-off or open circuit, no requests before this uptime */
+	uint32_t jitterSeed;
+	uint64_t requestStartMs; /**< Start of the event upload in flight */
+	uint32_t requestBytes;
+	uint8_t requestNumEvents; /**< Queued events in the upload in flight, lost if it fails */
 } ATMO_CLOUD_TCP_Priv_t;
 
 static ATMO_CLOUD_TCP_Priv_t _ATMO_CLOUD_TCP_PrivData[ATMO_MAX_NUM_CLOUD_TCP_INSTANCES];
@@ -83,9 +121,12 @@ static ATMO_BOOL_t _ATMO_CLOUD_TCP_Connected = false;
 static ATMO_DriverInstanceHandle_t _ATMO_CLOUD_TCP_TcpServerInstance = 0; // There should only be one TCP server running on a system at a time
 
 char rfc3986[256] = {0};
+static const char _ATMO_CLOUD_TCP_Hex[] = "0123456789ABCDEF";
 
-static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendEvent( ATMO_DriverInstanceData_t *instance, const char *eventName, ATMO_Value_t *data, uint32_t timeout );
-static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instance, const char *commandName, ATMO_Value_t *data, uint32_t timeout );
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instance, const char *commandName );
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendEventBatch( ATMO_DriverInstanceData_t *instance );
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendLoggedEvents( ATMO_DriverInstanceData_t *instance );
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopAllCommands( ATMO_DriverInstanceData_t *instance, uint32_t waitMs );
 
 typedef enum
 {
@@ -100,21 +141,101 @@ typedef struct
 {
 	ATMO_BOOL_t isEvent;
 	char name[ATMO_CLOUD_MAX_NAME_LEN];
-	ATMO_Value_t value;
+	ATMO_Value_t value; /**< Events are converted to a string when they are queued (binary batches keep the original type) */
+	uint32_t queuedMs; /**< Uptime when the entry was queued */
+	uint16_t batchLen; /**< Worst case size of the entry in a batch body */
 } ATMO_CLOUD_Entry_t;
 
 #ifndef ATMO_CLOUD_TCP_QUEUE_SIZE
 #define ATMO_CLOUD_TCP_QUEUE_SIZE (10)
 #endif
 
+// Queued events are uploaded together in one POST to /thing/<uuid>/events once
+// any of these limits is hit (or the queue is full). The body is a JSON array:
+// [{"name":"<event>","data":"<value>","age":<ms since queued>},...]
+// The HTTP packet buffer must be able to hold the body plus the request headers.
+#ifndef ATMO_CLOUD_TCP_BATCH_MAX_EVENTS
+#define ATMO_CLOUD_TCP_BATCH_MAX_EVENTS (8)
+#endif
+
+#ifndef ATMO_CLOUD_TCP_BATCH_MAX_BYTES
+#define ATMO_CLOUD_TCP_BATCH_MAX_BYTES (512)
+#endif
+
+#ifndef ATMO_CLOUD_TCP_BATCH_MAX_AGE_MS
+#define ATMO_CLOUD_TCP_BATCH_MAX_AGE_MS (2000)
+#endif
+
+// ,{"name":"","data":null,"age":4294967295} plus the NULL terminator
+#define ATMO_CLOUD_TCP_BATCH_ENTRY_OVERHEAD (42)
+
+// With ATMO_CLOUD_TCP_BINARY_EVENTS defined (the server has to support it) the
+// batch body is sent as application/x-atmo-events instead of JSON, and values
+// keep their type instead of being converted to a string:
+// < Version (1 Byte) >< Event Count (1 Byte) >
+// followed by Event Count entries of
+// < Name Length (varint) >< Name >< Age ms (varint) >< Value (see atmo_valuecodec.h) >
+#ifdef ATMO_CLOUD_TCP_BINARY_EVENTS
+#if ATMO_CLOUD_TCP_BATCH_MAX_EVENTS > 127
+#error "The binary batch event count must fit in a single byte varint"
+#endif
+#define ATMO_CLOUD_TCP_BATCH_HEADER_LEN (2)
+#define ATMO_CLOUD_TCP_BATCH_CONTENT_TYPE "application/x-atmo-events"
+#else
+#define ATMO_CLOUD_TCP_BATCH_HEADER_LEN (1)
+#define ATMO_CLOUD_TCP_BATCH_CONTENT_TYPE "application/json"
+#endif
+
+// Events that can't be queued (no connection or the queue is full) go to the
+// persistent event log if one was set up with ATMO_CLOUD_EVENTLOG_Init. Logged
+// events are uploaded in order with the same batch POST once the queue is empty,
+// as [{"name":"<event>","data":"<value>","seq":<log sequence>},...], and are
+// only released from the log when the server accepted the batch.
+#ifndef ATMO_CLOUD_TCP_LOG_RETRY_MS
+#define ATMO_CLOUD_TCP_LOG_RETRY_MS (5000)
+#endif
+
 #ifndef ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS
 #define ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS (5000)
 #endif
 
+// A request that gets no answer (or a 5xx) holds back every request of the
+// transport for an exponentially growing delay, up to ATMO_CLOUD_TCP_BACKOFF_MAX_MS.
+// Half of each delay is random so devices that lost the network together don't
+// retry in lockstep. After ATMO_CLOUD_TCP_CIRCUIT_THRESHOLD failures in a row the
+// circuit opens: nothing is sent for ATMO_CLOUD_TCP_CIRCUIT_OPEN_MS and new events
+// go to the event log, then a single request probes the link.
+#ifndef ATMO_CLOUD_TCP_BACKOFF_BASE_MS
+#define ATMO_CLOUD_TCP_BACKOFF_BASE_MS (1000)
+#endif
+
+#ifndef ATMO_CLOUD_TCP_BACKOFF_MAX_MS
+#define ATMO_CLOUD_TCP_BACKOFF_MAX_MS (60000)
+#endif
+
+#ifndef ATMO_CLOUD_TCP_CIRCUIT_THRESHOLD
+#define ATMO_CLOUD_TCP_CIRCUIT_THRESHOLD (5)
+#endif
+
+#ifndef ATMO_CLOUD_TCP_CIRCUIT_OPEN_MS
+#define ATMO_CLOUD_TCP_CIRCUIT_OPEN_MS (300000)
+#endif
+
+// All pending commands are fetched with one GET to /thing/<uuid>/commands/pop?wait=<s>.
+// While no events are queued the server may hold the request for up to this long
+// until a command arrives, and the next poll is issued as soon as it returns.
+// The response is null or [{"name":"<command>","command":<value>},...]
+// Set to 0 to poll every ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS without waiting.
+#ifndef ATMO_CLOUD_COMMAND_LONG_POLL_MS
+#define ATMO_CLOUD_COMMAND_LONG_POLL_MS (10000)
+#endif
+
 static uint8_t _ATMO_CLOUD_TCP_QueueBuf[ATMO_CLOUD_TCP_QUEUE_SIZE * sizeof( ATMO_CLOUD_Entry_t )];
 
 static ATMO_RingBuffer_t _ATMO_CLOUD_TCP_CmdEvtQueue;
 
+static char _ATMO_CLOUD_TCP_BatchBuf[ATMO_CLOUD_TCP_BATCH_MAX_BYTES + 1];
+
 static void _ATMO_CLOUD_TCP_FreeCloudEntry( void *entry )
 {
 	ATMO_CLOUD_Entry_t *cloudEntry = ( ATMO_CLOUD_Entry_t * )entry;
@@ -151,6 +272,7 @@ ATMO_Status_t ATMO_CLOUD_TCP_AddDriverInstanceByType( ATMO_DriverInstanceHandle_
 	_ATMO_CLOUD_TCP_CurrentNumInstances++;
 
 	ATMO_Status_t status = ATMO_CLOUD_AddDriverInstance( &cloudTcpDriverInstance, &privData->instance, instanceNumber );
+	privData->cloudInstance = *instanceNumber;
 	return status;
 }
 
@@ -166,20 +288,39 @@ static void __ATMO_CLOUD_HTTP_UrlEncodeTableInit()
 	}
 }
 
-static int __ATMO_CLOUD_HTTP_UrlEncode( char *s, char *enc )
+/**
+ * Copy a string without its NULL terminator.
+ *
+ * @return number of bytes copied
+ */
+static unsigned int _ATMO_CLOUD_TCP_PutStr( char *buf, const char *str )
+{
+	unsigned int len = strlen( str );
+	memcpy( buf, str, len );
+	return len;
+}
+
+/**
+ * Percent-encode a string for use in a URL.
+ *
+ * @param s - NULL terminated string
+ * @param enc - output buffer, can be NULL to only calculate the length
+ * @return length of the encoded string, not including a NULL terminator
+ */
+static unsigned int __ATMO_CLOUD_HTTP_UrlEncode( const char *s, char *enc )
 {
-	unsigned int len = strlen( s );
 	unsigned int currEncPos = 0;
-	unsigned int i;
 
-	for ( i = 0; i < len; i++ )
+	for ( ; *s != 0; s++ )
 	{
-		if ( rfc3986[( int )s[i]] )
+		uint8_t c = ( uint8_t ) * s;
+
+		if ( rfc3986[c] )
 		{
 			// Just use the regular char
 			if ( enc != NULL )
 			{
-				sprintf( &enc[currEncPos], "%c", s[i] );
+				enc[currEncPos] = c;
 			}
 
 			currEncPos++;
@@ -188,14 +329,66 @@ static int __ATMO_CLOUD_HTTP_UrlEncode( char *s, char *enc )
 		{
 			if ( enc != NULL )
 			{
-				sprintf( &enc[currEncPos], "%%%02X", s[i] );
+				enc[currEncPos] = '%';
+				enc[currEncPos + 1] = _ATMO_CLOUD_TCP_Hex[c >> 4];
+				enc[currEncPos + 2] = _ATMO_CLOUD_TCP_Hex[c & 0xF];
 			}
 
 			currEncPos += 3;
 		}
 	}
 
-	return currEncPos + 1;
+	return currEncPos;
+}
+
+/**
+ * Escape a string for use inside a JSON string literal.
+ *
+ * @param s - NULL terminated string
+ * @param enc - output buffer, can be NULL to only calculate the length
+ * @return length of the escaped string, not including a NULL terminator
+ */
+static unsigned int __ATMO_CLOUD_HTTP_JsonEscape( const char *s, char *enc )
+{
+	unsigned int currEncPos = 0;
+
+	for ( ; *s != 0; s++ )
+	{
+		uint8_t c = ( uint8_t ) * s;
+
+		if ( c == '\"' || c == '\\' )
+		{
+			if ( enc != NULL )
+			{
+				enc[currEncPos] = '\\';
+				enc[currEncPos + 1] = c;
+			}
+
+			currEncPos += 2;
+		}
+		else if ( c < 0x20 )
+		{
+			if ( enc != NULL )
+			{
+				memcpy( &enc[currEncPos], "\\u00", 4 );
+				enc[currEncPos + 4] = _ATMO_CLOUD_TCP_Hex[c >> 4];
+				enc[currEncPos + 5] = _ATMO_CLOUD_TCP_Hex[c & 0xF];
+			}
+
+			currEncPos += 6;
+		}
+		else
+		{
+			if ( enc != NULL )
+			{
+				enc[currEncPos] = c;
+			}
+
+			currEncPos++;
+		}
+	}
+
+	return currEncPos;
 }
 
 static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_BuildSSIDFromUUID( uint8_t *mac, ATMO_UUID_t *uuid, char *ssid )
@@ -276,66 +469,322 @@ static void _ATMO_CLOUD_TCP_WifiDisconnected( void *data )
 	_ATMO_CLOUD_TCP_Connected = false;
 }
 
-static void _ATMO_CLOUD_TCP_CheckBuffer( void *data )
+/**
+ * Get an entry of the event queue, counting from the oldest one.
+ */
+static ATMO_CLOUD_Entry_t *_ATMO_CLOUD_TCP_QueueEntry( ATMO_RingBuffer_t *queue, uint8_t index )
+{
+	uint8_t *entries = ( uint8_t * )queue->entry;
+	return ( ATMO_CLOUD_Entry_t * )&entries[( ( queue->head + index ) % queue->capacity ) * queue->elementSize];
+}
+
+/**
+ * Check the flush triggers of the event queue.
+ *
+ * @return true if the queued events should be uploaded now
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_TCP_BatchReady( ATMO_RingBuffer_t *queue )
+{
+	if ( ATMO_RingBuffer_Empty( queue ) )
+	{
+		return false;
+	}
+
+	if ( ATMO_RingBuffer_Full( queue ) )
+	{
+		return true;
+	}
+
+	uint32_t now = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+	unsigned int numEvents = 0;
+	unsigned int numBytes = 2;
+	unsigned int i;
+
+	for ( i = 0; i < queue->count; i++ )
+	{
+		ATMO_CLOUD_Entry_t *pEntry = _ATMO_CLOUD_TCP_QueueEntry( queue, i );
+
+		if ( !pEntry->isEvent )
+		{
+			continue;
+		}
+
+		numEvents++;
+		numBytes += pEntry->batchLen;
+
+		if ( ( now - pEntry->queuedMs ) >= ATMO_CLOUD_TCP_BATCH_MAX_AGE_MS ||
+		        numEvents >= ATMO_CLOUD_TCP_BATCH_MAX_EVENTS ||
+		        numBytes >= ATMO_CLOUD_TCP_BATCH_MAX_BYTES )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Whether a request may be started now, as far as back-off and the circuit breaker are concerned.
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_TCP_RequestAllowed( ATMO_CLOUD_TCP_Priv_t *priv )
+{
+	if ( ATMO_PLATFORM_UptimeMs() < priv->retryAtMs )
+	{
+		return false;
+	}
+
+	if ( priv->metrics.circuitState == ATMO_CLOUD_TCP_Circuit_Open )
+	{
+		priv->metrics.circuitState = ATMO_CLOUD_TCP_Circuit_HalfOpen;
+	}
+
+	// Only one probe at a time while half open
+	if ( priv->metrics.circuitState == ATMO_CLOUD_TCP_Circuit_HalfOpen && ( priv->inTransaction || priv->commandPollInFlight ) )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Random part of a back-off delay
+ *
+ * @return 0 to maxMs
+ */
+static uint32_t _ATMO_CLOUD_TCP_Jitter( ATMO_CLOUD_TCP_Priv_t *priv, uint32_t maxMs )
+{
+	// xorshift32, seeded from the uptime of the first failure
+	if ( priv->jitterSeed == 0 )
+	{
+		priv->jitterSeed = ( uint32_t )ATMO_PLATFORM_UptimeMs() ^ ( 0x9E3779B9 * ( priv->instanceNum + 1 ) );
+	}
+
+	priv->jitterSeed ^= priv->jitterSeed << 13;
+	priv->jitterSeed ^= priv->jitterSeed >> 17;
+	priv->jitterSeed ^= priv->jitterSeed << 5;
+
+	return priv->jitterSeed % ( maxMs + 1 );
+}
+
+/**
+ * Account for a finished request and update the back-off and circuit state.
+ *
+ * @param startMs - uptime the request was started at, 0 to leave it out of the latency (long polls)
+ */
+static void _ATMO_CLOUD_TCP_RecordResult( ATMO_CLOUD_TCP_Priv_t *priv, ATMO_HTTP_Status_t status, unsigned int respCode, uint64_t startMs, uint32_t bytesSent, uint32_t bytesReceived )
 {
-	static ATMO_BOOL_t currentlyChecking = false;
-	static uint64_t lastCloudCommandCheck = 0;
+	ATMO_CLOUD_TCP_Metrics_t *metrics = &priv->metrics;
+	uint64_t now = ATMO_PLATFORM_UptimeMs();
+	ATMO_BOOL_t failed = false;
+
+	metrics->numRequests++;
+	metrics->bytesSent += bytesSent;
+
+	if ( status == ATMO_HTTP_Status_Timeout )
+	{
+		metrics->numTimeouts++;
+		failed = true;
+	}
+	else if ( status != ATMO_HTTP_Status_Success )
+	{
+		metrics->numTransportFailures++;
+		failed = true;
+	}
+	else
+	{
+		metrics->bytesReceived += bytesReceived;
+
+		if ( respCode >= 500 )
+		{
+			metrics->numServerErrors++;
+			failed = true;
+		}
+		else if ( respCode >= 200 && respCode < 300 )
+		{
+			metrics->numSuccess++;
+		}
+		else
+		{
+			metrics->numRejected++;
+		}
+	}
+
+	if ( !failed && startMs != 0 )
+	{
+		uint32_t latencyMs = ( uint32_t )( now - startMs );
+		unsigned int bucket = 0;
+
+		while ( bucket < ATMO_CLOUD_TCP_LATENCY_BUCKETS - 1 && ( latencyMs >> ( bucket + 1 ) ) > 0 )
+		{
+			bucket++;
+		}
+
+		metrics->latencyHistogram[bucket]++;
+	}
+
+	if ( !failed )
+	{
+		// The server answered, the link is fine
+		metrics->consecutiveFailures = 0;
+		metrics->circuitState = ATMO_CLOUD_TCP_Circuit_Closed;
+		priv->retryAtMs = 0;
+		return;
+	}
+
+	metrics->consecutiveFailures++;
 
-	if ( currentlyChecking )
+	if ( metrics->circuitState == ATMO_CLOUD_TCP_Circuit_HalfOpen || metrics->consecutiveFailures >= ATMO_CLOUD_TCP_CIRCUIT_THRESHOLD )
 	{
+		if ( metrics->circuitState != ATMO_CLOUD_TCP_Circuit_Open )
+		{
+			metrics->circuitTrips++;
+		}
+
+		metrics->circuitState = ATMO_CLOUD_TCP_Circuit_Open;
+		priv->retryAtMs = now + ATMO_CLOUD_TCP_CIRCUIT_OPEN_MS / 2 + _ATMO_CLOUD_TCP_Jitter( priv, ATMO_CLOUD_TCP_CIRCUIT_OPEN_MS / 2 );
 		return;
 	}
 
-	currentlyChecking = true;
+	uint32_t delayMs = ATMO_CLOUD_TCP_BACKOFF_MAX_MS;
+
+	if ( metrics->consecutiveFailures <= 16 && ( ( uint32_t )ATMO_CLOUD_TCP_BACKOFF_BASE_MS << ( metrics->consecutiveFailures - 1 ) ) < ATMO_CLOUD_TCP_BACKOFF_MAX_MS )
+	{
+		delayMs = ( uint32_t )ATMO_CLOUD_TCP_BACKOFF_BASE_MS << ( metrics->consecutiveFailures - 1 );
+	}
+
+	priv->retryAtMs = now + delayMs / 2 + _ATMO_CLOUD_TCP_Jitter( priv, delayMs / 2 );
+}
 
+ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_GetMetrics( ATMO_DriverInstanceHandle_t instance, ATMO_CLOUD_TCP_Metrics_t *metrics )
+{
 	unsigned int i;
 
+	if ( metrics == NULL )
+	{
+		return ATMO_CLOUD_Status_Invalid;
+	}
+
 	for ( i = 0; i < _ATMO_CLOUD_TCP_CurrentNumInstances; i++ )
 	{
-		if ( _ATMO_CLOUD_TCP_PrivData[i].inTransaction )
+		ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[i];
+
+		if ( priv->cloudInstance != instance )
+		{
+			continue;
+		}
+
+		memcpy( metrics, &priv->metrics, sizeof( *metrics ) );
+
+		uint32_t numSamples = 0;
+		uint32_t count = 0;
+		unsigned int bucket;
+
+		for ( bucket = 0; bucket < ATMO_CLOUD_TCP_LATENCY_BUCKETS; bucket++ )
 		{
-			currentlyChecking = false;
-			return;
+			numSamples += metrics->latencyHistogram[bucket];
 		}
 
-		if ( !ATMO_RingBuffer_Empty( &_ATMO_CLOUD_TCP_PrivData[i].eventQueue ) )
+		for ( bucket = 0; bucket < ATMO_CLOUD_TCP_LATENCY_BUCKETS && numSamples > 0; bucket++ )
 		{
-			ATMO_CLOUD_Entry_t *pEntry = ATMO_RingBuffer_Pop( &_ATMO_CLOUD_TCP_PrivData[i].eventQueue );
-			ATMO_CLOUD_Entry_t entry;
-			memcpy(&entry, pEntry, sizeof(entry));
+			count += metrics->latencyHistogram[bucket];
+
+			if ( metrics->latencyP50Ms == 0 && count * 2 >= numSamples )
+			{
+				metrics->latencyP50Ms = 2UL << bucket;
+			}
 
-			if ( entry.isEvent )
+			if ( metrics->latencyP99Ms == 0 && ( uint64_t )count * 100 >= ( uint64_t )numSamples * 99 )
 			{
-//				uint32_t timeSec = ATMO_PLATFORM_UptimeMs() / 1000;
-//				ATMO_PLATFORM_DebugPrint("%lu: Sending event %s\r\n", timeSec, (char *)entry->name);
-				_ATMO_CLOUD_TCP_SendEvent( &_ATMO_CLOUD_TCP_PrivData[i].instance, entry.name, &entry.value, 10000 );
-				ATMO_FreeValue( &entry.value );
+				metrics->latencyP99Ms = 2UL << bucket;
 			}
 		}
 
-		// Check cloud commands
-		if ( ATMO_PLATFORM_UptimeMs() - lastCloudCommandCheck >= ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS)
-		{
-			lastCloudCommandCheck = ATMO_PLATFORM_UptimeMs();
+		uint64_t now = ATMO_PLATFORM_UptimeMs();
+		metrics->retryInMs = ( priv->retryAtMs > now ) ? ( uint32_t )( priv->retryAtMs - now ) : 0;
+		return ATMO_CLOUD_Status_Success;
+	}
 
-			unsigned int j;
+	return ATMO_CLOUD_Status_Invalid;
+}
 
-			for ( j = 0; j < TOTAL_NUM_CLOUD_COMMANDS; j++ )
-			{
-				ATMO_Value_t value;
-				ATMO_InitValue( &value );
+static ATMO_BOOL_t _ATMO_CLOUD_TCP_CommandPollDue( ATMO_CLOUD_TCP_Priv_t *priv )
+{
+	// The server did the waiting, go straight back to listening
+	if ( priv->lastCommandWaitMs > 0 && !priv->commandPopAllUnsupported )
+	{
+		return true;
+	}
 
-				if ( _ATMO_CLOUD_TCP_PopCommand( &_ATMO_CLOUD_TCP_PrivData[i].instance, cloudCommandsList[j], &value, 10000 ) == ATMO_CLOUD_Status_Success )
-				{
-					ATMO_CLOUD_DispatchCommandResult( cloudCommandsList[j], &value );
-				}
+	// Finish popping the commands one by one before waiting for the next round
+	if ( priv->commandPopAllUnsupported && priv->nextCommand > 0 )
+	{
+		return true;
+	}
 
-				ATMO_FreeValue( &value );
-			}
+	return ( ATMO_PLATFORM_UptimeMs() - priv->lastCommandCheck ) >= ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS;
+}
+
+static void _ATMO_CLOUD_TCP_PollCommands( ATMO_CLOUD_TCP_Priv_t *priv )
+{
+	if ( priv->commandPollInFlight )
+	{
+		return;
+	}
+
+	if ( !priv->commandPopAllUnsupported )
+	{
+		// Don't hold queued events back while the server waits for commands
+		uint32_t waitMs = ATMO_RingBuffer_Empty( &priv->eventQueue ) ? ATMO_CLOUD_COMMAND_LONG_POLL_MS : 0;
+
+		if ( _ATMO_CLOUD_TCP_PopAllCommands( &priv->instance, waitMs ) == ATMO_CLOUD_Status_Success )
+		{
+			priv->lastCommandCheck = ATMO_PLATFORM_UptimeMs();
+			priv->lastCommandWaitMs = 0;
 		}
+
+		return;
 	}
 
-	currentlyChecking = false;
+	// Older servers only support popping one command at a time, the next one goes out once this one is back
+	if ( _ATMO_CLOUD_TCP_PopCommand( &priv->instance, cloudCommandsList[priv->nextCommand] ) == ATMO_CLOUD_Status_Success )
+	{
+		priv->lastCommandCheck = ATMO_PLATFORM_UptimeMs();
+	}
+}
+
+static void _ATMO_CLOUD_TCP_CheckBuffer( void *data )
+{
+	unsigned int i;
+
+	for ( i = 0; i < _ATMO_CLOUD_TCP_CurrentNumInstances; i++ )
+	{
+		ATMO_RingBuffer_t *queue = &_ATMO_CLOUD_TCP_PrivData[i].eventQueue;
+
+		// Command entries only keep duplicate requests out of the queue, drop them once they reach the head
+		while ( !ATMO_RingBuffer_Empty( queue ) && !( ( ATMO_CLOUD_Entry_t * )ATMO_RingBuffer_Head( queue ) )->isEvent )
+		{
+			ATMO_CLOUD_Entry_t *pEntry = ATMO_RingBuffer_Pop( queue );
+			ATMO_FreeValue( &pEntry->value );
+		}
+
+		if ( _ATMO_CLOUD_TCP_BatchReady( queue ) )
+		{
+//			uint32_t timeSec = ATMO_PLATFORM_UptimeMs() / 1000;
+//			ATMO_PLATFORM_DebugPrint("%lu: Sending %u queued entries\r\n", timeSec, queue->count);
+			_ATMO_CLOUD_TCP_SendEventBatch( &_ATMO_CLOUD_TCP_PrivData[i].instance );
+		}
+		else if ( ATMO_RingBuffer_Empty( queue ) && ATMO_CLOUD_EVENTLOG_IsEnabled() && !ATMO_CLOUD_EVENTLOG_IsEmpty() )
+		{
+			_ATMO_CLOUD_TCP_SendLoggedEvents( &_ATMO_CLOUD_TCP_PrivData[i].instance );
+		}
+
+		// Check cloud commands
+		if ( TOTAL_NUM_CLOUD_COMMANDS > 0 && _ATMO_CLOUD_TCP_CommandPollDue( &_ATMO_CLOUD_TCP_PrivData[i] ) )
+		{
+			_ATMO_CLOUD_TCP_PollCommands( &_ATMO_CLOUD_TCP_PrivData[i] );
+		}
+	}
 }
 
 static uint32_t _ATMO_CLOUD_TCP_GetInstanceNum( ATMO_DriverInstanceData_t *instance )
@@ -469,88 +918,200 @@ static ATMO_BOOL_t _ATMO_CLOUD_TCP_TransportAvailable( ATMO_DriverInstanceData_t
 	return true;
 }
 
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_LogEvent( const char *eventName, ATMO_Value_t *data )
+{
+	if ( !ATMO_CLOUD_EVENTLOG_IsEnabled() )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	ATMO_Value_t strValue;
+	ATMO_InitValue( &strValue );
+	ATMO_CreateValueConverted( &strValue, ATMO_DATATYPE_STRING, data );
+
+	const char *str = ( strValue.type == ATMO_DATATYPE_STRING ) ? ( const char * )strValue.data : NULL;
+	ATMO_CLOUD_EVENTLOG_Status_t status = ATMO_CLOUD_EVENTLOG_Append( eventName, str, NULL );
+
+	ATMO_FreeValue( &strValue );
+	return ( status == ATMO_CLOUD_EVENTLOG_Status_Success ) ? ATMO_CLOUD_Status_Success : ATMO_CLOUD_Status_Fail;
+}
+
 ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_SendEvent( ATMO_DriverInstanceData_t *instance, const char *eventName, ATMO_Value_t *data, uint32_t timeout )
 {
 	uint32_t instanceNum = _ATMO_CLOUD_TCP_GetInstanceNum( instance );
 
-	// Don't send events if there's no connection
-	if(!_ATMO_CLOUD_TCP_TransportAvailable(instance))
+	if ( instanceNum >= _ATMO_CLOUD_TCP_CurrentNumInstances )
 	{
 		return ATMO_CLOUD_Status_Fail;
 	}
 
-	if ( ATMO_RingBuffer_Full( &_ATMO_CLOUD_TCP_PrivData[instanceNum].eventQueue ) )
+	ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[instanceNum];
+
+	// Store events that can't be queued, and keep later ones behind them so they are delivered in order
+	if ( !_ATMO_CLOUD_TCP_TransportAvailable( instance ) ||
+	        ATMO_RingBuffer_Full( &priv->eventQueue ) ||
+	        ( ATMO_CLOUD_EVENTLOG_IsEnabled() && ( !ATMO_CLOUD_EVENTLOG_IsEmpty() || priv->metrics.circuitState == ATMO_CLOUD_TCP_Circuit_Open ) ) )
 	{
-		return ATMO_CLOUD_Status_Fail;
+		ATMO_CLOUD_Status_t status = _ATMO_CLOUD_TCP_LogEvent( eventName, data );
+
+		if ( status != ATMO_CLOUD_Status_Success )
+		{
+			priv->metrics.eventsDropped++;
+		}
+
+		return status;
 	}
 
 	ATMO_CLOUD_Entry_t entry;
 	entry.isEvent = true;
 	strncpy( entry.name, eventName, ATMO_CLOUD_MAX_NAME_LEN );
+	entry.name[ATMO_CLOUD_MAX_NAME_LEN - 1] = 0;
 
 	ATMO_InitValue( &entry.value );
+	entry.queuedMs = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+
+#ifdef ATMO_CLOUD_TCP_BINARY_EVENTS
+	unsigned int valueLen = 0;
 	ATMO_CreateValueCopy( &entry.value, data );
-	ATMO_RingBuffer_Push( &_ATMO_CLOUD_TCP_PrivData[instanceNum].eventQueue, &entry );
-	return ATMO_CLOUD_Status_Success;
-}
 
-ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendEvent( ATMO_DriverInstanceData_t *instance, const char *eventName, ATMO_Value_t *data, uint32_t timeout )
-{
-	if ( !_ATMO_CLOUD_TCP_TransportAvailable( instance ) )
+	// Values the codec can't carry are sent as their string conversion
+	if ( ATMO_VALUECODEC_Encode( &entry.value, NULL, 0, &valueLen ) != ATMO_Status_Success )
 	{
-		return ATMO_CLOUD_Status_Fail;
+		ATMO_FreeValue( &entry.value );
+		ATMO_CreateValueConverted( &entry.value, ATMO_DATATYPE_STRING, data );
+		ATMO_VALUECODEC_Encode( &entry.value, NULL, 0, &valueLen );
 	}
 
-	uint32_t instanceNum = _ATMO_CLOUD_TCP_GetInstanceNum( instance );
+	unsigned int nameLen = strlen( entry.name );
+	unsigned int batchLen = ATMO_VALUECODEC_EncodeVarint( nameLen, NULL ) + nameLen + ATMO_VALUECODEC_MAX_VARINT_LEN + valueLen;
+#else
+	// Convert now so the batch size can be tracked without converting every tick
+	ATMO_CreateValueConverted( &entry.value, ATMO_DATATYPE_STRING, data );
 
-	if ( _ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction )
+	unsigned int batchLen = ATMO_CLOUD_TCP_BATCH_ENTRY_OVERHEAD + __ATMO_CLOUD_HTTP_JsonEscape( entry.name, NULL );
+
+	if ( entry.value.type == ATMO_DATATYPE_STRING )
 	{
-		return ATMO_CLOUD_Status_Fail;
+		batchLen += __ATMO_CLOUD_HTTP_JsonEscape( ( char * )entry.value.data, NULL );
 	}
+#endif
 
-	_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = true;
-
-	// Get data as a string
-	ATMO_Value_t dataStr;
-	ATMO_InitValue( &dataStr );
-	ATMO_CreateValueConverted( &dataStr, ATMO_DATATYPE_STRING, data );
-	unsigned int encodedDataLen = 0;
+	entry.batchLen = batchLen > 0xFFFF ? 0xFFFF : batchLen;
+	ATMO_RingBuffer_Push( &priv->eventQueue, &entry );
 
-	if ( strlen( ( char * )dataStr.data ) == 0 )
+	if ( priv->eventQueue.count > priv->metrics.queueHighWater )
 	{
-		encodedDataLen = strlen( "null" ) + 1;
+		priv->metrics.queueHighWater = priv->eventQueue.count;
 	}
-	else
+
+	return ATMO_CLOUD_Status_Success;
+}
+
+/**
+ * Append a single event to a batch body.
+ *
+ * @param buf - must have room for entry->batchLen bytes
+ * @return number of bytes written, not including the NULL terminator
+ */
+#ifdef ATMO_CLOUD_TCP_BINARY_EVENTS
+static unsigned int _ATMO_CLOUD_TCP_BatchAppend( char *buf, ATMO_CLOUD_Entry_t *entry, uint32_t now, ATMO_BOOL_t separator )
+{
+	uint8_t *out = ( uint8_t * )buf;
+	unsigned int nameLen = strlen( entry->name );
+	unsigned int len = ATMO_VALUECODEC_EncodeVarint( nameLen, out );
+	unsigned int valueLen = 0;
+
+	memcpy( &out[len], entry->name, nameLen );
+	len += nameLen;
+	len += ATMO_VALUECODEC_EncodeVarint( now - entry->queuedMs, &out[len] );
+
+	// Sized when the entry was queued, so this can't run out of room
+	ATMO_VALUECODEC_Encode( &entry->value, &out[len], entry->batchLen - len, &valueLen );
+	return len + valueLen;
+}
+#else
+static unsigned int _ATMO_CLOUD_TCP_BatchAppend( char *buf, ATMO_CLOUD_Entry_t *entry, uint32_t now, ATMO_BOOL_t separator )
+{
+	unsigned int len = 0;
+
+	if ( separator )
 	{
-		encodedDataLen = strlen( ( char * )dataStr.data ) * 3;
+		buf[len++] = ',';
 	}
 
-	char dataEncoded[encodedDataLen + 1];
-	memset( dataEncoded, 0, encodedDataLen + 1 );
+	len += sprintf( &buf[len], "{\"name\":\"" );
+	len += __ATMO_CLOUD_HTTP_JsonEscape( entry->name, &buf[len] );
 
-	if ( strlen( ( char * )dataStr.data ) == 0 )
+	if ( entry->value.type != ATMO_DATATYPE_STRING || strlen( ( char * )entry->value.data ) == 0 )
 	{
-		strcpy( dataEncoded, "null" );
+		len += sprintf( &buf[len], "\",\"data\":null" );
 	}
 	else
 	{
-		__ATMO_CLOUD_HTTP_UrlEncode( ( char * )dataStr.data, dataEncoded );
+		len += sprintf( &buf[len], "\",\"data\":\"" );
+		len += __ATMO_CLOUD_HTTP_JsonEscape( ( char * )entry->value.data, &buf[len] );
+		buf[len++] = '\"';
 	}
 
-	ATMO_FreeValue( &dataStr );
+	len += sprintf( &buf[len], ",\"age\":%lu}", ( unsigned long )( now - entry->queuedMs ) );
+	return len;
+}
+#endif
+
+static void _ATMO_CLOUD_TCP_EventsSent( ATMO_DriverInstanceHandle_t httpInstance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respData, unsigned int respDataLen, void *arg )
+{
+	ATMO_CLOUD_TCP_Priv_t *priv = ( ATMO_CLOUD_TCP_Priv_t * )arg;
+	priv->inTransaction = false;
+
+	_ATMO_CLOUD_TCP_RecordResult( priv, status, respCode, priv->requestStartMs, priv->requestBytes, respDataLen );
+
+	if ( status != ATMO_HTTP_Status_Success || respCode < 200 || respCode >= 300 )
+	{
+		priv->metrics.eventsDropped += priv->requestNumEvents;
+	}
+}
+
+/**
+ * Start sending a single event with a GET, for events that don't fit in a batch.
+ *
+ * @return Busy if no connection is free, the event should stay queued then
+ */
+static ATMO_HTTP_Status_t _ATMO_CLOUD_TCP_SendEvent( ATMO_CLOUD_TCP_Priv_t *priv, const char *eventName, ATMO_Value_t *data )
+{
+	// Get data as a string
+	ATMO_Value_t dataStr;
+	ATMO_InitValue( &dataStr );
+	ATMO_CreateValueConverted( &dataStr, ATMO_DATATYPE_STRING, data );
+	const char *dataCStr = ( dataStr.type == ATMO_DATATYPE_STRING ) ? ( const char * )dataStr.data : "";
 
 	// Get UUID str
 	char uuid[40];
 	ATMO_CLOUD_GetRegistrationInfoUuid( ATMO_CLOUD_GetRegistration(), uuid, sizeof( uuid ) );
 
-	// Print everything binary
-	const char *urlFormat = "%s/thing/%s/event/%s/%s";
-	unsigned int urlSize = strlen( ATMO_CLOUD_GetRegistration()->url ) + strlen( uuid ) + strlen( eventName ) + strlen( dataEncoded ) + 16;
+	// <url>/thing/<uuid>/event/<name>/<data>, the data is percent-encoded straight into the URL
+	const char *baseUrl = ATMO_CLOUD_GetRegistration()->url;
+	unsigned int urlSize = strlen( baseUrl ) + strlen( uuid ) + strlen( eventName ) + ( strlen( dataCStr ) * 3 ) + 24;
+	unsigned int urlLen = 0;
 
-	char url[urlSize + 1];
-	memset( url, 0, urlSize + 1 );
-	sprintf( url, urlFormat, ATMO_CLOUD_GetRegistration()->url, uuid, eventName,
-	         dataEncoded );
+	char url[urlSize];
+	urlLen += _ATMO_CLOUD_TCP_PutStr( &url[urlLen], baseUrl );
+	urlLen += _ATMO_CLOUD_TCP_PutStr( &url[urlLen], "/thing/" );
+	urlLen += _ATMO_CLOUD_TCP_PutStr( &url[urlLen], uuid );
+	urlLen += _ATMO_CLOUD_TCP_PutStr( &url[urlLen], "/event/" );
+	urlLen += _ATMO_CLOUD_TCP_PutStr( &url[urlLen], eventName );
+	url[urlLen++] = '/';
+
+	if ( *dataCStr == 0 )
+	{
+		urlLen += _ATMO_CLOUD_TCP_PutStr( &url[urlLen], "null" );
+	}
+	else
+	{
+		urlLen += __ATMO_CLOUD_HTTP_UrlEncode( dataCStr, &url[urlLen] );
+	}
+
+	url[urlLen] = 0;
+	ATMO_FreeValue( &dataStr );
 
 	ATMO_HTTP_Header_t header;
 	header.headerKey = "cloud";
@@ -564,22 +1125,302 @@ ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendEvent( ATMO_DriverInstanceData_t *instan
 	trans.headerOverlay = &header;
 	trans.headerOverlayLen = 1;
 
-	unsigned int respCode = 0;
-	unsigned int respLen = 0;
+	// The request is built right away, the URL is not needed once this returns
+	ATMO_HTTP_Status_t httpStatus = ATMO_HTTP_PerformAsync( priv->httpInstance, &trans, 5000, _ATMO_CLOUD_TCP_EventsSent, priv );
 
-	if ( ATMO_HTTP_Perform( _ATMO_CLOUD_TCP_PrivData[instanceNum].httpInstance, &trans, &respCode, &respLen, 5000 ) != ATMO_HTTP_Status_Success )
+	if ( httpStatus == ATMO_HTTP_Status_Success )
+	{
+		priv->inTransaction = true;
+		priv->requestStartMs = ATMO_PLATFORM_UptimeMs();
+		priv->requestBytes = 0;
+		priv->requestNumEvents = 1;
+	}
+
+	return httpStatus;
+}
+
+/**
+ * Start uploading as many queued events as fit in one batch with a single POST.
+ * Events are removed from the queue once the upload started, whether it succeeds or not.
+ */
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendEventBatch( ATMO_DriverInstanceData_t *instance )
+{
+	if ( !_ATMO_CLOUD_TCP_TransportAvailable( instance ) )
 	{
-		_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
 		return ATMO_CLOUD_Status_Fail;
 	}
 
-	if ( respCode != 200 )
+	uint32_t instanceNum = _ATMO_CLOUD_TCP_GetInstanceNum( instance );
+	ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[instanceNum];
+	ATMO_RingBuffer_t *queue = &priv->eventQueue;
+	unsigned int numAvailable = 0;
+
+	if ( priv->inTransaction || ATMO_RingBuffer_Empty( queue ) || !_ATMO_CLOUD_TCP_RequestAllowed( priv ) )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	// Wait for a connection (i.e. while a command long poll is running) without building the body
+	if ( ATMO_HTTP_GetAvailableConnections( priv->httpInstance, &numAvailable ) != ATMO_HTTP_Status_Success || numAvailable == 0 )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	// An event that doesn't fit in a batch by itself is still sent on its own
+	ATMO_CLOUD_Entry_t *pHead = ( ATMO_CLOUD_Entry_t * )ATMO_RingBuffer_Head( queue );
+
+	if ( pHead->isEvent && ( pHead->batchLen + ATMO_CLOUD_TCP_BATCH_HEADER_LEN + 1 ) > ATMO_CLOUD_TCP_BATCH_MAX_BYTES )
+	{
+		ATMO_HTTP_Status_t httpStatus = _ATMO_CLOUD_TCP_SendEvent( priv, pHead->name, &pHead->value );
+
+		if ( httpStatus == ATMO_HTTP_Status_Busy )
+		{
+			return ATMO_CLOUD_Status_Fail;
+		}
+
+		ATMO_CLOUD_Entry_t *pEntry = ( ATMO_CLOUD_Entry_t * )ATMO_RingBuffer_Pop( queue );
+		ATMO_FreeValue( &pEntry->value );
+		return ( httpStatus == ATMO_HTTP_Status_Success ) ? ATMO_CLOUD_Status_Success : ATMO_CLOUD_Status_Fail;
+	}
+
+	uint32_t now = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+	unsigned int bodyLen = 0;
+	unsigned int numEvents = 0;
+	unsigned int numEntries = 0;
+
+#ifdef ATMO_CLOUD_TCP_BINARY_EVENTS
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen++] = ATMO_VALUECODEC_VERSION;
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen++] = 0; // Event count, filled in below
+#else
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen++] = '[';
+#endif
+
+	// Entries stay queued until the request is on its way
+	while ( numEntries < queue->count && numEvents < ATMO_CLOUD_TCP_BATCH_MAX_EVENTS )
+	{
+		ATMO_CLOUD_Entry_t *pEntry = _ATMO_CLOUD_TCP_QueueEntry( queue, numEntries );
+
+		if ( pEntry->isEvent )
+		{
+			// batchLen assumes the longest possible age, leave room for the closing bracket
+			if ( bodyLen + pEntry->batchLen + 1 > ATMO_CLOUD_TCP_BATCH_MAX_BYTES )
+			{
+				break;
+			}
+
+			bodyLen += _ATMO_CLOUD_TCP_BatchAppend( &_ATMO_CLOUD_TCP_BatchBuf[bodyLen], pEntry, now, numEvents > 0 );
+			numEvents++;
+		}
+
+		numEntries++;
+	}
+
+#ifdef ATMO_CLOUD_TCP_BINARY_EVENTS
+	_ATMO_CLOUD_TCP_BatchBuf[1] = ( char )numEvents;
+#else
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen++] = ']';
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen] = 0;
+#endif
+
+	ATMO_CLOUD_Status_t status = ATMO_CLOUD_Status_NoData;
+
+	if ( numEvents > 0 )
+	{
+		// Get UUID str
+		char uuid[40];
+		ATMO_CLOUD_GetRegistrationInfoUuid( ATMO_CLOUD_GetRegistration(), uuid, sizeof( uuid ) );
+
+		const char *urlFormat = "%s/thing/%s/events";
+		unsigned int urlSize = strlen( ATMO_CLOUD_GetRegistration()->url ) + strlen( uuid ) + 16;
+		char url[urlSize + 1];
+		memset( url, 0, urlSize + 1 );
+		sprintf( url, urlFormat, ATMO_CLOUD_GetRegistration()->url, uuid );
+
+		ATMO_HTTP_Header_t header;
+		header.headerKey = "cloud";
+		header.headerValue = ATMO_CLOUD_GetRegistration()->token;
+
+		ATMO_HTTP_Transaction_t trans;
+		trans.url = url;
+		trans.method = ATMO_HTTP_POST;
+		trans.contentType = ATMO_CLOUD_TCP_BATCH_CONTENT_TYPE;
+		trans.data = _ATMO_CLOUD_TCP_BatchBuf;
+		trans.dataLen = bodyLen;
+		trans.headerOverlay = &header;
+		trans.headerOverlayLen = 1;
+
+		// The request is built right away, the body buffer is free again once this returns
+		ATMO_HTTP_Status_t httpStatus = ATMO_HTTP_PerformAsync( priv->httpInstance, &trans, 5000, _ATMO_CLOUD_TCP_EventsSent, priv );
+
+		if ( httpStatus == ATMO_HTTP_Status_Busy )
+		{
+			return ATMO_CLOUD_Status_Fail;
+		}
+
+		if ( httpStatus == ATMO_HTTP_Status_Success )
+		{
+			priv->inTransaction = true;
+			priv->requestStartMs = ATMO_PLATFORM_UptimeMs();
+			priv->requestBytes = bodyLen;
+			priv->requestNumEvents = numEvents;
+			status = ATMO_CLOUD_Status_Success;
+		}
+		else
+		{
+			status = ATMO_CLOUD_Status_Fail;
+		}
+	}
+
+	while ( numEntries-- > 0 )
+	{
+		ATMO_CLOUD_Entry_t *pEntry = ( ATMO_CLOUD_Entry_t * )ATMO_RingBuffer_Pop( queue );
+		ATMO_FreeValue( &pEntry->value );
+	}
+
+	return status;
+}
+
+static void _ATMO_CLOUD_TCP_LoggedEventsSent( ATMO_DriverInstanceHandle_t httpInstance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respData, unsigned int respDataLen, void *arg )
+{
+	ATMO_CLOUD_TCP_Priv_t *priv = ( ATMO_CLOUD_TCP_Priv_t * )arg;
+	priv->inTransaction = false;
+
+	_ATMO_CLOUD_TCP_RecordResult( priv, status, respCode, priv->requestStartMs, priv->requestBytes, respDataLen );
+
+	if ( status == ATMO_HTTP_Status_Success && respCode >= 200 && respCode < 300 )
+	{
+		ATMO_CLOUD_EVENTLOG_Ack( priv->replayLastSeq );
+	}
+	else
+	{
+		priv->replayRetryMs = ATMO_PLATFORM_UptimeMs() + ATMO_CLOUD_TCP_LOG_RETRY_MS;
+	}
+}
+
+/**
+ * Start uploading the oldest events of the persistent event log as one batch.
+ * They stay in the log until the server accepted them.
+ */
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_SendLoggedEvents( ATMO_DriverInstanceData_t *instance )
+{
+	if ( !_ATMO_CLOUD_TCP_TransportAvailable( instance ) )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	uint32_t instanceNum = _ATMO_CLOUD_TCP_GetInstanceNum( instance );
+	ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[instanceNum];
+	unsigned int numAvailable = 0;
+
+	if ( priv->inTransaction || ATMO_PLATFORM_UptimeMs() < priv->replayRetryMs || !_ATMO_CLOUD_TCP_RequestAllowed( priv ) )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	if ( ATMO_HTTP_GetAvailableConnections( priv->httpInstance, &numAvailable ) != ATMO_HTTP_Status_Success || numAvailable == 0 )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	ATMO_CLOUD_EVENTLOG_Cursor_t cursor;
+	ATMO_CLOUD_EVENTLOG_Record_t record;
+	unsigned int bodyLen = 0;
+	unsigned int numEvents = 0;
+
+	if ( ATMO_CLOUD_EVENTLOG_Begin( &cursor ) != ATMO_CLOUD_EVENTLOG_Status_Success )
 	{
-		_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
 		return ATMO_CLOUD_Status_Fail;
 	}
 
-	_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen++] = '[';
+
+	while ( numEvents < ATMO_CLOUD_TCP_BATCH_MAX_EVENTS )
+	{
+		ATMO_CLOUD_EVENTLOG_Cursor_t next = cursor;
+
+		if ( ATMO_CLOUD_EVENTLOG_Read( &next, &record ) != ATMO_CLOUD_EVENTLOG_Status_Success )
+		{
+			break;
+		}
+
+		unsigned int entryLen = ATMO_CLOUD_TCP_BATCH_ENTRY_OVERHEAD + __ATMO_CLOUD_HTTP_JsonEscape( record.name, NULL ) + __ATMO_CLOUD_HTTP_JsonEscape( record.data, NULL );
+
+		// Leave room for the closing bracket
+		if ( bodyLen + entryLen + 1 > ATMO_CLOUD_TCP_BATCH_MAX_BYTES )
+		{
+			break;
+		}
+
+		char *buf = &_ATMO_CLOUD_TCP_BatchBuf[bodyLen];
+		unsigned int len = 0;
+
+		if ( numEvents > 0 )
+		{
+			buf[len++] = ',';
+		}
+
+		len += sprintf( &buf[len], "{\"name\":\"" );
+		len += __ATMO_CLOUD_HTTP_JsonEscape( record.name, &buf[len] );
+
+		if ( !record.hasData )
+		{
+			len += sprintf( &buf[len], "\",\"data\":null" );
+		}
+		else
+		{
+			len += sprintf( &buf[len], "\",\"data\":\"" );
+			len += __ATMO_CLOUD_HTTP_JsonEscape( record.data, &buf[len] );
+			buf[len++] = '\"';
+		}
+
+		len += sprintf( &buf[len], ",\"seq\":%lu}", ( unsigned long )record.seq );
+
+		bodyLen += len;
+		priv->replayLastSeq = record.seq;
+		cursor = next;
+		numEvents++;
+	}
+
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen++] = ']';
+	_ATMO_CLOUD_TCP_BatchBuf[bodyLen] = 0;
+
+	if ( numEvents == 0 )
+	{
+		return ATMO_CLOUD_Status_NoData;
+	}
+
+	// Get UUID str
+	char uuid[40];
+	ATMO_CLOUD_GetRegistrationInfoUuid( ATMO_CLOUD_GetRegistration(), uuid, sizeof( uuid ) );
+
+	const char *urlFormat = "%s/thing/%s/events";
+	unsigned int urlSize = strlen( ATMO_CLOUD_GetRegistration()->url ) + strlen( uuid ) + 16;
+	char url[urlSize + 1];
+	memset( url, 0, urlSize + 1 );
+	sprintf( url, urlFormat, ATMO_CLOUD_GetRegistration()->url, uuid );
+
+	ATMO_HTTP_Header_t header;
+	header.headerKey = "cloud";
+	header.headerValue = ATMO_CLOUD_GetRegistration()->token;
+
+	ATMO_HTTP_Transaction_t trans;
+	trans.url = url;
+	trans.method = ATMO_HTTP_POST;
+	trans.contentType = "application/json";
+	trans.data = _ATMO_CLOUD_TCP_BatchBuf;
+	trans.dataLen = bodyLen;
+	trans.headerOverlay = &header;
+	trans.headerOverlayLen = 1;
+
+	if ( ATMO_HTTP_PerformAsync( priv->httpInstance, &trans, 5000, _ATMO_CLOUD_TCP_LoggedEventsSent, priv ) != ATMO_HTTP_Status_Success )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	priv->inTransaction = true;
+	priv->requestStartMs = ATMO_PLATFORM_UptimeMs();
+	priv->requestBytes = bodyLen;
+	priv->requestNumEvents = 0;
 	return ATMO_CLOUD_Status_Success;
 }
 
@@ -604,7 +1445,7 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instan
 
 	for ( i = 0; i < _ATMO_CLOUD_TCP_PrivData[instanceNum].eventQueue.count; i++ )
 	{
-		ATMO_CLOUD_Entry_t *pEntry = ( ATMO_CLOUD_Entry_t * )ATMO_RingBuffer_Index( &_ATMO_CLOUD_TCP_PrivData[instanceNum].eventQueue, i );
+		ATMO_CLOUD_Entry_t *pEntry = _ATMO_CLOUD_TCP_QueueEntry( &_ATMO_CLOUD_TCP_PrivData[instanceNum].eventQueue, i );
 
 		if ( pEntry->isEvent == false && strcmp( pEntry->name, commandName ) == 0 )
 		{
@@ -616,11 +1457,105 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instan
 	entry.isEvent = false;
 	strncpy( entry.name, commandName, ATMO_CLOUD_MAX_NAME_LEN );
 	ATMO_InitValue( &entry.value );
+	entry.queuedMs = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+	entry.batchLen = 0;
 	ATMO_RingBuffer_Push( &_ATMO_CLOUD_TCP_PrivData[instanceNum].eventQueue, &entry );
 	return ATMO_CLOUD_Status_Success;
 }
 
-ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instance, const char *commandName, ATMO_Value_t *data, uint32_t timeout )
+/**
+ * Parse the answer of a single command pop, {"command":<data>} or null.
+ *
+ * @param resp - NULL terminated response body
+ * @param data - set to the command data as a string
+ * @return NoData if no command was pending
+ */
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_ParsePoppedCommand( const char *resp, unsigned int respLen, ATMO_Value_t *data )
+{
+	if ( respLen == 0 )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	// Simple JSON parsing (should incorporate robust json lib at some point)
+	const char *start = strstr( resp, "command\":" );
+
+	if ( start == NULL )
+	{
+		return ( strcmp( resp, "null" ) == 0 ) ? ATMO_CLOUD_Status_NoData : ATMO_CLOUD_Status_Fail;
+	}
+
+	start += strlen( "command\":" );
+
+	// Trim if string
+	if ( *start == '\"' )
+	{
+		start++;
+	}
+
+	const char *end = &resp[respLen - 1];
+
+	if ( *end != '}' )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	end--;
+
+	if ( *end == '\"' )
+	{
+		end--;
+	}
+
+	if ( end < start - 1 )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	unsigned int len = ( unsigned int )( end - start + 1 );
+	char cmdDataStr[len + 1];
+	memcpy( cmdDataStr, start, len );
+	cmdDataStr[len] = 0;
+	ATMO_CreateValueString( data, cmdDataStr );
+	return ATMO_CLOUD_Status_Success;
+}
+
+static void _ATMO_CLOUD_TCP_CommandPopped( ATMO_DriverInstanceHandle_t httpInstance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respBody, unsigned int respBodyLen, void *arg )
+{
+	ATMO_CLOUD_TCP_Priv_t *priv = ( ATMO_CLOUD_TCP_Priv_t * )arg;
+	const char *commandName = cloudCommandsList[priv->nextCommand];
+
+	priv->commandPollInFlight = false;
+	_ATMO_CLOUD_TCP_RecordResult( priv, status, respCode, priv->lastCommandCheck, 0, respBodyLen );
+
+	// Move on whether or not this one worked, it's popped again next round
+	if ( ++priv->nextCommand >= TOTAL_NUM_CLOUD_COMMANDS )
+	{
+		priv->nextCommand = 0;
+	}
+
+	if ( status != ATMO_HTTP_Status_Success || respCode != 200 || respBody == NULL )
+	{
+		return;
+	}
+
+	ATMO_Value_t value;
+	ATMO_InitValue( &value );
+
+	if ( _ATMO_CLOUD_TCP_ParsePoppedCommand( ( const char * )respBody, respBodyLen, &value ) == ATMO_CLOUD_Status_Success )
+	{
+		ATMO_CLOUD_DispatchCommandResult( commandName, &value );
+	}
+
+	ATMO_FreeValue( &value );
+}
+
+/**
+ * Start popping a single command, for servers without the aggregated endpoint.
+ *
+ * @return Success if the request was started
+ */
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instance, const char *commandName )
 {
 	if ( !_ATMO_CLOUD_TCP_TransportAvailable( instance ) )
 	{
@@ -628,14 +1563,13 @@ ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *insta
 	}
 
 	uint32_t instanceNum = _ATMO_CLOUD_TCP_GetInstanceNum( instance );
+	ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[instanceNum];
 
-	if ( _ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction )
+	if ( priv->commandPollInFlight || !_ATMO_CLOUD_TCP_RequestAllowed( priv ) )
 	{
 		return ATMO_CLOUD_Status_Fail;
 	}
 
-	_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = true;
-
 	// Get UUID str
 	char uuid[40];
 	ATMO_CLOUD_GetRegistrationInfoUuid( ATMO_CLOUD_GetRegistration(), uuid, sizeof( uuid ) );
@@ -646,10 +1580,6 @@ ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *insta
 	memset( url, 0, urlSize + 1 );
 	sprintf( url, urlFormat, ATMO_CLOUD_GetRegistration()->url, uuid, commandName );
 
-// #ifdef ATMO_HTTP_DEBUG
-// 	ATMO_PLATFORM_DebugPrint("Sending to url: %s\r\n", url);
-// #endif
-
 	ATMO_HTTP_Header_t header;
 	header.headerKey = "cloud";
 	header.headerValue = ATMO_CLOUD_GetRegistration()->token;
@@ -662,92 +1592,302 @@ ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *insta
 	trans.headerOverlay = &header;
 	trans.headerOverlayLen = 1;
 
-	unsigned int respCode = 0;
-	unsigned int respLen = 0;
-
-	if ( ATMO_HTTP_Perform( _ATMO_CLOUD_TCP_PrivData[instanceNum].httpInstance, &trans, &respCode, &respLen, 5000 ) != ATMO_HTTP_Status_Success )
+	if ( ATMO_HTTP_PerformAsync( priv->httpInstance, &trans, 5000, _ATMO_CLOUD_TCP_CommandPopped, priv ) != ATMO_HTTP_Status_Success )
 	{
-		_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
 		return ATMO_CLOUD_Status_Fail;
 	}
 
-	if ( respCode != 200 || respLen == 0 )
+	priv->commandPollInFlight = true;
+	priv->commandPollWaitMs = 0;
+	return ATMO_CLOUD_Status_Success;
+}
+
+/**
+ * Find the end of a JSON value.
+ *
+ * @param value - start of the value
+ * @return the closing quote of a string, otherwise the first character after the value
+ */
+static char *_ATMO_CLOUD_TCP_JsonValueEnd( char *value )
+{
+	ATMO_BOOL_t inString = false;
+	unsigned int depth = 0;
+	char *pos = value;
+
+	if ( *pos == '\"' )
 	{
-		_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
-		return ATMO_CLOUD_Status_Fail;
+		for ( pos++; *pos != 0; pos++ )
+		{
+			if ( *pos == '\\' && *( pos + 1 ) != 0 )
+			{
+				pos++;
+			}
+			else if ( *pos == '\"' )
+			{
+				break;
+			}
+		}
+
+		return pos;
 	}
 
-	uint8_t respData[respLen + 1];
-	memset( respData, 0, respLen + 1 );
+	for ( ; *pos != 0; pos++ )
+	{
+		if ( inString )
+		{
+			if ( *pos == '\\' && *( pos + 1 ) != 0 )
+			{
+				pos++;
+			}
+			else if ( *pos == '\"' )
+			{
+				inString = false;
+			}
+		}
+		else if ( *pos == '\"' )
+		{
+			inString = true;
+		}
+		else if ( *pos == '{' || *pos == '[' )
+		{
+			depth++;
+		}
+		else if ( *pos == '}' || *pos == ']' || *pos == ',' )
+		{
+			if ( depth == 0 )
+			{
+				break;
+			}
+
+			if ( *pos != ',' )
+			{
+				depth--;
+			}
+		}
+	}
 
-	if ( ATMO_HTTP_GetRespData( _ATMO_CLOUD_TCP_PrivData[instanceNum].httpInstance, respData, respLen ) != ATMO_HTTP_Status_Success )
+	return pos;
+}
+
+/**
+ * Dispatch a single {"name":"<command>","command":<value>} entry.
+ */
+static ATMO_BOOL_t _ATMO_CLOUD_TCP_DispatchCommandEntry( char *entry )
+{
+	char *name = strstr( entry, "\"name\":\"" );
+
+	if ( name == NULL )
 	{
-		_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
-		return ATMO_CLOUD_Status_Fail;
+		return false;
 	}
 
-	respData[respLen] = 0;
+	name += strlen( "\"name\":\"" );
+	char *nameEnd = _ATMO_CLOUD_TCP_JsonValueEnd( name - 1 );
 
-// #ifdef ATMO_HTTP_DEBUG
-// 	ATMO_PLATFORM_DebugPrint("Resp %s\r\n\r\n", (char *)respData);
-// #endif
+	if ( *nameEnd != '\"' )
+	{
+		return false;
+	}
 
-	ATMO_InitValue( data );
+	*nameEnd = 0;
 
-	// Simple JSON parsing (should incorporate robust json lib at some point)
-	char *start = strstr( ( char * )respData, "command\":" );
+	char *start = strstr( nameEnd + 1, "\"command\":" );
 
-	if ( start )
+	if ( start == NULL )
 	{
-		start += strlen( "command\":" );
+		return false;
+	}
 
-		// Trim if string
-		if ( *start == '\"' )
-		{
-			start++;
-		}
+	start += strlen( "\"command\":" );
 
-		char *end = ( char * )&respData[strlen( ( char * )respData ) - 1];
+	char *end = _ATMO_CLOUD_TCP_JsonValueEnd( start );
 
-		if ( *end == '}' )
-		{
-			end--;
+	// Trim if string
+	if ( *start == '\"' )
+	{
+		start++;
+	}
+
+	*end = 0;
+
+	ATMO_Value_t value;
+	ATMO_InitValue( &value );
+	ATMO_CreateValueString( &value, start );
+	ATMO_CLOUD_DispatchCommandResult( name, &value );
+	ATMO_FreeValue( &value );
+	return true;
+}
+
+/**
+ * Scan the next part of a command poll response. Each object in the top
+ * level array is collected on its own and dispatched once it is closed.
+ */
+static void _ATMO_CLOUD_TCP_CommandsReceived( ATMO_DriverInstanceHandle_t httpInstance, unsigned int respCode, const uint8_t *data, unsigned int dataLen, void *arg )
+{
+	ATMO_CLOUD_TCP_Priv_t *priv = ( ATMO_CLOUD_TCP_Priv_t * )arg;
+	ATMO_CLOUD_TCP_CommandScanner_t *scanner = &priv->commandScanner;
+	unsigned int i;
 
-			if ( *end == '\"' )
+	if ( respCode != 200 )
+	{
+		return;
+	}
+
+	for ( i = 0; i < dataLen; i++ )
+	{
+		char c = ( char )data[i];
+		ATMO_BOOL_t structural = !scanner->inString;
+
+		if ( structural && ( c == '{' || c == '[' ) )
+		{
+			if ( scanner->depth == 1 && c == '{' )
 			{
-				end--;
+				scanner->entryLen = 0;
+				scanner->overflow = false;
 			}
 
-			unsigned int len = ( unsigned int )( end - start + 1 );
-			char cmdDataStr[len + 1];
-			memset( cmdDataStr, 0, len + 1 );
-			cmdDataStr[len] = 0;
-			memcpy( cmdDataStr, start, len );
-			ATMO_CreateValueString( data, cmdDataStr );
-// #ifdef ATMO_HTTP_DEBUG
-// 			ATMO_PLATFORM_DebugPrint("Final Data: %s\r\n", data->data);
-// #endif
+			scanner->depth++;
 		}
-		else
+
+		if ( scanner->depth >= 2 )
 		{
-			_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
-			return ATMO_CLOUD_Status_Fail;
+			if ( scanner->entryLen < ATMO_CLOUD_TCP_COMMAND_ENTRY_MAX_LEN )
+			{
+				scanner->entry[scanner->entryLen++] = c;
+			}
+			else
+			{
+				scanner->overflow = true;
+			}
 		}
-	}
-	else
-	{
-		if ( strcmp( ( char * )respData, "null" ) == 0 )
+
+		if ( scanner->inString )
+		{
+			if ( scanner->escaped )
+			{
+				scanner->escaped = false;
+			}
+			else if ( c == '\\' )
+			{
+				scanner->escaped = true;
+			}
+			else if ( c == '\"' )
+			{
+				scanner->inString = false;
+			}
+		}
+		else if ( c == '\"' )
 		{
-			_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
-			return ATMO_CLOUD_Status_NoData;
+			scanner->inString = true;
 		}
-		else
+		else if ( ( c == '}' || c == ']' ) && scanner->depth > 0 )
 		{
-			_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
-			return ATMO_CLOUD_Status_Fail;
+			scanner->depth--;
+
+			if ( scanner->depth == 1 && c == '}' && !scanner->overflow )
+			{
+				scanner->entry[scanner->entryLen] = 0;
+
+				if ( _ATMO_CLOUD_TCP_DispatchCommandEntry( scanner->entry ) )
+				{
+					scanner->numCommands++;
+				}
+			}
 		}
 	}
+}
+
+/**
+ * Wrap up an aggregated command poll, the commands were already dispatched while the body arrived.
+ */
+static void _ATMO_CLOUD_TCP_CommandsPopped( ATMO_DriverInstanceHandle_t httpInstance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respBody, unsigned int respBodyLen, void *arg )
+{
+	ATMO_CLOUD_TCP_Priv_t *priv = ( ATMO_CLOUD_TCP_Priv_t * )arg;
+	uint64_t elapsedMs = ATMO_PLATFORM_UptimeMs() - priv->lastCommandCheck;
+
+	priv->commandPollInFlight = false;
+
+	// Long polls take as long as the server wants, only plain polls say something about the latency
+	_ATMO_CLOUD_TCP_RecordResult( priv, status, respCode, ( priv->commandPollWaitMs == 0 ) ? priv->lastCommandCheck : 0, 0, respBodyLen );
+
+	priv->lastCommandCheck = ATMO_PLATFORM_UptimeMs();
+	priv->lastCommandWaitMs = 0;
+
+	if ( status != ATMO_HTTP_Status_Success )
+	{
+		return;
+	}
+
+	if ( respCode == 404 )
+	{
+		priv->commandPopAllUnsupported = true;
+		return;
+	}
+
+	if ( respCode != 200 )
+	{
+		return;
+	}
+
+	// An empty answer well before the wait expired means the server doesn't hold requests,
+	// fall back to the poll interval instead of polling back to back
+	if ( priv->commandScanner.numCommands > 0 || elapsedMs >= ( priv->commandPollWaitMs / 2 ) )
+	{
+		priv->lastCommandWaitMs = priv->commandPollWaitMs;
+	}
+}
+
+/**
+ * Start fetching every pending command with a single request.
+ *
+ * @param waitMs - how long the server may hold the request waiting for a command
+ * @return Success if the request was started
+ */
+static ATMO_CLOUD_Status_t _ATMO_CLOUD_TCP_PopAllCommands( ATMO_DriverInstanceData_t *instance, uint32_t waitMs )
+{
+	if ( !_ATMO_CLOUD_TCP_TransportAvailable( instance ) )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	uint32_t instanceNum = _ATMO_CLOUD_TCP_GetInstanceNum( instance );
+	ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[instanceNum];
+
+	if ( priv->commandPollInFlight || !_ATMO_CLOUD_TCP_RequestAllowed( priv ) )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
+
+	// Get UUID str
+	char uuid[40];
+	ATMO_CLOUD_GetRegistrationInfoUuid( ATMO_CLOUD_GetRegistration(), uuid, sizeof( uuid ) );
+
+	const char *urlFormat = "%s/thing/%s/commands/pop?wait=%lu";
+	unsigned int urlSize = strlen( ATMO_CLOUD_GetRegistration()->url ) + strlen( uuid ) + 40;
+	char url[urlSize + 1];
+	memset( url, 0, urlSize + 1 );
+	sprintf( url, urlFormat, ATMO_CLOUD_GetRegistration()->url, uuid, ( unsigned long )( waitMs / 1000 ) );
+
+	ATMO_HTTP_Header_t header;
+	header.headerKey = "cloud";
+	header.headerValue = ATMO_CLOUD_GetRegistration()->token;
+
+	ATMO_HTTP_Transaction_t trans;
+	trans.url = url;
+	trans.method = ATMO_HTTP_GET;
+	trans.data = NULL;
+	trans.dataLen = 0;
+	trans.headerOverlay = &header;
+	trans.headerOverlayLen = 1;
+
+	memset( &priv->commandScanner, 0, sizeof( priv->commandScanner ) );
+
+	if ( ATMO_HTTP_PerformStream( priv->httpInstance, &trans, waitMs + 5000, _ATMO_CLOUD_TCP_CommandsReceived, _ATMO_CLOUD_TCP_CommandsPopped, priv ) != ATMO_HTTP_Status_Success )
+	{
+		return ATMO_CLOUD_Status_Fail;
+	}
 
-	_ATMO_CLOUD_TCP_PrivData[instanceNum].inTransaction = false;
+	priv->commandPollInFlight = true;
+	priv->commandPollWaitMs = waitMs;
 	return ATMO_CLOUD_Status_Success;
 }
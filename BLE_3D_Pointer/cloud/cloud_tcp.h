@@ -57,12 +57,48 @@ extern "C" {
 
 /* Exported Constants --------------------------------------------------------*/
 
+#define ATMO_CLOUD_TCP_LATENCY_BUCKETS (16)
+
 /* Exported Macros -----------------------------------------------------------*/
 
 /* Exported Structures -------------------------------------------------------*/
 
 /* Exported Types ------------------------------------------------------------*/
 
+/**
+ * State of the circuit breaker in front of the cloud transport.
+ */
+typedef enum
+{
+	ATMO_CLOUD_TCP_Circuit_Closed, /**< Requests go out normally */
+	ATMO_CLOUD_TCP_Circuit_Open, /**< Network is known to be bad, no requests until the open time passed */
+	ATMO_CLOUD_TCP_Circuit_HalfOpen, /**< A single probe request decides whether to close the circuit again */
+} ATMO_CLOUD_TCP_CircuitState_t;
+
+/**
+ * Health of a TCP cloud transport since it was added.
+ */
+typedef struct
+{
+	uint32_t numRequests; /**< Requests that completed, successfully or not */
+	uint32_t numSuccess; /**< 2xx responses */
+	uint32_t numTransportFailures; /**< No response: connect or send failed, connection lost */
+	uint32_t numTimeouts; /**< No complete response in time */
+	uint32_t numServerErrors; /**< 5xx responses */
+	uint32_t numRejected; /**< Other responses, e.g. 4xx. These don't trigger a back-off */
+	uint32_t bytesSent; /**< Request bodies */
+	uint32_t bytesReceived; /**< Response bodies */
+	uint32_t latencyP50Ms; /**< Median round trip, rounded up to a power of two. Long polls are left out */
+	uint32_t latencyP99Ms;
+	uint32_t latencyHistogram[ATMO_CLOUD_TCP_LATENCY_BUCKETS]; /**< Bucket n counts round trips below 2^(n+1) ms (the last one everything longer) */
+	uint32_t queueHighWater; /**< Most events queued at once */
+	uint32_t eventsDropped; /**< Events that were neither delivered nor stored in the event log */
+	uint32_t consecutiveFailures;
+	uint32_t circuitTrips; /**< Times the circuit opened */
+	ATMO_CLOUD_TCP_CircuitState_t circuitState;
+	uint32_t retryInMs; /**< Time until requests are allowed again, 0 if they are now */
+} ATMO_CLOUD_TCP_Metrics_t;
+
 /**
  * @brief This will register the TCP driver with the cloud driver
  *
@@ -98,6 +134,15 @@ ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_SendEvent( ATMO_DriverInstanceData_t *instanc
 
 ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_PopCommand( ATMO_DriverInstanceData_t *instance, const char *commandName, ATMO_Value_t *data, uint32_t timeout );
 
+/**
+ * Get the request counters, latency and back-off state of a TCP cloud transport.
+ *
+ * @param instance - Cloud instance returned by ATMO_CLOUD_TCP_AddDriverInstance
+ * @param metrics
+ * @return ATMO_CLOUD_Status_t
+ */
+ATMO_CLOUD_Status_t ATMO_CLOUD_TCP_GetMetrics( ATMO_DriverInstanceHandle_t instance, ATMO_CLOUD_TCP_Metrics_t *metrics );
+
 #ifdef __cplusplus
 }
 #endif
@@ -48,6 +48,8 @@ static ATMO_FILESYSTEM_Config_t filesystemDefaultConfig =
 {
 	.numRetries = 1,
 	.retryDelayMs = 50,
+	.cacheSize = 0,
+	.lookahead = 0,
 };
 
 ATMO_DriverInstanceHandle_t numberOfFilesystemDriverInstance = 0;
@@ -90,6 +90,8 @@ typedef struct
 {
 	unsigned int numRetries; /**< Number of retries on a filesystem operation failure */
 	unsigned int retryDelayMs; /**< How long to wait (in milliseconds) before retrying */
+	unsigned int cacheSize; /**< Bytes of the read/program caches, 0 keeps the driver default. Set after init, before mounting */
+	unsigned int lookahead; /**< Blocks scanned per allocation pass, 0 keeps the driver default. Set after init, before mounting */
 } ATMO_FILESYSTEM_Config_t;
 
 typedef struct ATMO_FILESYSTEM_DriverInstance_t ATMO_FILESYSTEM_DriverInstance_t;
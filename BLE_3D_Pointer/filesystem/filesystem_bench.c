@@ -0,0 +1,245 @@
+/**
+ ******************************************************************************
+ * @file    filesystem_bench.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Filesystem benchmark
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "filesystem_bench.h"
+#include "../app_src/atmosphere_platform.h"
+
+#define ATMO_FILESYSTEM_BENCH_FILE "bench"
+
+typedef struct
+{
+	const ATMO_FILESYSTEM_BENCH_Config_t *config;
+	uint32_t startMs;
+	ATMO_RAM_BLOCK_Stats_t startStats;
+	uint32_t rand;
+} ATMO_FILESYSTEM_BENCH_Run_t;
+
+static void _ATMO_FILESYSTEM_BENCH_Start( ATMO_FILESYSTEM_BENCH_Run_t *run )
+{
+	if ( run->config->blockStats != NULL )
+	{
+		memcpy( &run->startStats, run->config->blockStats, sizeof( ATMO_RAM_BLOCK_Stats_t ) );
+	}
+
+	run->startMs = ( uint32_t )ATMO_PLATFORM_UptimeMs();
+}
+
+static void _ATMO_FILESYSTEM_BENCH_Stop( ATMO_FILESYSTEM_BENCH_Run_t *run, ATMO_FILESYSTEM_BENCH_Result_t *result, uint32_t bytes )
+{
+	const ATMO_RAM_BLOCK_Stats_t *stats = run->config->blockStats;
+
+	result->elapsedMs = ( uint32_t )ATMO_PLATFORM_UptimeMs() - run->startMs;
+	result->bytes = bytes;
+
+	if ( stats != NULL )
+	{
+		result->busyUs = stats->busyUs - run->startStats.busyUs;
+		result->bytesRead = stats->bytesRead - run->startStats.bytesRead;
+		result->bytesProgrammed = stats->bytesProgrammed - run->startStats.bytesProgrammed;
+		result->numErases = stats->numErases - run->startStats.numErases;
+	}
+}
+
+static uint32_t _ATMO_FILESYSTEM_BENCH_Rand( ATMO_FILESYSTEM_BENCH_Run_t *run )
+{
+	// xorshift32
+	run->rand ^= run->rand << 13;
+	run->rand ^= run->rand >> 17;
+	run->rand ^= run->rand << 5;
+	return run->rand;
+}
+
+/**
+ * Write or read a whole file, in order or one chunk at a time at random chunk offsets.
+ */
+static ATMO_FILESYSTEM_Status_t _ATMO_FILESYSTEM_BENCH_Io( ATMO_FILESYSTEM_BENCH_Run_t *run, const char *path, int flags, ATMO_BOOL_t write, ATMO_BOOL_t random )
+{
+	const ATMO_FILESYSTEM_BENCH_Config_t *config = run->config;
+	uint32_t numChunks = config->fileSize / config->chunkSize;
+	ATMO_FILESYSTEM_Status_t status = ATMO_FILESYSTEM_Status_Success;
+	ATMO_FILESYSTEM_File_t file;
+	uint32_t i;
+
+	if ( ATMO_FILESYSTEM_FileOpen( config->fsHandle, &file, path, flags ) != ATMO_FILESYSTEM_Status_Success )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
+
+	for ( i = 0; i < numChunks && status == ATMO_FILESYSTEM_Status_Success; i++ )
+	{
+		if ( random )
+		{
+			status = ATMO_FILESYSTEM_FileSeek( config->fsHandle, &file, ( _ATMO_FILESYSTEM_BENCH_Rand( run ) % numChunks ) * config->chunkSize );
+
+			if ( status != ATMO_FILESYSTEM_Status_Success )
+			{
+				break;
+			}
+		}
+
+		if ( write )
+		{
+			memset( config->buf, ( uint8_t )i, config->chunkSize );
+			status = ATMO_FILESYSTEM_FileWrite( config->fsHandle, &file, config->buf, config->chunkSize );
+		}
+		else
+		{
+			status = ATMO_FILESYSTEM_FileRead( config->fsHandle, &file, config->buf, config->chunkSize );
+		}
+	}
+
+	// Closing flushes what the filesystem still caches, it belongs in the measurement
+	if ( ATMO_FILESYSTEM_FileClose( config->fsHandle, &file ) != ATMO_FILESYSTEM_Status_Success )
+	{
+		status = ATMO_FILESYSTEM_Status_Fail;
+	}
+
+	return status;
+}
+
+static ATMO_FILESYSTEM_Status_t _ATMO_FILESYSTEM_BENCH_RunIo( ATMO_FILESYSTEM_BENCH_Run_t *run, ATMO_FILESYSTEM_BENCH_Results_t *results )
+{
+	static const struct
+	{
+		int flags;
+		ATMO_BOOL_t write;
+		ATMO_BOOL_t random;
+	} tests[ATMO_FILESYSTEM_BENCH_NumTests] =
+	{
+		{ ATMO_WRONLY | ATMO_CREAT | ATMO_TRUNC, true, false }, // ATMO_FILESYSTEM_BENCH_SeqWrite
+		{ ATMO_RDONLY, false, false }, // ATMO_FILESYSTEM_BENCH_SeqRead
+		{ ATMO_RDWR, true, true }, // ATMO_FILESYSTEM_BENCH_RandWrite
+		{ ATMO_RDONLY, false, true }, // ATMO_FILESYSTEM_BENCH_RandRead
+	};
+	unsigned int i;
+
+	for ( i = 0; i < ATMO_FILESYSTEM_BENCH_NumTests; i++ )
+	{
+		_ATMO_FILESYSTEM_BENCH_Start( run );
+
+		if ( _ATMO_FILESYSTEM_BENCH_Io( run, ATMO_FILESYSTEM_BENCH_FILE, tests[i].flags, tests[i].write, tests[i].random ) != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+
+		_ATMO_FILESYSTEM_BENCH_Stop( run, &results->io[i], run->config->fileSize );
+	}
+
+	return ATMO_FILESYSTEM_Status_Success;
+}
+
+static ATMO_FILESYSTEM_Status_t _ATMO_FILESYSTEM_BENCH_RunMount( ATMO_FILESYSTEM_BENCH_Run_t *run, ATMO_FILESYSTEM_BENCH_Results_t *results )
+{
+	const ATMO_FILESYSTEM_BENCH_Config_t *config = run->config;
+	ATMO_BLOCK_DeviceInfo_t info;
+	uint32_t stored = 0;
+	unsigned int numFiles = 0;
+	unsigned int step;
+
+	if ( ATMO_BLOCK_GetDeviceInfo( config->blockHandle, &info ) != ATMO_BLOCK_Status_Success )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
+
+	uint32_t capacity = info.blockSize * info.blockCount;
+
+	// Start empty, the file of the throughput tests is fragmented by the random writes
+	ATMO_FILESYSTEM_Remove( config->fsHandle, ATMO_FILESYSTEM_BENCH_FILE );
+
+	for ( step = 0; step < ATMO_FILESYSTEM_BENCH_FILL_STEPS; step++ )
+	{
+		uint32_t target = ( uint32_t )( ( ( uint64_t )capacity * step ) / ATMO_FILESYSTEM_BENCH_FILL_STEPS );
+
+		while ( stored < target )
+		{
+			char path[sizeof( ATMO_FILESYSTEM_BENCH_FILE ) + 4];
+			sprintf( path, "%s%u", ATMO_FILESYSTEM_BENCH_FILE, numFiles++ % 10000 );
+
+			// Running out of space ends the test, the steps reached so far still count
+			if ( _ATMO_FILESYSTEM_BENCH_Io( run, path, ATMO_WRONLY | ATMO_CREAT | ATMO_TRUNC, true, false ) != ATMO_FILESYSTEM_Status_Success )
+			{
+				return ATMO_FILESYSTEM_Status_Success;
+			}
+
+			stored += config->fileSize;
+		}
+
+		if ( ATMO_FILESYSTEM_Unmount( config->fsHandle ) != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+
+		_ATMO_FILESYSTEM_BENCH_Start( run );
+
+		if ( ATMO_FILESYSTEM_Mount( config->fsHandle ) != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+
+		_ATMO_FILESYSTEM_BENCH_Stop( run, &results->mount[step], 0 );
+		results->mountFillPercent[step] = ( uint8_t )( ( ( uint64_t )stored * 100 ) / capacity );
+		results->numMountSteps = step + 1;
+	}
+
+	return ATMO_FILESYSTEM_Status_Success;
+}
+
+ATMO_FILESYSTEM_Status_t ATMO_FILESYSTEM_BENCH_Run( const ATMO_FILESYSTEM_BENCH_Config_t *config, ATMO_FILESYSTEM_BENCH_Results_t *results )
+{
+	ATMO_FILESYSTEM_BENCH_Run_t run;
+
+	if ( config->buf == NULL || config->chunkSize == 0 || config->fileSize < config->chunkSize || config->seed == 0 )
+	{
+		return ATMO_FILESYSTEM_Status_Invalid;
+	}
+
+	memset( results, 0, sizeof( ATMO_FILESYSTEM_BENCH_Results_t ) );
+	memset( &run, 0, sizeof( run ) );
+	run.config = config;
+	run.rand = config->seed;
+
+	if ( ATMO_FILESYSTEM_Wipe( config->fsHandle ) != ATMO_FILESYSTEM_Status_Success )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
+
+	if ( _ATMO_FILESYSTEM_BENCH_RunIo( &run, results ) != ATMO_FILESYSTEM_Status_Success )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
+
+	return _ATMO_FILESYSTEM_BENCH_RunMount( &run, results );
+}
@@ -0,0 +1,123 @@
+/**
+ ******************************************************************************
+ * @file    filesystem_bench.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Filesystem benchmark header file
+ *
+ * Runs a fixed workload against a mounted filesystem driver to size a storage
+ * configuration before committing to hardware: sequential and random write/read
+ * throughput and mount time at increasing fill levels. Put the filesystem on a
+ * RAM block device with a stats struct (see block_ram.h) to also get the flash
+ * traffic, from which write amplification is bytesProgrammed / bytes, and the
+ * modelled flash time from the configured latencies.
+ *
+ * The benchmark wipes the filesystem.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_FILESYSTEM_BENCH__H
+#define __ATMO_FILESYSTEM_BENCH__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "filesystem.h"
+#include "../block/block_ram.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+// Mount is timed with the device filled to 0, 1/N, ... (N-1)/N of its capacity
+#ifndef ATMO_FILESYSTEM_BENCH_FILL_STEPS
+#define ATMO_FILESYSTEM_BENCH_FILL_STEPS (4)
+#endif
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+typedef enum
+{
+	ATMO_FILESYSTEM_BENCH_SeqWrite,
+	ATMO_FILESYSTEM_BENCH_SeqRead,
+	ATMO_FILESYSTEM_BENCH_RandWrite,
+	ATMO_FILESYSTEM_BENCH_RandRead,
+	ATMO_FILESYSTEM_BENCH_NumTests
+} ATMO_FILESYSTEM_BENCH_Test_t;
+
+typedef struct
+{
+	ATMO_DriverInstanceHandle_t fsHandle; /**< Initialized filesystem */
+	ATMO_DriverInstanceHandle_t blockHandle; /**< Block device under the filesystem, for its capacity */
+	const ATMO_RAM_BLOCK_Stats_t *blockStats; /**< Optional, stats of the block device */
+	uint8_t *buf; /**< Scratch buffer of chunkSize bytes */
+	uint32_t chunkSize; /**< Bytes per read/write call */
+	uint32_t fileSize; /**< Bytes per test file, a multiple of chunkSize */
+	uint32_t seed; /**< For the random offsets, non zero */
+} ATMO_FILESYSTEM_BENCH_Config_t;
+
+typedef struct
+{
+	uint32_t elapsedMs; /**< Wall clock time */
+	uint32_t bytes; /**< File bytes written or read */
+	uint64_t busyUs; /**< Modelled flash time, 0 without block stats */
+	uint32_t bytesRead; /**< Flash traffic, 0 without block stats */
+	uint32_t bytesProgrammed;
+	uint32_t numErases;
+} ATMO_FILESYSTEM_BENCH_Result_t;
+
+typedef struct
+{
+	ATMO_FILESYSTEM_BENCH_Result_t io[ATMO_FILESYSTEM_BENCH_NumTests];
+	ATMO_FILESYSTEM_BENCH_Result_t mount[ATMO_FILESYSTEM_BENCH_FILL_STEPS];
+	uint8_t mountFillPercent[ATMO_FILESYSTEM_BENCH_FILL_STEPS]; /**< File data stored when mounting, in percent of the device */
+	uint8_t numMountSteps; /**< Fill steps reached before the filesystem ran out of space */
+} ATMO_FILESYSTEM_BENCH_Results_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Wipe the filesystem and run the benchmark.
+ *
+ * @param[in] config
+ * @param[out] results
+ * @return ATMO_FILESYSTEM_Status_t
+ */
+ATMO_FILESYSTEM_Status_t ATMO_FILESYSTEM_BENCH_Run( const ATMO_FILESYSTEM_BENCH_Config_t *config, ATMO_FILESYSTEM_BENCH_Results_t *results );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_FILESYSTEM_BENCH__H */
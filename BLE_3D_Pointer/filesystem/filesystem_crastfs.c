@@ -9,48 +9,110 @@
  * OVERVIEW
  * ========
  * The CRASTFS is designed to hold exactly the amount of information that Nimbus needs to run.
+ *
+ * The built in records are read from the block device in a single read at init
+ * and kept in RAM, so opening and reading them at boot never goes back to the
+ * device. Writes only program the bytes that changed, then bring the CRC of
+ * the built in area up to date.
  */
 
 static ATMO_BLOCK_DeviceInfo_t deviceInfo;
 static ATMO_DriverInstanceHandle_t blockHandle = 0;
 static ATMO_BOOL_t _ATMO_CRASTFS_EnoughRoom = true;
-#define ATMO_CRASTFS_MAGICWORD (0xABBC4369)
+#define ATMO_CRASTFS_MAGICWORD (0xABBC436B)
+
+// Written before the built in area had a CRC, the CRCs are added at init
+#define ATMO_CRASTFS_MAGICWORD_NO_CRC (0xABBC4369)
+
+// What a dropped record is reset to, the same as after a wipe of erased flash
+#define ATMO_CRASTFS_DROPPED_BYTE (0xFF)
+#define ATMO_CRASTFS_DROPPED_CHUNK (32)
+
+static uint8_t _ATMO_CRASTFS_Image[ATMO_CRASTFS_SIZE]; /**< Built in area as stored on the block device */
+static ATMO_BOOL_t _ATMO_CRASTFS_ImageLoaded = false;
+
+typedef enum
+{
+	ATMO_CRASTFS_RecordType_Raw,
+	ATMO_CRASTFS_RecordType_Registration,
+	ATMO_CRASTFS_RecordType_OtaComplete,
+} ATMO_CRASTFS_RecordType_t;
 
 typedef struct
 {
+	const char *path;
 	uint32_t offset;
 	uint32_t size;
+	ATMO_CRASTFS_RecordType_t type;
+	uint32_t hash;
 } ATMO_CRASTFS_FileInfo_t;
 
 #define ATMO_CRASTFS_NUM_FILES (6)
-static ATMO_CRASTFS_FileInfo_t _ATMO_CRASTFS_FileInfo[ATMO_CRASTFS_NUM_FILES] =
+
+#if ATMO_CRASTFS_CRC_SIZE != ( 2 * ATMO_CRASTFS_NUM_FILES )
+#error "ATMO_CRASTFS_CRC_SIZE must hold one CRC-16 per built in record"
+#endif
+
+// Total number of records including the built in ones
+#ifndef ATMO_CRASTFS_MAX_RECORDS
+#define ATMO_CRASTFS_MAX_RECORDS (ATMO_CRASTFS_NUM_FILES + 4)
+#endif
+
+// Paths are found through an open addressing table with linear probing, so a
+// lookup costs one hash of the path and usually a single strcmp. Must be a
+// power of two larger than ATMO_CRASTFS_MAX_RECORDS.
+#define ATMO_CRASTFS_HASH_SLOTS (16)
+
+#if ( ATMO_CRASTFS_HASH_SLOTS & ( ATMO_CRASTFS_HASH_SLOTS - 1 ) ) != 0 || ATMO_CRASTFS_HASH_SLOTS <= ATMO_CRASTFS_MAX_RECORDS
+#error "ATMO_CRASTFS_HASH_SLOTS must be a power of two larger than ATMO_CRASTFS_MAX_RECORDS"
+#endif
+
+static ATMO_CRASTFS_FileInfo_t _ATMO_CRASTFS_FileInfo[ATMO_CRASTFS_MAX_RECORDS] =
 {
 	{
+		"registrationInfo",
 		ATMO_CRASTFS_REGISTERED_OFFSET,
-		ATMO_CRASTFS_REGISTERED_SIZE
+		ATMO_CRASTFS_REGISTERED_SIZE,
+		ATMO_CRASTFS_RecordType_Registration
 	},
 	{
+		"project_uuid",
 		ATMO_CRASTFS_PROJECT_UUID_OFFSET,
-		ATMO_CRASTFS_PROJECT_UUID_SIZE
+		ATMO_CRASTFS_PROJECT_UUID_SIZE,
+		ATMO_CRASTFS_RecordType_Raw
 	},
 	{
+		"buildUuid",
 		ATMO_CRASTFS_BUILD_UUID_OFFSET,
-		ATMO_CRASTFS_BUILD_UUID_SIZE
+		ATMO_CRASTFS_BUILD_UUID_SIZE,
+		ATMO_CRASTFS_RecordType_Raw
 	},
 	{
+		"ota_complete",
 		ATMO_CRASTFS_OTA_COMPLETE_OFFSET,
-		ATMO_CRASTFS_OTA_COMPLETE_SIZE
+		ATMO_CRASTFS_OTA_COMPLETE_SIZE,
+		ATMO_CRASTFS_RecordType_OtaComplete
 	},
 	{
+		"extra1",
 		ATMO_CRASTFS_EXTRA1_OFFSET,
-		ATMO_CRASTFS_EXTRA1_SIZE
+		ATMO_CRASTFS_EXTRA1_SIZE,
+		ATMO_CRASTFS_RecordType_Raw
 	},
 	{
+		"extra2",
 		ATMO_CRASTFS_EXTRA2_OFFSET,
-		ATMO_CRASTFS_EXTRA2_SIZE
+		ATMO_CRASTFS_EXTRA2_SIZE,
+		ATMO_CRASTFS_RecordType_Raw
 	}
 };
 
+static unsigned int _ATMO_CRASTFS_NumRecords = ATMO_CRASTFS_NUM_FILES;
+static uint32_t _ATMO_CRASTFS_NextOffset = ATMO_CRASTFS_SIZE;
+
+static uint8_t _ATMO_CRASTFS_HashTable[ATMO_CRASTFS_HASH_SLOTS]; /**< Record index + 1, 0 for an empty slot */
+static unsigned int _ATMO_CRASTFS_NumHashed = 0;
+
 ATMO_FILESYSTEM_DriverInstance_t CRASTFSFilesystemDriverInstance =
 {
 	ATMO_CRASTFS_FILESYSTEM_Init,
@@ -74,13 +136,6 @@ ATMO_FILESYSTEM_DriverInstance_t CRASTFSFilesystemDriverInstance =
 	ATMO_CRASTFS_FILESYSTEM_DirMk
 };
 
-static const char *buildUuidPathStr = "buildUuid";
-static const char *projectUuidPathStr = "project_uuid";
-static const char *regInfoPathStr = "registrationInfo";
-static const char *otaCompletePathStr = "ota_complete";
-static const char *extra1PathStr = "extra1";
-static const char *extra2PathStr = "extra2";
-
 static ATMO_DriverInstanceData_t crastFsDriverInstanceData;
 
 ATMO_Status_t ATMO_CRASTFS_FILESYSTEM_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
@@ -92,33 +147,206 @@ ATMO_Status_t ATMO_CRASTFS_FILESYSTEM_AddDriverInstance( ATMO_DriverInstanceHand
 	crastFsDriverInstanceData.argument = NULL;
 	return ATMO_FILESYSTEM_AddDriverInstance( &CRASTFSFilesystemDriverInstance, &crastFsDriverInstanceData, instanceNumber );
 }
+
+static uint16_t _ATMO_CRASTFS_Crc( uint32_t start, uint32_t end )
+{
+	// CRC-16/CCITT
+	uint16_t crc = 0xFFFF;
+	uint32_t i;
+
+	for ( i = start; i < end; i++ )
+	{
+		crc ^= ( uint16_t )_ATMO_CRASTFS_Image[i] << 8;
+
+		unsigned int bit;
+
+		for ( bit = 0; bit < 8; bit++ )
+		{
+			crc = ( crc & 0x8000 ) ? ( ( crc << 1 ) ^ 0x1021 ) : ( crc << 1 );
+		}
+	}
+
+	return crc;
+}
+
+/**
+ * The built in records are laid out back to back in table order, so a record
+ * reaches up to the next one. This also covers the registration, whose table
+ * size is only its first byte.
+ */
+static uint32_t _ATMO_CRASTFS_RecordEnd( unsigned int index )
+{
+	return ( index + 1 < ATMO_CRASTFS_NUM_FILES ) ? _ATMO_CRASTFS_FileInfo[index + 1].offset : ATMO_CRASTFS_CRC_OFFSET;
+}
+
+static uint16_t _ATMO_CRASTFS_RecordCrc( unsigned int index )
+{
+	return _ATMO_CRASTFS_Crc( _ATMO_CRASTFS_FileInfo[index].offset, _ATMO_CRASTFS_RecordEnd( index ) );
+}
+
+static uint16_t _ATMO_CRASTFS_StoredCrc( unsigned int index )
+{
+	uint32_t offset = ATMO_CRASTFS_CRC_OFFSET + ( 2 * index );
+
+	return _ATMO_CRASTFS_Image[offset] | ( _ATMO_CRASTFS_Image[offset + 1] << 8 );
+}
+
+static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_LoadImage( void )
+{
+	_ATMO_CRASTFS_ImageLoaded = ( ATMO_BLOCK_Read( blockHandle, 0, 0, _ATMO_CRASTFS_Image, ATMO_CRASTFS_SIZE ) == ATMO_BLOCK_Status_Success );
+
+	return _ATMO_CRASTFS_ImageLoaded ? ATMO_FILESYSTEM_Status_Success : ATMO_FILESYSTEM_Status_Fail;
+}
+
+/**
+ * Write to the built in area, programming only the runs of bytes that differ
+ * from what is stored.
+ */
+static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_WriteImage( uint32_t offset, const uint8_t *data, uint32_t size )
+{
+	uint32_t i = 0;
+
+	while ( i < size )
+	{
+		if ( _ATMO_CRASTFS_Image[offset + i] == data[i] )
+		{
+			i++;
+			continue;
+		}
+
+		uint32_t start = offset + i;
+
+		while ( i < size && _ATMO_CRASTFS_Image[offset + i] != data[i] )
+		{
+			_ATMO_CRASTFS_Image[offset + i] = data[i];
+			i++;
+		}
+
+		if ( ATMO_BLOCK_Program( blockHandle, 0, start, &_ATMO_CRASTFS_Image[start], ( offset + i ) - start ) != ATMO_BLOCK_Status_Success )
+		{
+			// Get back in line with what actually made it to the device
+			_ATMO_CRASTFS_LoadImage();
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+	}
+
+	return ATMO_FILESYSTEM_Status_Success;
+}
+
+static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_CommitCrc( unsigned int index )
+{
+	uint16_t crc = _ATMO_CRASTFS_RecordCrc( index );
+	uint8_t crcBytes[2] = { crc & 0xFF, ( crc >> 8 ) & 0xFF };
+
+	return _ATMO_CRASTFS_WriteImage( ATMO_CRASTFS_CRC_OFFSET + ( 2 * index ), crcBytes, sizeof( crcBytes ) );
+}
+
+static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_CommitAllCrcs( void )
+{
+	unsigned int i;
+
+	for ( i = 0; i < ATMO_CRASTFS_NUM_FILES; i++ )
+	{
+		if ( _ATMO_CRASTFS_CommitCrc( i ) != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+	}
+
+	return ATMO_FILESYSTEM_Status_Success;
+}
+
+/**
+ * Reset a record that failed its CRC, it then reads back like it was never
+ * written.
+ */
+static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_DropRecord( unsigned int index )
+{
+	uint8_t dropped[ATMO_CRASTFS_DROPPED_CHUNK];
+	uint32_t offset = _ATMO_CRASTFS_FileInfo[index].offset;
+	uint32_t end = _ATMO_CRASTFS_RecordEnd( index );
+
+	memset( dropped, ATMO_CRASTFS_DROPPED_BYTE, sizeof( dropped ) );
+
+	while ( offset < end )
+	{
+		uint32_t size = ( ( end - offset ) < sizeof( dropped ) ) ? ( end - offset ) : sizeof( dropped );
+
+		if ( _ATMO_CRASTFS_WriteImage( offset, dropped, size ) != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+
+		offset += size;
+	}
+
+	return _ATMO_CRASTFS_CommitCrc( index );
+}
+
+static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_WriteMagicWord( void )
+{
+	uint32_t magicWord = ATMO_CRASTFS_MAGICWORD;
+
+	return _ATMO_CRASTFS_WriteImage( ATMO_CRASTFS_MAGICWORD_OFFSET, ( const uint8_t * )&magicWord, sizeof( magicWord ) );
+}
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_Init( ATMO_DriverInstanceData_t *instance, ATMO_DriverInstanceHandle_t blockDriverHandle )
 {
 	blockHandle = blockDriverHandle;
 	ATMO_BLOCK_GetDeviceInfo( blockHandle, &deviceInfo );
 
-	uint32_t totalNumBytes = deviceInfo.blockSize * deviceInfo.blockCount;
-
-	if ( totalNumBytes < ATMO_CRASTFS_SIZE )
+	// Every record lives in the first block
+	if ( deviceInfo.blockSize < _ATMO_CRASTFS_NextOffset )
 	{
 		_ATMO_CRASTFS_EnoughRoom = false;
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
 
-	// Write metadata
+	if ( _ATMO_CRASTFS_LoadImage() != ATMO_FILESYSTEM_Status_Success )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
+
 	uint32_t magicWord = 0;
+	memcpy( &magicWord, &_ATMO_CRASTFS_Image[ATMO_CRASTFS_MAGICWORD_OFFSET], sizeof( magicWord ) );
 
-	if ( ATMO_BLOCK_Read( blockHandle, 0, ATMO_CRASTFS_MAGICWORD_OFFSET, &magicWord, sizeof( magicWord ) ) != ATMO_BLOCK_Status_Success )
+	if ( magicWord == ATMO_CRASTFS_MAGICWORD_NO_CRC )
 	{
-		return ATMO_FILESYSTEM_Status_Fail;
+		// Keep the contents, they are covered from now on
+		if ( _ATMO_CRASTFS_CommitAllCrcs() != ATMO_FILESYSTEM_Status_Success || _ATMO_CRASTFS_WriteMagicWord() != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
+
+		return ATMO_FILESYSTEM_Status_Success;
 	}
 
 	if ( magicWord != ATMO_CRASTFS_MAGICWORD )
 	{
 #ifndef ATMO_SLIM_STACK
-		ATMO_PLATFORM_DebugPrint( "Filesystem version incorrect, wiping...\r\n" );
+		ATMO_PLATFORM_DebugPrint( "Filesystem version incorrect or corrupted, wiping...\r\n" );
 #endif
-		ATMO_CRASTFS_FILESYSTEM_Wipe( instance );
+		return ATMO_CRASTFS_FILESYSTEM_Wipe( instance );
+	}
+
+	// A record and its CRC are written one after the other. A reset in between
+	// costs that record, not the rest of the image.
+	unsigned int i;
+
+	for ( i = 0; i < ATMO_CRASTFS_NUM_FILES; i++ )
+	{
+		if ( _ATMO_CRASTFS_StoredCrc( i ) == _ATMO_CRASTFS_RecordCrc( i ) )
+		{
+			continue;
+		}
+
+#ifndef ATMO_SLIM_STACK
+		ATMO_PLATFORM_DebugPrint( "Filesystem record %s corrupted, dropping it\r\n", _ATMO_CRASTFS_FileInfo[i].path );
+#endif
+
+		if ( _ATMO_CRASTFS_DropRecord( i ) != ATMO_FILESYSTEM_Status_Success )
+		{
+			return ATMO_FILESYSTEM_Status_Fail;
+		}
 	}
 
 	return ATMO_FILESYSTEM_Status_Success;
@@ -138,10 +366,14 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_Wipe( ATMO_DriverInstanceData_t
 		ATMO_BLOCK_Erase( blockHandle, i );
 	}
 
-	// Write metadata
-	uint32_t magicWord = ATMO_CRASTFS_MAGICWORD;
+	// Whatever the erased device reads back as is the new image
+	if ( _ATMO_CRASTFS_LoadImage() != ATMO_FILESYSTEM_Status_Success )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
 
-	if ( ATMO_BLOCK_Program( blockHandle, 0, ATMO_CRASTFS_MAGICWORD_OFFSET, &magicWord, sizeof( magicWord ) ) != ATMO_BLOCK_Status_Success )
+	// Write metadata
+	if ( _ATMO_CRASTFS_WriteMagicWord() != ATMO_FILESYSTEM_Status_Success || _ATMO_CRASTFS_CommitAllCrcs() != ATMO_FILESYSTEM_Status_Success )
 	{
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
@@ -159,36 +391,92 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_Unmount( ATMO_DriverInstanceDat
 	return ATMO_FILESYSTEM_Status_Success;
 }
 
-static int _ATMO_CRASTFS_FILESYSTEM_GetFileInfoIndex( const char *path )
+static uint32_t _ATMO_CRASTFS_Hash( const char *path )
 {
-	if ( strcmp( path, buildUuidPathStr ) == 0 )
-	{
-		return 2;
-	}
-	else if ( strcmp( path, projectUuidPathStr ) == 0 )
+	// FNV-1a
+	uint32_t hash = 0x811C9DC5;
+
+	while ( *path != '\0' )
 	{
-		return 1;
+		hash ^= ( uint8_t ) * path++;
+		hash *= 0x01000193;
 	}
-	else if ( strcmp( path, regInfoPathStr ) == 0 )
+
+	return hash;
+}
+
+/**
+ * Add any records that are not in the hash table yet. The built in records are
+ * picked up on first use, so nothing has to run before the first lookup.
+ */
+static void _ATMO_CRASTFS_UpdateIndex()
+{
+	for ( ; _ATMO_CRASTFS_NumHashed < _ATMO_CRASTFS_NumRecords; _ATMO_CRASTFS_NumHashed++ )
 	{
-		return 0;
+		ATMO_CRASTFS_FileInfo_t *info = &_ATMO_CRASTFS_FileInfo[_ATMO_CRASTFS_NumHashed];
+		info->hash = _ATMO_CRASTFS_Hash( info->path );
+
+		unsigned int slot = info->hash & ( ATMO_CRASTFS_HASH_SLOTS - 1 );
+
+		while ( _ATMO_CRASTFS_HashTable[slot] != 0 )
+		{
+			slot = ( slot + 1 ) & ( ATMO_CRASTFS_HASH_SLOTS - 1 );
+		}
+
+		_ATMO_CRASTFS_HashTable[slot] = _ATMO_CRASTFS_NumHashed + 1;
 	}
-	else if ( strcmp( path, otaCompletePathStr ) == 0 )
+}
+
+static int _ATMO_CRASTFS_FILESYSTEM_GetFileInfoIndex( const char *path )
+{
+	_ATMO_CRASTFS_UpdateIndex();
+
+	uint32_t hash = _ATMO_CRASTFS_Hash( path );
+	unsigned int slot = hash & ( ATMO_CRASTFS_HASH_SLOTS - 1 );
+
+	// The table is never full, an empty slot always ends the probe
+	while ( _ATMO_CRASTFS_HashTable[slot] != 0 )
 	{
-		return 3;
+		int index = _ATMO_CRASTFS_HashTable[slot] - 1;
+
+		if ( _ATMO_CRASTFS_FileInfo[index].hash == hash && strcmp( _ATMO_CRASTFS_FileInfo[index].path, path ) == 0 )
+		{
+			return index;
+		}
+
+		slot = ( slot + 1 ) & ( ATMO_CRASTFS_HASH_SLOTS - 1 );
 	}
-	else if ( strcmp( path, extra1PathStr ) == 0 )
+
+	return -1;
+}
+
+ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_AddRecord( const char *path, uint32_t size )
+{
+	if ( path == NULL || size == 0 || _ATMO_CRASTFS_FILESYSTEM_GetFileInfoIndex( path ) >= 0 )
 	{
-		return 4;
+		return ATMO_FILESYSTEM_Status_Invalid;
 	}
-	else if ( strcmp( path, extra2PathStr ) == 0 )
+
+	if ( _ATMO_CRASTFS_NumRecords >= ATMO_CRASTFS_MAX_RECORDS )
 	{
-		return 5;
+		return ATMO_FILESYSTEM_Status_Fail;
 	}
-	else
+
+	// The block driver is only known after init, otherwise init checks the total
+	if ( deviceInfo.blockSize > 0 && size > deviceInfo.blockSize - _ATMO_CRASTFS_NextOffset )
 	{
-		return -1;
+		return ATMO_FILESYSTEM_Status_Invalid;
 	}
+
+	ATMO_CRASTFS_FileInfo_t *info = &_ATMO_CRASTFS_FileInfo[_ATMO_CRASTFS_NumRecords++];
+	info->path = path;
+	info->offset = _ATMO_CRASTFS_NextOffset;
+	info->size = size;
+	info->type = ATMO_CRASTFS_RecordType_Raw;
+
+	_ATMO_CRASTFS_NextOffset += size;
+
+	return ATMO_FILESYSTEM_Status_Success;
 }
 
 static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_SimpleRead( uint32_t offset, void *buffer, uint32_t bufferSize, uint32_t readSize )
@@ -198,6 +486,12 @@ static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_SimpleRead( uint32_t offset, void
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
 
+	if ( _ATMO_CRASTFS_ImageLoaded && ( offset + readSize ) <= ATMO_CRASTFS_SIZE )
+	{
+		memcpy( buffer, &_ATMO_CRASTFS_Image[offset], readSize );
+		return ATMO_FILESYSTEM_Status_Success;
+	}
+
 	return ( ATMO_BLOCK_Read( blockHandle, 0, offset, buffer, readSize ) == ATMO_BLOCK_Status_Success ) ? ATMO_FILESYSTEM_Status_Success : ATMO_FILESYSTEM_Status_Fail;
 }
 
@@ -208,6 +502,12 @@ static ATMO_FILESYSTEM_Status_t _ATMO_CRASTFS_SimpleWrite( uint32_t offset, void
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
 
+	// The CRC is brought up to date once the whole record is written
+	if ( _ATMO_CRASTFS_ImageLoaded && ( offset + writeSize ) <= ATMO_CRASTFS_SIZE )
+	{
+		return _ATMO_CRASTFS_WriteImage( offset, ( const uint8_t * )buffer, writeSize );
+	}
+
 	return ( ATMO_BLOCK_Program( blockHandle, 0, offset, buffer, writeSize ) == ATMO_BLOCK_Status_Success ) ? ATMO_FILESYSTEM_Status_Success : ATMO_FILESYSTEM_Status_Fail;
 }
 
@@ -350,7 +650,7 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileOpen( ATMO_DriverInstanceDa
 	}
 
 #ifdef ATMO_CRASTFS_DEBUG
-	ATMO_PLATFORM_DebugPrint( "Opened file %s. Offset: %d Size %d\r\n", path, offset, size );
+	ATMO_PLATFORM_DebugPrint( "Opened file %s. Offset: %d Size %d\r\n", path, _ATMO_CRASTFS_FileInfo[index].offset, _ATMO_CRASTFS_FileInfo[index].size );
 #endif
 
 	file->data = &_ATMO_CRASTFS_FileInfo[index];
@@ -360,48 +660,34 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileOpen( ATMO_DriverInstanceDa
 
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileClose( ATMO_DriverInstanceData_t *instance, ATMO_FILESYSTEM_File_t *file )
 {
-	return ATMO_FILESYSTEM_Status_Success;
+	return ATMO_CRASTFS_FILESYSTEM_FileSync( instance, file );
 }
 
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileSync( ATMO_DriverInstanceData_t *instance, ATMO_FILESYSTEM_File_t *file )
 {
-	return ATMO_FILESYSTEM_Status_Success;
+	// Writes may still only be in the block driver's RAM copy
+	return ( ATMO_BLOCK_Sync( blockHandle ) == ATMO_BLOCK_Status_Success ) ? ATMO_FILESYSTEM_Status_Success : ATMO_FILESYSTEM_Status_Fail;
 }
 
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileRead( ATMO_DriverInstanceData_t *instance, ATMO_FILESYSTEM_File_t *file, void *buffer, uint32_t size )
 {
 	ATMO_CRASTFS_FileInfo_t *info = ( ATMO_CRASTFS_FileInfo_t * )file->data;
 
-	switch ( info->offset )
+	switch ( info->type )
 	{
-		case ATMO_CRASTFS_REGISTERED_OFFSET:
+		case ATMO_CRASTFS_RecordType_Registration:
 		{
 			return _ATMO_CRASTFS_ReadRegistrationData( buffer, size );
 		}
 
-		case ATMO_CRASTFS_BUILD_UUID_OFFSET:
-		{
-			return _ATMO_CRASTFS_SimpleRead( ATMO_CRASTFS_BUILD_UUID_OFFSET, buffer, size, ATMO_CRASTFS_BUILD_UUID_SIZE );
-		}
-
-		case ATMO_CRASTFS_PROJECT_UUID_OFFSET:
-		{
-			return _ATMO_CRASTFS_SimpleRead( ATMO_CRASTFS_PROJECT_UUID_OFFSET, buffer, size, ATMO_CRASTFS_PROJECT_UUID_SIZE );
-		}
-
-		case ATMO_CRASTFS_OTA_COMPLETE_OFFSET:
+		case ATMO_CRASTFS_RecordType_OtaComplete:
 		{
 			return _ATMO_CRASTFS_ReadOtaComplete( buffer, size );
 		}
 
-		case ATMO_CRASTFS_EXTRA1_OFFSET:
+		case ATMO_CRASTFS_RecordType_Raw:
 		{
-			return _ATMO_CRASTFS_SimpleRead( ATMO_CRASTFS_EXTRA1_OFFSET, buffer, size, ATMO_CRASTFS_EXTRA1_SIZE );
-		}
-
-		case ATMO_CRASTFS_EXTRA2_OFFSET:
-		{
-			return _ATMO_CRASTFS_SimpleRead( ATMO_CRASTFS_EXTRA2_OFFSET, buffer, size, ATMO_CRASTFS_EXTRA2_SIZE );
+			return _ATMO_CRASTFS_SimpleRead( info->offset, buffer, size, info->size );
 		}
 
 		default:
@@ -417,41 +703,30 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileWrite( ATMO_DriverInstanceD
 {
 
 	ATMO_CRASTFS_FileInfo_t *info = ( ATMO_CRASTFS_FileInfo_t * )file->data;
+	ATMO_FILESYSTEM_Status_t status;
 
 #ifdef ATMO_CRASTFS_DEBUG
 	ATMO_PLATFORM_DebugPrint( "Writing Offset %d\r\n", info->offset );
 #endif
 
-	switch ( info->offset )
+	switch ( info->type )
 	{
-		case ATMO_CRASTFS_REGISTERED_OFFSET:
-		{
-			return _ATMO_CRASTFS_WriteRegistrationData( buffer, size );
-		}
-
-		case ATMO_CRASTFS_BUILD_UUID_OFFSET:
+		case ATMO_CRASTFS_RecordType_Registration:
 		{
-			return _ATMO_CRASTFS_SimpleWrite( ATMO_CRASTFS_BUILD_UUID_OFFSET, buffer, size, ATMO_CRASTFS_BUILD_UUID_SIZE );
+			status = _ATMO_CRASTFS_WriteRegistrationData( buffer, size );
+			break;
 		}
 
-		case ATMO_CRASTFS_PROJECT_UUID_OFFSET:
+		case ATMO_CRASTFS_RecordType_OtaComplete:
 		{
-			return _ATMO_CRASTFS_SimpleWrite( ATMO_CRASTFS_PROJECT_UUID_OFFSET, buffer, size, ATMO_CRASTFS_PROJECT_UUID_SIZE );
+			status = _ATMO_CRASTFS_WriteOtaComplete( buffer, size );
+			break;
 		}
 
-		case ATMO_CRASTFS_OTA_COMPLETE_OFFSET:
+		case ATMO_CRASTFS_RecordType_Raw:
 		{
-			return _ATMO_CRASTFS_ReadOtaComplete( buffer, size );
-		}
-
-		case ATMO_CRASTFS_EXTRA1_OFFSET:
-		{
-			return _ATMO_CRASTFS_SimpleWrite( ATMO_CRASTFS_EXTRA1_OFFSET, buffer, size, ATMO_CRASTFS_EXTRA1_SIZE );
-		}
-
-		case ATMO_CRASTFS_EXTRA2_OFFSET:
-		{
-			return _ATMO_CRASTFS_SimpleWrite( ATMO_CRASTFS_EXTRA2_OFFSET, buffer, size, ATMO_CRASTFS_EXTRA2_SIZE );
+			status = _ATMO_CRASTFS_SimpleWrite( info->offset, buffer, size, info->size );
+			break;
 		}
 
 		default:
@@ -460,7 +735,15 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileWrite( ATMO_DriverInstanceD
 		}
 	}
 
-	return ATMO_FILESYSTEM_Status_Success;
+	// Application records live past the built in area and aren't covered
+	unsigned int index = info - _ATMO_CRASTFS_FileInfo;
+
+	if ( status == ATMO_FILESYSTEM_Status_Success && _ATMO_CRASTFS_ImageLoaded && index < ATMO_CRASTFS_NUM_FILES )
+	{
+		status = _ATMO_CRASTFS_CommitCrc( index );
+	}
+
+	return status;
 }
 
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileSeek( ATMO_DriverInstanceData_t *instance, ATMO_FILESYSTEM_File_t *file, uint32_t offset )
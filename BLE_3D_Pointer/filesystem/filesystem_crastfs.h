@@ -44,7 +44,13 @@ extern "C" {
 #define ATMO_CRASTFS_EXTRA2_OFFSET (ATMO_CRASTFS_EXTRA1_OFFSET + ATMO_CRASTFS_EXTRA1_SIZE)
 #define ATMO_CRASTFS_EXTRA2_SIZE (33)
 
-#define ATMO_CRASTFS_SIZE (ATMO_CRASTFS_EXTRA2_OFFSET + ATMO_CRASTFS_EXTRA2_SIZE)
+// A CRC-16 for each of the six built in records, in the order of the record
+// table. The whole built in area is read once at init, a record that fails its
+// CRC is dropped on its own and the others are kept.
+#define ATMO_CRASTFS_CRC_OFFSET (ATMO_CRASTFS_EXTRA2_OFFSET + ATMO_CRASTFS_EXTRA2_SIZE)
+#define ATMO_CRASTFS_CRC_SIZE (12)
+
+#define ATMO_CRASTFS_SIZE (ATMO_CRASTFS_CRC_OFFSET + ATMO_CRASTFS_CRC_SIZE)
 
 /* Exported Constants --------------------------------------------------------*/
 
@@ -73,6 +79,25 @@ ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileRewind( ATMO_DriverInstance
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_FileTruncate( ATMO_DriverInstanceData_t *instance, ATMO_FILESYSTEM_File_t *file, uint32_t size );
 ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_DirMk( ATMO_DriverInstanceData_t *instance, const char *path );
 
+/**
+ * Add an application record (calibration data, counters...) after the built in
+ * ones. It can then be opened by path like any other file. Space is handed out
+ * in the order records are added, so they must be added in the same order on
+ * every boot, before they are opened. The path is not copied.
+ *
+ * All records share the first block of the block device, after the
+ * ATMO_CRASTFS_SIZE bytes of built in ones. On the 256 byte ONSEMI NVRAM that
+ * leaves 4 bytes for application records, anything bigger needs its own block
+ * device or filesystem.
+ *
+ * @param[in] path
+ * @param[in] size - Maximum number of bytes the record can hold
+ * @return Invalid if the record doesn't fit in what is left of the block, Fail
+ *         if there are already ATMO_CRASTFS_MAX_RECORDS records. Records added
+ *         before init are checked by init, which fails if they don't fit.
+ */
+ATMO_FILESYSTEM_Status_t ATMO_CRASTFS_FILESYSTEM_AddRecord( const char *path, uint32_t size );
+
 
 
 #ifdef __cplusplus
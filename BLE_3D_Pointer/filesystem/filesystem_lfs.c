@@ -3,10 +3,54 @@
 #include "../app_src/atmosphere_platform.h"
 #include "../block/block.h"
 
+// Still built on the vendored littlefs 1.3 (see LFS_VERSION in lfs.h). The move
+// to littlefs 2.x is open: it needs the v2 sources vendored and a migration of
+// the 1.x on-disk format, which 2.x can't mount. Until then there is one open
+// file per filesystem, no block_cycles wear leveling, and the copy-on-write cost
+// of 1.x on every write.
+#if LFS_VERSION_MAJOR != 1
+#error "filesystem_lfs.c is written against the littlefs 1.x API"
+#endif
+
+#ifndef NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES
 #define NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES (4)
+#endif
+
+// All buffers are static so the filesystem works under ATMO_STATIC_CORE, where
+// ATMO_Malloc has nothing to give. The read, program and file caches are each
+// ATMO_LFS_MAX_CACHE_SIZE bytes, the lookahead buffer holds one bit per block.
+// The block device's read and program sizes must fit in the cache.
+#ifndef ATMO_LFS_MAX_CACHE_SIZE
+#define ATMO_LFS_MAX_CACHE_SIZE (64)
+#endif
+
+#ifndef ATMO_LFS_MAX_LOOKAHEAD
+#define ATMO_LFS_MAX_LOOKAHEAD (128)
+#endif
+
+#if ( ATMO_LFS_MAX_LOOKAHEAD % 32 ) != 0
+#error "ATMO_LFS_MAX_LOOKAHEAD must be a multiple of 32"
+#endif
+
+typedef struct
+{
+	ATMO_DriverInstanceData_t driver;
+	uint32_t fsNum;
+	ATMO_DriverInstanceHandle_t blockHandle;
+	ATMO_BLOCK_DeviceInfo_t devInfo;
+	ATMO_BOOL_t initialized; /**< devInfo is only known after init */
+	ATMO_BOOL_t mounted;
+	ATMO_BOOL_t fileOpen; /**< littlefs 1.x shares the static file cache, one open file at a time */
+	lfs_file_t file;
+	uint8_t readBuffer[ATMO_LFS_MAX_CACHE_SIZE];
+	uint8_t progBuffer[ATMO_LFS_MAX_CACHE_SIZE];
+	uint8_t fileBuffer[ATMO_LFS_MAX_CACHE_SIZE];
+	uint32_t lookaheadBuffer[ATMO_LFS_MAX_LOOKAHEAD / 32];
+} ATMO_LFS_Priv_t;
 
 static struct lfs_config configs[NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES];
 static lfs_t filesystems[NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES];
+static ATMO_LFS_Priv_t privData[NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES];
 
 static uint32_t currentNumFileSystems = 0;
 
@@ -94,15 +138,37 @@ int lfs_sync( const struct lfs_config *c )
 
 ATMO_Status_t ATMO_LFS_FILESYSTEM_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
 {
-	ATMO_DriverInstanceData_t *driver = ( ATMO_DriverInstanceData_t * )ATMO_Malloc( sizeof( ATMO_DriverInstanceData_t ) );
+	if ( currentNumFileSystems >= NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES )
+	{
+		return ATMO_Status_OutOfMemory;
+	}
+
+	ATMO_LFS_Priv_t *priv = &privData[currentNumFileSystems];
+	priv->fsNum = currentNumFileSystems++;
+
+	ATMO_DriverInstanceData_t *driver = &priv->driver;
 	driver->name = "Filesystem";
 	driver->initialized = false;
 	driver->instanceNumber = *instanceNumber;
-	driver->argument = ATMO_Malloc( sizeof( uint32_t ) );
-	*( ( uint32_t * )driver->argument ) = currentNumFileSystems++;
+	driver->argument = &priv->fsNum;
 
 	return ATMO_FILESYSTEM_AddDriverInstance( &lfsFilesystemDriverInstance, driver, instanceNumber );
 }
+
+/**
+ * Check that a cache size works with the block device.
+ */
+static ATMO_BOOL_t _ATMO_LFS_CacheSizeValid( const ATMO_BLOCK_DeviceInfo_t *devInfo, uint32_t cacheSize )
+{
+	if ( devInfo->readSize == 0 || devInfo->progSize == 0 || devInfo->blockSize == 0 )
+	{
+		return false;
+	}
+
+	return ( cacheSize > 0 && cacheSize <= ATMO_LFS_MAX_CACHE_SIZE && ( cacheSize % devInfo->readSize ) == 0 &&
+	         ( cacheSize % devInfo->progSize ) == 0 && ( devInfo->blockSize % cacheSize ) == 0 );
+}
+
 ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_Init( ATMO_DriverInstanceData_t *instance, ATMO_DriverInstanceHandle_t blockDriverHandle )
 {
 	uint32_t fsNum = *( ( uint32_t * )instance->argument );
@@ -112,30 +178,88 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_Init( ATMO_DriverInstanceData_t *in
 		return ATMO_FILESYSTEM_Status_Invalid;
 	}
 
-	ATMO_BLOCK_DeviceInfo_t devInfo;
-	ATMO_BLOCK_GetDeviceInfo( blockDriverHandle, &devInfo );
-
-	configs[fsNum].context = malloc( sizeof( uint32_t ) );
-	*( ( uint32_t * )configs[fsNum].context ) = blockDriverHandle;
-	configs[fsNum].block_count = devInfo.blockCount;
-	configs[fsNum].block_size = devInfo.blockSize;
-	configs[fsNum].read_size = devInfo.readSize;
-	configs[fsNum].prog_size = devInfo.progSize;
-	configs[fsNum].lookahead = 128;
+	ATMO_LFS_Priv_t *priv = &privData[fsNum];
+
+	if ( ATMO_BLOCK_GetDeviceInfo( blockDriverHandle, &priv->devInfo ) != ATMO_BLOCK_Status_Success || priv->devInfo.readSize == 0 || priv->devInfo.progSize == 0 )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
+
+	// Smallest cache the device allows, SetConfiguration can raise it
+	uint32_t cacheSize = ( priv->devInfo.readSize > priv->devInfo.progSize ) ? priv->devInfo.readSize : priv->devInfo.progSize;
+
+	if ( !_ATMO_LFS_CacheSizeValid( &priv->devInfo, cacheSize ) )
+	{
+		return ATMO_FILESYSTEM_Status_NotSupported;
+	}
+
+	priv->blockHandle = blockDriverHandle;
+	priv->initialized = true;
+	priv->mounted = false;
+	priv->fileOpen = false;
+
+	configs[fsNum].context = &priv->blockHandle;
+	configs[fsNum].block_count = priv->devInfo.blockCount;
+	configs[fsNum].block_size = priv->devInfo.blockSize;
+	configs[fsNum].read_size = cacheSize;
+	configs[fsNum].prog_size = cacheSize;
+	configs[fsNum].lookahead = ATMO_LFS_MAX_LOOKAHEAD;
 	configs[fsNum].erase = lfs_erase;
 	configs[fsNum].prog = lfs_prog;
 	configs[fsNum].read = lfs_read;
 	configs[fsNum].sync = lfs_sync;
-	configs[fsNum].file_buffer = NULL;
-	configs[fsNum].lookahead_buffer = NULL;
-	configs[fsNum].prog_buffer = NULL;
-	configs[fsNum].read_buffer = NULL;
+	configs[fsNum].file_buffer = priv->fileBuffer;
+	configs[fsNum].lookahead_buffer = priv->lookaheadBuffer;
+	configs[fsNum].prog_buffer = priv->progBuffer;
+	configs[fsNum].read_buffer = priv->readBuffer;
 
 	return ATMO_FILESYSTEM_Status_Success;
 }
 
 ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_SetConfiguration( ATMO_DriverInstanceData_t *instance, const ATMO_FILESYSTEM_Config_t *config )
 {
+	uint32_t fsNum = *( ( uint32_t * )instance->argument );
+
+	if ( fsNum >= NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES )
+	{
+		return ATMO_FILESYSTEM_Status_Invalid;
+	}
+
+	ATMO_LFS_Priv_t *priv = &privData[fsNum];
+
+	// Checked against the block geometry, and init would overwrite it anyway
+	if ( !priv->initialized && ( config->cacheSize != 0 || config->lookahead != 0 ) )
+	{
+		return ATMO_FILESYSTEM_Status_Invalid;
+	}
+
+	// The geometry is fixed while mounted
+	if ( priv->mounted && ( config->cacheSize != 0 || config->lookahead != 0 ) )
+	{
+		return ATMO_FILESYSTEM_Status_Invalid;
+	}
+
+	if ( config->cacheSize != 0 )
+	{
+		if ( !_ATMO_LFS_CacheSizeValid( &priv->devInfo, config->cacheSize ) )
+		{
+			return ATMO_FILESYSTEM_Status_Invalid;
+		}
+
+		configs[fsNum].read_size = config->cacheSize;
+		configs[fsNum].prog_size = config->cacheSize;
+	}
+
+	if ( config->lookahead != 0 )
+	{
+		if ( config->lookahead > ATMO_LFS_MAX_LOOKAHEAD || ( config->lookahead % 32 ) != 0 )
+		{
+			return ATMO_FILESYSTEM_Status_Invalid;
+		}
+
+		configs[fsNum].lookahead = config->lookahead;
+	}
+
 	return ATMO_FILESYSTEM_Status_Success;
 }
 
@@ -143,10 +267,20 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_Wipe( ATMO_DriverInstanceData_t *in
 {
 	uint32_t fsNum = *( ( uint32_t * )instance->argument );
 
-	// Try to unmount
-	ATMO_LFS_FILESYSTEM_Unmount( instance );
+	if ( fsNum >= NUMBER_OF_LITTLEFS_FILESYSTEM_DRIVER_INSTANCES )
+	{
+		return ATMO_FILESYSTEM_Status_Invalid;
+	}
+
+	if ( privData[fsNum].mounted )
+	{
+		ATMO_LFS_FILESYSTEM_Unmount( instance );
+	}
 
-	lfs_format( &filesystems[fsNum], &configs[fsNum] );
+	if ( lfs_format( &filesystems[fsNum], &configs[fsNum] ) != 0 )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
 
 	return ATMO_LFS_FILESYSTEM_Mount( instance );
 }
@@ -160,6 +294,11 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_Mount( ATMO_DriverInstanceData_t *i
 		return ATMO_FILESYSTEM_Status_Invalid;
 	}
 
+	if ( privData[fsNum].mounted )
+	{
+		return ATMO_FILESYSTEM_Status_Success;
+	}
+
 	int err = lfs_mount( &filesystems[fsNum], &configs[fsNum] );
 
 	// This will happen the first time
@@ -173,6 +312,9 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_Mount( ATMO_DriverInstanceData_t *i
 		}
 	}
 
+	privData[fsNum].mounted = true;
+	privData[fsNum].fileOpen = false;
+
 	return ATMO_FILESYSTEM_Status_Success;
 }
 
@@ -185,6 +327,13 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_Unmount( ATMO_DriverInstanceData_t
 		return ATMO_FILESYSTEM_Status_Invalid;
 	}
 
+	if ( !privData[fsNum].mounted )
+	{
+		return ATMO_FILESYSTEM_Status_Success;
+	}
+
+	privData[fsNum].mounted = false;
+
 	if ( lfs_unmount( &filesystems[fsNum] ) != 0 )
 	{
 		return ATMO_FILESYSTEM_Status_Fail;
@@ -259,14 +408,21 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_FileOpen( ATMO_DriverInstanceData_t
 		return ATMO_FILESYSTEM_Status_Invalid;
 	}
 
-	file->data = ATMO_Malloc( sizeof( struct lfs_file ) );
+	ATMO_LFS_Priv_t *priv = &privData[fsNum];
+
+	if ( priv->fileOpen )
+	{
+		return ATMO_FILESYSTEM_Status_Fail;
+	}
 
-	if ( lfs_file_open( &filesystems[fsNum], ( lfs_file_t * )file->data, path, flags ) != 0 )
+	if ( lfs_file_open( &filesystems[fsNum], &priv->file, path, flags ) != 0 )
 	{
-		ATMO_Free( file->data );
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
 
+	priv->fileOpen = true;
+	file->data = &priv->file;
+
 	return ATMO_FILESYSTEM_Status_Success;
 }
 
@@ -279,14 +435,14 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_FileClose( ATMO_DriverInstanceData_
 		return ATMO_FILESYSTEM_Status_Invalid;
 	}
 
+	// The file is closed even if the final sync failed
+	privData[fsNum].fileOpen = false;
+
 	if ( lfs_file_close( &filesystems[fsNum], ( lfs_file_t * )file->data ) != 0 )
 	{
-		ATMO_Free( file->data );
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
 
-	ATMO_Free( file->data );
-
 	return ATMO_FILESYSTEM_Status_Success;
 }
 
@@ -350,7 +506,7 @@ ATMO_FILESYSTEM_Status_t ATMO_LFS_FILESYSTEM_FileSeek( ATMO_DriverInstanceData_t
 		return ATMO_FILESYSTEM_Status_Invalid;
 	}
 
-	if ( lfs_file_seek( &filesystems[fsNum], ( lfs_file_t * )file->data, offset, LFS_SEEK_SET ) != 0 )
+	if ( lfs_file_seek( &filesystems[fsNum], ( lfs_file_t * )file->data, offset, LFS_SEEK_SET ) < 0 )
 	{
 		return ATMO_FILESYSTEM_Status_Fail;
 	}
@@ -38,35 +38,216 @@
 #include "../tcpclient/tcpclient.h"
 
 #define ATMO_HTTP_NUM_INSTANCES (2)
+#define ATMO_HTTP_NUM_CONNECTIONS (2)
+#define ATMO_HTTP_MAX_RESP_HEADERS (16)
 
-static void _ATMO_HTTP_Tcp1RxCb( void *rawData );
-static void _ATMO_HTTP_Tcp2RxCb( void *rawData );
+#ifndef ATMO_HTTP_MAX_HOST_LEN
+#define ATMO_HTTP_MAX_HOST_LEN (64)
+#endif
+
+#ifndef ATMO_HTTP_KEEPALIVE_IDLE_MS
+#define ATMO_HTTP_KEEPALIVE_IDLE_MS (20000)
+#endif
+
+static void _ATMO_HTTP_Conn1RxCb( void *rawData );
+static void _ATMO_HTTP_Conn2RxCb( void *rawData );
 
 typedef struct
 {
-	ATMO_DriverInstanceHandle_t tcpClientInstance;
-	uint8_t *pktBuf;
-	uint32_t pktBufSize;
-	ATMO_BOOL_t rxDataAvailable;
 	uint8_t *lastRespData;
 	uint32_t lastRespDataLen;
 } ATMO_HTTP_PrivData_t;
 
-static ATMO_HTTP_PrivData_t _ATMO_HTTP_PrivData[2];
-static ATMO_Callback_t _ATMO_HTTP_TcpCallbacks[2] = {_ATMO_HTTP_Tcp1RxCb, _ATMO_HTTP_Tcp2RxCb};
+/**
+ * Framing state of a response being received into a connection buffer.
+ */
+typedef struct
+{
+	uint32_t rxLen; /**< Bytes in the buffer (body is already de-chunked) */
+	uint32_t headerLen; /**< 0 until the status line and headers are complete */
+	int32_t contentLength; /**< -1 if not given */
+	ATMO_BOOL_t chunked;
+	struct phr_chunked_decoder decoder;
+	ATMO_BOOL_t keepAlive;
+	unsigned int respCode;
+	uint32_t bodyLen; /**< Total body received so far */
+	uint32_t bodyStreamed; /**< Body handed to the body callback and dropped from the buffer */
+} ATMO_HTTP_Response_t;
+
+typedef enum
+{
+	ATMO_HTTP_Response_Incomplete,
+	ATMO_HTTP_Response_Complete,
+	ATMO_HTTP_Response_Error,
+	ATMO_HTTP_Response_Timeout,
+} ATMO_HTTP_ResponseState_t;
+
+/**
+ * Transaction state of a connection. Connect and send happen from the tick,
+ * the response is consumed from the TCP receive callback as it arrives.
+ */
+typedef enum
+{
+	ATMO_HTTP_ConnState_Idle,
+	ATMO_HTTP_ConnState_Sending, /**< Request is built, connect (if needed) and send */
+	ATMO_HTTP_ConnState_Receiving,
+	ATMO_HTTP_ConnState_Done, /**< Response finished or failed, callback not run yet */
+	ATMO_HTTP_ConnState_Completing, /**< Callback is running */
+} ATMO_HTTP_ConnState_t;
+
+/**
+ * A TCP client owned by an HTTP instance, along with the buffer its requests
+ * and responses are built and received in. The connection is left open after
+ * a transaction if the server allows it, so the next request to the same host
+ * can skip the TCP (and TLS) handshake.
+ */
+typedef struct
+{
+	ATMO_BOOL_t inUse;
+	ATMO_HTTP_ConnState_t state;
+	ATMO_BOOL_t connected;
+	ATMO_BOOL_t reused;
+	volatile ATMO_BOOL_t rxDataAvailable;
+	ATMO_DriverInstanceHandle_t httpInstance;
+	ATMO_DriverInstanceHandle_t tcpClientInstance;
+	uint8_t *buf;
+	uint32_t bufSize;
+	char host[ATMO_HTTP_MAX_HOST_LEN];
+	unsigned int port;
+	ATMO_BOOL_t isHttps;
+	uint64_t lastUsedMs;
+	uint32_t reqLen;
+	const uint8_t *body; /**< Sent after the request straight from the caller's buffer, NULL if there is none */
+	uint32_t bodyLen;
+	uint64_t startMs;
+	unsigned int timeoutMs;
+	ATMO_HTTP_Response_t resp;
+	ATMO_HTTP_ResponseState_t result;
+	ATMO_HTTP_ResponseCallback_t cb;
+	ATMO_HTTP_BodyCallback_t bodyCb; /**< NULL unless the body is streamed */
+	void *cbArg;
+} ATMO_HTTP_Connection_t;
+
+/**
+ * Result of a blocking ATMO_HTTP_Perform
+ */
+typedef struct
+{
+	volatile ATMO_BOOL_t done;
+	ATMO_HTTP_Status_t status;
+	unsigned int respCode;
+	const uint8_t *respData;
+	unsigned int respDataLen;
+} ATMO_HTTP_SyncResult_t;
+
+static ATMO_HTTP_PrivData_t _ATMO_HTTP_PrivData[ATMO_HTTP_NUM_INSTANCES];
+static ATMO_HTTP_Connection_t _ATMO_HTTP_Connections[ATMO_HTTP_NUM_CONNECTIONS];
+static ATMO_Callback_t _ATMO_HTTP_ConnCallbacks[ATMO_HTTP_NUM_CONNECTIONS] = {_ATMO_HTTP_Conn1RxCb, _ATMO_HTTP_Conn2RxCb};
 static uint8_t _ATMO_HTTP_NumInstances = 0;
+static ATMO_BOOL_t _ATMO_HTTP_TickRegistered = false;
 
-#define ATMO_HTTP_POST_TEMPLATE "POST %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\nContent-Type: %s\r\nContent-Length: %d\r\n"
-#define ATMO_HTTP_GET_TEMPLATE "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n"
+static void _ATMO_HTTP_Tick( void *data );
 
-static void _ATMO_HTTP_Tcp1RxCb( void *rawData )
+static void _ATMO_HTTP_CloseConnection( ATMO_HTTP_Connection_t *conn )
 {
-	_ATMO_HTTP_PrivData[0].rxDataAvailable = true;
+	if ( conn->connected )
+	{
+		ATMO_TCP_CLIENT_Disconnect( conn->tcpClientInstance );
+	}
+
+	conn->connected = false;
+	conn->rxDataAvailable = false;
 }
 
-static void _ATMO_HTTP_Tcp2RxCb( void *rawData )
+/**
+ * Pick an idle pooled connection of an HTTP instance for a host. An open
+ * connection to the same host is preferred, then an unused one, then the
+ * least recently used one, which is closed first.
+ *
+ * @return NULL if every connection of the instance is busy
+ */
+static ATMO_HTTP_Connection_t *_ATMO_HTTP_GetConnection( ATMO_DriverInstanceHandle_t instance, const char *host, unsigned int port, ATMO_BOOL_t isHttps )
 {
-	_ATMO_HTTP_PrivData[1].rxDataAvailable = true;
+	ATMO_HTTP_Connection_t *freeConn = NULL;
+	ATMO_HTTP_Connection_t *oldestConn = NULL;
+	unsigned int i;
+
+	for ( i = 0; i < ATMO_HTTP_NUM_CONNECTIONS; i++ )
+	{
+		ATMO_HTTP_Connection_t *conn = &_ATMO_HTTP_Connections[i];
+
+		if ( !conn->inUse || conn->state != ATMO_HTTP_ConnState_Idle || conn->httpInstance != instance )
+		{
+			continue;
+		}
+
+		if ( conn->connected && conn->port == port && conn->isHttps == isHttps && strcmp( conn->host, host ) == 0 )
+		{
+			ATMO_TCP_CLIENT_ConnectionStatus_t tcpStatus = ATMO_TCP_CLIENT_Disconnected;
+			ATMO_TCP_CLIENT_GetConnectionStatus( conn->tcpClientInstance, &tcpStatus );
+
+			if ( tcpStatus == ATMO_TCP_CLIENT_Connected )
+			{
+				return conn;
+			}
+
+			_ATMO_HTTP_CloseConnection( conn );
+		}
+
+		if ( !conn->connected )
+		{
+			if ( freeConn == NULL )
+			{
+				freeConn = conn;
+			}
+		}
+		else if ( oldestConn == NULL || conn->lastUsedMs < oldestConn->lastUsedMs )
+		{
+			oldestConn = conn;
+		}
+	}
+
+	if ( freeConn != NULL )
+	{
+		return freeConn;
+	}
+
+	if ( oldestConn != NULL )
+	{
+		_ATMO_HTTP_CloseConnection( oldestConn );
+	}
+
+	return oldestConn;
+}
+
+static ATMO_HTTP_Status_t _ATMO_HTTP_AddConnection( ATMO_DriverInstanceHandle_t instance, ATMO_DriverInstanceHandle_t tcpClientDriverInstance, uint8_t *packetBuf, uint32_t packetBufSize )
+{
+	unsigned int i;
+
+	if ( packetBuf == NULL || packetBufSize == 0 )
+	{
+		return ATMO_HTTP_Status_Invalid;
+	}
+
+	for ( i = 0; i < ATMO_HTTP_NUM_CONNECTIONS; i++ )
+	{
+		ATMO_HTTP_Connection_t *conn = &_ATMO_HTTP_Connections[i];
+
+		if ( !conn->inUse )
+		{
+			memset( conn, 0, sizeof( ATMO_HTTP_Connection_t ) );
+			conn->inUse = true;
+			conn->state = ATMO_HTTP_ConnState_Idle;
+			conn->httpInstance = instance;
+			conn->tcpClientInstance = tcpClientDriverInstance;
+			conn->buf = packetBuf;
+			conn->bufSize = packetBufSize;
+			ATMO_TCP_CLIENT_SetReceiveCallback( tcpClientDriverInstance, _ATMO_HTTP_ConnCallbacks[i] );
+			return ATMO_HTTP_Status_Success;
+		}
+	}
+
+	return ATMO_HTTP_Status_Fail;
 }
 
 ATMO_HTTP_Status_t ATMO_HTTP_Init( ATMO_DriverInstanceHandle_t tcpClientDriverInstance, uint8_t *packetBuf, uint32_t packetBufSize, ATMO_DriverInstanceHandle_t *httpInstance )
@@ -76,23 +257,80 @@ ATMO_HTTP_Status_t ATMO_HTTP_Init( ATMO_DriverInstanceHandle_t tcpClientDriverIn
 		return ATMO_HTTP_Status_Fail;
 	}
 
-	_ATMO_HTTP_PrivData[_ATMO_HTTP_NumInstances].tcpClientInstance = tcpClientDriverInstance;
-	_ATMO_HTTP_PrivData[_ATMO_HTTP_NumInstances].pktBuf = packetBuf;
-	_ATMO_HTTP_PrivData[_ATMO_HTTP_NumInstances].pktBufSize = packetBufSize;
-	_ATMO_HTTP_PrivData[_ATMO_HTTP_NumInstances].rxDataAvailable = false;
 	_ATMO_HTTP_PrivData[_ATMO_HTTP_NumInstances].lastRespData = NULL;
 	_ATMO_HTTP_PrivData[_ATMO_HTTP_NumInstances].lastRespDataLen = 0;
-	ATMO_TCP_CLIENT_SetReceiveCallback( tcpClientDriverInstance, _ATMO_HTTP_TcpCallbacks[_ATMO_HTTP_NumInstances] );
+
+	if ( _ATMO_HTTP_AddConnection( _ATMO_HTTP_NumInstances, tcpClientDriverInstance, packetBuf, packetBufSize ) != ATMO_HTTP_Status_Success )
+	{
+		return ATMO_HTTP_Status_Fail;
+	}
+
+	if ( !_ATMO_HTTP_TickRegistered )
+	{
+		ATMO_AddTickCallback( _ATMO_HTTP_Tick );
+		_ATMO_HTTP_TickRegistered = true;
+	}
+
 	*httpInstance = _ATMO_HTTP_NumInstances++;
 
 	return ATMO_HTTP_Status_Success;
 }
 
-ATMO_HTTP_Status_t ATMO_HTTP_DeInit( ATMO_DriverInstanceHandle_t instance )
+ATMO_HTTP_Status_t ATMO_HTTP_AddConnection( ATMO_DriverInstanceHandle_t instance, ATMO_DriverInstanceHandle_t tcpClientDriverInstance, uint8_t *packetBuf, uint32_t packetBufSize )
+{
+	if ( instance >= _ATMO_HTTP_NumInstances )
+	{
+		return ATMO_HTTP_Status_Invalid;
+	}
+
+	return _ATMO_HTTP_AddConnection( instance, tcpClientDriverInstance, packetBuf, packetBufSize );
+}
+
+ATMO_HTTP_Status_t ATMO_HTTP_CloseConnections( ATMO_DriverInstanceHandle_t instance )
 {
+	unsigned int i;
+
+	for ( i = 0; i < ATMO_HTTP_NUM_CONNECTIONS; i++ )
+	{
+		ATMO_HTTP_Connection_t *conn = &_ATMO_HTTP_Connections[i];
+
+		if ( conn->inUse && conn->state == ATMO_HTTP_ConnState_Idle && conn->httpInstance == instance )
+		{
+			_ATMO_HTTP_CloseConnection( conn );
+		}
+	}
+
 	return ATMO_HTTP_Status_Success;
 }
 
+ATMO_HTTP_Status_t ATMO_HTTP_GetAvailableConnections( ATMO_DriverInstanceHandle_t instance, unsigned int *numAvailable )
+{
+	if ( numAvailable == NULL )
+	{
+		return ATMO_HTTP_Status_Invalid;
+	}
+
+	unsigned int i;
+	*numAvailable = 0;
+
+	for ( i = 0; i < ATMO_HTTP_NUM_CONNECTIONS; i++ )
+	{
+		ATMO_HTTP_Connection_t *conn = &_ATMO_HTTP_Connections[i];
+
+		if ( conn->inUse && conn->state == ATMO_HTTP_ConnState_Idle && conn->httpInstance == instance )
+		{
+			( *numAvailable )++;
+		}
+	}
+
+	return ATMO_HTTP_Status_Success;
+}
+
+ATMO_HTTP_Status_t ATMO_HTTP_DeInit( ATMO_DriverInstanceHandle_t instance )
+{
+	return ATMO_HTTP_CloseConnections( instance );
+}
+
 
 ATMO_HTTP_Status_t ATMO_HTTP_SetConfiguration( ATMO_DriverInstanceHandle_t instance, const ATMO_HTTP_Config_t *config )
 {
@@ -135,6 +373,7 @@ static void _ATMO_HTTP_ParseUrl( const char *url, ATMO_BOOL_t *isHttps, unsigned
 	// No path
 	if ( pathStart == NULL )
 	{
+		*hostLen = strlen( *host );
 		*path = NULL;
 		*pathLen = 0;
 	}
@@ -149,145 +388,587 @@ static void _ATMO_HTTP_ParseUrl( const char *url, ATMO_BOOL_t *isHttps, unsigned
 }
 
 /**
- * @brief Build an HTTP request string
- *
- * @param transaction
- * @param isHttps
- * @param port
- * @param host - The host string, NULL terminated. This MUST BE FREED by the caller.
- * @return char* - The entire request string. NULL terminated. This MUST BE FREED by the caller.
+ * Request writer. Pieces are gathered straight into the connection buffer,
+ * once something doesn't fit the writer stops and the request is dropped.
  */
-static char *_ATMO_HTTP_BuildRequest( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, ATMO_BOOL_t *isHttps, unsigned int *port, const char **host, unsigned int *hostLen )
+typedef struct
 {
-	char *path = NULL;
-	unsigned int pathLen = 0;
+	uint8_t *buf;
+	uint32_t bufSize;
+	uint32_t len;
+	ATMO_BOOL_t overflow;
+} ATMO_HTTP_Writer_t;
+
+static void _ATMO_HTTP_WriterPut( ATMO_HTTP_Writer_t *writer, const void *data, uint32_t dataLen )
+{
+	if ( writer->overflow || dataLen >= writer->bufSize - writer->len )
+	{
+		writer->overflow = true;
+		return;
+	}
+
+	memcpy( &writer->buf[writer->len], data, dataLen );
+	writer->len += dataLen;
+}
+
+#define _ATMO_HTTP_WriterPutConst(writer, str) _ATMO_HTTP_WriterPut( writer, str, sizeof( str ) - 1 )
 
-	_ATMO_HTTP_ParseUrl( transaction->url, isHttps, port, host, hostLen, &path, &pathLen );
+static void _ATMO_HTTP_WriterPutStr( ATMO_HTTP_Writer_t *writer, const char *str )
+{
+	_ATMO_HTTP_WriterPut( writer, str, strlen( str ) );
+}
+
+static void _ATMO_HTTP_WriterPutUInt( ATMO_HTTP_Writer_t *writer, uint32_t value )
+{
+	char digits[10];
+	unsigned int pos = sizeof( digits );
 
-	// Save the host in its own string
-	char hostStr[*hostLen + 1];
-	memset( hostStr, 0, ( *hostLen ) + 1 );
-	strncpy( hostStr, *host, *hostLen );
+	do
+	{
+		digits[--pos] = '0' + ( value % 10 );
+		value /= 10;
+	}
+	while ( value > 0 );
 
-	char pathStr[pathLen + 1];
-	memset( pathStr, 0, pathLen + 1 );
-	strncpy( pathStr, path, pathLen );
+	_ATMO_HTTP_WriterPut( writer, &digits[pos], sizeof( digits ) - pos );
+}
 
-	// Could do this one of two ways:
-	// Allocate a bigger buffer than we'll ever need OR
-	// Precalculate the size beforehand and allocate a buffer of the perfect size
-	// Allocating a nice big buffer is faster and simpler
-	// Still need to make sure that the buffer doesn't get overrun
-	unsigned int currentSize = 0;
+/**
+ * @brief Build the request line and headers. A POST body is not copied, it is
+ * sent after them from the caller's buffer.
+ *
+ * @param buf - Buffer to build the request in
+ * @param bufSize
+ * @param transaction
+ * @param host - Host as given in the URL, including the port if there was one
+ * @param hostLen
+ * @param path
+ * @param pathLen
+ * @return Length of the request, 0 if it doesn't fit in the buffer
+ */
+static uint32_t _ATMO_HTTP_BuildRequest( uint8_t *buf, uint32_t bufSize, ATMO_HTTP_Transaction_t *transaction, const char *host, unsigned int hostLen, const char *path, unsigned int pathLen )
+{
+	// Single pass, no formatting. The last byte of the buffer stays unused like it always has.
+	ATMO_HTTP_Writer_t writer = { buf, bufSize, 0, false };
+	unsigned int i;
 
 	if ( transaction->method == ATMO_HTTP_POST )
 	{
-		currentSize += sprintf( ( char * )_ATMO_HTTP_PrivData[instance].pktBuf, ATMO_HTTP_POST_TEMPLATE, pathStr, hostStr, transaction->contentType == NULL ? "application/json" : transaction->contentType,
-		                        transaction->dataLen );
+		_ATMO_HTTP_WriterPutConst( &writer, "POST " );
 	}
 	else
 	{
-		currentSize += sprintf( ( char * )_ATMO_HTTP_PrivData[instance].pktBuf, ATMO_HTTP_GET_TEMPLATE, pathStr, hostStr );
+		_ATMO_HTTP_WriterPutConst( &writer, "GET " );
 	}
 
-	// Add additional headers
-	unsigned int i;
+	if ( pathLen > 0 )
+	{
+		_ATMO_HTTP_WriterPut( &writer, path, pathLen );
+	}
+	else
+	{
+		_ATMO_HTTP_WriterPutConst( &writer, "/" );
+	}
+
+	_ATMO_HTTP_WriterPutConst( &writer, " HTTP/1.1\r\nHost: " );
+	_ATMO_HTTP_WriterPut( &writer, host, hostLen );
+	_ATMO_HTTP_WriterPutConst( &writer, "\r\nConnection: keep-alive\r\n" );
+
+	if ( transaction->method == ATMO_HTTP_POST )
+	{
+		_ATMO_HTTP_WriterPutConst( &writer, "Content-Type: " );
+		_ATMO_HTTP_WriterPutStr( &writer, transaction->contentType == NULL ? "application/json" : transaction->contentType );
+		_ATMO_HTTP_WriterPutConst( &writer, "\r\nContent-Length: " );
+		_ATMO_HTTP_WriterPutUInt( &writer, transaction->dataLen );
+		_ATMO_HTTP_WriterPutConst( &writer, "\r\n" );
+	}
 
+	// Add additional headers
 	for ( i = 0; i < transaction->headerOverlayLen; i++ )
 	{
-		int headerSize = snprintf( NULL, 0, "%s: %s\r\n", transaction->headerOverlay[i].headerKey, transaction->headerOverlay[i].headerValue );
+		_ATMO_HTTP_WriterPutStr( &writer, transaction->headerOverlay[i].headerKey );
+		_ATMO_HTTP_WriterPutConst( &writer, ": " );
+		_ATMO_HTTP_WriterPutStr( &writer, transaction->headerOverlay[i].headerValue );
+		_ATMO_HTTP_WriterPutConst( &writer, "\r\n" );
+	}
+
+	// Add additonal \r\n before data (or end)
+	_ATMO_HTTP_WriterPutConst( &writer, "\r\n" );
+
+	return writer.overflow ? 0 : writer.len;
+}
+
+static ATMO_BOOL_t _ATMO_HTTP_HeaderIs( const char *str, size_t strLen, const char *expected )
+{
+	size_t i;
+
+	if ( strLen != strlen( expected ) )
+	{
+		return false;
+	}
+
+	for ( i = 0; i < strLen; i++ )
+	{
+		char c = str[i];
 
-		if ( currentSize + headerSize >= _ATMO_HTTP_PrivData[instance].pktBufSize )
+		if ( c >= 'A' && c <= 'Z' )
 		{
-			return NULL;
+			c += 'a' - 'A';
 		}
 
-		currentSize += sprintf( ( char * )&_ATMO_HTTP_PrivData[instance].pktBuf[currentSize], "%s: %s\r\n", transaction->headerOverlay[i].headerKey, transaction->headerOverlay[i].headerValue );
+		if ( c != expected[i] )
+		{
+			return false;
+		}
 	}
 
-	// Add additonal \r\n before data (or end)
-	if ( currentSize + 2 >= _ATMO_HTTP_PrivData[instance].pktBufSize )
+	return true;
+}
+
+static ATMO_BOOL_t _ATMO_HTTP_HeaderContains( const char *str, size_t strLen, const char *expected )
+{
+	size_t expectedLen = strlen( expected );
+	size_t i;
+
+	for ( i = 0; i + expectedLen <= strLen; i++ )
+	{
+		if ( _ATMO_HTTP_HeaderIs( &str[i], expectedLen, expected ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Parse the status line and headers once they are complete and work out how
+ * the body is framed and whether the connection can be reused.
+ */
+static ATMO_HTTP_ResponseState_t _ATMO_HTTP_ParseHeaders( uint8_t *buf, ATMO_HTTP_Response_t *resp, uint32_t lastLen )
+{
+	struct phr_header headers[ATMO_HTTP_MAX_RESP_HEADERS];
+	size_t numHeaders = ATMO_HTTP_MAX_RESP_HEADERS;
+	int minorVersion = 0;
+	int status = 0;
+	const char *msg = NULL;
+	size_t msgLen = 0;
+
+	int ret = phr_parse_response( ( const char * )buf, resp->rxLen, &minorVersion, &status, &msg, &msgLen, headers, &numHeaders, lastLen );
+
+	if ( ret == -2 )
+	{
+		return ATMO_HTTP_Response_Incomplete;
+	}
+
+	if ( ret < 0 )
 	{
-		return NULL;
+		return ATMO_HTTP_Response_Error;
 	}
 
-	currentSize += sprintf( ( char * )&_ATMO_HTTP_PrivData[instance].pktBuf[currentSize], "\r\n" );
+	resp->headerLen = ret;
+	resp->respCode = status;
+	resp->keepAlive = ( minorVersion >= 1 );
 
-	if ( transaction->method == ATMO_HTTP_POST )
+	size_t i;
+
+	for ( i = 0; i < numHeaders; i++ )
+	{
+		if ( headers[i].name == NULL )
+		{
+			continue;
+		}
+
+		if ( _ATMO_HTTP_HeaderIs( headers[i].name, headers[i].name_len, "content-length" ) )
+		{
+			resp->contentLength = ( int32_t )strtoul( headers[i].value, NULL, 10 );
+		}
+		else if ( _ATMO_HTTP_HeaderIs( headers[i].name, headers[i].name_len, "transfer-encoding" ) )
+		{
+			resp->chunked = _ATMO_HTTP_HeaderContains( headers[i].value, headers[i].value_len, "chunked" );
+		}
+		else if ( _ATMO_HTTP_HeaderIs( headers[i].name, headers[i].name_len, "connection" ) )
+		{
+			if ( _ATMO_HTTP_HeaderContains( headers[i].value, headers[i].value_len, "close" ) )
+			{
+				resp->keepAlive = false;
+			}
+			else if ( _ATMO_HTTP_HeaderContains( headers[i].value, headers[i].value_len, "keep-alive" ) )
+			{
+				resp->keepAlive = true;
+			}
+		}
+	}
+
+	// These never have a body
+	if ( ( status >= 100 && status < 200 ) || status == 204 || status == 304 )
 	{
-		int size = transaction->dataLen + 4; // Data length and \r\n\r\n
+		resp->chunked = false;
+		resp->contentLength = 0;
+	}
 
-		if ( currentSize + size >= _ATMO_HTTP_PrivData[instance].pktBufSize )
+	// Without framing the body ends when the server closes the connection
+	if ( !resp->chunked && resp->contentLength < 0 )
+	{
+		resp->keepAlive = false;
+	}
+
+	return ATMO_HTTP_Response_Incomplete;
+}
+
+/**
+ * Account for newly received bytes at the end of the buffer. Body bytes
+ * that were streamed out are no longer in the buffer, whatever is left
+ * of the body always starts right after the headers.
+ */
+static ATMO_HTTP_ResponseState_t _ATMO_HTTP_ParseResponse( uint8_t *buf, ATMO_HTTP_Response_t *resp, uint32_t newBytes )
+{
+	uint32_t lastLen = resp->rxLen;
+	resp->rxLen += newBytes;
+
+	if ( resp->headerLen == 0 )
+	{
+		ATMO_HTTP_ResponseState_t state = _ATMO_HTTP_ParseHeaders( buf, resp, lastLen );
+
+		if ( resp->headerLen == 0 || state == ATMO_HTTP_Response_Error )
 		{
-			return NULL;
+			return state;
 		}
 
-		sprintf( ( char * )&_ATMO_HTTP_PrivData[instance].pktBuf[currentSize], "%s\r\n\r\n", transaction->data );
+		// Everything after the headers still has to be decoded
+		lastLen = resp->headerLen;
 	}
 
-	return ( char * )_ATMO_HTTP_PrivData[instance].pktBuf;
+	if ( resp->chunked )
+	{
+		// De-chunk in place, the decoded body always stays contiguous after the headers
+		size_t size = resp->rxLen - lastLen;
+		ssize_t ret = phr_decode_chunked( &resp->decoder, ( char * )&buf[lastLen], &size );
+
+		if ( ret == -1 )
+		{
+			return ATMO_HTTP_Response_Error;
+		}
+
+		resp->rxLen = lastLen + size;
+		resp->bodyLen = resp->bodyStreamed + resp->rxLen - resp->headerLen;
+
+		if ( ret == -2 )
+		{
+			return ATMO_HTTP_Response_Incomplete;
+		}
+
+		// Anything past the trailer is unexpected, don't reuse the connection
+		if ( ret > 0 )
+		{
+			resp->keepAlive = false;
+		}
+
+		return ATMO_HTTP_Response_Complete;
+	}
+
+	resp->bodyLen = resp->bodyStreamed + resp->rxLen - resp->headerLen;
+
+	if ( resp->contentLength >= 0 && resp->bodyLen >= ( uint32_t )resp->contentLength )
+	{
+		// Anything past the body is unexpected, don't reuse the connection
+		if ( resp->bodyLen > ( uint32_t )resp->contentLength )
+		{
+			resp->keepAlive = false;
+		}
+
+		resp->bodyLen = resp->contentLength;
+		return ATMO_HTTP_Response_Complete;
+	}
+
+	return ATMO_HTTP_Response_Incomplete;
 }
 
-static ATMO_BOOL_t _ATMO_HTTP_ParseResponse( ATMO_DriverInstanceHandle_t instance, uint8_t *dataPtr, unsigned int *respCode, unsigned int *respDataLen )
+static void _ATMO_HTTP_Finish( ATMO_HTTP_Connection_t *conn, ATMO_HTTP_ResponseState_t result )
 {
-	_ATMO_HTTP_PrivData[instance].lastRespDataLen = 0;
-	*respDataLen = 0;
+	conn->result = result;
+	conn->state = ATMO_HTTP_ConnState_Done;
+}
+
+/**
+ * Consume whatever the TCP client has received for a connection.
+ */
+static void _ATMO_HTTP_Receive( ATMO_HTTP_Connection_t *conn )
+{
+	conn->rxDataAvailable = false;
+
+	uint32_t numBytes = 0;
+	uint8_t *dataPtr = NULL;
+	ATMO_TCP_CLIENT_GetNumAvailableBytes( conn->tcpClientInstance, &numBytes, &dataPtr );
 
-	// Find HTTP version
-	if ( strstr( ( char * )dataPtr, "HTTP/" ) != ( char * )dataPtr )
+	if ( numBytes == 0 || dataPtr == NULL )
 	{
+		return;
+	}
 
-		return false;
+	// Keep room for a NULL terminator after the body
+	if ( conn->resp.rxLen + numBytes >= conn->bufSize )
+	{
+		_ATMO_HTTP_Finish( conn, ATMO_HTTP_Response_Error );
+		return;
 	}
 
-	// Find the first space
-	char *token = strchr( ( char * )dataPtr, ' ' );
+	memcpy( &conn->buf[conn->resp.rxLen], dataPtr, numBytes );
+
+	ATMO_HTTP_ResponseState_t state = _ATMO_HTTP_ParseResponse( conn->buf, &conn->resp, numBytes );
 
-	if ( token == NULL )
+	if ( state != ATMO_HTTP_Response_Error && conn->bodyCb != NULL && conn->resp.headerLen != 0 )
 	{
-		return false;
+		uint32_t streamLen = conn->resp.bodyLen - conn->resp.bodyStreamed;
+
+		if ( streamLen > 0 )
+		{
+			conn->bodyCb( conn->httpInstance, conn->resp.respCode, &conn->buf[conn->resp.headerLen], streamLen, conn->cbArg );
+			conn->resp.bodyStreamed += streamLen;
+		}
+
+		// Only the headers are kept, the next packet lands right after them
+		conn->resp.rxLen = conn->resp.headerLen;
+	}
+
+	if ( state != ATMO_HTTP_Response_Incomplete )
+	{
+		_ATMO_HTTP_Finish( conn, state );
+	}
+}
+
+static void _ATMO_HTTP_ConnectionRx( ATMO_HTTP_Connection_t *conn )
+{
+	if ( conn->state == ATMO_HTTP_ConnState_Receiving )
+	{
+		// Consume right away, the TCP client may reuse its buffer for the next packet
+		_ATMO_HTTP_Receive( conn );
+	}
+	else
+	{
+		conn->rxDataAvailable = true;
 	}
+}
+
+static void _ATMO_HTTP_Conn1RxCb( void *rawData )
+{
+	_ATMO_HTTP_ConnectionRx( &_ATMO_HTTP_Connections[0] );
+}
 
-	token++;
+static void _ATMO_HTTP_Conn2RxCb( void *rawData )
+{
+	_ATMO_HTTP_ConnectionRx( &_ATMO_HTTP_Connections[1] );
+}
 
-	*respCode = strtoul( token, NULL, 10 );
+static void _ATMO_HTTP_Send( ATMO_HTTP_Connection_t *conn )
+{
+	conn->reused = conn->connected;
 
-	if ( *respCode != 200 )
+	if ( !conn->connected )
 	{
-		// It's OK, but there's no meaningful data to return
-		return true;
+		if ( ATMO_TCP_CLIENT_Connect( conn->tcpClientInstance, conn->host, conn->port, conn->isHttps ) != ATMO_TCP_CLIENT_Status_Success )
+		{
+			_ATMO_HTTP_Finish( conn, ATMO_HTTP_Response_Error );
+			return;
+		}
+
+		conn->connected = true;
 	}
 
-	char *dataStart = strstr( ( char * )dataPtr, "\r\n\r\n" );
+	memset( &conn->resp, 0, sizeof( conn->resp ) );
+	conn->resp.contentLength = -1;
+
+	// The response is only complete after the trailer, or its leftovers would start the next response
+	conn->resp.decoder.consume_trailer = 1;
+	conn->rxDataAvailable = false;
+
+	// The response may arrive before the write returns
+	conn->state = ATMO_HTTP_ConnState_Receiving;
+
+	// Nothing may follow the body on a kept-alive connection, it would be read as the next request
+	ATMO_TCP_CLIENT_Segment_t segments[2] =
+	{
+		{ conn->buf, conn->reqLen },
+		{ conn->body, conn->bodyLen }
+	};
 
-	if ( dataStart == NULL )
+	if ( ATMO_TCP_CLIENT_WriteV( conn->tcpClientInstance, segments, ( conn->body != NULL ) ? 2 : 1 ) != ATMO_TCP_CLIENT_Status_Success )
 	{
-		return true;
+		ATMO_BOOL_t reused = conn->reused;
+		_ATMO_HTTP_CloseConnection( conn );
+
+		// A reused connection may have been closed by the server in the meantime, retry once on a fresh one
+		if ( reused )
+		{
+			conn->state = ATMO_HTTP_ConnState_Sending;
+		}
+		else
+		{
+			_ATMO_HTTP_Finish( conn, ATMO_HTTP_Response_Error );
+		}
 	}
+}
 
-	dataStart += 4;
-	*respDataLen = strlen( dataStart ) + 1;
+static void _ATMO_HTTP_CheckReceiving( ATMO_HTTP_Connection_t *conn, uint64_t now )
+{
+	if ( conn->rxDataAvailable )
+	{
+		_ATMO_HTTP_Receive( conn );
+		return;
+	}
 
-	_ATMO_HTTP_PrivData[instance].lastRespData = ( uint8_t * )dataStart;
-	_ATMO_HTTP_PrivData[instance].lastRespDataLen = *respDataLen;
+	ATMO_TCP_CLIENT_ConnectionStatus_t tcpStatus = ATMO_TCP_CLIENT_Connected;
+	ATMO_TCP_CLIENT_GetConnectionStatus( conn->tcpClientInstance, &tcpStatus );
 
+	if ( tcpStatus != ATMO_TCP_CLIENT_Connected )
+	{
+		conn->connected = false;
 
-	return true;
+		// The request is still in the buffer as long as nothing was received
+		if ( conn->resp.rxLen == 0 && conn->reused )
+		{
+			conn->state = ATMO_HTTP_ConnState_Sending;
+		}
+		// Close delimits an unframed body
+		else if ( conn->resp.headerLen != 0 && !conn->resp.chunked && conn->resp.contentLength < 0 )
+		{
+			_ATMO_HTTP_Finish( conn, ATMO_HTTP_Response_Complete );
+		}
+		else
+		{
+			_ATMO_HTTP_Finish( conn, ATMO_HTTP_Response_Error );
+		}
+
+		return;
+	}
+
+	if ( ( now - conn->startMs ) >= conn->timeoutMs )
+	{
+		ATMO_PLATFORM_DebugPrint( "HTTP timeout %d\r\n", conn->timeoutMs );
+		_ATMO_HTTP_Finish( conn, ATMO_HTTP_Response_Timeout );
+	}
 }
 
-ATMO_HTTP_Status_t ATMO_HTTP_Perform( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int *respCode, unsigned int *respDataLen, unsigned int timeoutMs )
+static void _ATMO_HTTP_Complete( ATMO_HTTP_Connection_t *conn )
+{
+	conn->lastUsedMs = ATMO_PLATFORM_UptimeMs();
+
+	// Only keep connections that are in a known state
+	if ( conn->result != ATMO_HTTP_Response_Complete || !conn->resp.keepAlive )
+	{
+		_ATMO_HTTP_CloseConnection( conn );
+	}
+
+	ATMO_HTTP_Status_t status = ( conn->result == ATMO_HTTP_Response_Timeout ) ? ATMO_HTTP_Status_Timeout : ATMO_HTTP_Status_Fail;
+	uint8_t *body = NULL;
+	uint32_t bodyLen = 0;
+
+	if ( conn->result == ATMO_HTTP_Response_Complete )
+	{
+		status = ATMO_HTTP_Status_Success;
+		bodyLen = conn->resp.bodyLen;
+
+		if ( conn->bodyCb == NULL )
+		{
+			body = &conn->buf[conn->resp.headerLen];
+			body[bodyLen] = 0;
+		}
+	}
+
+	// Keep the buffer from being reused until the callback is done with the body
+	conn->state = ATMO_HTTP_ConnState_Completing;
+
+	if ( conn->cb != NULL )
+	{
+		conn->cb( conn->httpInstance, status, conn->resp.respCode, body, bodyLen, conn->cbArg );
+	}
+
+	conn->state = ATMO_HTTP_ConnState_Idle;
+}
+
+/**
+ * Advance every transaction in flight, run completion callbacks and close
+ * pooled connections that have been idle for too long. Servers drop idle
+ * connections on their own, closing first avoids writing into a dead socket.
+ */
+static void _ATMO_HTTP_Tick( void *data )
+{
+	unsigned int i;
+
+	for ( i = 0; i < ATMO_HTTP_NUM_CONNECTIONS; i++ )
+	{
+		ATMO_HTTP_Connection_t *conn = &_ATMO_HTTP_Connections[i];
+		uint64_t now = ATMO_PLATFORM_UptimeMs();
+
+		if ( !conn->inUse )
+		{
+			continue;
+		}
+
+		switch ( conn->state )
+		{
+			case ATMO_HTTP_ConnState_Sending:
+			{
+				_ATMO_HTTP_Send( conn );
+				break;
+			}
+
+			case ATMO_HTTP_ConnState_Receiving:
+			{
+				_ATMO_HTTP_CheckReceiving( conn, now );
+				break;
+			}
+
+			case ATMO_HTTP_ConnState_Done:
+			{
+				_ATMO_HTTP_Complete( conn );
+				break;
+			}
+
+			case ATMO_HTTP_ConnState_Idle:
+			{
+				// Nothing is expected between transactions, the stream can't be trusted anymore
+				if ( conn->connected && ( conn->rxDataAvailable || ( now - conn->lastUsedMs ) >= ATMO_HTTP_KEEPALIVE_IDLE_MS ) )
+				{
+					_ATMO_HTTP_CloseConnection( conn );
+				}
+
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Set up a transaction on a free connection, it is sent from the tick.
+ */
+static ATMO_HTTP_Status_t _ATMO_HTTP_Start( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int timeoutMs, ATMO_HTTP_BodyCallback_t bodyCb, ATMO_HTTP_ResponseCallback_t cb, void *arg )
 {
 	unsigned int port = 80;
 	ATMO_BOOL_t isHttps = false;
 	const char *host = NULL;
 	unsigned int hostLen = 0;
-	_ATMO_HTTP_PrivData[instance].lastRespDataLen = 0;
+	char *path = NULL;
+	unsigned int pathLen = 0;
+
+	if ( instance >= _ATMO_HTTP_NumInstances || transaction == NULL || transaction->url == NULL )
+	{
+		return ATMO_HTTP_Status_Invalid;
+	}
 
-	// Build request string
-	char *reqString = _ATMO_HTTP_BuildRequest( instance, transaction, &isHttps, &port, &host, &hostLen );
+	_ATMO_HTTP_ParseUrl( transaction->url, &isHttps, &port, &host, &hostLen, &path, &pathLen );
 
-	char hostStr[hostLen + 1];
-	memset( hostStr, 0, hostLen + 1 );
+	if ( hostLen >= ATMO_HTTP_MAX_HOST_LEN )
+	{
+		return ATMO_HTTP_Status_Invalid;
+	}
+
+	char hostStr[ATMO_HTTP_MAX_HOST_LEN] = {0};
 	memcpy( hostStr, host, hostLen );
 
 	// If the host string has a port in it
@@ -298,64 +979,127 @@ ATMO_HTTP_Status_t ATMO_HTTP_Perform( ATMO_DriverInstanceHandle_t instance, ATMO
 		*portStart = 0;
 	}
 
-	// ATMO_PLATFORM_DebugPrint("HTTP Req Str: %s\r\n", reqString);
+	ATMO_HTTP_Connection_t *conn = _ATMO_HTTP_GetConnection( instance, hostStr, port, isHttps );
+
+	if ( conn == NULL )
+	{
+		return ATMO_HTTP_Status_Busy;
+	}
 
-	ATMO_TCP_CLIENT_Status_t tcpStatus = ATMO_TCP_CLIENT_Connect( _ATMO_HTTP_PrivData[instance].tcpClientInstance, hostStr, port, isHttps );
+	conn->reqLen = _ATMO_HTTP_BuildRequest( conn->buf, conn->bufSize, transaction, host, hostLen, path, pathLen );
 
-	if ( tcpStatus != ATMO_TCP_CLIENT_Status_Success )
+	if ( conn->reqLen == 0 )
 	{
 		return ATMO_HTTP_Status_Fail;
 	}
 
-	// Send data
-	// Wait for response
-	_ATMO_HTTP_PrivData[instance].rxDataAvailable = false;
-	tcpStatus = ATMO_TCP_CLIENT_WriteBytes( _ATMO_HTTP_PrivData[instance].tcpClientInstance, ( uint8_t * )reqString, strlen( reqString ) );
+	// ATMO_PLATFORM_DebugPrint("HTTP Req Str: %.*s\r\n", conn->reqLen, conn->buf);
 
-	if ( tcpStatus != ATMO_TCP_CLIENT_Status_Success )
+	conn->body = NULL;
+	conn->bodyLen = 0;
+
+	if ( transaction->method == ATMO_HTTP_POST && transaction->dataLen > 0 )
 	{
-		ATMO_TCP_CLIENT_Disconnect( _ATMO_HTTP_PrivData[instance].tcpClientInstance );
-		return ATMO_HTTP_Status_Fail;
+		conn->body = ( const uint8_t * )transaction->data;
+		conn->bodyLen = transaction->dataLen;
+	}
+
+	if ( !conn->connected )
+	{
+		strcpy( conn->host, hostStr );
+		conn->port = port;
+		conn->isHttps = isHttps;
 	}
 
-	uint64_t startTime = ATMO_PLATFORM_UptimeMs();
-	ATMO_BOOL_t isTimeout = false;
+	conn->startMs = ATMO_PLATFORM_UptimeMs();
+	conn->timeoutMs = timeoutMs;
+	conn->cb = cb;
+	conn->bodyCb = bodyCb;
+	conn->cbArg = arg;
+	conn->state = ATMO_HTTP_ConnState_Sending;
+
+	return ATMO_HTTP_Status_Success;
+}
+
+ATMO_HTTP_Status_t ATMO_HTTP_PerformAsync( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int timeoutMs, ATMO_HTTP_ResponseCallback_t cb, void *arg )
+{
+	return _ATMO_HTTP_Start( instance, transaction, timeoutMs, NULL, cb, arg );
+}
 
-	while ( ( ATMO_PLATFORM_UptimeMs() - startTime ) < timeoutMs )
+ATMO_HTTP_Status_t ATMO_HTTP_PerformStream( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int timeoutMs, ATMO_HTTP_BodyCallback_t bodyCb, ATMO_HTTP_ResponseCallback_t cb, void *arg )
+{
+	if ( bodyCb == NULL )
 	{
-		if ( _ATMO_HTTP_PrivData[instance].rxDataAvailable )
-		{
-			uint32_t numBytes = 0;
-			uint8_t *dataPtr = NULL;
-			ATMO_TCP_CLIENT_GetNumAvailableBytes( _ATMO_HTTP_PrivData[instance].tcpClientInstance, &numBytes, &dataPtr );
-			dataPtr[numBytes] = 0;
-			_ATMO_HTTP_ParseResponse( instance, dataPtr, respCode, respDataLen );
-			break;
-		}
+		return ATMO_HTTP_Status_Invalid;
+	}
+
+	return _ATMO_HTTP_Start( instance, transaction, timeoutMs, bodyCb, cb, arg );
+}
+
+static void _ATMO_HTTP_SyncCb( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respData, unsigned int respDataLen, void *arg )
+{
+	ATMO_HTTP_SyncResult_t *result = ( ATMO_HTTP_SyncResult_t * )arg;
+	result->status = status;
+	result->respCode = respCode;
+	result->respData = respData;
+	result->respDataLen = respDataLen;
+	result->done = true;
+}
+
+ATMO_HTTP_Status_t ATMO_HTTP_Perform( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int *respCode, unsigned int *respDataLen, unsigned int timeoutMs )
+{
+	ATMO_HTTP_SyncResult_t result;
+	memset( &result, 0, sizeof( result ) );
+
+	*respDataLen = 0;
+
+	if ( instance < _ATMO_HTTP_NumInstances )
+	{
+		_ATMO_HTTP_PrivData[instance].lastRespDataLen = 0;
+	}
+
+	ATMO_HTTP_Status_t status = _ATMO_HTTP_Start( instance, transaction, timeoutMs, NULL, _ATMO_HTTP_SyncCb, &result );
+
+	if ( status != ATMO_HTTP_Status_Success )
+	{
+		return ( status == ATMO_HTTP_Status_Busy ) ? ATMO_HTTP_Status_Fail : status;
+	}
 
+	// The transaction is driven by the HTTP tick
+	while ( !result.done )
+	{
 		ATMO_PLATFORM_DelayMilliseconds( 1 );
 		ATMO_Tick();
 	}
 
-	if ( ( ATMO_PLATFORM_UptimeMs() - startTime ) > timeoutMs )
+	if ( result.status != ATMO_HTTP_Status_Success )
 	{
-		isTimeout = true;
+		return result.status;
 	}
 
-	// No matter what, disconnect here
-	ATMO_TCP_CLIENT_Disconnect( _ATMO_HTTP_PrivData[instance].tcpClientInstance );
+	*respCode = result.respCode;
 
-	if ( isTimeout )
+	if ( result.respCode != 200 )
 	{
-		ATMO_PLATFORM_DebugPrint( "HTTP timeout %d\r\n", timeoutMs );
-		return ATMO_HTTP_Status_Fail;
+		// It's OK, but there's no meaningful data to return
+		return ATMO_HTTP_Status_Success;
 	}
 
+	// Length includes the NULL terminator
+	*respDataLen = result.respDataLen + 1;
+	_ATMO_HTTP_PrivData[instance].lastRespData = ( uint8_t * )result.respData;
+	_ATMO_HTTP_PrivData[instance].lastRespDataLen = *respDataLen;
+
 	return ATMO_HTTP_Status_Success;
 }
 
 ATMO_HTTP_Status_t ATMO_HTTP_GetRespData( ATMO_DriverInstanceHandle_t instance, uint8_t *buf, unsigned int bufLen )
 {
+	if ( instance >= _ATMO_HTTP_NumInstances || buf == NULL )
+	{
+		return ATMO_HTTP_Status_Invalid;
+	}
+
 	if ( _ATMO_HTTP_PrivData[instance].lastRespDataLen > bufLen || _ATMO_HTTP_PrivData[instance].lastRespDataLen == 0 )
 	{
 		return ATMO_HTTP_Status_Fail;
@@ -366,5 +1110,3 @@ ATMO_HTTP_Status_t ATMO_HTTP_GetRespData( ATMO_DriverInstanceHandle_t instance,
 	_ATMO_HTTP_PrivData[instance].lastRespDataLen = 0;
 	return ATMO_HTTP_Status_Success;
 }
-
-
@@ -67,6 +67,8 @@ typedef enum
 	ATMO_HTTP_Status_Invalid       = 0x03u,  // Invalid operation
 	ATMO_HTTP_Status_NotSupported  = 0x04u,  // Feature not supported by platform
 	ATMO_HTTP_Status_Unspecified   = 0x05u,  // Some other status not defined
+	ATMO_HTTP_Status_Busy          = 0x06u,  // All connections are in use
+	ATMO_HTTP_Status_Timeout       = 0x07u,  // No complete response within the timeout
 } ATMO_HTTP_Status_t;
 
 typedef enum
@@ -94,7 +96,7 @@ typedef struct
 	const char *url; /**< URL */
 	ATMO_HTTP_Method_t method; /**< Get/Post */
 	const char *contentType; /**< Content type for POST. Can be NULL, will default to application/json */
-	const char *data; /**< Data for POST. Can be NULL. */
+	const char *data; /**< Data for POST. Can be NULL. Sent from this buffer, not copied. */
 	unsigned int dataLen; /**< Length of POST data. */
 	ATMO_HTTP_Header_t *headerOverlay; /**< Array of headers to overlay. */
 	uint8_t headerOverlayLen; /**< Length of array. */
@@ -106,6 +108,31 @@ typedef struct
 	uint8_t unused; // Currently unused
 } ATMO_HTTP_Config_t;
 
+/**
+ * Called when an asynchronous transaction finishes.
+ *
+ * @param instance
+ * @param status - Success if a complete response was received
+ * @param respCode - HTTP response code
+ * @param respData - Response body, NULL terminated. Only valid until the callback returns.
+ * @param respDataLen - Length of the body, not including the NULL terminator
+ * @param arg - Argument given to ATMO_HTTP_PerformAsync
+ */
+typedef void ( *ATMO_HTTP_ResponseCallback_t )( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respData, unsigned int respDataLen, void *arg );
+
+/**
+ * Called with each piece of a streamed response body as it is received.
+ * The body is already de-chunked. Runs from the TCP receive callback, so it
+ * must not start another transaction.
+ *
+ * @param instance
+ * @param respCode - HTTP response code
+ * @param data - Next part of the body. Only valid until the callback returns.
+ * @param dataLen
+ * @param arg - Argument given to ATMO_HTTP_PerformStream
+ */
+typedef void ( *ATMO_HTTP_BodyCallback_t )( ATMO_DriverInstanceHandle_t instance, unsigned int respCode, const uint8_t *data, unsigned int dataLen, void *arg );
+
 
 /* Exported Function Prototypes -----------------------------------------------*/
 /**
@@ -117,6 +144,39 @@ typedef struct
  */
 ATMO_HTTP_Status_t ATMO_HTTP_Init( ATMO_DriverInstanceHandle_t tcpClientDriverInstance, uint8_t *packetBuf, uint32_t packetBufSize, ATMO_DriverInstanceHandle_t *httpInstance );
 
+/**
+ * Add another TCP client to the connection pool of an HTTP instance.
+ *
+ * Connections are kept open after a transaction when the server allows it and
+ * are reused for the next request to the same host. Every connection runs one
+ * transaction at a time in its own packet buffer, so more connections allow
+ * more transactions in flight and more hosts to be kept open at the same time.
+ *
+ * @param[in] instance
+ * @param[in] tcpClientDriverInstance
+ * @param[in] packetBuf - Buffer for requests and responses on this connection
+ * @param[in] packetBufSize
+ * @return status
+ */
+ATMO_HTTP_Status_t ATMO_HTTP_AddConnection( ATMO_DriverInstanceHandle_t instance, ATMO_DriverInstanceHandle_t tcpClientDriverInstance, uint8_t *packetBuf, uint32_t packetBufSize );
+
+/**
+ * Close all idle pooled connections of an HTTP instance.
+ *
+ * @param[in] instance
+ * @return status
+ */
+ATMO_HTTP_Status_t ATMO_HTTP_CloseConnections( ATMO_DriverInstanceHandle_t instance );
+
+/**
+ * Get the number of pooled connections of an HTTP instance that can start a transaction.
+ *
+ * @param[in] instance
+ * @param[out] numAvailable
+ * @return status
+ */
+ATMO_HTTP_Status_t ATMO_HTTP_GetAvailableConnections( ATMO_DriverInstanceHandle_t instance, unsigned int *numAvailable );
+
 /**
  * De-initialize the HTTP driver.
  *
@@ -133,21 +193,63 @@ ATMO_HTTP_Status_t ATMO_HTTP_DeInit( ATMO_DriverInstanceHandle_t instance );
  */
 ATMO_HTTP_Status_t ATMO_HTTP_SetConfiguration( ATMO_DriverInstanceHandle_t instance, const ATMO_HTTP_Config_t *config );
 
+/**
+ * Start a HTTP Get/Post transaction without waiting for it.
+ *
+ * The request line and headers are built in the packet buffer right away, but
+ * a POST body is sent straight from transaction->data and is not copied. The
+ * transaction itself doesn't have to stay valid after this returns, the body
+ * data does, until the completion callback has run. Connecting, sending and
+ * receiving are driven by the tick and the TCP receive callback, the callback
+ * runs from the tick once the transaction is done.
+ *
+ * @param[in] transaction
+ * @param[in] timeoutMs - timeout in milliseconds of transaction
+ * @param[in] cb - Completion callback, can be NULL
+ * @param[in] arg - Passed to the callback
+ * @return Busy if every connection of the instance has a transaction in flight
+ */
+ATMO_HTTP_Status_t ATMO_HTTP_PerformAsync( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int timeoutMs, ATMO_HTTP_ResponseCallback_t cb, void *arg );
+
+/**
+ * Start a HTTP Get/Post transaction and stream the response body to a callback.
+ *
+ * Works like ATMO_HTTP_PerformAsync, but the body is handed to bodyCb as it
+ * arrives instead of being collected in the packet buffer, so the buffer only
+ * has to hold the request, the response headers and one received packet.
+ * The completion callback gets a NULL body and the total body length.
+ * The POST body must stay valid until the completion callback, like for
+ * ATMO_HTTP_PerformAsync.
+ *
+ * @param[in] transaction
+ * @param[in] timeoutMs - timeout in milliseconds of transaction
+ * @param[in] bodyCb - Body callback
+ * @param[in] cb - Completion callback, can be NULL
+ * @param[in] arg - Passed to both callbacks
+ * @return Busy if every connection of the instance has a transaction in flight
+ */
+ATMO_HTTP_Status_t ATMO_HTTP_PerformStream( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int timeoutMs, ATMO_HTTP_BodyCallback_t bodyCb, ATMO_HTTP_ResponseCallback_t cb, void *arg );
+
 /**
  * Perform a HTTP Get/Post transaction.
  *
- * This will technically *block*, but it will call ATMO_Tick once in awhile to keep things moving
+ * This will technically *block*, but it will call ATMO_Tick once in awhile to keep things moving.
+ * It runs on the same tick-driven transaction as ATMO_HTTP_PerformAsync, so
+ * it must not be called from a completion or body callback.
  *
  * @param[in] transaction
  * @param[out] respCode -returned response code
- * @param[out] respDataLen - length of returned response data in bytes
+ * @param[out] respDataLen - length of returned response data in bytes, including the NULL terminator
  * @param[in] timeoutMs - timeout in milliseconds of transaction
  * @return status
  */
 ATMO_HTTP_Status_t ATMO_HTTP_Perform( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Transaction_t *transaction, unsigned int *respCode, unsigned int *respDataLen, unsigned int timeoutMs );
 
 /**
- * Get the HTTP response data.
+ * Get the HTTP response data of the last ATMO_HTTP_Perform.
+ *
+ * The data is still in the connection's packet buffer, so this has to be
+ * called before the next transaction on the instance.
  *
  * @param buf
  * @param bufLen
@@ -119,6 +119,21 @@ ATMO_I2C_Status_t ATMO_I2C_MasterRead( ATMO_DriverInstanceHandle_t instance, uin
 	return i2cInstances[instance]->MasterRead( i2cInstancesData[instance], slaveAddress, cmdBytes, numCmdBytes, readBytes, numReadBytes, timeoutMs );
 }
 
+ATMO_I2C_Status_t ATMO_I2C_MasterWriteAsync( ATMO_DriverInstanceHandle_t instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, ATMO_I2C_WriteCallback_t cb, void *arg )
+{
+	if ( !( instance < numberOfI2CDriverInstance ) )
+	{
+		return ATMO_I2C_Status_Invalid;
+	}
+
+	if ( i2cInstances[instance]->MasterWriteAsync == NULL )
+	{
+		return ATMO_I2C_Status_NotSupported;
+	}
+
+	return i2cInstances[instance]->MasterWriteAsync( i2cInstancesData[instance], slaveAddress, cmdBytes, numCmdBytes, writeBytes, numWriteBytes, cb, arg );
+}
+
 uint32_t ATMO_I2C_BaudToHz( ATMO_I2C_BaudRate_t baudRate )
 {
 	switch ( baudRate )
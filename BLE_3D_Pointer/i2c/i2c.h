@@ -125,6 +125,14 @@ typedef struct
 } ATMO_I2C_Peripheral_t;
 
 
+/**
+ * Called when an asynchronous write has finished, possibly from interrupt context
+ *
+ * @param status :ATMO_I2C_Status_Success if every byte was sent.
+ * @param arg :The argument passed to ATMO_I2C_MasterWriteAsync.
+ */
+typedef void ( *ATMO_I2C_WriteCallback_t )( ATMO_I2C_Status_t status, void *arg );
+
 typedef struct ATMO_I2C_DriverInstance_t ATMO_I2C_DriverInstance_t;
 
 struct ATMO_I2C_DriverInstance_t
@@ -134,6 +142,7 @@ struct ATMO_I2C_DriverInstance_t
 	ATMO_I2C_Status_t ( *SetConfiguration )( ATMO_DriverInstanceData_t *instanceData, const ATMO_I2C_Peripheral_t *config );
 	ATMO_I2C_Status_t ( *MasterWrite )( ATMO_DriverInstanceData_t *instanceData, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, unsigned int timeoutMs );
 	ATMO_I2C_Status_t ( *MasterRead )( ATMO_DriverInstanceData_t *instanceData, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, uint8_t *readBytes, uint16_t numReadBytes, unsigned int timeoutMs );
+	ATMO_I2C_Status_t ( *MasterWriteAsync )( ATMO_DriverInstanceData_t *instanceData, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, ATMO_I2C_WriteCallback_t cb, void *arg ); /**< Optional, may be NULL */
 };
 
 /* Exported Function Prototypes -----------------------------------------------*/
@@ -204,6 +213,24 @@ ATMO_I2C_Status_t ATMO_I2C_MasterWrite( ATMO_DriverInstanceHandle_t instance, ui
  */
 ATMO_I2C_Status_t ATMO_I2C_MasterRead( ATMO_DriverInstanceHandle_t instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, uint8_t *readBytes, uint16_t numReadBytes, unsigned int timeoutMs );
 
+/**
+ * This routine starts sending one or more bytes to a slave device via the specified I2C peripheral and returns
+ * without waiting for the transfer. The callback reports how it ended. Both buffers must stay valid until then.
+ * Only one transfer can be in progress, the caller is responsible for giving up on one that never finishes.
+ *
+ * @param instance :The peripheral instance used to write to the specified slave device.
+ * @param slaveAddress :The address of the slave device.
+ * @param cmdBytes :The pointer to a buffer holding the command that will be sent by the I2C peripheral. May be NULL.
+ * @param numCmdBytes :The number of bytes in the cmdBytes buffer that will be sent by the I2C peripheral. May be 0.
+ * @param writeBytes :The pointer to a buffer holding the data bytes that will be sent by the I2C peripheral.
+ * @param numWriteBytes :The number of bytes in the writeBytes buffer that will be sent by the I2C peripheral.
+ * @param cb :Called once the transfer has finished. Only called if the transfer was started.
+ * @param arg :Passed to the callback.
+ * @return ATMO_I2C_Status_Busy while another transfer is in progress, ATMO_I2C_Status_NotSupported if the
+ *         driver can only write blocking.
+ */
+ATMO_I2C_Status_t ATMO_I2C_MasterWriteAsync( ATMO_DriverInstanceHandle_t instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, ATMO_I2C_WriteCallback_t cb, void *arg );
+
 /**
  * Convert baud rate enum to its value in hz
  *
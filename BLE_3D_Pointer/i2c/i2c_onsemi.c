@@ -43,9 +43,16 @@ const ATMO_I2C_DriverInstance_t onsemiI2CDriverInstance =
 	ATMO_ONSEMI_I2C_DeInit,
 	ATMO_ONSEMI_I2C_SetConfiguration,
 	ATMO_ONSEMI_I2C_MasterWrite,
-	ATMO_ONSEMI_I2C_MasterRead
+	ATMO_ONSEMI_I2C_MasterRead,
+	ATMO_ONSEMI_I2C_MasterWriteAsync
 };
 
+// There is a single I2C peripheral, so one asynchronous write at a time
+static ATMO_I2C_WriteCallback_t _ATMO_ONSEMI_I2C_WriteCb = NULL;
+static void *_ATMO_ONSEMI_I2C_WriteCbArg = NULL;
+static uint32_t _ATMO_ONSEMI_I2C_WriteNumBytes = 0;
+static volatile ATMO_BOOL_t _ATMO_ONSEMI_I2C_WriteInFlight = false;
+
 ATMO_Status_t ATMO_ONSEMI_I2C_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
 {
 	static ATMO_DriverInstanceData_t driverInstanceData;
@@ -77,28 +84,68 @@ ATMO_I2C_Status_t ATMO_ONSEMI_I2C_SetConfiguration( ATMO_DriverInstanceData_t *i
 
 ATMO_I2C_Status_t ATMO_ONSEMI_I2C_MasterWrite( ATMO_DriverInstanceData_t *instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, unsigned int timeout_ms )
 {
-	uint8_t data[numCmdBytes + numWriteBytes];
+	// Command and data go out as one transfer straight from the caller's buffers
+	int32_t halStatus = HAL_I2C_WriteScatter( slaveAddress, cmdBytes, numCmdBytes, writeBytes, numWriteBytes, false );
+	ATMO_I2C_Status_t status = ( halStatus == HAL_OK ) ? ATMO_I2C_Status_Success : ATMO_I2C_Status_Fail;
+	return status;
+}
 
-	if ( numCmdBytes > 0 )
+static void _ATMO_ONSEMI_I2C_WriteDone( struct HAL_I2C_TransferData *transfer )
+{
+	ATMO_I2C_Status_t status = ATMO_I2C_Status_Success;
+
+	if ( transfer->event & ARM_I2C_EVENT_ADDRESS_NACK )
 	{
-		memcpy( data, cmdBytes, numCmdBytes );
+		status = ATMO_I2C_Status_ReceivedNak;
 	}
+	else if ( transfer->event & ARM_I2C_EVENT_ARBITRATION_LOST )
+	{
+		status = ATMO_I2C_Status_ArbitrationLost;
+	}
+	else if ( !( transfer->event & ARM_I2C_EVENT_TRANSFER_DONE ) || ( transfer->event & ( ARM_I2C_EVENT_TRANSFER_INCOMPLETE | ARM_I2C_EVENT_BUS_ERROR ) ) ||
+	          transfer->num != _ATMO_ONSEMI_I2C_WriteNumBytes )
+	{
+		status = ATMO_I2C_Status_Fail;
+	}
+
+	_ATMO_ONSEMI_I2C_WriteInFlight = false;
 
-	if ( numWriteBytes > 0 )
+	if ( _ATMO_ONSEMI_I2C_WriteCb != NULL )
 	{
-		memcpy( &data[numCmdBytes], writeBytes, numWriteBytes );
+		_ATMO_ONSEMI_I2C_WriteCb( status, _ATMO_ONSEMI_I2C_WriteCbArg );
 	}
+}
 
-	int32_t halStatus = HAL_I2C_Write( slaveAddress, data, numCmdBytes + numWriteBytes, false );
-	ATMO_I2C_Status_t status = ( halStatus == HAL_OK ) ? ATMO_I2C_Status_Success : ATMO_I2C_Status_Fail;
-	return status;
+ATMO_I2C_Status_t ATMO_ONSEMI_I2C_MasterWriteAsync( ATMO_DriverInstanceData_t *instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, ATMO_I2C_WriteCallback_t cb, void *arg )
+{
+	// The write in flight keeps its callback until it has finished
+	if ( _ATMO_ONSEMI_I2C_WriteInFlight )
+	{
+		return ATMO_I2C_Status_Busy;
+	}
+
+	_ATMO_ONSEMI_I2C_WriteCb = cb;
+	_ATMO_ONSEMI_I2C_WriteCbArg = arg;
+	_ATMO_ONSEMI_I2C_WriteNumBytes = numCmdBytes + numWriteBytes;
+	_ATMO_ONSEMI_I2C_WriteInFlight = true;
+
+	int32_t halStatus = HAL_I2C_WriteScatterAsync( slaveAddress, cmdBytes, numCmdBytes, writeBytes, numWriteBytes, false, &_ATMO_ONSEMI_I2C_WriteDone );
+
+	if ( halStatus != HAL_OK )
+	{
+		_ATMO_ONSEMI_I2C_WriteInFlight = false;
+		return ( halStatus == HAL_ERROR_BUSY ) ? ATMO_I2C_Status_Busy : ATMO_I2C_Status_Fail;
+	}
+
+	return ATMO_I2C_Status_Success;
 }
 
 ATMO_I2C_Status_t ATMO_ONSEMI_I2C_MasterRead( ATMO_DriverInstanceData_t *instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, uint8_t *readBytes, uint16_t numReadBytes, unsigned int timeout_ms )
 {
 	if ( numCmdBytes > 0 )
 	{
-		if ( HAL_I2C_Write( slaveAddress, cmdBytes, numCmdBytes, false ) != HAL_OK )
+		// Keep the bus after the command so the read follows with a repeated start
+		if ( HAL_I2C_Write( slaveAddress, cmdBytes, numCmdBytes, true ) != HAL_OK )
 		{
 			return ATMO_I2C_Status_Fail;
 		}
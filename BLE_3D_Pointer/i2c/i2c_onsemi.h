@@ -64,6 +64,8 @@ ATMO_I2C_Status_t ATMO_ONSEMI_I2C_MasterWrite( ATMO_DriverInstanceData_t *instan
 
 ATMO_I2C_Status_t ATMO_ONSEMI_I2C_MasterRead( ATMO_DriverInstanceData_t *instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, uint8_t *readBytes, uint16_t numReadBytes, unsigned int timeout_ms );
 
+ATMO_I2C_Status_t ATMO_ONSEMI_I2C_MasterWriteAsync( ATMO_DriverInstanceData_t *instance, uint16_t slaveAddress, const uint8_t *cmdBytes, uint16_t numCmdBytes, const uint8_t *writeBytes, uint16_t numWriteBytes, ATMO_I2C_WriteCallback_t cb, void *arg );
+
 
 #ifdef __cplusplus
 }
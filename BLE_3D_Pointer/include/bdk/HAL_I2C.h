@@ -247,6 +247,55 @@ extern int32_t HAL_I2C_WriteAsync(uint32_t addr,
 		bool xfer_pending,
 		HAL_I2C_Callback cb);
 
+/** \brief Performs I2C write transaction of two data arrays.
+ *
+ * The bytes of \p data follow the bytes of \p head within the same
+ * transaction, so a register address and the register content can be written
+ * without copying them into one array first.
+ *
+ * This function is blocking until I2C transaction is completed.
+ *
+ * \param addr
+ * 7-bit I2C address of device.
+ *
+ * \param head
+ * Pointer to data array written first, e.g. the register address.
+ * May be NULL if \p head_num is 0.
+ *
+ * \param head_num
+ * Number of bytes to be written from \p head.
+ *
+ * \param data
+ * Pointer to data array written after \p head.
+ * May be NULL if \p num is 0.
+ *
+ * \param num
+ * Number of bytes to be written from \p data.
+ *
+ * \param xfer_pending
+ * Whether an STOP condition should be generated after transaction is complete.
+ */
+extern int32_t HAL_I2C_WriteScatter(uint32_t addr,
+		const uint8_t *head,
+		uint32_t head_num,
+		const uint8_t *data,
+		uint32_t num,
+		bool xfer_pending);
+
+/** \brief Performs an I2C write transaction of two data arrays
+ * asynchronously and calls application defined callback when done.
+ *
+ * See \ref HAL_I2C_WriteScatter. Both arrays must remain valid until I2C
+ * transaction is finished.
+ */
+extern int32_t HAL_I2C_WriteScatterAsync(uint32_t addr,
+		const uint8_t *head,
+		uint32_t head_num,
+		const uint8_t *data,
+		uint32_t num,
+		bool xfer_pending,
+		HAL_I2C_Callback cb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -56,6 +56,8 @@ typedef struct _I2C_TRANSFER_INFO
     uint8_t              *data;       /* Pointer to data buffer */
     uint8_t addr;       /* Device address */
     bool pending;    /* If transfer is pending */
+    uint32_t head_num;   /* Number of data sent from data, the rest comes from tail */
+    const uint8_t        *tail;       /* Pointer to data sent after the first head_num bytes */
 } I2C_TRANSFER_INFO;
 
 /* I2C Information (Run-time) */
@@ -77,4 +79,11 @@ typedef struct
     I2C_TRANSFER_INFO      *xfer;     /* I2C transfer information */
 } I2C_RESOURCES;
 
+/* Extension to the CMSIS-Driver: master transmit of two buffers as one
+ * transfer, e.g. a register address followed by the register data without
+ * copying them into one buffer first. See I2C_MasterTransmitScatter. */
+extern int32_t I2C0_MasterTransmitScatter(uint32_t addr, const uint8_t *head,
+                                          uint32_t head_num, const uint8_t *tail,
+                                          uint32_t tail_num, bool xfer_pending);
+
 #endif    /* I2C_RSLXX_H */
@@ -20,9 +20,7 @@ static int32_t _NOA1305_BusRead(uint8_t dev_id, uint8_t addr, uint8_t *value)
 
 static int32_t _NOA1305_BusWrite(uint8_t dev_id, uint8_t addr, uint8_t value)
 {
-    uint8_t data[2] = { addr, value };
-
-    return ATMO_I2C_MasterWrite(_NOA1305_I2CInstance, dev_id, NULL, 0, data, 2, 0);
+    return ATMO_I2C_MasterWrite(_NOA1305_I2CInstance, dev_id, &addr, 1, &value, 1, 0);
 }
 
 ATMO_BOOL_t NOA1305_Init( ATMO_DriverInstanceHandle_t i2cInstance )
@@ -0,0 +1,685 @@
+/**
+ ******************************************************************************
+ * @file    sensorlog.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Flash backed circular sensor log
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "sensorlog.h"
+#include "../app_src/atmosphere_platform.h"
+
+#define ATMO_SENSORLOG_MAGIC (0x474C5341) // "ASLG"
+#define ATMO_SENSORLOG_PAGE_HEADER_LEN (15)
+
+/**
+ * The chunk read last, decoded. Chunks are only written once per page, so the
+ * page sequence and chunk index identify the contents.
+ */
+typedef struct
+{
+	ATMO_BOOL_t valid;
+	uint32_t pageSeq;
+	uint32_t chunk;
+	uint32_t numSamples;
+	ATMO_SENSORLOG_Sample_t samples[ATMO_SENSORLOG_SAMPLES_PER_CHUNK];
+} ATMO_SENSORLOG_ChunkCache_t;
+
+typedef struct
+{
+	ATMO_BOOL_t enabled;
+	ATMO_SENSORLOG_Config_t config;
+	uint32_t chunksPerPage; /**< Including the header chunk */
+	uint32_t numPages; /**< Pages in sequence up to the head page */
+	uint32_t headBlock;
+	uint32_t headSeq;
+	uint32_t headChunk; /**< Next free chunk in the head page */
+	uint32_t timeBase; /**< Log time at an uptime of 0 */
+	ATMO_BOOL_t primed;
+	uint32_t lastSampleMs;
+	ATMO_BOOL_t hasNewest;
+	ATMO_SENSORLOG_Sample_t newest; /**< Last sample logged, in the chunk buffer or in flash */
+	uint32_t numBuffered; /**< Samples in the chunk buffer */
+	uint32_t chunkLen; /**< Bytes used in the chunk buffer */
+	ATMO_SAMPLECODEC_State_t codec;
+	uint32_t samplesLogged;
+	uint32_t pagesDropped;
+} ATMO_SENSORLOG_State_t;
+
+static ATMO_SENSORLOG_State_t _ATMO_SENSORLOG_State;
+static ATMO_SENSORLOG_ChunkCache_t _ATMO_SENSORLOG_Cache;
+
+// Samples are collected here until the chunk is full
+static uint8_t _ATMO_SENSORLOG_ChunkBuf[ATMO_SENSORLOG_CHUNK_SIZE];
+static uint8_t _ATMO_SENSORLOG_ReadBuf[ATMO_SENSORLOG_CHUNK_SIZE];
+
+static void _ATMO_SENSORLOG_PutU16( uint8_t *buf, uint16_t value )
+{
+	buf[0] = value & 0xFF;
+	buf[1] = ( value >> 8 ) & 0xFF;
+}
+
+static void _ATMO_SENSORLOG_PutU32( uint8_t *buf, uint32_t value )
+{
+	buf[0] = value & 0xFF;
+	buf[1] = ( value >> 8 ) & 0xFF;
+	buf[2] = ( value >> 16 ) & 0xFF;
+	buf[3] = ( value >> 24 ) & 0xFF;
+}
+
+static uint16_t _ATMO_SENSORLOG_GetU16( const uint8_t *buf )
+{
+	return ( uint16_t )( buf[0] | ( buf[1] << 8 ) );
+}
+
+static uint32_t _ATMO_SENSORLOG_GetU32( const uint8_t *buf )
+{
+	return ( uint32_t )buf[0] | ( ( uint32_t )buf[1] << 8 ) | ( ( uint32_t )buf[2] << 16 ) | ( ( uint32_t )buf[3] << 24 );
+}
+
+static uint16_t _ATMO_SENSORLOG_Crc16( uint16_t crc, const uint8_t *data, uint32_t len )
+{
+	uint32_t i;
+	unsigned int bit;
+
+	// CRC-16/CCITT, a torn chunk must not pass by chance
+	for ( i = 0; i < len; i++ )
+	{
+		crc ^= ( uint16_t )data[i] << 8;
+
+		for ( bit = 0; bit < 8; bit++ )
+		{
+			crc = ( crc & 0x8000 ) ? ( uint16_t )( ( crc << 1 ) ^ 0x1021 ) : ( uint16_t )( crc << 1 );
+		}
+	}
+
+	return crc;
+}
+
+/**
+ * CRC of a chunk, covering everything but the CRC itself.
+ */
+static uint16_t _ATMO_SENSORLOG_ChunkCrc( const uint8_t *chunk, uint32_t len )
+{
+	uint16_t crc = _ATMO_SENSORLOG_Crc16( 0xFFFF, chunk, 1 );
+	return _ATMO_SENSORLOG_Crc16( crc, &chunk[3], len - 3 );
+}
+
+/**
+ * Wrap safe comparison of log times.
+ */
+static ATMO_BOOL_t _ATMO_SENSORLOG_Before( uint32_t a, uint32_t b )
+{
+	return ( int32_t )( a - b ) < 0;
+}
+
+static uint32_t _ATMO_SENSORLOG_Now( void )
+{
+	return _ATMO_SENSORLOG_State.timeBase + ( uint32_t )ATMO_PLATFORM_UptimeMs();
+}
+
+static ATMO_BOOL_t _ATMO_SENSORLOG_BlockRead( uint32_t block, uint32_t offset, void *buf, uint32_t size )
+{
+	ATMO_SENSORLOG_Config_t *config = &_ATMO_SENSORLOG_State.config;
+	return ATMO_BLOCK_Read( config->blockInstance, config->firstBlock + block, offset, buf, size ) == ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BOOL_t _ATMO_SENSORLOG_BlockProgram( uint32_t block, uint32_t offset, void *buf, uint32_t size )
+{
+	ATMO_SENSORLOG_Config_t *config = &_ATMO_SENSORLOG_State.config;
+	return ATMO_BLOCK_Program( config->blockInstance, config->firstBlock + block, offset, buf, size ) == ATMO_BLOCK_Status_Success;
+}
+
+static uint32_t _ATMO_SENSORLOG_TailSeq( void )
+{
+	return _ATMO_SENSORLOG_State.headSeq - _ATMO_SENSORLOG_State.numPages + 1;
+}
+
+/**
+ * Block holding a page that is still in the log.
+ */
+static uint32_t _ATMO_SENSORLOG_PageBlock( uint32_t pageSeq )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint32_t numBlocks = state->config.numBlocks;
+	return ( state->headBlock + numBlocks - ( ( state->headSeq - pageSeq ) % numBlocks ) ) % numBlocks;
+}
+
+/**
+ * @return false if the block doesn't hold a page of this log
+ */
+static ATMO_BOOL_t _ATMO_SENSORLOG_ReadPageHeader( uint32_t block, uint32_t *pageSeq, uint32_t *startMs )
+{
+	uint8_t header[ATMO_SENSORLOG_PAGE_HEADER_LEN];
+
+	if ( !_ATMO_SENSORLOG_BlockRead( block, 0, header, sizeof( header ) ) ||
+	        _ATMO_SENSORLOG_GetU32( header ) != ATMO_SENSORLOG_MAGIC ||
+	        header[12] != _ATMO_SENSORLOG_State.config.sensorId ||
+	        _ATMO_SENSORLOG_Crc16( 0xFFFF, header, 13 ) != _ATMO_SENSORLOG_GetU16( &header[13] ) )
+	{
+		return false;
+	}
+
+	*pageSeq = _ATMO_SENSORLOG_GetU32( &header[4] );
+
+	if ( startMs != NULL )
+	{
+		*startMs = _ATMO_SENSORLOG_GetU32( &header[8] );
+	}
+
+	return true;
+}
+
+/**
+ * @return number of samples in the chunk, 0 if it is erased or damaged
+ */
+static uint32_t _ATMO_SENSORLOG_DecodeChunk( const uint8_t *chunk, ATMO_SENSORLOG_Sample_t *samples )
+{
+	ATMO_SAMPLECODEC_State_t codec;
+	uint32_t numSamples = chunk[0];
+	uint32_t len = ATMO_SENSORLOG_CHUNK_HEADER_LEN;
+	uint32_t i;
+
+	if ( numSamples == 0 || numSamples > ATMO_SENSORLOG_SAMPLES_PER_CHUNK )
+	{
+		return 0;
+	}
+
+	ATMO_SAMPLECODEC_Reset( &codec, _ATMO_SENSORLOG_GetU32( &chunk[3] ) );
+
+	for ( i = 0; i < numSamples; i++ )
+	{
+		unsigned int sampleLen = ATMO_SAMPLECODEC_Decode( &codec, &chunk[len], ATMO_SENSORLOG_CHUNK_SIZE - len, &samples[i] );
+
+		if ( sampleLen == 0 )
+		{
+			return 0;
+		}
+
+		len += sampleLen;
+	}
+
+	return ( _ATMO_SENSORLOG_ChunkCrc( chunk, len ) == _ATMO_SENSORLOG_GetU16( &chunk[1] ) ) ? numSamples : 0;
+}
+
+/**
+ * Decode a chunk into the cache.
+ *
+ * @return number of samples in the chunk
+ */
+static uint32_t _ATMO_SENSORLOG_LoadChunk( uint32_t pageSeq, uint32_t chunk )
+{
+	ATMO_SENSORLOG_ChunkCache_t *cache = &_ATMO_SENSORLOG_Cache;
+
+	if ( cache->valid && cache->pageSeq == pageSeq && cache->chunk == chunk )
+	{
+		return cache->numSamples;
+	}
+
+	cache->valid = false;
+
+	if ( !_ATMO_SENSORLOG_BlockRead( _ATMO_SENSORLOG_PageBlock( pageSeq ), chunk * ATMO_SENSORLOG_CHUNK_SIZE, _ATMO_SENSORLOG_ReadBuf, ATMO_SENSORLOG_CHUNK_SIZE ) )
+	{
+		return 0;
+	}
+
+	cache->numSamples = _ATMO_SENSORLOG_DecodeChunk( _ATMO_SENSORLOG_ReadBuf, cache->samples );
+	cache->pageSeq = pageSeq;
+	cache->chunk = chunk;
+	cache->valid = true;
+	return cache->numSamples;
+}
+
+/**
+ * Erase the next block and make it the head page, dropping the oldest page if the log is full.
+ */
+static ATMO_BOOL_t _ATMO_SENSORLOG_OpenPage( uint32_t startMs )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint8_t *header = _ATMO_SENSORLOG_ReadBuf;
+	uint32_t next = ( state->headBlock + 1 ) % state->config.numBlocks;
+
+	// The oldest page is gone from here on, even if erasing fails
+	if ( state->numPages == state->config.numBlocks )
+	{
+		state->numPages--;
+		state->pagesDropped++;
+	}
+
+	if ( ATMO_BLOCK_Erase( state->config.blockInstance, state->config.firstBlock + next ) != ATMO_BLOCK_Status_Success )
+	{
+		return false;
+	}
+
+	_ATMO_SENSORLOG_Cache.valid = false;
+	memset( header, 0xFF, ATMO_SENSORLOG_CHUNK_SIZE );
+	_ATMO_SENSORLOG_PutU32( &header[0], ATMO_SENSORLOG_MAGIC );
+	_ATMO_SENSORLOG_PutU32( &header[4], state->headSeq + 1 );
+	_ATMO_SENSORLOG_PutU32( &header[8], startMs );
+	header[12] = state->config.sensorId;
+	_ATMO_SENSORLOG_PutU16( &header[13], _ATMO_SENSORLOG_Crc16( 0xFFFF, header, 13 ) );
+
+	if ( !_ATMO_SENSORLOG_BlockProgram( next, 0, header, ATMO_SENSORLOG_CHUNK_SIZE ) )
+	{
+		return false;
+	}
+
+	state->headBlock = next;
+	state->headSeq++;
+	state->headChunk = 1;
+	state->numPages++;
+	return true;
+}
+
+/**
+ * Write the samples in the chunk buffer to the head page.
+ */
+static ATMO_SENSORLOG_Status_t _ATMO_SENSORLOG_WriteChunk( void )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint8_t *chunk = _ATMO_SENSORLOG_ChunkBuf;
+
+	if ( state->numBuffered == 0 )
+	{
+		return ATMO_SENSORLOG_Status_Success;
+	}
+
+	uint32_t len = state->chunkLen;
+
+	chunk[0] = state->numBuffered;
+	_ATMO_SENSORLOG_PutU16( &chunk[1], _ATMO_SENSORLOG_ChunkCrc( chunk, len ) );
+	memset( &chunk[len], 0xFF, ATMO_SENSORLOG_CHUNK_SIZE - len );
+	state->numBuffered = 0;
+
+	if ( state->headChunk >= state->chunksPerPage && !_ATMO_SENSORLOG_OpenPage( _ATMO_SENSORLOG_GetU32( &chunk[3] ) ) )
+	{
+		return ATMO_SENSORLOG_Status_Fail;
+	}
+
+	// A failed program leaves the chunk unusable either way
+	uint32_t offset = state->headChunk++ * ATMO_SENSORLOG_CHUNK_SIZE;
+
+	if ( !_ATMO_SENSORLOG_BlockProgram( state->headBlock, offset, chunk, ATMO_SENSORLOG_CHUNK_SIZE ) ||
+	        ATMO_BLOCK_Sync( state->config.blockInstance ) != ATMO_BLOCK_Status_Success )
+	{
+		return ATMO_SENSORLOG_Status_Fail;
+	}
+
+	return ATMO_SENSORLOG_Status_Success;
+}
+
+static ATMO_SENSORLOG_Status_t _ATMO_SENSORLOG_Append( const ATMO_SENSORLOG_Sample_t *sample )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint8_t *chunk = _ATMO_SENSORLOG_ChunkBuf;
+	ATMO_SENSORLOG_Status_t status = ATMO_SENSORLOG_Status_Success;
+
+	if ( state->numBuffered > 0 )
+	{
+		unsigned int len = 0;
+
+		if ( state->numBuffered < ATMO_SENSORLOG_SAMPLES_PER_CHUNK )
+		{
+			len = ATMO_SAMPLECODEC_Encode( &state->codec, sample, &chunk[state->chunkLen], ATMO_SENSORLOG_CHUNK_SIZE - state->chunkLen );
+		}
+
+		if ( len > 0 )
+		{
+			state->chunkLen += len;
+			state->numBuffered++;
+		}
+		else
+		{
+			status = _ATMO_SENSORLOG_WriteChunk();
+		}
+	}
+
+	// Start a new chunk at the time of the sample, it always fits
+	if ( state->numBuffered == 0 )
+	{
+		_ATMO_SENSORLOG_PutU32( &chunk[3], sample->timeMs );
+		ATMO_SAMPLECODEC_Reset( &state->codec, sample->timeMs );
+		state->chunkLen = ATMO_SENSORLOG_CHUNK_HEADER_LEN;
+		state->chunkLen += ATMO_SAMPLECODEC_Encode( &state->codec, sample, &chunk[state->chunkLen], ATMO_SENSORLOG_CHUNK_SIZE - state->chunkLen );
+		state->numBuffered = 1;
+	}
+
+	state->newest = *sample;
+	state->hasNewest = true;
+	state->samplesLogged++;
+	return status;
+}
+
+/**
+ * Rebuild the state from the blocks after a reset.
+ */
+static void _ATMO_SENSORLOG_Mount( void )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint32_t numBlocks = state->config.numBlocks;
+	ATMO_BOOL_t found = false;
+	uint32_t pageSeq = 0;
+	uint32_t startMs = 0;
+	uint32_t i;
+
+	// The head is the page written last
+	for ( i = 0; i < numBlocks; i++ )
+	{
+		if ( _ATMO_SENSORLOG_ReadPageHeader( i, &pageSeq, NULL ) && ( !found || _ATMO_SENSORLOG_Before( state->headSeq, pageSeq ) ) )
+		{
+			found = true;
+			state->headBlock = i;
+			state->headSeq = pageSeq;
+		}
+	}
+
+	if ( !found )
+	{
+		// The first chunk opens a page in block 0
+		state->headBlock = numBlocks - 1;
+		state->headSeq = 0;
+		state->headChunk = state->chunksPerPage;
+		state->numPages = 0;
+		return;
+	}
+
+	// Pages are written in order, walk back to the oldest one still in sequence
+	for ( state->numPages = 1; state->numPages < numBlocks; state->numPages++ )
+	{
+		uint32_t prev = ( state->headBlock + numBlocks - state->numPages ) % numBlocks;
+
+		if ( !_ATMO_SENSORLOG_ReadPageHeader( prev, &pageSeq, NULL ) || pageSeq != state->headSeq - state->numPages )
+		{
+			break;
+		}
+	}
+
+	// The page was opened with the sample that starts its first chunk
+	if ( _ATMO_SENSORLOG_ReadPageHeader( state->headBlock, &pageSeq, &startMs ) )
+	{
+		state->newest.timeMs = startMs;
+		state->hasNewest = true;
+	}
+
+	// Chunks are written in order, the first erased one is the write position.
+	// A chunk cut short is skipped by readers and never programmed again.
+	for ( state->headChunk = 1; state->headChunk < state->chunksPerPage; state->headChunk++ )
+	{
+		uint8_t *chunk = _ATMO_SENSORLOG_ReadBuf;
+		ATMO_BOOL_t erased = true;
+
+		if ( !_ATMO_SENSORLOG_BlockRead( state->headBlock, state->headChunk * ATMO_SENSORLOG_CHUNK_SIZE, chunk, ATMO_SENSORLOG_CHUNK_SIZE ) )
+		{
+			continue;
+		}
+
+		for ( i = 0; i < ATMO_SENSORLOG_CHUNK_SIZE && erased; i++ )
+		{
+			erased = ( chunk[i] == 0xFF );
+		}
+
+		if ( erased )
+		{
+			break;
+		}
+
+		uint32_t numSamples = _ATMO_SENSORLOG_DecodeChunk( chunk, _ATMO_SENSORLOG_Cache.samples );
+
+		if ( numSamples > 0 )
+		{
+			state->newest = _ATMO_SENSORLOG_Cache.samples[numSamples - 1];
+		}
+	}
+
+	_ATMO_SENSORLOG_Cache.valid = false;
+}
+
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Init( const ATMO_SENSORLOG_Config_t *config )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	ATMO_BLOCK_DeviceInfo_t info;
+
+	if ( config == NULL || config->numBlocks < 2 )
+	{
+		return ATMO_SENSORLOG_Status_Invalid;
+	}
+
+	memset( state, 0, sizeof( *state ) );
+	memset( &_ATMO_SENSORLOG_Cache, 0, sizeof( _ATMO_SENSORLOG_Cache ) );
+	memcpy( &state->config, config, sizeof( state->config ) );
+
+	if ( ATMO_BLOCK_GetDeviceInfo( config->blockInstance, &info ) != ATMO_BLOCK_Status_Success )
+	{
+		return ATMO_SENSORLOG_Status_Fail;
+	}
+
+	if ( info.progSize == 0 || ( ATMO_SENSORLOG_CHUNK_SIZE % info.progSize ) != 0 || ( info.blockSize % ATMO_SENSORLOG_CHUNK_SIZE ) != 0 ||
+	        info.blockSize < 2 * ATMO_SENSORLOG_CHUNK_SIZE || config->firstBlock + config->numBlocks > info.blockCount )
+	{
+		return ATMO_SENSORLOG_Status_Invalid;
+	}
+
+	state->chunksPerPage = info.blockSize / ATMO_SENSORLOG_CHUNK_SIZE;
+
+	_ATMO_SENSORLOG_Mount();
+
+	// Carry on from the newest sample so the log stays ordered after a reset
+	state->timeBase = state->hasNewest ? ( state->newest.timeMs + 1 - ( uint32_t )ATMO_PLATFORM_UptimeMs() ) : 0;
+	state->enabled = true;
+
+	return ATMO_SENSORLOG_Status_Success;
+}
+
+ATMO_BOOL_t ATMO_SENSORLOG_IsEnabled( void )
+{
+	return _ATMO_SENSORLOG_State.enabled;
+}
+
+void ATMO_SENSORLOG_PushSample( uint8_t sensorId, int16_t x, int16_t y, int16_t z )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+
+	if ( !state->enabled || sensorId != state->config.sensorId )
+	{
+		return;
+	}
+
+	uint32_t now = _ATMO_SENSORLOG_Now();
+	uint32_t periodMs = state->config.minIntervalMs;
+
+	// Allow a quarter period of jitter, like the stream decimation
+	if ( state->primed && periodMs > 0 && ( now - state->lastSampleMs ) + ( periodMs / 4 ) < periodMs )
+	{
+		return;
+	}
+
+	state->primed = true;
+	state->lastSampleMs = now;
+
+	ATMO_SENSORLOG_Sample_t sample = { now, x, y, z };
+
+	if ( _ATMO_SENSORLOG_Append( &sample ) != ATMO_SENSORLOG_Status_Success )
+	{
+		ATMO_PLATFORM_DebugPrint( "Error writing sensor log\r\n" );
+	}
+}
+
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Flush( void )
+{
+	if ( !_ATMO_SENSORLOG_State.enabled )
+	{
+		return ATMO_SENSORLOG_Status_Invalid;
+	}
+
+	return _ATMO_SENSORLOG_WriteChunk();
+}
+
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Seek( uint32_t fromMs, ATMO_SENSORLOG_Cursor_t *cursor )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+
+	if ( !state->enabled || cursor == NULL )
+	{
+		return ATMO_SENSORLOG_Status_Invalid;
+	}
+
+	if ( state->numPages == 0 )
+	{
+		return ATMO_SENSORLOG_Status_NoData;
+	}
+
+	// Binary search for the last page starting at or before the time
+	uint32_t tailSeq = _ATMO_SENSORLOG_TailSeq();
+	uint32_t lo = 0;
+	uint32_t hi = state->numPages;
+
+	while ( hi - lo > 1 )
+	{
+		uint32_t mid = lo + ( ( hi - lo ) / 2 );
+		uint32_t pageSeq = 0;
+		uint32_t startMs = 0;
+
+		if ( !_ATMO_SENSORLOG_ReadPageHeader( _ATMO_SENSORLOG_PageBlock( tailSeq + mid ), &pageSeq, &startMs ) ||
+		        !_ATMO_SENSORLOG_Before( fromMs, startMs ) )
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	cursor->pageSeq = tailSeq + lo;
+	cursor->chunk = 1;
+	cursor->sample = 0;
+	cursor->fromMs = fromMs;
+
+	return ATMO_SENSORLOG_Status_Success;
+}
+
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Read( ATMO_SENSORLOG_Cursor_t *cursor, uint32_t toMs, ATMO_SENSORLOG_Sample_t *samples, uint32_t maxSamples, uint32_t *numSamples )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint32_t num = 0;
+
+	if ( !state->enabled || cursor == NULL || samples == NULL || numSamples == NULL )
+	{
+		return ATMO_SENSORLOG_Status_Invalid;
+	}
+
+	while ( num < maxSamples && state->numPages > 0 && !_ATMO_SENSORLOG_Before( state->headSeq, cursor->pageSeq ) )
+	{
+		uint32_t tailSeq = _ATMO_SENSORLOG_TailSeq();
+
+		if ( _ATMO_SENSORLOG_Before( cursor->pageSeq, tailSeq ) )
+		{
+			cursor->pageSeq = tailSeq;
+			cursor->chunk = 1;
+			cursor->sample = 0;
+		}
+
+		ATMO_BOOL_t isHead = ( cursor->pageSeq == state->headSeq );
+
+		if ( cursor->chunk >= ( isHead ? state->headChunk : state->chunksPerPage ) )
+		{
+			if ( isHead )
+			{
+				break;
+			}
+
+			cursor->pageSeq++;
+			cursor->chunk = 1;
+			cursor->sample = 0;
+			continue;
+		}
+
+		uint32_t chunkSamples = _ATMO_SENSORLOG_LoadChunk( cursor->pageSeq, cursor->chunk );
+
+		for ( ; cursor->sample < chunkSamples && num < maxSamples; cursor->sample++ )
+		{
+			ATMO_SENSORLOG_Sample_t *sample = &_ATMO_SENSORLOG_Cache.samples[cursor->sample];
+
+			if ( _ATMO_SENSORLOG_Before( sample->timeMs, cursor->fromMs ) )
+			{
+				continue;
+			}
+
+			// Stay on the sample so later reads keep ending here
+			if ( _ATMO_SENSORLOG_Before( toMs, sample->timeMs ) )
+			{
+				*numSamples = num;
+				return ( num > 0 ) ? ATMO_SENSORLOG_Status_Success : ATMO_SENSORLOG_Status_NoData;
+			}
+
+			samples[num++] = *sample;
+		}
+
+		if ( cursor->sample >= chunkSamples )
+		{
+			cursor->chunk++;
+			cursor->sample = 0;
+		}
+	}
+
+	*numSamples = num;
+	return ( num > 0 ) ? ATMO_SENSORLOG_Status_Success : ATMO_SENSORLOG_Status_NoData;
+}
+
+void ATMO_SENSORLOG_GetInfo( ATMO_SENSORLOG_Info_t *info )
+{
+	ATMO_SENSORLOG_State_t *state = &_ATMO_SENSORLOG_State;
+	uint32_t pageSeq = 0;
+
+	if ( info == NULL )
+	{
+		return;
+	}
+
+	memset( info, 0, sizeof( *info ) );
+
+	if ( !state->enabled )
+	{
+		return;
+	}
+
+	info->sensorId = state->config.sensorId;
+	info->numPages = state->numPages;
+	info->newestMs = state->newest.timeMs;
+	info->nowMs = _ATMO_SENSORLOG_Now();
+	info->samplesLogged = state->samplesLogged;
+	info->pagesDropped = state->pagesDropped;
+
+	if ( state->numPages > 0 )
+	{
+		_ATMO_SENSORLOG_ReadPageHeader( _ATMO_SENSORLOG_PageBlock( _ATMO_SENSORLOG_TailSeq() ), &pageSeq, &info->oldestMs );
+	}
+}
@@ -0,0 +1,196 @@
+/**
+ ******************************************************************************
+ * @file    sensorlog.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Flash backed circular sensor log header file
+ *
+ * Records the samples of one sensor to a range of blocks of any ATMO_BLOCK
+ * device, overwriting the oldest page (block) once the log is full. Times are
+ * in log time: milliseconds of uptime, continued from the newest logged sample
+ * after a reset so the log stays ordered across power cycles.
+ *
+ * Every page starts with a header chunk (all fields little endian):
+ *
+ * < Magic (4 Bytes) >< Page Sequence (4 Bytes) >< Start Time ms (4 Bytes) >
+ * < Sensor ID (1 Byte) >< CRC-16 (2 Bytes) >
+ *
+ * The start time of every page is the time index used to seek. The rest of
+ * the page is split into fixed-size chunks, each holding a run of samples:
+ *
+ * < Sample Count (1 Byte) >< CRC-16 (2 Bytes) >< Start Time ms (4 Bytes) >
+ * < Samples >
+ *
+ * The samples are delta coded with atmo_samplecodec.h, starting from a reset
+ * at the start time, so every chunk decodes on its own. A sample that doesn't
+ * fit starts a new chunk. Chunks are written whole and carry their own CRC,
+ * so a chunk torn by a power cut is skipped on its own. Samples are collected
+ * in RAM until a chunk is full, at most one chunk is lost on a power cut
+ * unless ATMO_SENSORLOG_Flush was called.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __ATMO_SENSORLOG__H
+#define __ATMO_SENSORLOG__H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "../atmo/core.h"
+#include "../block/block.h"
+#include "../atmo/atmo_samplecodec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported Constants --------------------------------------------------------*/
+
+// Must be a multiple of the program size of the device and divide its block size
+#ifndef ATMO_SENSORLOG_CHUNK_SIZE
+#define ATMO_SENSORLOG_CHUNK_SIZE (64)
+#endif
+
+#define ATMO_SENSORLOG_CHUNK_HEADER_LEN (7)
+#define ATMO_SENSORLOG_SAMPLES_PER_CHUNK ( ( ATMO_SENSORLOG_CHUNK_SIZE - ATMO_SENSORLOG_CHUNK_HEADER_LEN ) / ATMO_SAMPLECODEC_MIN_SAMPLE_LEN )
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported Types ------------------------------------------------------------*/
+
+typedef enum
+{
+	ATMO_SENSORLOG_Status_Success              = 0x00u,  /**< Operation was successful */
+	ATMO_SENSORLOG_Status_Fail                 = 0x01u,  /**< Operation failed */
+	ATMO_SENSORLOG_Status_Invalid              = 0x02u,  /**< Invalid argument or log not initialized */
+	ATMO_SENSORLOG_Status_NoData               = 0x03u,  /**< No more samples in the requested range */
+} ATMO_SENSORLOG_Status_t;
+
+typedef struct
+{
+	ATMO_DriverInstanceHandle_t blockInstance;
+	uint32_t firstBlock; /**< First block of the device used by the log */
+	uint32_t numBlocks; /**< Number of blocks used by the log, at least 2 */
+	uint8_t sensorId; /**< Samples of other sensors are ignored */
+	uint16_t minIntervalMs; /**< Samples closer together are dropped, 0 logs everything */
+} ATMO_SENSORLOG_Config_t;
+
+typedef ATMO_SAMPLECODEC_Sample_t ATMO_SENSORLOG_Sample_t;
+
+/**
+ * Read position within the log, set up with ATMO_SENSORLOG_Seek.
+ */
+typedef struct
+{
+	uint32_t pageSeq;
+	uint32_t chunk;
+	uint32_t sample;
+	uint32_t fromMs;
+} ATMO_SENSORLOG_Cursor_t;
+
+typedef struct
+{
+	uint8_t sensorId;
+	uint32_t numPages; /**< Pages holding samples */
+	uint32_t oldestMs; /**< Start time of the oldest page */
+	uint32_t newestMs; /**< Time of the newest sample, including unflushed ones */
+	uint32_t nowMs; /**< Current log time */
+	uint32_t samplesLogged; /**< Since init */
+	uint32_t pagesDropped; /**< Overwritten since init */
+} ATMO_SENSORLOG_Info_t;
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Mount the log and recover the write position. Nothing is erased until the
+ * first page is written.
+ *
+ * @param[in] config
+ * @return status
+ */
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Init( const ATMO_SENSORLOG_Config_t *config );
+
+/**
+ * @return true if the log was initialized successfully
+ */
+ATMO_BOOL_t ATMO_SENSORLOG_IsEnabled( void );
+
+/**
+ * Hand a single raw sample to the log. Samples of other sensors and samples
+ * within the minimum interval are ignored.
+ *
+ * @param[in] sensorId
+ * @param[in] x
+ * @param[in] y
+ * @param[in] z
+ */
+void ATMO_SENSORLOG_PushSample( uint8_t sensorId, int16_t x, int16_t y, int16_t z );
+
+/**
+ * Write the partially filled chunk to flash. The rest of the chunk is lost, so
+ * only call this when the samples must survive a power cut or be read back.
+ *
+ * @return status
+ */
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Flush( void );
+
+/**
+ * Get a cursor at the first sample at or after a time. Samples still
+ * collected in RAM are not visible until flushed.
+ *
+ * @param[in] fromMs - Log time
+ * @param[out] cursor
+ * @return NoData if the log is empty
+ */
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Seek( uint32_t fromMs, ATMO_SENSORLOG_Cursor_t *cursor );
+
+/**
+ * Read samples at the cursor and advance it. A cursor that fell behind the
+ * oldest page (overwritten while reading) continues at the oldest sample.
+ *
+ * @param[in,out] cursor
+ * @param[in] toMs - Last log time to return
+ * @param[out] samples
+ * @param[in] maxSamples
+ * @param[out] numSamples
+ * @return NoData once there are no more samples up to toMs
+ */
+ATMO_SENSORLOG_Status_t ATMO_SENSORLOG_Read( ATMO_SENSORLOG_Cursor_t *cursor, uint32_t toMs, ATMO_SENSORLOG_Sample_t *samples, uint32_t maxSamples, uint32_t *numSamples );
+
+/**
+ * @param[out] info
+ */
+void ATMO_SENSORLOG_GetInfo( ATMO_SENSORLOG_Info_t *info );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATMO_SENSORLOG__H */
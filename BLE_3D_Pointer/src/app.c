@@ -15,6 +15,7 @@
 
 #include "app.h"
 #include "../app_src/atmosphere_platform.h"
+#include "../block/block_onsemi.h"
 
 enum App_StateStruct app_state = APP_STATE_INIT;
 
@@ -114,6 +115,7 @@ void Main_Loop(void)
         if ( Timer_SetWakeupAtNextEvent() != APP_TIMER_ALARM_NOW)
         {
             /* Prepare device for entering deep sleep mode. */
+            ATMO_ONSEMI_BLOCK_Flush();
             trace_deinit();
             HAL_I2C_DeInit();
 
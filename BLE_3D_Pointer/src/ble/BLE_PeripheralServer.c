@@ -37,6 +37,7 @@
 #include "app_trace.h"
 #include "app_ble_hooks.h"
 #include "../../app_src/atmosphere_platform.h"
+#include "../../ble/ble_onsemi.h"
 
 //-----------------------------------------------------------------------------
 // DEFINES / CONSTANTS
@@ -388,10 +389,12 @@ static int GAPM_CmpEvt(ke_msg_id_t const msg_id, struct gapm_cmp_evt const *para
 
         /* Device started/stoped advertising */
         case GAPM_ADV_UNDIRECT:
+        case GAPM_ADV_DIRECT_LDC:
             TRACE_PRINTF("operation=%d, status=%d\r\n", param->operation,
                     param->status);
             //ASSERT_DEBUG(param->status == GAP_ERR_NO_ERROR
             //                || param->status == GAP_ERR_CANCELED);
+            _ATMO_ONSEMI_BLE_AdvertisingComplete(param->operation, param->status);
             break;
 
         default:
@@ -506,6 +509,8 @@ static int GAPC_ConnectionReqInd(ke_msg_id_t const msg_id, struct gapc_connectio
             ble_env.state = BLE_STATE_CONNECTED;
             ble_env.conhdl = param->conhdl;
 
+            _ATMO_ONSEMI_BLE_SetLastCentral(param->peer_addr.addr, param->peer_addr_type);
+
             BDK_BLE_SendConnectionConfirmation();
             BDK_BLE_SetServiceState(true);
 
@@ -235,6 +235,55 @@ int32_t HAL_I2C_WriteAsync(uint32_t addr,
 	return Driver_I2C0.MasterTransmit(addr, data, num, xfer_pending);
 }
 
+int32_t HAL_I2C_WriteScatter(uint32_t addr,
+		const uint8_t *head,
+		uint32_t head_num,
+		const uint8_t *data,
+		uint32_t num,
+		bool xfer_pending)
+{
+	int32_t err = HAL_OK;
+
+	ASSERT_ALWAYS(HAL_IsInterrupt() == false);
+
+	while ((err = HAL_I2C_WriteScatterAsync(addr, head, head_num, data, num, xfer_pending, NULL)) != HAL_OK)
+	{
+		if (err == HAL_ERROR_BUSY)
+		{
+			SYS_WAIT_FOR_INTERRUPT;
+		}
+		else
+		{
+			return err;
+		}
+	}
+
+	return HAL_I2C_WaitForTransfer();
+}
+
+int32_t HAL_I2C_WriteScatterAsync(uint32_t addr,
+		const uint8_t *head,
+		uint32_t head_num,
+		const uint8_t *data,
+		uint32_t num,
+		bool xfer_pending,
+		HAL_I2C_Callback cb)
+{
+	HAL_I2C_Init();
+
+	if (Driver_I2C0.GetStatus().busy != 0)
+	{
+		return HAL_ERROR_BUSY;
+	}
+
+	ctrl.transfer_data.addr = addr;
+	ctrl.transfer_data.data = (uint8_t*) ((head_num != 0U) ? head : data);
+	ctrl.transfer_data.num = 0U;
+	ctrl.callback = cb;
+
+	return I2C0_MasterTransmitScatter(addr, head, head_num, data, num, xfer_pending);
+}
+
 static int32_t HAL_I2C_WaitForTransfer(void)
 {
 	ARM_I2C_STATUS status;
@@ -127,7 +127,10 @@ static void I2Cx_MasterIRQHandler (const I2C_RESOURCES *i2c)
             {
                 if (i2c->xfer->cnt < i2c->xfer->num)
                 {
-                    I2C->DATA = i2c->xfer->data[i2c->xfer->cnt++];
+                    I2C->DATA = (i2c->xfer->cnt < i2c->xfer->head_num) ?
+                                i2c->xfer->data[i2c->xfer->cnt] :
+                                i2c->xfer->tail[i2c->xfer->cnt - i2c->xfer->head_num];
+                    i2c->xfer->cnt++;
                 }
 
                 if (i2c->xfer->cnt == i2c->xfer->num)
@@ -415,26 +418,38 @@ static int32_t I2C_PowerControl (ARM_POWER_STATE state,
 }
 
 /* ----------------------------------------------------------------------------
- * Function      : int32_t I2C_MasterTransmit (uint32_t addr,
- *                                             const uint8_t *data,
- *                                             uint32_t num, bool xfer_pending,
- *                                             const I2C_RESOURCES *i2c)
+ * Function      : int32_t I2C_MasterTransmitScatter (uint32_t addr,
+ *                                                    const uint8_t *head,
+ *                                                    uint32_t head_num,
+ *                                                    const uint8_t *tail,
+ *                                                    uint32_t tail_num,
+ *                                                    bool xfer_pending,
+ *                                                    const I2C_RESOURCES *i2c)
  * ----------------------------------------------------------------------------
- * Description   : Start transmitting data as I2C Master.
+ * Description   : Start transmitting data from two buffers as I2C Master.
+ *                 The bytes of tail follow the bytes of head within the same
+ *                 transfer, without a repeated start in between.
  * Inputs        : addr         - Slave address (7-bit)
- *                 data         - Pointer to data buffer to send to I2C Slave
- *                 num          - Number of data bytes to send
+ *                 head         - Pointer to first data buffer to send to I2C
+ *                                Slave, may be NULL if head_num is 0
+ *                 head_num     - Number of data bytes to send from head
+ *                 tail         - Pointer to second data buffer to send to I2C
+ *                                Slave, may be NULL if tail_num is 0
+ *                 tail_num     - Number of data bytes to send from tail
  *                 xfer_pending - Transfer operation is pending (Stop condition
  *                                will not be generated)
  *                 i2c          - Pointer to I2C resources
  * Outputs       : Execution status
  * Assumptions   : None
  * ------------------------------------------------------------------------- */
-static int32_t I2C_MasterTransmit (uint32_t addr, const uint8_t *data,
-                                   uint32_t num, bool xfer_pending,
-                                   const I2C_RESOURCES *i2c)
+static int32_t I2C_MasterTransmitScatter (uint32_t addr, const uint8_t *head,
+                                          uint32_t head_num, const uint8_t *tail,
+                                          uint32_t tail_num, bool xfer_pending,
+                                          const I2C_RESOURCES *i2c)
 {
-    if ((data == NULL) || (num == 0U) ||
+    if (((head == NULL) && (head_num != 0U)) ||
+        ((tail == NULL) && (tail_num != 0U)) ||
+        ((head_num + tail_num) == 0U) ||
         ((addr & ~ARM_I2C_ADDRESS_GC) > 0x7FU))
     {
         /* Invalid parameters */
@@ -462,11 +477,13 @@ static int32_t I2C_MasterTransmit (uint32_t addr, const uint8_t *data,
     i2c->info->status.direction        = I2C_STATUS_DIRECTION_TX;
 
     /* Set transfer info */
-    i2c->xfer->num     = num;
-    i2c->xfer->cnt     = 0U;
-    i2c->xfer->data    = (uint8_t *)data;
-    i2c->xfer->addr    = (uint8_t)(addr);
-    i2c->xfer->pending = xfer_pending;
+    i2c->xfer->num      = head_num + tail_num;
+    i2c->xfer->cnt      = 0U;
+    i2c->xfer->data     = (uint8_t *)head;
+    i2c->xfer->head_num = head_num;
+    i2c->xfer->tail     = tail;
+    i2c->xfer->addr     = (uint8_t)(addr);
+    i2c->xfer->pending  = xfer_pending;
 
     /* Disable slave mode and set clock prescaler */
     i2c->reg->CTRL0 = (((i2c->reg->CTRL0 & ~I2C_CTRL0_SPEED_Mask)   |
@@ -479,6 +496,35 @@ static int32_t I2C_MasterTransmit (uint32_t addr, const uint8_t *data,
     return ARM_DRIVER_OK;
 }
 
+/* ----------------------------------------------------------------------------
+ * Function      : int32_t I2C_MasterTransmit (uint32_t addr,
+ *                                             const uint8_t *data,
+ *                                             uint32_t num, bool xfer_pending,
+ *                                             const I2C_RESOURCES *i2c)
+ * ----------------------------------------------------------------------------
+ * Description   : Start transmitting data as I2C Master.
+ * Inputs        : addr         - Slave address (7-bit)
+ *                 data         - Pointer to data buffer to send to I2C Slave
+ *                 num          - Number of data bytes to send
+ *                 xfer_pending - Transfer operation is pending (Stop condition
+ *                                will not be generated)
+ *                 i2c          - Pointer to I2C resources
+ * Outputs       : Execution status
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static int32_t I2C_MasterTransmit (uint32_t addr, const uint8_t *data,
+                                   uint32_t num, bool xfer_pending,
+                                   const I2C_RESOURCES *i2c)
+{
+    if ((data == NULL) || (num == 0U))
+    {
+        /* Invalid parameters */
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    return I2C_MasterTransmitScatter(addr, data, num, NULL, 0U, xfer_pending, i2c);
+}
+
 /* ----------------------------------------------------------------------------
  * Function      : int32_t I2C_MasterReceive (uint32_t addr,
  *                                            uint8_t *data,
@@ -533,6 +579,8 @@ static int32_t I2C_MasterReceive (uint32_t addr, uint8_t *data,
     i2c->xfer->data    = (uint8_t *)data;
     i2c->xfer->addr    = (uint8_t)(addr);
     i2c->xfer->pending = xfer_pending;
+    i2c->xfer->head_num = num;
+    i2c->xfer->tail    = NULL;
 
     /* Disable slave mode and set clock prescaler */
     i2c->reg->CTRL0 = (((i2c->reg->CTRL0 & ~I2C_CTRL0_SPEED_Mask)   |
@@ -917,6 +965,11 @@ static int32_t I2C0_MasterTransmit (uint32_t addr, const uint8_t *data, uint32_t
     return I2C_MasterTransmit(addr, data, num, xfer_pending, &I2C0_Resources);
 }
 
+int32_t I2C0_MasterTransmitScatter (uint32_t addr, const uint8_t *head, uint32_t head_num, const uint8_t *tail, uint32_t tail_num, bool xfer_pending)
+{
+    return I2C_MasterTransmitScatter(addr, head, head_num, tail, tail_num, xfer_pending, &I2C0_Resources);
+}
+
 static int32_t I2C0_MasterReceive (uint32_t addr, uint8_t *data, uint32_t num, bool xfer_pending)
 {
     return I2C_MasterReceive(addr, data, num, xfer_pending, &I2C0_Resources);
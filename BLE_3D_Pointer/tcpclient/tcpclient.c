@@ -136,6 +136,39 @@ ATMO_TCP_CLIENT_Status_t ATMO_TCP_CLIENT_WriteBytes( ATMO_DriverInstanceHandle_t
 	return tcpClientInstances[instance]->WriteBytes( tcpClientInstancesData[instance], data, dataLen );
 }
 
+ATMO_TCP_CLIENT_Status_t ATMO_TCP_CLIENT_WriteV( ATMO_DriverInstanceHandle_t instance, const ATMO_TCP_CLIENT_Segment_t *segments, unsigned int numSegments )
+{
+	if ( !( instance < numTcpClientDriverInstances ) )
+	{
+		return ATMO_TCP_CLIENT_Status_Invalid;
+	}
+
+	if ( tcpClientInstances[instance]->WriteV != NULL )
+	{
+		return tcpClientInstances[instance]->WriteV( tcpClientInstancesData[instance], segments, numSegments );
+	}
+
+	// The connection is a byte stream, writing the segments one after the other is equivalent
+	unsigned int i;
+
+	for ( i = 0; i < numSegments; i++ )
+	{
+		if ( segments[i].dataLen == 0 )
+		{
+			continue;
+		}
+
+		ATMO_TCP_CLIENT_Status_t status = tcpClientInstances[instance]->WriteBytes( tcpClientInstancesData[instance], ( uint8_t * )segments[i].data, segments[i].dataLen );
+
+		if ( status != ATMO_TCP_CLIENT_Status_Success )
+		{
+			return status;
+		}
+	}
+
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
 ATMO_TCP_CLIENT_Status_t ATMO_TCP_CLIENT_SetReceiveCallback( ATMO_DriverInstanceHandle_t instance, ATMO_Callback_t cb )
 {
 	if ( !( instance < numTcpClientDriverInstances ) )
@@ -90,6 +90,16 @@ typedef enum
 	ATMO_TCP_CLIENT_Error /**< Internal error. */
 } ATMO_TCP_CLIENT_ConnectionStatus_t;
 
+/**
+ * @brief One piece of data for ATMO_TCP_CLIENT_WriteV
+ *
+ */
+typedef struct
+{
+	const uint8_t *data;
+	unsigned int dataLen;
+} ATMO_TCP_CLIENT_Segment_t;
+
 // Some C gore so we can use the struct within itself
 typedef struct ATMO_TCP_CLIENT_DriverInstance_t ATMO_TCP_CLIENT_DriverInstance_t;
 
@@ -104,6 +114,7 @@ struct ATMO_TCP_CLIENT_DriverInstance_t
 	ATMO_TCP_CLIENT_Status_t ( *WriteBytes )( ATMO_DriverInstanceData_t *instanceData, uint8_t *data, unsigned int dataLen );
 	ATMO_TCP_CLIENT_Status_t ( *SetReceiveCallback )( ATMO_DriverInstanceData_t *instanceData, ATMO_Callback_t cb );
 	ATMO_TCP_CLIENT_Status_t ( *GetNumAvailableBytes )( ATMO_DriverInstanceData_t *instanceData, uint32_t *numBytes, uint8_t **bytePtr );
+	ATMO_TCP_CLIENT_Status_t ( *WriteV )( ATMO_DriverInstanceData_t *instanceData, const ATMO_TCP_CLIENT_Segment_t *segments, unsigned int numSegments ); /**< Optional, can be NULL */
 };
 
 /* Exported Function Prototypes -----------------------------------------------*/
@@ -176,6 +187,17 @@ ATMO_TCP_CLIENT_Status_t ATMO_TCP_CLIENT_GetConnectionStatus( ATMO_DriverInstanc
 */
 ATMO_TCP_CLIENT_Status_t ATMO_TCP_CLIENT_WriteBytes( ATMO_DriverInstanceHandle_t instance, uint8_t *data, unsigned int dataLen );
 
+/**
+* Send several buffers to a TCP endpoint as one contiguous stream, without
+* copying them together first. Drivers that don't implement this get one
+* ATMO_TCP_CLIENT_WriteBytes call per segment.
+*
+* @param[in] instance
+* @param[in] segments
+* @param[in] numSegments
+*/
+ATMO_TCP_CLIENT_Status_t ATMO_TCP_CLIENT_WriteV( ATMO_DriverInstanceHandle_t instance, const ATMO_TCP_CLIENT_Segment_t *segments, unsigned int numSegments );
+
 /**
 * Set the receive callback function. There will be no data transferred. Use ATMO_TCP_CLIENT_ReadBytes to read the data.
 *
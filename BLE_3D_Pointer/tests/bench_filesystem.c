@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * @file    bench_filesystem.c
+ * @author
+ * @version
+ * @date
+ * @brief   Filesystem benchmark on a modelled NOR flash part
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Runs the filesystem bench on littlefs over a RAM block device that models a
+// 1 MiB NOR part with a 16 byte program size, once with the smallest cache the
+// part allows and once with the largest one. Prints the modelled flash time and
+// the flash traffic of each test, and fails if a test does not move the whole
+// file. The host uptime doesn't advance on its own, so there is no wall clock
+// time here, run the same bench on the target for that.
+
+#include "host/atmo_host.h"
+#include <string.h>
+#include "../filesystem/filesystem_bench.h"
+#include "../filesystem/filesystem_lfs.h"
+
+#define BENCH_BLOCK_SIZE (4096)
+#define BENCH_BLOCK_COUNT (256)
+#define BENCH_PROG_SIZE (16)
+#define BENCH_CHUNK_SIZE (256)
+#define BENCH_FILE_SIZE (64 * 1024)
+
+static const char *testNames[ATMO_FILESYSTEM_BENCH_NumTests] = { "seq write", "seq read", "rand write", "rand read" };
+static const uint32_t cacheSizes[] = { BENCH_PROG_SIZE, ATMO_LFS_MAX_CACHE_SIZE };
+
+static uint8_t flash[BENCH_BLOCK_SIZE * BENCH_BLOCK_COUNT];
+static uint8_t chunk[BENCH_CHUNK_SIZE];
+
+static void _BENCH_Print( const char *name, uint32_t cacheSize, const ATMO_FILESYSTEM_BENCH_Result_t *result )
+{
+	printf( "%-12s %6u | %8u %10.1f | %8u %8u %6u\n", name, cacheSize, result->bytes, result->busyUs / 1000.0,
+	        result->bytesRead, result->bytesProgrammed, result->numErases );
+}
+
+int main( int argc, char **argv )
+{
+	ATMO_RAM_BLOCK_Stats_t stats;
+	ATMO_RAM_BLOCK_Config_t blockConfig =
+	{
+		flash, BENCH_BLOCK_SIZE, BENCH_BLOCK_COUNT, BENCH_PROG_SIZE, 1,
+		5, 40, 45000, &stats
+	};
+	ATMO_DriverInstanceHandle_t blockInstance = 0;
+	ATMO_DriverInstanceHandle_t fsInstance = 0;
+
+	ATMO_HOST_CHECK( ATMO_RAM_BLOCK_AddDriverInstanceConfig( &blockInstance, &blockConfig ) == ATMO_Status_Success, "block device" );
+	ATMO_HOST_CHECK( ATMO_LFS_FILESYSTEM_AddDriverInstance( &fsInstance ) == ATMO_Status_Success, "filesystem" );
+	ATMO_BLOCK_Init( blockInstance );
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_Init( fsInstance, blockInstance ) == ATMO_FILESYSTEM_Status_Success, "filesystem init" );
+
+	printf( "%-12s %6s | %8s %10s | %8s %8s %6s\n", "test", "cache", "bytes", "flash ms", "read", "prog", "erase" );
+
+	for ( unsigned int i = 0; i < sizeof( cacheSizes ) / sizeof( cacheSizes[0] ); i++ )
+	{
+		ATMO_FILESYSTEM_Config_t fsConfig = { 1, 0, cacheSizes[i], 0 };
+		ATMO_FILESYSTEM_BENCH_Config_t config = { fsInstance, blockInstance, &stats, chunk, sizeof( chunk ), BENCH_FILE_SIZE, 1 };
+		ATMO_FILESYSTEM_BENCH_Results_t results;
+
+		// The cache can only change while unmounted, the bench leaves it mounted
+		ATMO_FILESYSTEM_Unmount( fsInstance );
+		ATMO_HOST_CHECK( ATMO_FILESYSTEM_SetConfiguration( fsInstance, &fsConfig ) == ATMO_FILESYSTEM_Status_Success, "cache size %u", cacheSizes[i] );
+		ATMO_HOST_CHECK( ATMO_FILESYSTEM_BENCH_Run( &config, &results ) == ATMO_FILESYSTEM_Status_Success, "bench run with a %u byte cache", cacheSizes[i] );
+
+		for ( unsigned int test = 0; test < ATMO_FILESYSTEM_BENCH_NumTests; test++ )
+		{
+			_BENCH_Print( testNames[test], cacheSizes[i], &results.io[test] );
+			ATMO_HOST_CHECK( results.io[test].bytes == BENCH_FILE_SIZE, "%s moved %u bytes", testNames[test], results.io[test].bytes );
+		}
+
+		for ( unsigned int step = 0; step < results.numMountSteps; step++ )
+		{
+			char name[16];
+			snprintf( name, sizeof( name ), "mount %u%%", results.mountFillPercent[step] );
+			_BENCH_Print( name, cacheSizes[i], &results.mount[step] );
+		}
+
+		ATMO_HOST_CHECK( results.numMountSteps > 0, "no mount timed" );
+	}
+
+	return 0;
+}
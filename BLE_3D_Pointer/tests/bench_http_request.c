@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ * @file    bench_http_request.c
+ * @author
+ * @version
+ * @date
+ * @brief   HTTP request builder benchmark
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Builds the requests the cloud driver sends, a batch POST of events and a
+// command GET, over and over and prints the time per request. Each request is
+// checked against the same request put together with snprintf, and a buffer
+// one byte too small must be refused. Configure with -DATMO_HOST_SANITIZE=OFF
+// for meaningful host times.
+
+#include "host/atmo_host.h"
+#include <string.h>
+#include <time.h>
+
+// The builder is static, so the driver is built into the bench
+#include "../http/http.c"
+
+#define BENCH_NUM_ITERATIONS (200000)
+#define BENCH_TOKEN "0123456789abcdef0123456789abcdef01234567"
+#define BENCH_UUID "8a6f1c2e-4b3d-4e5f-9a7b-1c2d3e4f5a6b"
+#define BENCH_HOST "api.example.com"
+
+static uint8_t buf[1024];
+static char expected[1024];
+
+static uint64_t _BENCH_Nanoseconds( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return ( uint64_t )now.tv_sec * 1000000000ull + ( uint64_t )now.tv_nsec;
+}
+
+static uint32_t _BENCH_Build( ATMO_HTTP_Transaction_t *transaction, uint8_t *dest, uint32_t destSize )
+{
+	ATMO_BOOL_t isHttps = false;
+	unsigned int port = 0;
+	const char *host = NULL;
+	unsigned int hostLen = 0;
+	char *path = NULL;
+	unsigned int pathLen = 0;
+
+	_ATMO_HTTP_ParseUrl( transaction->url, &isHttps, &port, &host, &hostLen, &path, &pathLen );
+	return _ATMO_HTTP_BuildRequest( dest, destSize, transaction, host, hostLen, path, pathLen );
+}
+
+static void _BENCH_Run( const char *name, ATMO_HTTP_Transaction_t *transaction )
+{
+	const char *path = strstr( transaction->url + strlen( "https://" ), "/" );
+	int expectedLen;
+
+	if ( transaction->method == ATMO_HTTP_POST )
+	{
+		expectedLen = snprintf( expected, sizeof( expected ), "POST %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Type: %s\r\nContent-Length: %u\r\n%s: %s\r\n\r\n",
+		                        path, BENCH_HOST, transaction->contentType, transaction->dataLen, transaction->headerOverlay[0].headerKey, transaction->headerOverlay[0].headerValue );
+	}
+	else
+	{
+		expectedLen = snprintf( expected, sizeof( expected ), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n%s: %s\r\n\r\n",
+		                        path, BENCH_HOST, transaction->headerOverlay[0].headerKey, transaction->headerOverlay[0].headerValue );
+	}
+
+	uint32_t len = _BENCH_Build( transaction, buf, sizeof( buf ) );
+	ATMO_HOST_CHECK( len == ( uint32_t )expectedLen && memcmp( buf, expected, len ) == 0, "%s is '%.*s'", name, ( int )len, buf );
+
+	// The last byte of the buffer is never used
+	ATMO_HOST_CHECK( _BENCH_Build( transaction, buf, len + 1 ) == len, "%s doesn't fit in %u bytes", name, len + 1 );
+	ATMO_HOST_CHECK( _BENCH_Build( transaction, buf, len ) == 0, "%s overflows %u bytes", name, len );
+
+	uint64_t start = _BENCH_Nanoseconds();
+	uint32_t total = 0;
+
+	for ( int i = 0; i < BENCH_NUM_ITERATIONS; i++ )
+	{
+		total += _BENCH_Build( transaction, buf, sizeof( buf ) );
+	}
+
+	uint64_t elapsed = _BENCH_Nanoseconds() - start;
+	ATMO_HOST_CHECK( total == len * BENCH_NUM_ITERATIONS, "%s length changed", name );
+	printf( "%-12s %6u %10.1f\n", name, len, ( double )elapsed / BENCH_NUM_ITERATIONS );
+}
+
+int main( int argc, char **argv )
+{
+	static const char body[] = "[{\"ts\":1700000000,\"v\":{\"x\":1.5,\"y\":-2.25,\"z\":0.125}}]";
+	ATMO_HTTP_Header_t header = { "cloud", BENCH_TOKEN };
+
+	ATMO_HTTP_Transaction_t post = { "https://" BENCH_HOST "/thing/" BENCH_UUID "/events", ATMO_HTTP_POST, "application/json", body, sizeof( body ) - 1, &header, 1 };
+	ATMO_HTTP_Transaction_t get = { "https://" BENCH_HOST "/thing/" BENCH_UUID "/commands/pop?wait=30000", ATMO_HTTP_GET, NULL, NULL, 0, &header, 1 };
+
+	printf( "%-12s %6s %10s\n", "request", "bytes", "ns" );
+	_BENCH_Run( "event post", &post );
+	_BENCH_Run( "command get", &get );
+
+	return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ ******************************************************************************
+ * @file    bench_samplecodec.c
+ * @author
+ * @version
+ * @date
+ * @brief   Sample codec benchmark on synthetic sensor traces
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Runs the sample codec bench on orientation, accelerometer and gyro traces
+// shaped like the BHI160 output at the rates the app uses, with stretches of
+// the device lying still and being moved. Prints the size against raw and
+// float samples and the time per sample, and fails if a trace does not round
+// trip or does not compress. Configure with -DATMO_HOST_SANITIZE=OFF for
+// meaningful host times, and run the same bench on the target for cycle counts.
+
+#include "host/atmo_host.h"
+#include <math.h>
+#include <time.h>
+#include "../atmo/atmo_samplecodec_bench.h"
+
+#define BENCH_NUM_SAMPLES (50000)
+
+typedef enum
+{
+	BENCH_Trace_Orientation,
+	BENCH_Trace_Accel,
+	BENCH_Trace_Gyro,
+	BENCH_Trace_Count,
+} BENCH_Trace_t;
+
+static const char *traceNames[BENCH_Trace_Count] = { "orientation", "accel", "gyro" };
+static const int traceRatesHz[] = { 10, 50, 100 };
+
+// A log chunk payload and a full BLE frame payload
+static const uint32_t blockSizes[] = { 61, 120 };
+
+static ATMO_SAMPLECODEC_Sample_t trace[BENCH_NUM_SAMPLES];
+
+static uint32_t _BENCH_Nanoseconds( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return ( uint32_t )( ( uint64_t )now.tv_sec * 1000000000ull + ( uint64_t )now.tv_nsec );
+}
+
+static double _BENCH_Normal( void )
+{
+	double u = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+	double v = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+	return sqrt( -2.0 * log( u ) ) * cos( 2.0 * M_PI * v );
+}
+
+static int16_t _BENCH_Clamp( double value )
+{
+	return ( value > 32767 ) ? 32767 : ( value < -32768 ) ? -32768 : ( int16_t )lrint( value );
+}
+
+static void _BENCH_Generate( BENCH_Trace_t kind, int rateHz )
+{
+	double phase = 0, heading = 0, pitch = 0, roll = 0, headingRate = 0;
+	uint32_t timeMs = 1000;
+
+	for ( int i = 0; i < BENCH_NUM_SAMPLES; i++ )
+	{
+		// 10 s still, then 20 s moving, with the usual timer jitter
+		ATMO_BOOL_t moving = ( ( i / ( rateHz * 10 ) ) % 3 ) != 0;
+		timeMs += 1000 / rateHz + ( rand() % 3 - 1 );
+		trace[i].timeMs = timeMs;
+
+		switch ( kind )
+		{
+			case BENCH_Trace_Orientation:
+			{
+				// 360 degrees is 32768, heading wraps
+				headingRate = ( headingRate + ( moving ? _BENCH_Normal() * 0.3 : 0 ) ) * 0.98;
+				heading += headingRate;
+				pitch = ( pitch + ( moving ? _BENCH_Normal() * 0.5 : 0 ) ) * 0.995;
+				roll = ( roll + ( moving ? _BENCH_Normal() * 0.5 : 0 ) ) * 0.995;
+				int wrapped = ( ( int )lrint( heading * 32768 / 360.0 ) ) % 32768;
+				trace[i].x = ( int16_t )( ( wrapped < 0 ) ? wrapped + 32768 : wrapped );
+				trace[i].y = _BENCH_Clamp( pitch * 32768 / 360.0 );
+				trace[i].z = _BENCH_Clamp( roll * 32768 / 360.0 );
+				break;
+			}
+
+			case BENCH_Trace_Accel:
+			{
+				// 4g range, 1g is 8192
+				double motion = moving ? sin( phase ) * 2000 + _BENCH_Normal() * 300 : 0;
+				phase += 0.2;
+				trace[i].x = _BENCH_Clamp( motion + _BENCH_Normal() * 15 );
+				trace[i].y = _BENCH_Clamp( motion * 0.5 + _BENCH_Normal() * 15 );
+				trace[i].z = _BENCH_Clamp( 8192 + motion * 0.3 + _BENCH_Normal() * 15 );
+				break;
+			}
+
+			default:
+			{
+				double motion = moving ? sin( phase ) * 3000 : 0;
+				phase += 0.05;
+				trace[i].x = _BENCH_Clamp( motion + _BENCH_Normal() * 8 );
+				trace[i].y = _BENCH_Clamp( -motion * 0.3 + _BENCH_Normal() * 8 );
+				trace[i].z = _BENCH_Clamp( _BENCH_Normal() * 8 );
+				break;
+			}
+		}
+	}
+}
+
+int main( int argc, char **argv )
+{
+	static uint8_t buf[256];
+
+	printf( "%-12s %4s %6s | %7s %7s %7s | %8s %8s\n", "trace", "Hz", "block", "B/smp", "vs raw", "vs flt", "enc ns", "dec ns" );
+
+	for ( int kind = 0; kind < BENCH_Trace_Count; kind++ )
+	{
+		for ( unsigned int rate = 0; rate < sizeof( traceRatesHz ) / sizeof( traceRatesHz[0] ); rate++ )
+		{
+			srand( kind * 10 + rate );
+			_BENCH_Generate( ( BENCH_Trace_t )kind, traceRatesHz[rate] );
+
+			for ( unsigned int size = 0; size < sizeof( blockSizes ) / sizeof( blockSizes[0] ); size++ )
+			{
+				ATMO_SAMPLECODEC_BENCH_Config_t config = { trace, BENCH_NUM_SAMPLES, buf, blockSizes[size], _BENCH_Nanoseconds };
+				ATMO_SAMPLECODEC_BENCH_Results_t results;
+
+				ATMO_HOST_CHECK( ATMO_SAMPLECODEC_BENCH_Run( &config, &results ) == ATMO_Status_Success, "bench run" );
+				printf( "%-12s %4d %6u | %7.2f %6.2fx %6.2fx | %8.1f %8.1f\n", traceNames[kind], traceRatesHz[rate], blockSizes[size],
+				        ( double )results.blockBytes / BENCH_NUM_SAMPLES, ( double )results.rawBytes / results.blockBytes,
+				        ( double )results.floatBytes / results.blockBytes, ( double )results.encodeTicks / BENCH_NUM_SAMPLES,
+				        ( double )results.decodeTicks / BENCH_NUM_SAMPLES );
+
+				ATMO_HOST_CHECK( results.match, "%s at %d Hz does not round trip", traceNames[kind], traceRatesHz[rate] );
+				ATMO_HOST_CHECK( results.blockBytes < results.rawBytes, "%s at %d Hz is bigger than raw", traceNames[kind], traceRatesHz[rate] );
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ * @file    atmo_host.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Host test platform
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __ATMO_HOST__H
+#define __ATMO_HOST__H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../app_src/atmosphere_platform.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+
+// Report and exit on the first failed check, ctest picks up the exit status
+#define ATMO_HOST_CHECK( cond, ... ) \
+	do \
+	{ \
+		if ( !( cond ) ) \
+		{ \
+			printf( "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond ); \
+			printf( __VA_ARGS__ ); \
+			printf( "\n" ); \
+			exit( 1 ); \
+		} \
+	} while ( 0 )
+
+/* Exported Function Prototypes -----------------------------------------------*/
+
+/**
+ * Move the simulated uptime forward
+ *
+ * Uptime only moves when a test asks it to, or when the code under test calls
+ * ATMO_PLATFORM_DelayMilliseconds.
+ *
+ * @param[in] milliseconds
+ */
+void ATMO_HOST_AdvanceMs( uint32_t milliseconds );
+
+/**
+ * Start the simulated uptime from zero again, as after a reboot
+ */
+void ATMO_HOST_ResetUptime( void );
+
+/**
+ * Run the core tick until done is set, one simulated millisecond per tick
+ *
+ * Sleeps a little real time between ticks so sockets and server threads
+ * can make progress.
+ *
+ * @param[in] done
+ * @param[in] maxMs - Simulated time to give up after
+ * @return true if done was set in time
+ */
+ATMO_BOOL_t ATMO_HOST_RunUntil( volatile ATMO_BOOL_t *done, uint32_t maxMs );
+
+/**
+ * Seed for the randomised tests, from the first argument or ATMO_HOST_SEED
+ *
+ * @param[in] argc
+ * @param[in] argv
+ * @return seed
+ */
+unsigned int ATMO_HOST_Seed( int argc, char **argv );
+
+#endif
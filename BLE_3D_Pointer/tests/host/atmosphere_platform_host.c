@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ * @file    atmosphere_platform_host.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Host test platform
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "atmo_host.h"
+#include <stdarg.h>
+#include <unistd.h>
+#include "../../app_src/atmosphere_variantSetup.h"
+#include "../../app_src/atmosphere_elementSetup.h"
+#include "../../app_src/atmosphere_callbacks.h"
+#include "../../app_src/atmosphere_abilityHandler.h"
+
+static uint64_t _ATMO_HOST_UptimeMs = 0;
+
+void ATMO_HOST_Trace( const char *format, ... )
+{
+	if ( getenv( "ATMO_HOST_TRACE" ) == NULL )
+	{
+		return;
+	}
+
+	va_list args;
+	va_start( args, format );
+	vprintf( format, args );
+	va_end( args );
+}
+
+void ATMO_HOST_AdvanceMs( uint32_t milliseconds )
+{
+	_ATMO_HOST_UptimeMs += milliseconds;
+}
+
+void ATMO_HOST_ResetUptime( void )
+{
+	_ATMO_HOST_UptimeMs = 0;
+}
+
+ATMO_BOOL_t ATMO_HOST_RunUntil( volatile ATMO_BOOL_t *done, uint32_t maxMs )
+{
+	for ( uint32_t i = 0; i < maxMs && !*done; i++ )
+	{
+		ATMO_Tick();
+		ATMO_HOST_AdvanceMs( 1 );
+		usleep( 100 );
+	}
+
+	return *done;
+}
+
+unsigned int ATMO_HOST_Seed( int argc, char **argv )
+{
+	const char *seed = ( argc > 1 ) ? argv[1] : getenv( "ATMO_HOST_SEED" );
+	unsigned int value = ( seed != NULL ) ? ( unsigned int )strtoul( seed, NULL, 0 ) : 1;
+	printf( "seed %u\n", value );
+	return value;
+}
+
+void ATMO_PLATFORM_Init()
+{
+}
+
+void ATMO_PLATFORM_PostInit()
+{
+}
+
+void ATMO_PLATFORM_VariantSetup()
+{
+}
+
+void ATMO_ElementSetup()
+{
+}
+
+void ATMO_Setup()
+{
+}
+
+void ATMO_AbilityHandler( unsigned int abilityHandleId, ATMO_Value_t *value )
+{
+}
+
+void ATMO_PLATFORM_DelayMilliseconds( uint32_t milliseconds )
+{
+	_ATMO_HOST_UptimeMs += milliseconds;
+
+	// Give the server threads a moment, at the same pace as ATMO_HOST_RunUntil
+	usleep( 100 );
+}
+
+void *ATMO_Malloc( uint32_t numBytes )
+{
+	return malloc( numBytes );
+}
+
+void *ATMO_Calloc( size_t num, size_t size )
+{
+	return calloc( num, size );
+}
+
+void ATMO_Free( void *data )
+{
+	free( data );
+}
+
+void ATMO_Lock()
+{
+
+}
+
+void ATMO_Unlock()
+{
+
+}
+
+uint64_t ATMO_PLATFORM_UptimeMs()
+{
+	return _ATMO_HOST_UptimeMs;
+}
+
+uint32_t ATMO_PLATFORM_GetBattLevel()
+{
+	return 100;
+}
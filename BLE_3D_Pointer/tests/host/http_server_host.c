@@ -0,0 +1,275 @@
+/**
+ ******************************************************************************
+ * @file    http_server_host.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Scripted local HTTP server for host tests
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "http_server_host.h"
+#include <string.h>
+#include <strings.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Long enough apart that the client reads the fragments as separate packets
+#define ATMO_HOST_HTTP_SERVER_FRAGMENT_GAP_US (3000)
+
+typedef struct
+{
+	int fd;
+	char request[ATMO_HOST_HTTP_SERVER_MAX_REQUEST_LEN + 1];
+	unsigned int requestLen;
+} ATMO_HOST_HTTP_SERVER_Conn_t;
+
+typedef struct
+{
+	int listenFd;
+	pthread_t thread;
+	volatile ATMO_BOOL_t stop;
+	ATMO_HOST_HTTP_SERVER_Handler_t handler;
+	void *arg;
+	ATMO_HOST_HTTP_SERVER_Conn_t conns[ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS];
+	volatile unsigned int numAccepted;
+	volatile unsigned int numRequests;
+} ATMO_HOST_HTTP_SERVER_State_t;
+
+static ATMO_HOST_HTTP_SERVER_State_t _ATMO_HOST_HTTP_SERVER_State;
+
+static void _ATMO_HOST_HTTP_SERVER_Close( ATMO_HOST_HTTP_SERVER_Conn_t *conn )
+{
+	close( conn->fd );
+	conn->fd = -1;
+	conn->requestLen = 0;
+}
+
+/**
+ * Answer the request at the start of the connection's buffer, if it is complete
+ *
+ * @return true if a request was handled
+ */
+static ATMO_BOOL_t _ATMO_HOST_HTTP_SERVER_Handle( ATMO_HOST_HTTP_SERVER_Conn_t *conn )
+{
+	ATMO_HOST_HTTP_SERVER_State_t *state = &_ATMO_HOST_HTTP_SERVER_State;
+	conn->request[conn->requestLen] = '\0';
+
+	char *headerEnd = strstr( conn->request, "\r\n\r\n" );
+
+	if ( headerEnd == NULL )
+	{
+		return false;
+	}
+
+	unsigned int headerLen = ( unsigned int )( headerEnd - conn->request ) + 4;
+	unsigned int bodyLen = 0;
+
+	for ( char *line = strstr( conn->request, "\r\n" ); line != NULL && line < headerEnd; line = strstr( line + 2, "\r\n" ) )
+	{
+		if ( strncasecmp( line + 2, "Content-Length:", 15 ) == 0 )
+		{
+			bodyLen = ( unsigned int )strtoul( line + 17, NULL, 10 );
+		}
+	}
+
+	if ( conn->requestLen < headerLen + bodyLen )
+	{
+		return false;
+	}
+
+	char method[16] = "";
+	char path[512] = "";
+	char body[ATMO_HOST_HTTP_SERVER_MAX_REQUEST_LEN + 1];
+	sscanf( conn->request, "%15s %511s", method, path );
+	memcpy( body, &conn->request[headerLen], bodyLen );
+	body[bodyLen] = '\0';
+
+	// Keep anything pipelined behind this request
+	conn->requestLen -= headerLen + bodyLen;
+	memmove( conn->request, &conn->request[headerLen + bodyLen], conn->requestLen );
+
+	ATMO_HOST_HTTP_SERVER_Reply_t reply;
+	memset( &reply, 0, sizeof( reply ) );
+	state->handler( method, path, body, bodyLen, &reply, state->arg );
+	state->numRequests++;
+
+	for ( unsigned int i = 0; i < ATMO_HOST_HTTP_SERVER_MAX_FRAGMENTS && reply.fragments[i] != NULL; i++ )
+	{
+		if ( i > 0 )
+		{
+			usleep( ATMO_HOST_HTTP_SERVER_FRAGMENT_GAP_US );
+		}
+
+		send( conn->fd, reply.fragments[i], strlen( reply.fragments[i] ), MSG_NOSIGNAL );
+	}
+
+	if ( reply.close )
+	{
+		_ATMO_HOST_HTTP_SERVER_Close( conn );
+	}
+
+	return true;
+}
+
+static void *_ATMO_HOST_HTTP_SERVER_Thread( void *arg )
+{
+	ATMO_HOST_HTTP_SERVER_State_t *state = &_ATMO_HOST_HTTP_SERVER_State;
+
+	while ( !state->stop )
+	{
+		struct pollfd fds[ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS + 1];
+		fds[0].fd = state->listenFd;
+		fds[0].events = POLLIN;
+
+		for ( unsigned int i = 0; i < ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS; i++ )
+		{
+			fds[i + 1].fd = state->conns[i].fd;
+			fds[i + 1].events = POLLIN;
+		}
+
+		if ( poll( fds, ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS + 1, 10 ) <= 0 )
+		{
+			continue;
+		}
+
+		if ( fds[0].revents & POLLIN )
+		{
+			int fd = accept( state->listenFd, NULL, NULL );
+			int noDelay = 1;
+
+			// Don't let Nagle merge the fragments
+			setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof( noDelay ) );
+
+			for ( unsigned int i = 0; i < ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS && fd >= 0; i++ )
+			{
+				if ( state->conns[i].fd < 0 )
+				{
+					state->conns[i].fd = fd;
+					state->conns[i].requestLen = 0;
+					state->numAccepted++;
+					fd = -1;
+				}
+			}
+
+			if ( fd >= 0 )
+			{
+				close( fd );
+			}
+		}
+
+		for ( unsigned int i = 0; i < ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS; i++ )
+		{
+			ATMO_HOST_HTTP_SERVER_Conn_t *conn = &state->conns[i];
+
+			if ( conn->fd < 0 || fds[i + 1].fd != conn->fd || !( fds[i + 1].revents & ( POLLIN | POLLHUP | POLLERR ) ) )
+			{
+				continue;
+			}
+
+			ssize_t received = recv( conn->fd, &conn->request[conn->requestLen], ATMO_HOST_HTTP_SERVER_MAX_REQUEST_LEN - conn->requestLen, 0 );
+
+			if ( received <= 0 )
+			{
+				_ATMO_HOST_HTTP_SERVER_Close( conn );
+				continue;
+			}
+
+			conn->requestLen += ( unsigned int )received;
+
+			while ( conn->fd >= 0 && _ATMO_HOST_HTTP_SERVER_Handle( conn ) )
+			{
+			}
+		}
+	}
+
+	return NULL;
+}
+
+unsigned int ATMO_HOST_HTTP_SERVER_Start( ATMO_HOST_HTTP_SERVER_Handler_t handler, void *arg )
+{
+	ATMO_HOST_HTTP_SERVER_State_t *state = &_ATMO_HOST_HTTP_SERVER_State;
+	struct sockaddr_in addr;
+	socklen_t addrLen = sizeof( addr );
+
+	memset( state, 0, sizeof( *state ) );
+	state->handler = handler;
+	state->arg = arg;
+
+	for ( unsigned int i = 0; i < ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS; i++ )
+	{
+		state->conns[i].fd = -1;
+	}
+
+	memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	addr.sin_port = 0;
+
+	state->listenFd = socket( AF_INET, SOCK_STREAM, 0 );
+	ATMO_HOST_CHECK( state->listenFd >= 0, "socket" );
+	ATMO_HOST_CHECK( bind( state->listenFd, ( struct sockaddr * )&addr, sizeof( addr ) ) == 0, "bind" );
+	ATMO_HOST_CHECK( listen( state->listenFd, 4 ) == 0, "listen" );
+	getsockname( state->listenFd, ( struct sockaddr * )&addr, &addrLen );
+
+	ATMO_HOST_CHECK( pthread_create( &state->thread, NULL, _ATMO_HOST_HTTP_SERVER_Thread, NULL ) == 0, "server thread" );
+	return ntohs( addr.sin_port );
+}
+
+void ATMO_HOST_HTTP_SERVER_Stop( void )
+{
+	ATMO_HOST_HTTP_SERVER_State_t *state = &_ATMO_HOST_HTTP_SERVER_State;
+	state->stop = true;
+	pthread_join( state->thread, NULL );
+
+	for ( unsigned int i = 0; i < ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS; i++ )
+	{
+		if ( state->conns[i].fd >= 0 )
+		{
+			_ATMO_HOST_HTTP_SERVER_Close( &state->conns[i] );
+		}
+	}
+
+	close( state->listenFd );
+}
+
+unsigned int ATMO_HOST_HTTP_SERVER_NumAccepted( void )
+{
+	return _ATMO_HOST_HTTP_SERVER_State.numAccepted;
+}
+
+unsigned int ATMO_HOST_HTTP_SERVER_NumRequests( void )
+{
+	return _ATMO_HOST_HTTP_SERVER_State.numRequests;
+}
@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ * @file    http_server_host.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Scripted local HTTP server for host tests
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __ATMO_HOST_HTTP_SERVER__H
+#define __ATMO_HOST_HTTP_SERVER__H
+
+#include "atmo_host.h"
+
+#define ATMO_HOST_HTTP_SERVER_MAX_FRAGMENTS (8)
+#define ATMO_HOST_HTTP_SERVER_MAX_CONNECTIONS (4)
+#define ATMO_HOST_HTTP_SERVER_MAX_REQUEST_LEN (4096)
+
+typedef struct
+{
+	const char *fragments[ATMO_HOST_HTTP_SERVER_MAX_FRAGMENTS]; /**< Sent in order as separate packets, up to the first NULL. None leaves the request unanswered */
+	ATMO_BOOL_t close; /**< Close the connection after the reply */
+} ATMO_HOST_HTTP_SERVER_Reply_t;
+
+/**
+ * Called on the server thread for every complete request. The fragments must
+ * stay valid until the next request.
+ */
+typedef void ( *ATMO_HOST_HTTP_SERVER_Handler_t )( const char *method, const char *path, const char *body, unsigned int bodyLen, ATMO_HOST_HTTP_SERVER_Reply_t *reply, void *arg );
+
+/**
+ * Start serving on a free port of 127.0.0.1
+ *
+ * @param[in] handler
+ * @param[in] arg - Passed to the handler
+ * @return port
+ */
+unsigned int ATMO_HOST_HTTP_SERVER_Start( ATMO_HOST_HTTP_SERVER_Handler_t handler, void *arg );
+
+/**
+ * Close every connection and stop the server thread
+ */
+void ATMO_HOST_HTTP_SERVER_Stop( void );
+
+/**
+ * @return Connections accepted since the server started
+ */
+unsigned int ATMO_HOST_HTTP_SERVER_NumAccepted( void );
+
+/**
+ * @return Requests handled since the server started
+ */
+unsigned int ATMO_HOST_HTTP_SERVER_NumRequests( void );
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __HOST_BDK_TASK_H
+#define __HOST_BDK_TASK_H
+
+// Host build stand-in, the SDK header is not needed off target
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __HOST_APP_TIMER_H
+#define __HOST_APP_TIMER_H
+
+// Host build stand-in, the SDK header is not needed off target
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef __HOST_APP_TRACE_H
+#define __HOST_APP_TRACE_H
+
+// Host build stand-in, traces go to stdout when ATMO_HOST_TRACE is set
+
+void ATMO_HOST_Trace( const char *format, ... );
+
+#define TRACE_PRINTF ATMO_HOST_Trace
+
+#endif
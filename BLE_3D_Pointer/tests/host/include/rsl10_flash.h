@@ -0,0 +1,28 @@
+#ifndef __HOST_RSL10_FLASH_H
+#define __HOST_RSL10_FLASH_H
+
+#include <stdint.h>
+
+// Host build stand-in for the flash controller registers
+
+typedef struct
+{
+	volatile uint32_t MAIN_CTRL;
+	volatile uint32_t MAIN_WRITE_UNLOCK;
+	volatile uint32_t NVR_CTRL;
+	volatile uint32_t NVR_WRITE_UNLOCK;
+} FLASH_Type;
+
+extern FLASH_Type ATMO_HOST_FlashRegs;
+
+#define FLASH (&ATMO_HOST_FlashRegs)
+
+#define MAIN_LOW_W_ENABLE 1
+#define MAIN_MIDDLE_W_ENABLE 2
+#define MAIN_HIGH_W_ENABLE 4
+#define MAIN_LOW_W_DISABLE 0
+#define MAIN_MIDDLE_W_DISABLE 0
+#define MAIN_HIGH_W_DISABLE 0
+#define FLASH_MAIN_KEY 0
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef __HOST_RSL10_FLASH_ROM_H
+#define __HOST_RSL10_FLASH_ROM_H
+
+#include <stdint.h>
+
+// Host build stand-in, tests provide the flash routines
+
+typedef int FlashStatus;
+
+#define FLASH_ERR_NONE 0
+
+FlashStatus Flash_WriteWordPair( uint32_t addr, uint32_t word0, uint32_t word1 );
+
+FlashStatus Flash_EraseSector( uint32_t addr );
+
+#endif
@@ -0,0 +1,282 @@
+/**
+ ******************************************************************************
+ * @file    tcpclient_host.c
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Host TCP client driver on POSIX sockets
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "tcpclient_host.h"
+#include "atmo_host.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define ATMO_HOST_TCP_CLIENT_RX_SIZE (512)
+
+typedef struct
+{
+	int fd; /**< -1 when not connected */
+	ATMO_Callback_t rxCb;
+	uint8_t rxBuf[ATMO_HOST_TCP_CLIENT_RX_SIZE];
+	uint32_t rxLen;
+} ATMO_HOST_TCP_CLIENT_State_t;
+
+static ATMO_HOST_TCP_CLIENT_State_t _ATMO_HOST_TCP_CLIENT_States[ATMO_HOST_TCP_CLIENT_NUM_INSTANCES];
+static ATMO_DriverInstanceData_t _ATMO_HOST_TCP_CLIENT_Data[ATMO_HOST_TCP_CLIENT_NUM_INSTANCES];
+static unsigned int _ATMO_HOST_TCP_CLIENT_NumInstances = 0;
+static ATMO_TCP_CLIENT_Segment_t _ATMO_HOST_TCP_CLIENT_LastWrite[ATMO_HOST_TCP_CLIENT_MAX_SEGMENTS];
+static unsigned int _ATMO_HOST_TCP_CLIENT_LastWriteNumSegments = 0;
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_Init( ATMO_DriverInstanceData_t *instanceData );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_DeInit( ATMO_DriverInstanceData_t *instanceData );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_SetConfiguration( ATMO_DriverInstanceData_t *instanceData, const ATMO_TCP_CLIENT_Config_t *config );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_Connect( ATMO_DriverInstanceData_t *instanceData, const char *host, unsigned int port, ATMO_BOOL_t useSSL );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_Disconnect( ATMO_DriverInstanceData_t *instanceData );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_GetConnectionStatus( ATMO_DriverInstanceData_t *instanceData, ATMO_TCP_CLIENT_ConnectionStatus_t *status );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_WriteBytes( ATMO_DriverInstanceData_t *instanceData, uint8_t *data, unsigned int dataLen );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_SetReceiveCallback( ATMO_DriverInstanceData_t *instanceData, ATMO_Callback_t cb );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_GetNumAvailableBytes( ATMO_DriverInstanceData_t *instanceData, uint32_t *numBytes, uint8_t **bytePtr );
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_WriteV( ATMO_DriverInstanceData_t *instanceData, const ATMO_TCP_CLIENT_Segment_t *segments, unsigned int numSegments );
+
+static const ATMO_TCP_CLIENT_DriverInstance_t _ATMO_HOST_TCP_CLIENT_Driver =
+{
+	ATMO_HOST_TCP_CLIENT_Init,
+	ATMO_HOST_TCP_CLIENT_DeInit,
+	ATMO_HOST_TCP_CLIENT_SetConfiguration,
+	ATMO_HOST_TCP_CLIENT_Connect,
+	ATMO_HOST_TCP_CLIENT_Disconnect,
+	ATMO_HOST_TCP_CLIENT_GetConnectionStatus,
+	ATMO_HOST_TCP_CLIENT_WriteBytes,
+	ATMO_HOST_TCP_CLIENT_SetReceiveCallback,
+	ATMO_HOST_TCP_CLIENT_GetNumAvailableBytes,
+	ATMO_HOST_TCP_CLIENT_WriteV
+};
+
+static ATMO_HOST_TCP_CLIENT_State_t *_ATMO_HOST_TCP_CLIENT_GetState( ATMO_DriverInstanceData_t *instanceData )
+{
+	return ( ATMO_HOST_TCP_CLIENT_State_t * )instanceData->argument;
+}
+
+static void _ATMO_HOST_TCP_CLIENT_Close( ATMO_HOST_TCP_CLIENT_State_t *state )
+{
+	if ( state->fd >= 0 )
+	{
+		close( state->fd );
+		state->fd = -1;
+	}
+}
+
+static void _ATMO_HOST_TCP_CLIENT_Tick( void *data )
+{
+	for ( unsigned int i = 0; i < _ATMO_HOST_TCP_CLIENT_NumInstances; i++ )
+	{
+		ATMO_HOST_TCP_CLIENT_State_t *state = &_ATMO_HOST_TCP_CLIENT_States[i];
+
+		if ( state->fd < 0 )
+		{
+			continue;
+		}
+
+		ssize_t received = recv( state->fd, state->rxBuf, sizeof( state->rxBuf ), MSG_DONTWAIT );
+
+		if ( received == 0 || ( received < 0 && errno != EAGAIN && errno != EWOULDBLOCK ) )
+		{
+			_ATMO_HOST_TCP_CLIENT_Close( state );
+		}
+		else if ( received > 0 )
+		{
+			state->rxLen = ( uint32_t )received;
+
+			if ( state->rxCb != NULL )
+			{
+				state->rxCb( NULL );
+			}
+
+			state->rxLen = 0;
+		}
+	}
+}
+
+ATMO_Status_t ATMO_HOST_TCP_CLIENT_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber )
+{
+	if ( _ATMO_HOST_TCP_CLIENT_NumInstances >= ATMO_HOST_TCP_CLIENT_NUM_INSTANCES )
+	{
+		return ATMO_Status_OutOfMemory;
+	}
+
+	if ( _ATMO_HOST_TCP_CLIENT_NumInstances == 0 )
+	{
+		ATMO_AddTickCallback( _ATMO_HOST_TCP_CLIENT_Tick );
+	}
+
+	ATMO_HOST_TCP_CLIENT_State_t *state = &_ATMO_HOST_TCP_CLIENT_States[_ATMO_HOST_TCP_CLIENT_NumInstances];
+	ATMO_DriverInstanceData_t *driver = &_ATMO_HOST_TCP_CLIENT_Data[_ATMO_HOST_TCP_CLIENT_NumInstances];
+	memset( state, 0, sizeof( *state ) );
+	state->fd = -1;
+
+	driver->name = "Host TCP Client";
+	driver->initialized = false;
+	driver->instanceNumber = _ATMO_HOST_TCP_CLIENT_NumInstances;
+	driver->argument = state;
+	_ATMO_HOST_TCP_CLIENT_NumInstances++;
+
+	return ATMO_TCP_CLIENT_AddDriverInstance( &_ATMO_HOST_TCP_CLIENT_Driver, driver, instanceNumber );
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_Init( ATMO_DriverInstanceData_t *instanceData )
+{
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_DeInit( ATMO_DriverInstanceData_t *instanceData )
+{
+	_ATMO_HOST_TCP_CLIENT_Close( _ATMO_HOST_TCP_CLIENT_GetState( instanceData ) );
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_SetConfiguration( ATMO_DriverInstanceData_t *instanceData, const ATMO_TCP_CLIENT_Config_t *config )
+{
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_Connect( ATMO_DriverInstanceData_t *instanceData, const char *host, unsigned int port, ATMO_BOOL_t useSSL )
+{
+	ATMO_HOST_TCP_CLIENT_State_t *state = _ATMO_HOST_TCP_CLIENT_GetState( instanceData );
+	struct addrinfo hints;
+	struct addrinfo *addrs = NULL;
+	char portStr[8];
+
+	if ( useSSL )
+	{
+		return ATMO_TCP_CLIENT_Status_NotSupported;
+	}
+
+	_ATMO_HOST_TCP_CLIENT_Close( state );
+
+	memset( &hints, 0, sizeof( hints ) );
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf( portStr, sizeof( portStr ), "%u", port );
+
+	if ( getaddrinfo( host, portStr, &hints, &addrs ) != 0 )
+	{
+		return ATMO_TCP_CLIENT_Status_Fail;
+	}
+
+	for ( struct addrinfo *addr = addrs; addr != NULL && state->fd < 0; addr = addr->ai_next )
+	{
+		state->fd = socket( addr->ai_family, addr->ai_socktype, addr->ai_protocol );
+
+		if ( state->fd >= 0 && connect( state->fd, addr->ai_addr, addr->ai_addrlen ) != 0 )
+		{
+			_ATMO_HOST_TCP_CLIENT_Close( state );
+		}
+	}
+
+	freeaddrinfo( addrs );
+	return ( state->fd >= 0 ) ? ATMO_TCP_CLIENT_Status_Success : ATMO_TCP_CLIENT_Status_Fail;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_Disconnect( ATMO_DriverInstanceData_t *instanceData )
+{
+	_ATMO_HOST_TCP_CLIENT_Close( _ATMO_HOST_TCP_CLIENT_GetState( instanceData ) );
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_GetConnectionStatus( ATMO_DriverInstanceData_t *instanceData, ATMO_TCP_CLIENT_ConnectionStatus_t *status )
+{
+	*status = ( _ATMO_HOST_TCP_CLIENT_GetState( instanceData )->fd >= 0 ) ? ATMO_TCP_CLIENT_Connected : ATMO_TCP_CLIENT_Disconnected;
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_WriteBytes( ATMO_DriverInstanceData_t *instanceData, uint8_t *data, unsigned int dataLen )
+{
+	ATMO_TCP_CLIENT_Segment_t segment = { data, dataLen };
+	return ATMO_HOST_TCP_CLIENT_WriteV( instanceData, &segment, 1 );
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_SetReceiveCallback( ATMO_DriverInstanceData_t *instanceData, ATMO_Callback_t cb )
+{
+	_ATMO_HOST_TCP_CLIENT_GetState( instanceData )->rxCb = cb;
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_GetNumAvailableBytes( ATMO_DriverInstanceData_t *instanceData, uint32_t *numBytes, uint8_t **bytePtr )
+{
+	ATMO_HOST_TCP_CLIENT_State_t *state = _ATMO_HOST_TCP_CLIENT_GetState( instanceData );
+	*numBytes = state->rxLen;
+	*bytePtr = state->rxBuf;
+	state->rxLen = 0;
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+static ATMO_TCP_CLIENT_Status_t ATMO_HOST_TCP_CLIENT_WriteV( ATMO_DriverInstanceData_t *instanceData, const ATMO_TCP_CLIENT_Segment_t *segments, unsigned int numSegments )
+{
+	ATMO_HOST_TCP_CLIENT_State_t *state = _ATMO_HOST_TCP_CLIENT_GetState( instanceData );
+
+	ATMO_HOST_CHECK( numSegments <= ATMO_HOST_TCP_CLIENT_MAX_SEGMENTS, "%u segments in one write", numSegments );
+	memcpy( _ATMO_HOST_TCP_CLIENT_LastWrite, segments, numSegments * sizeof( ATMO_TCP_CLIENT_Segment_t ) );
+	_ATMO_HOST_TCP_CLIENT_LastWriteNumSegments = numSegments;
+
+	for ( unsigned int i = 0; i < numSegments; i++ )
+	{
+		const uint8_t *data = segments[i].data;
+		unsigned int remaining = segments[i].dataLen;
+
+		while ( remaining > 0 )
+		{
+			// MSG_NOSIGNAL so a connection the server closed fails the write instead of killing the test
+			ssize_t sent = ( state->fd >= 0 ) ? send( state->fd, data, remaining, MSG_NOSIGNAL ) : -1;
+
+			if ( sent <= 0 )
+			{
+				_ATMO_HOST_TCP_CLIENT_Close( state );
+				return ATMO_TCP_CLIENT_Status_Fail;
+			}
+
+			data += sent;
+			remaining -= ( unsigned int )sent;
+		}
+	}
+
+	return ATMO_TCP_CLIENT_Status_Success;
+}
+
+const ATMO_TCP_CLIENT_Segment_t *ATMO_HOST_TCP_CLIENT_LastWrite( unsigned int *numSegments )
+{
+	*numSegments = _ATMO_HOST_TCP_CLIENT_LastWriteNumSegments;
+	return _ATMO_HOST_TCP_CLIENT_LastWrite;
+}
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file    tcpclient_host.h
+ * @author
+ * @version
+ * @date
+ * @brief   Atmosphere API - Host TCP client driver on POSIX sockets
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __ATMO_HOST_TCP_CLIENT__H
+#define __ATMO_HOST_TCP_CLIENT__H
+
+#include "../../tcpclient/tcpclient.h"
+
+#ifndef ATMO_HOST_TCP_CLIENT_NUM_INSTANCES
+#define ATMO_HOST_TCP_CLIENT_NUM_INSTANCES (2)
+#endif
+
+#define ATMO_HOST_TCP_CLIENT_MAX_SEGMENTS (4)
+
+/**
+ * Add a TCP client that connects with a plain socket. Received data is polled
+ * from the core tick and handed to the receive callback a packet at a time,
+ * like the target's driver does. SSL is not supported.
+ *
+ * @param[out] instanceNumber
+ * @return status
+ */
+ATMO_Status_t ATMO_HOST_TCP_CLIENT_AddDriverInstance( ATMO_DriverInstanceHandle_t *instanceNumber );
+
+/**
+ * Get the segments of the last write on any instance, to check what was sent
+ * from where. The data pointers are the caller's and may be stale by now.
+ *
+ * @param[out] numSegments
+ * @return segments
+ */
+const ATMO_TCP_CLIENT_Segment_t *ATMO_HOST_TCP_CLIENT_LastWrite( unsigned int *numSegments );
+
+#endif
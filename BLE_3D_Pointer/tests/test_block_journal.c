@@ -0,0 +1,245 @@
+/**
+ ******************************************************************************
+ * @file    test_block_journal.c
+ * @author
+ * @version
+ * @date
+ * @brief   Power cut test for the onsemi block journal
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Programs random edits into the onsemi block and cuts power at a random flash
+// operation, optionally tearing the word pair or sector being written. After
+// every cut the block is remounted and must read back as either the last
+// completed sync or the one that was cut short, never anything in between.
+
+#include "host/atmo_host.h"
+#include <string.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include "../block/block_onsemi.h"
+#include <rsl10_flash_rom.h>
+#include <rsl10_flash.h>
+
+// Must match block_onsemi.c
+#define TEST_LEGACY_PAGE (0x00080000)
+#define TEST_LEGACY_DATA (0x00080200)
+#define TEST_JOURNAL_BASE (0x0015E000)
+#define TEST_SECTOR_SIZE (2048)
+#define TEST_JOURNAL_SIZE (2 * TEST_SECTOR_SIZE)
+
+// Usable bytes, reads and programs must end before the last byte
+#define TEST_BLOCK_SIZE (255)
+
+#define TEST_ITERATIONS (20000)
+
+FLASH_Type ATMO_HOST_FlashRegs;
+
+static jmp_buf cutPoint;
+static long opsUntilCut = -1; /**< Flash operations left before the cut, -1 never cuts */
+static ATMO_BOOL_t tornWrite = false;
+static long flashOps = 0;
+static long flashErases = 0;
+
+ATMO_CLOUD_Status_t ATMO_CLOUD_RegisterRegistrationSetCallback( ATMO_Callback_t cb )
+{
+	return ATMO_CLOUD_Status_Success;
+}
+
+static void _TEST_MaybeCut( uint32_t *words, unsigned int numWords, ATMO_BOOL_t erase, const uint32_t *newWords )
+{
+	flashOps++;
+
+	if ( opsUntilCut == 0 )
+	{
+		if ( tornWrite )
+		{
+			// Leave the cells somewhere between the old and new contents
+			for ( unsigned int i = 0; i < numWords; i++ )
+			{
+				uint32_t noise = ( uint32_t )rand() ^ ( ( uint32_t )rand() << 16 );
+				words[i] = erase ? ( words[i] | noise ) : ( words[i] & ( newWords[i] | noise ) );
+			}
+		}
+
+		longjmp( cutPoint, 1 );
+	}
+
+	if ( opsUntilCut > 0 )
+	{
+		opsUntilCut--;
+	}
+}
+
+FlashStatus Flash_WriteWordPair( uint32_t addr, uint32_t word0, uint32_t word1 )
+{
+	uint32_t *words = ( uint32_t * )( uintptr_t )addr;
+	uint32_t newWords[2] = { word0, word1 };
+	ATMO_HOST_CHECK( ( addr & 7 ) == 0, "unaligned word pair 0x%08x", addr );
+	ATMO_HOST_CHECK( addr >= TEST_JOURNAL_BASE && addr < TEST_JOURNAL_BASE + TEST_JOURNAL_SIZE, "write outside the journal 0x%08x", addr );
+
+	_TEST_MaybeCut( words, 2, false, newWords );
+
+	// Flash can only clear bits
+	words[0] &= word0;
+	words[1] &= word1;
+	return FLASH_ERR_NONE;
+}
+
+FlashStatus Flash_EraseSector( uint32_t addr )
+{
+	ATMO_HOST_CHECK( ( addr % TEST_SECTOR_SIZE ) == 0, "unaligned erase 0x%08x", addr );
+	ATMO_HOST_CHECK( addr >= TEST_JOURNAL_BASE && addr < TEST_JOURNAL_BASE + TEST_JOURNAL_SIZE, "erase outside the journal 0x%08x", addr );
+
+	flashErases++;
+	_TEST_MaybeCut( ( uint32_t * )( uintptr_t )addr, TEST_SECTOR_SIZE / 4, true, NULL );
+	memset( ( void * )( uintptr_t )addr, 0xFF, TEST_SECTOR_SIZE );
+	return FLASH_ERR_NONE;
+}
+
+static void _TEST_MapFlash( uint32_t addr, size_t size )
+{
+	void *mapped = mmap( ( void * )( uintptr_t )addr, size, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	ATMO_HOST_CHECK( mapped != MAP_FAILED, "can't map flash at 0x%08x", addr );
+	memset( mapped, 0xFF, size );
+}
+
+static ATMO_BOOL_t _TEST_BlockIs( const uint8_t *expected )
+{
+	uint8_t contents[TEST_BLOCK_SIZE];
+	ATMO_ONSEMI_BLOCK_Read( NULL, 0, 0, contents, TEST_BLOCK_SIZE );
+	return memcmp( contents, expected, TEST_BLOCK_SIZE ) == 0;
+}
+
+int main( int argc, char **argv )
+{
+	uint8_t image[TEST_BLOCK_SIZE];
+	long totalCuts = 0;
+
+	srand( ATMO_HOST_Seed( argc, argv ) );
+	ATMO_Init();
+
+	_TEST_MapFlash( TEST_LEGACY_PAGE, 0x1000 );
+	_TEST_MapFlash( TEST_JOURNAL_BASE, TEST_JOURNAL_SIZE );
+
+	// Data from before the journal is migrated on the first mount
+	for ( unsigned int i = 0; i < TEST_BLOCK_SIZE; i++ )
+	{
+		image[i] = ( uint8_t )i;
+		( ( uint8_t * )( uintptr_t )TEST_LEGACY_DATA )[i] = ( uint8_t )i;
+	}
+
+	ATMO_ONSEMI_BLOCK_Init( NULL );
+	ATMO_HOST_CHECK( _TEST_BlockIs( image ), "legacy data not migrated" );
+
+	for ( int iter = 0; iter < TEST_ITERATIONS; iter++ )
+	{
+		uint8_t previous[TEST_BLOCK_SIZE];
+		memcpy( previous, image, sizeof( image ) );
+
+		// Mostly small edits, sometimes enough to force a compaction
+		int numEdits = 1 + rand() % ( ( rand() % 10 == 0 ) ? 64 : 4 );
+
+		for ( int i = 0; i < numEdits; i++ )
+		{
+			image[rand() % TEST_BLOCK_SIZE] = ( uint8_t )rand();
+		}
+
+		ATMO_ONSEMI_BLOCK_Program( NULL, 0, 0, image, TEST_BLOCK_SIZE );
+
+		ATMO_BOOL_t doCut = ( rand() % 3 ) == 0;
+		opsUntilCut = doCut ? rand() % ( numEdits + 4 ) : -1;
+		tornWrite = ( rand() % 2 ) == 0;
+
+		if ( setjmp( cutPoint ) == 0 )
+		{
+			ATMO_ONSEMI_BLOCK_Sync( NULL );
+
+			if ( rand() % 4 == 0 )
+			{
+				ATMO_ONSEMI_BLOCK_Program( NULL, 0, 0, image, TEST_BLOCK_SIZE );
+				ATMO_ONSEMI_BLOCK_Sync( NULL );
+			}
+
+			// Let any deferred write run
+			ATMO_HOST_AdvanceMs( 1000 );
+			ATMO_Tick();
+			opsUntilCut = -1;
+			ATMO_HOST_CHECK( _TEST_BlockIs( image ), "iteration %d: sync lost data", iter );
+		}
+		else
+		{
+			totalCuts++;
+			opsUntilCut = -1;
+
+			// Reboot, the RAM copy is gone
+			ATMO_ONSEMI_BLOCK_Init( NULL );
+
+			if ( !_TEST_BlockIs( image ) )
+			{
+				ATMO_HOST_CHECK( _TEST_BlockIs( previous ), "iteration %d: cut sync left a mix of old and new data", iter );
+				memcpy( image, previous, sizeof( image ) );
+			}
+		}
+
+		if ( rand() % 50 == 0 )
+		{
+			ATMO_ONSEMI_BLOCK_Init( NULL );
+			ATMO_HOST_CHECK( _TEST_BlockIs( image ), "iteration %d: reboot lost data", iter );
+		}
+	}
+
+	// A sync is on flash by the time it returns
+	ATMO_ONSEMI_BLOCK_Init( NULL );
+	image[0] ^= 0xFF;
+	ATMO_ONSEMI_BLOCK_Program( NULL, 0, 0, image, TEST_BLOCK_SIZE );
+	ATMO_ONSEMI_BLOCK_Sync( NULL );
+	ATMO_ONSEMI_BLOCK_Init( NULL );
+	ATMO_HOST_CHECK( _TEST_BlockIs( image ), "sync returned before the data was written" );
+
+	// Programmed data nobody syncs is still written after the delay
+	image[1] ^= 0xFF;
+	ATMO_ONSEMI_BLOCK_Program( NULL, 0, 0, image, TEST_BLOCK_SIZE );
+	ATMO_HOST_AdvanceMs( 1000 );
+	ATMO_Tick();
+	ATMO_ONSEMI_BLOCK_Init( NULL );
+	ATMO_HOST_CHECK( _TEST_BlockIs( image ), "programmed data never written" );
+
+	// Writing back what is already stored, as the boot code does, must not touch flash
+	ATMO_ONSEMI_BLOCK_Init( NULL );
+	long opsBefore = flashOps;
+	ATMO_ONSEMI_BLOCK_Program( NULL, 0, 0, image, TEST_BLOCK_SIZE );
+	ATMO_ONSEMI_BLOCK_Sync( NULL );
+	ATMO_HOST_AdvanceMs( 1000 );
+	ATMO_Tick();
+	ATMO_HOST_CHECK( flashOps == opsBefore, "unchanged data was written again" );
+
+	printf( "ok: %ld erases, %ld power cuts, %ld flash operations\n", flashErases, totalCuts, flashOps );
+	return 0;
+}
@@ -0,0 +1,218 @@
+/**
+ ******************************************************************************
+ * @file    test_cloud_eventlog.c
+ * @author
+ * @version
+ * @date
+ * @brief   Tests for the persistent cloud event log
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "host/atmo_host.h"
+#include <string.h>
+#include "../cloud/cloud_eventlog.h"
+#include "../block/block_ram.h"
+
+#define TEST_BLOCK_SIZE (256)
+#define TEST_NUM_BLOCKS (4)
+
+static uint8_t flash[TEST_BLOCK_SIZE * TEST_NUM_BLOCKS];
+static ATMO_CLOUD_EVENTLOG_Config_t config;
+
+static void _TEST_Erase( ATMO_CLOUD_EVENTLOG_Policy_t policy )
+{
+	memset( flash, 0xFF, sizeof( flash ) );
+	config.policy = policy;
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Init( &config ) == ATMO_CLOUD_EVENTLOG_Status_Success, "init" );
+}
+
+static ATMO_CLOUD_EVENTLOG_Stats_t _TEST_Stats( void )
+{
+	ATMO_CLOUD_EVENTLOG_Stats_t stats;
+	ATMO_CLOUD_EVENTLOG_GetStats( &stats );
+	return stats;
+}
+
+/**
+ * Read every pending event, checking they come back in order without gaps
+ *
+ * @return number of events read
+ */
+static uint32_t _TEST_ReadAll( uint32_t *firstSeq, uint32_t *lastSeq )
+{
+	ATMO_CLOUD_EVENTLOG_Cursor_t cursor;
+	ATMO_CLOUD_EVENTLOG_Record_t record;
+	uint32_t numRead = 0;
+
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Begin( &cursor ) == ATMO_CLOUD_EVENTLOG_Status_Success, "begin" );
+
+	while ( ATMO_CLOUD_EVENTLOG_Read( &cursor, &record ) == ATMO_CLOUD_EVENTLOG_Status_Success )
+	{
+		char expected[ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN];
+		snprintf( expected, sizeof( expected ), "v%u", ( unsigned int )record.seq );
+		ATMO_HOST_CHECK( numRead == 0 || record.seq == *lastSeq + 1, "gap after %u", ( unsigned int )*lastSeq );
+		ATMO_HOST_CHECK( strcmp( record.name, "temp" ) == 0 && record.hasData && strcmp( record.data, expected ) == 0,
+		                 "event %u reads %s=%s", ( unsigned int )record.seq, record.name, record.data );
+
+		if ( numRead == 0 )
+		{
+			*firstSeq = record.seq;
+		}
+
+		*lastSeq = record.seq;
+		numRead++;
+	}
+
+	return numRead;
+}
+
+static uint32_t _TEST_Append( void )
+{
+	char data[ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN];
+	uint32_t seq = _TEST_Stats().nextSeq;
+	snprintf( data, sizeof( data ), "v%u", ( unsigned int )seq );
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Append( "temp", data, &seq ) == ATMO_CLOUD_EVENTLOG_Status_Success, "append %s", data );
+	return seq;
+}
+
+static void _TEST_DropOldest( void )
+{
+	uint32_t firstSeq = 0, lastSeq = 0, appendedSeq = 0;
+
+	_TEST_Erase( ATMO_CLOUD_EVENTLOG_Policy_DropOldest );
+
+	for ( int i = 0; i < 100; i++ )
+	{
+		appendedSeq = _TEST_Append();
+	}
+
+	ATMO_CLOUD_EVENTLOG_Stats_t stats = _TEST_Stats();
+	uint32_t numRead = _TEST_ReadAll( &firstSeq, &lastSeq );
+	ATMO_HOST_CHECK( stats.numDropped > 0, "100 events should not fit" );
+	ATMO_HOST_CHECK( numRead == stats.numPending && stats.numPending + stats.numDropped == 100, "%u pending, %u dropped, %u read",
+	                 ( unsigned int )stats.numPending, ( unsigned int )stats.numDropped, ( unsigned int )numRead );
+	ATMO_HOST_CHECK( lastSeq == appendedSeq, "newest event missing" );
+
+	// Acknowledged events stay acknowledged across a remount
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Ack( firstSeq + 9 ) == ATMO_CLOUD_EVENTLOG_Status_Success, "ack" );
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Init( &config ) == ATMO_CLOUD_EVENTLOG_Status_Success, "remount" );
+	ATMO_CLOUD_EVENTLOG_Stats_t remounted = _TEST_Stats();
+	ATMO_HOST_CHECK( remounted.numPending == stats.numPending - 10 && remounted.nextSeq == stats.nextSeq, "remount lost track" );
+
+	uint32_t remountFirst = 0;
+	numRead = _TEST_ReadAll( &remountFirst, &lastSeq );
+	ATMO_HOST_CHECK( remountFirst == firstSeq + 10 && numRead == remounted.numPending, "acked events came back" );
+
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Ack( remounted.nextSeq - 1 ) == ATMO_CLOUD_EVENTLOG_Status_Success, "ack all" );
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Init( &config ) == ATMO_CLOUD_EVENTLOG_Status_Success, "remount" );
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_IsEmpty() && _TEST_Stats().nextSeq == stats.nextSeq, "log should be empty" );
+
+	// Sequence numbers carry on, the cloud relies on them to drop duplicates
+	ATMO_HOST_CHECK( _TEST_Append() == stats.nextSeq, "sequence restarted" );
+}
+
+static void _TEST_RejectNew( void )
+{
+	uint32_t numAppended = 0;
+	uint32_t firstSeq = 0, lastSeq = 0;
+	ATMO_CLOUD_EVENTLOG_Status_t status;
+
+	_TEST_Erase( ATMO_CLOUD_EVENTLOG_Policy_RejectNew );
+
+	do
+	{
+		char data[ATMO_CLOUD_EVENTLOG_MAX_DATA_LEN];
+		snprintf( data, sizeof( data ), "v%u", ( unsigned int )_TEST_Stats().nextSeq );
+		status = ATMO_CLOUD_EVENTLOG_Append( "temp", data, NULL );
+		numAppended += ( status == ATMO_CLOUD_EVENTLOG_Status_Success ) ? 1 : 0;
+	} while ( status == ATMO_CLOUD_EVENTLOG_Status_Success && numAppended < 1000 );
+
+	ATMO_HOST_CHECK( status == ATMO_CLOUD_EVENTLOG_Status_Full, "full log returned %d", status );
+	ATMO_HOST_CHECK( _TEST_Stats().numDropped == 0, "reject policy dropped events" );
+	ATMO_HOST_CHECK( _TEST_ReadAll( &firstSeq, &lastSeq ) == numAppended, "events missing" );
+
+	// Acknowledging a block's worth makes room again
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Ack( firstSeq + numAppended / 2 ) == ATMO_CLOUD_EVENTLOG_Status_Success, "ack" );
+	_TEST_Append();
+}
+
+static void _TEST_TornAppend( void )
+{
+	static uint8_t before[sizeof( flash )];
+	uint32_t firstSeq = 0, lastSeq = 0;
+
+	_TEST_Erase( ATMO_CLOUD_EVENTLOG_Policy_DropOldest );
+
+	for ( int i = 0; i < 5; i++ )
+	{
+		_TEST_Append();
+	}
+
+	memcpy( before, flash, sizeof( flash ) );
+	uint32_t tornSeq = _TEST_Append();
+
+	// Power lost before the end of the record made it to flash
+	uint32_t lastByte = 0;
+
+	for ( uint32_t i = 0; i < sizeof( flash ); i++ )
+	{
+		if ( flash[i] != before[i] )
+		{
+			lastByte = i;
+		}
+	}
+
+	ATMO_HOST_CHECK( lastByte > 0, "append wrote nothing" );
+	flash[lastByte] = 0xFF;
+
+	ATMO_HOST_CHECK( ATMO_CLOUD_EVENTLOG_Init( &config ) == ATMO_CLOUD_EVENTLOG_Status_Success, "remount" );
+	ATMO_HOST_CHECK( _TEST_ReadAll( &firstSeq, &lastSeq ) == 5 && lastSeq == tornSeq - 1, "torn event should be dropped alone" );
+
+	// And the log keeps working after it
+	uint32_t seq = _TEST_Append();
+	ATMO_HOST_CHECK( _TEST_ReadAll( &firstSeq, &lastSeq ) == 6 && lastSeq == seq, "append after a torn record" );
+}
+
+int main( int argc, char **argv )
+{
+	ATMO_Init();
+
+	ATMO_DriverInstanceHandle_t blockInstance = 0;
+	ATMO_RAM_BLOCK_AddDriverInstance( &blockInstance, flash, TEST_BLOCK_SIZE, TEST_NUM_BLOCKS );
+	config.blockInstance = blockInstance;
+	config.firstBlock = 0;
+	config.numBlocks = TEST_NUM_BLOCKS;
+
+	_TEST_DropOldest();
+	_TEST_RejectNew();
+	_TEST_TornAppend();
+
+	printf( "ok\n" );
+	return 0;
+}
@@ -0,0 +1,312 @@
+/**
+ ******************************************************************************
+ * @file    test_cloud_tcp.c
+ * @author
+ * @version
+ * @date
+ * @brief   Cloud TCP request flow test against a local server
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Drives the cloud TCP driver against a scripted server on 127.0.0.1. Every
+// request is started from the tick and must return right away, the responses
+// are handled from later ticks. The server counts the command polls it gets.
+
+#include "host/atmo_host.h"
+#include "host/tcpclient_host.h"
+#include "host/http_server_host.h"
+#include <string.h>
+#include <unistd.h>
+
+// The driver is built in with a command list of its own, the app one is empty
+#define ATMO_CLOUDCOMMANDS_H_
+static char *cloudCommandsList[] = {"setLed", "reboot"};
+#define TOTAL_NUM_CLOUD_COMMANDS (2)
+
+// Small enough for a short string value to need a request of its own
+#define ATMO_CLOUD_TCP_BATCH_MAX_BYTES (128)
+#include "../cloud/cloud_tcp.c"
+
+#define TEST_TIMEOUT_MS (10000)
+#define TEST_BIG_EVENT_LEN (20)
+
+static ATMO_CLOUD_RegistrationInfo_t registration;
+static uint8_t packetBuf[2048];
+
+// Written by the server thread, read once the request it answered is done
+static volatile ATMO_BOOL_t bigEventSeen = false;
+static volatile ATMO_BOOL_t batchSeen = false;
+static volatile ATMO_BOOL_t rebootPopped = false;
+static volatile unsigned int bigEventPathLen = 0;
+static char batchBody[512];
+
+// Command polls, the aggregated one is answered until this is cleared
+static volatile ATMO_BOOL_t popAllSupported = true;
+static volatile unsigned int numPopAll = 0;
+static volatile unsigned int numSinglePops = 0;
+static volatile ATMO_BOOL_t commandsReleased = false;
+static volatile ATMO_BOOL_t secondPopAll = false;
+static char popAllWait[16];
+static char popAllReply[128];
+
+// The body of the first aggregated poll, split inside an entry
+static const char *popAllBody[] = {"[{\"name\":\"setLed\",\"comm", "and\":\"on\"},{\"name\":\"reboot\",\"command\":\"now\"}]"};
+
+static volatile ATMO_BOOL_t commandDispatched = false;
+static unsigned int numDispatched = 0;
+static uint64_t lastDispatchMs = 0;
+static char dispatchLog[128];
+
+ATMO_Status_t ATMO_CLOUD_AddDriverInstance( const ATMO_CLOUD_DriverInstance_t *driverInstance, ATMO_DriverInstanceData_t *driverInstanceData, ATMO_DriverInstanceHandle_t *instanceNumber )
+{
+	*instanceNumber = 0;
+	return ATMO_Status_Success;
+}
+
+ATMO_CLOUD_RegistrationInfo_t *ATMO_CLOUD_GetRegistration( void )
+{
+	return &registration;
+}
+
+ATMO_CLOUD_Status_t ATMO_CLOUD_GetRegistrationInfoUuid( ATMO_CLOUD_RegistrationInfo_t *info, char *buffer, size_t size )
+{
+	snprintf( buffer, size, "device-1" );
+	return ATMO_CLOUD_Status_Success;
+}
+
+ATMO_CLOUD_Status_t ATMO_CLOUD_DispatchCommandResult( const char *command, ATMO_Value_t *result )
+{
+	size_t len = strlen( dispatchLog );
+	snprintf( &dispatchLog[len], sizeof( dispatchLog ) - len, "%s=%s;", command, ( result->type == ATMO_DATATYPE_STRING ) ? ( const char * )result->data : "" );
+	numDispatched++;
+	lastDispatchMs = ATMO_PLATFORM_UptimeMs();
+	commandDispatched = true;
+	return ATMO_CLOUD_Status_Success;
+}
+
+ATMO_CLOUD_Status_t ATMO_CLOUD_SetExtraRequiredSettings( uint16_t extraSettings )
+{
+	return ATMO_CLOUD_Status_Success;
+}
+
+ATMO_CLOUD_Status_t ATMO_CLOUD_ClearExtraRequiredSettings( uint16_t extraSettings )
+{
+	return ATMO_CLOUD_Status_Success;
+}
+
+int ATMO_CLOUD_PROVISIONER_HandleCommand( uint8_t *command, uint32_t commandLength, uint8_t *respBuffer, uint32_t respBufferLength, ATMO_BOOL_t *connectionVerified )
+{
+	return 0;
+}
+
+static void _TEST_ServerHandler( const char *method, const char *path, const char *body, unsigned int bodyLen, ATMO_HOST_HTTP_SERVER_Reply_t *reply, void *arg )
+{
+	const char *ok = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+	if ( strncmp( path, "/thing/device-1/event/big/", 26 ) == 0 )
+	{
+		bigEventPathLen = strlen( path );
+		bigEventSeen = true;
+		reply->fragments[0] = ok;
+	}
+	else if ( strcmp( path, "/thing/device-1/events" ) == 0 && strcmp( method, "POST" ) == 0 )
+	{
+		snprintf( batchBody, sizeof( batchBody ), "%.*s", ( int )bodyLen, body );
+		batchSeen = true;
+		reply->fragments[0] = ok;
+	}
+	else if ( strncmp( path, "/thing/device-1/commands/pop?wait=", 34 ) == 0 && popAllSupported )
+	{
+		snprintf( popAllWait, sizeof( popAllWait ), "%s", &path[34] );
+
+		if ( ++numPopAll == 1 )
+		{
+			// Hold the poll until the commands "arrive"
+			usleep( 30000 );
+			snprintf( popAllReply, sizeof( popAllReply ), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n", ( unsigned int )( strlen( popAllBody[0] ) + strlen( popAllBody[1] ) ) );
+			reply->fragments[0] = popAllReply;
+			reply->fragments[1] = popAllBody[0];
+			reply->fragments[2] = popAllBody[1];
+			commandsReleased = true;
+		}
+		else
+		{
+			// Answered right away, this server doesn't actually wait
+			secondPopAll = true;
+			reply->fragments[0] = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nnull";
+		}
+	}
+	else if ( strcmp( path, "/thing/device-1/command/setLed/pop" ) == 0 )
+	{
+		numSinglePops++;
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nContent-Length: 16\r\n\r\n{\"command\":\"on\"}";
+	}
+	else if ( strcmp( path, "/thing/device-1/command/reboot/pop" ) == 0 )
+	{
+		numSinglePops++;
+		rebootPopped = true;
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nnull";
+	}
+	else
+	{
+		// Including the aggregated command pop, this is an older server
+		reply->fragments[0] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+	}
+}
+
+// Tick until the flag drops
+static ATMO_BOOL_t _TEST_RunWhile( ATMO_BOOL_t *busy, uint32_t maxMs )
+{
+	volatile ATMO_BOOL_t never = false;
+	uint32_t i;
+
+	for ( i = 0; i < maxMs && *busy; i++ )
+	{
+		ATMO_HOST_RunUntil( &never, 1 );
+	}
+
+	return !*busy;
+}
+
+static void _TEST_LongPoll( ATMO_CLOUD_TCP_Priv_t *priv )
+{
+	volatile ATMO_BOOL_t never = false;
+
+	// Nothing queued, so the server may hold the poll
+	ATMO_HOST_AdvanceMs( ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS );
+	_ATMO_CLOUD_TCP_CheckBuffer( NULL );
+	ATMO_HOST_CHECK( priv->commandPollInFlight && priv->commandPollWaitMs == ATMO_CLOUD_COMMAND_LONG_POLL_MS, "long poll not started" );
+
+	// Every pending command comes back in the one response, as soon as the server has it
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( &commandsReleased, TEST_TIMEOUT_MS ), "poll never answered" );
+	uint64_t releasedMs = ATMO_PLATFORM_UptimeMs();
+	ATMO_HOST_CHECK( atoi( popAllWait ) == ATMO_CLOUD_COMMAND_LONG_POLL_MS / 1000, "wait=%s", popAllWait );
+
+	// Commands came back, so listening starts again straight away
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( &secondPopAll, 1000 ), "no poll right after the commands" );
+	ATMO_HOST_CHECK( strcmp( dispatchLog, "setLed=on;reboot=now;" ) == 0, "dispatched %s", dispatchLog );
+	ATMO_HOST_CHECK( lastDispatchMs - releasedMs < ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS / 10, "dispatched %lu ms after the server answered", ( unsigned long )( lastDispatchMs - releasedMs ) );
+	ATMO_HOST_CHECK( numPopAll == 2 && numSinglePops == 0, "%u polls, %u single pops", numPopAll, numSinglePops );
+	ATMO_HOST_CHECK( _TEST_RunWhile( &priv->commandPollInFlight, TEST_TIMEOUT_MS ), "second poll never completed" );
+
+	// An empty answer that wasn't held means the next one waits for the poll interval
+	ATMO_HOST_RunUntil( &never, ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS / 2 );
+	ATMO_HOST_CHECK( numPopAll == 2, "%u polls before the interval", numPopAll );
+	ATMO_HOST_RunUntil( &never, ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS );
+	ATMO_HOST_CHECK( _TEST_RunWhile( &priv->commandPollInFlight, TEST_TIMEOUT_MS ), "third poll never completed" );
+	ATMO_HOST_CHECK( numPopAll == 3 && numSinglePops == 0 && numDispatched == 2, "%u polls, %u single pops, %u dispatched", numPopAll, numSinglePops, numDispatched );
+}
+
+static void _TEST_Commands( ATMO_CLOUD_TCP_Priv_t *priv )
+{
+	// From here on the server is an older one
+	popAllSupported = false;
+	commandDispatched = false;
+	numDispatched = 0;
+	dispatchLog[0] = 0;
+
+	ATMO_HOST_AdvanceMs( ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS );
+	_ATMO_CLOUD_TCP_CheckBuffer( NULL );
+	ATMO_HOST_CHECK( priv->commandPollInFlight, "aggregated command pop not started" );
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( ( volatile ATMO_BOOL_t * )&priv->commandPopAllUnsupported, TEST_TIMEOUT_MS ), "404 not taken as an older server" );
+
+	// One command per request, the tick doesn't wait for it
+	ATMO_HOST_AdvanceMs( ATMO_CLOUD_COMMAND_CHECK_INTERVAL_MS );
+	_ATMO_CLOUD_TCP_CheckBuffer( NULL );
+	ATMO_HOST_CHECK( priv->commandPollInFlight && !commandDispatched, "single command pop not in flight" );
+
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( &commandDispatched, TEST_TIMEOUT_MS ), "setLed never dispatched" );
+	ATMO_HOST_CHECK( strcmp( dispatchLog, "setLed=on;" ) == 0, "dispatched %s", dispatchLog );
+
+	// The next command goes out right after, without waiting for the poll interval
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( &rebootPopped, 1000 ), "reboot not popped" );
+	ATMO_HOST_CHECK( _TEST_RunWhile( &priv->commandPollInFlight, TEST_TIMEOUT_MS ), "reboot pop never completed" );
+	ATMO_HOST_CHECK( numDispatched == 1 && numSinglePops == 2 && priv->nextCommand == 0, "%u dispatched, %u single pops, next command %u", numDispatched, numSinglePops, priv->nextCommand );
+}
+
+static void _TEST_Events( ATMO_CLOUD_TCP_Priv_t *priv )
+{
+	ATMO_Value_t value;
+	char big[TEST_BIG_EVENT_LEN + 1];
+	memset( big, '\t', TEST_BIG_EVENT_LEN );
+	big[TEST_BIG_EVENT_LEN] = 0;
+
+	// Escaped six times over it's too big for a batch and goes out by itself
+	ATMO_InitValue( &value );
+	ATMO_CreateValueString( &value, big );
+	ATMO_HOST_CHECK( ATMO_CLOUD_TCP_SendEvent( &priv->instance, "big", &value, 0 ) == ATMO_CLOUD_Status_Success, "big event not queued" );
+	ATMO_FreeValue( &value );
+
+	uint32_t numSuccess = priv->metrics.numSuccess;
+	_ATMO_CLOUD_TCP_CheckBuffer( NULL );
+	ATMO_HOST_CHECK( priv->inTransaction && ATMO_RingBuffer_Empty( &priv->eventQueue ), "big event not in flight" );
+	ATMO_HOST_CHECK( _TEST_RunWhile( &priv->inTransaction, TEST_TIMEOUT_MS ), "big event never completed" );
+	ATMO_HOST_CHECK( bigEventSeen && bigEventPathLen == 26 + ( TEST_BIG_EVENT_LEN * 3 ), "big event path of %u bytes", bigEventPathLen );
+	ATMO_HOST_CHECK( priv->metrics.numSuccess == numSuccess + 1 && priv->metrics.eventsDropped == 0, "big event not counted as delivered" );
+
+	// Small ones are batched
+	ATMO_InitValue( &value );
+	ATMO_CreateValueString( &value, "21" );
+	ATMO_HOST_CHECK( ATMO_CLOUD_TCP_SendEvent( &priv->instance, "temp", &value, 0 ) == ATMO_CLOUD_Status_Success, "temp not queued" );
+	ATMO_HOST_CHECK( ATMO_CLOUD_TCP_SendEvent( &priv->instance, "temp", &value, 0 ) == ATMO_CLOUD_Status_Success, "temp not queued" );
+	ATMO_FreeValue( &value );
+
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( &batchSeen, ATMO_CLOUD_TCP_BATCH_MAX_AGE_MS + TEST_TIMEOUT_MS ), "batch never sent" );
+	ATMO_HOST_CHECK( _TEST_RunWhile( &priv->inTransaction, TEST_TIMEOUT_MS ), "batch never completed" );
+	ATMO_HOST_CHECK( strstr( batchBody, "\"name\":\"temp\"" ) != NULL && strstr( strstr( batchBody, "\"name\":\"temp\"" ) + 1, "\"name\":\"temp\"" ) != NULL, "batch body %s", batchBody );
+	ATMO_HOST_CHECK( priv->metrics.eventsDropped == 0, "%u events dropped", priv->metrics.eventsDropped );
+}
+
+int main( int argc, char **argv )
+{
+	ATMO_DriverInstanceHandle_t tcpInstance = 0;
+	ATMO_DriverInstanceHandle_t httpInstance = 0;
+	ATMO_DriverInstanceHandle_t cloudInstance = 0;
+
+	ATMO_Init();
+	unsigned int port = ATMO_HOST_HTTP_SERVER_Start( _TEST_ServerHandler, NULL );
+	ATMO_HOST_TCP_CLIENT_AddDriverInstance( &tcpInstance );
+	ATMO_HOST_CHECK( ATMO_HTTP_Init( tcpInstance, packetBuf, sizeof( packetBuf ), &httpInstance ) == ATMO_HTTP_Status_Success, "http init" );
+
+	registration.registered = true;
+	snprintf( registration.url, sizeof( registration.url ), "http://127.0.0.1:%u", port );
+	snprintf( registration.token, sizeof( registration.token ), "secret" );
+
+	ATMO_HOST_CHECK( ATMO_CLOUD_TCP_AddDriverInstanceByType( &cloudInstance, 0, ATMO_DRIVERTYPE_ETHERNET, httpInstance, 0, 0 ) == ATMO_Status_Success, "cloud instance" );
+	ATMO_CLOUD_TCP_Priv_t *priv = &_ATMO_CLOUD_TCP_PrivData[0];
+	ATMO_HOST_CHECK( ATMO_CLOUD_TCP_Init( &priv->instance, false ) == ATMO_CLOUD_Status_Success, "cloud init" );
+
+	_TEST_LongPoll( priv );
+	_TEST_Commands( priv );
+	_TEST_Events( priv );
+
+	ATMO_HOST_HTTP_SERVER_Stop();
+	printf( "ok: %u requests\n", ATMO_HOST_HTTP_SERVER_NumRequests() );
+	return 0;
+}
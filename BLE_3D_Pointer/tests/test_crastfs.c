@@ -0,0 +1,246 @@
+/**
+ ******************************************************************************
+ * @file    test_crastfs.c
+ * @author
+ * @version
+ * @date
+ * @brief   Corruption test for the CRASTFS built in records
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Stores a registration and the raw records, then damages the image the way a
+// reset between a record and its CRC would. Only the damaged record may be
+// lost, the others must read back unchanged, also after upgrading an image
+// from before the CRCs.
+
+#include "host/atmo_host.h"
+#include <string.h>
+
+// The driver's statics are tested directly
+#include "../filesystem/filesystem_crastfs.c"
+
+#define TEST_BLOCK_SIZE (256)
+#define TEST_NUM_BLOCKS (2)
+
+// Written over in place, like the RAM copy the ONSEMI block driver keeps
+static uint8_t flash[TEST_BLOCK_SIZE * TEST_NUM_BLOCKS];
+static ATMO_DriverInstanceHandle_t blockInstance;
+static ATMO_DriverInstanceHandle_t fsInstance;
+
+static ATMO_BLOCK_Status_t _TEST_FlashInit( ATMO_DriverInstanceData_t *instance )
+{
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashRead( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	memcpy( buffer, &flash[block * TEST_BLOCK_SIZE + offset], size );
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashProgram( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	memcpy( &flash[block * TEST_BLOCK_SIZE + offset], buffer, size );
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashErase( ATMO_DriverInstanceData_t *instance, uint32_t block )
+{
+	memset( &flash[block * TEST_BLOCK_SIZE], 0xFF, TEST_BLOCK_SIZE );
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashSync( ATMO_DriverInstanceData_t *instance )
+{
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashGetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info )
+{
+	info->blockCount = TEST_NUM_BLOCKS;
+	info->blockSize = TEST_BLOCK_SIZE;
+	info->progSize = 1;
+	info->readSize = 1;
+	return ATMO_BLOCK_Status_Success;
+}
+
+static const ATMO_BLOCK_DriverInstance_t testFlashDriver =
+{
+	_TEST_FlashInit,
+	_TEST_FlashRead,
+	_TEST_FlashProgram,
+	_TEST_FlashErase,
+	_TEST_FlashSync,
+	_TEST_FlashGetDeviceInfo
+};
+
+static void _TEST_Boot( void )
+{
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_Init( fsInstance, blockInstance ) == ATMO_FILESYSTEM_Status_Success, "init" );
+}
+
+static void _TEST_Write( const char *path, void *data, uint32_t size )
+{
+	ATMO_FILESYSTEM_File_t file;
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_FileOpen( fsInstance, &file, path, 0 ) == ATMO_FILESYSTEM_Status_Success, "open %s", path );
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_FileWrite( fsInstance, &file, data, size ) == ATMO_FILESYSTEM_Status_Success, "write %s", path );
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_FileClose( fsInstance, &file ) == ATMO_FILESYSTEM_Status_Success, "close %s", path );
+}
+
+static void _TEST_Read( const char *path, void *data, uint32_t size )
+{
+	ATMO_FILESYSTEM_File_t file;
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_FileOpen( fsInstance, &file, path, 0 ) == ATMO_FILESYSTEM_Status_Success, "open %s", path );
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_FileRead( fsInstance, &file, data, size ) == ATMO_FILESYSTEM_Status_Success, "read %s", path );
+	ATMO_HOST_CHECK( ATMO_FILESYSTEM_FileClose( fsInstance, &file ) == ATMO_FILESYSTEM_Status_Success, "close %s", path );
+}
+
+static ATMO_CLOUD_RegistrationInfo_t registration;
+static char buildUuid[ATMO_CRASTFS_BUILD_UUID_SIZE];
+static char extra1[ATMO_CRASTFS_EXTRA1_SIZE];
+
+static void _TEST_Store( void )
+{
+	memset( &registration, 0, sizeof( registration ) );
+	registration.registered = true;
+	memset( registration.uuid, 0xA5, sizeof( registration.uuid ) );
+	strcpy( registration.token, "token" );
+	strcpy( registration.url, "https://example.com" );
+	_TEST_Write( "registrationInfo", &registration, sizeof( registration ) );
+
+	memcpy( buildUuid, "0b2a07d6-5a1f-4bd5-9f6e-2b8d6f3e4c11", sizeof( buildUuid ) );
+	_TEST_Write( "buildUuid", buildUuid, sizeof( buildUuid ) );
+
+	memset( extra1, 0, sizeof( extra1 ) );
+	strcpy( extra1, "ssid" );
+	_TEST_Write( "extra1", extra1, sizeof( extra1 ) );
+}
+
+/**
+ * Check the stored records, the one named by dropped has to read back as never written
+ */
+static void _TEST_Check( const char *dropped )
+{
+	ATMO_CLOUD_RegistrationInfo_t readRegistration;
+	char readUuid[ATMO_CRASTFS_BUILD_UUID_SIZE];
+	char readExtra1[ATMO_CRASTFS_EXTRA1_SIZE];
+	uint8_t erased[ATMO_CRASTFS_BUILD_UUID_SIZE];
+
+	memset( erased, ATMO_CRASTFS_DROPPED_BYTE, sizeof( erased ) );
+
+	_TEST_Read( "registrationInfo", &readRegistration, sizeof( readRegistration ) );
+	_TEST_Read( "buildUuid", readUuid, sizeof( readUuid ) );
+	_TEST_Read( "extra1", readExtra1, sizeof( readExtra1 ) );
+
+	if ( strcmp( dropped, "registrationInfo" ) == 0 )
+	{
+		ATMO_HOST_CHECK( !readRegistration.registered, "dropped registration still registered" );
+	}
+	else
+	{
+		ATMO_HOST_CHECK( readRegistration.registered && strcmp( readRegistration.token, registration.token ) == 0 &&
+		                 strcmp( readRegistration.url, registration.url ) == 0 && memcmp( readRegistration.uuid, registration.uuid, sizeof( registration.uuid ) ) == 0,
+		                 "registration lost with %s dropped", dropped );
+	}
+
+	if ( strcmp( dropped, "buildUuid" ) == 0 )
+	{
+		ATMO_HOST_CHECK( memcmp( readUuid, erased, sizeof( readUuid ) ) == 0, "dropped build UUID not reset" );
+	}
+	else
+	{
+		ATMO_HOST_CHECK( memcmp( readUuid, buildUuid, sizeof( buildUuid ) ) == 0, "build UUID lost with %s dropped", dropped );
+	}
+
+	ATMO_HOST_CHECK( memcmp( readExtra1, extra1, sizeof( extra1 ) ) == 0, "extra1 lost with %s dropped", dropped );
+}
+
+static void _TEST_SetMagicWord( uint32_t magicWord )
+{
+	memcpy( &flash[ATMO_CRASTFS_MAGICWORD_OFFSET], &magicWord, sizeof( magicWord ) );
+}
+
+int main( int argc, char **argv )
+{
+	ATMO_BLOCK_AddDriverInstance( &testFlashDriver, NULL, &blockInstance );
+	ATMO_CRASTFS_FILESYSTEM_AddDriverInstance( &fsInstance );
+	ATMO_BLOCK_Init( blockInstance );
+
+	// A blank device gets formatted
+	memset( flash, 0xFF, sizeof( flash ) );
+	_TEST_Boot();
+	_TEST_Store();
+	_TEST_Boot();
+	_TEST_Check( "" );
+
+	// A record whose data changed without its CRC is dropped on its own
+	flash[ATMO_CRASTFS_BUILD_UUID_OFFSET + 3] ^= 0x10;
+	_TEST_Boot();
+	_TEST_Check( "buildUuid" );
+
+	// The dropped record is consistent again and can be rewritten
+	_TEST_Boot();
+	_TEST_Check( "buildUuid" );
+	_TEST_Store();
+	_TEST_Boot();
+	_TEST_Check( "" );
+
+	// Same when the CRC made it and the data didn't
+	flash[ATMO_CRASTFS_CRC_OFFSET] ^= 0x01;
+	_TEST_Boot();
+	_TEST_Check( "registrationInfo" );
+
+	// Images from before the CRC keep everything
+	_TEST_Store();
+	memset( &flash[ATMO_CRASTFS_CRC_OFFSET], 0xFF, ATMO_CRASTFS_CRC_SIZE );
+	_TEST_SetMagicWord( ATMO_CRASTFS_MAGICWORD_NO_CRC );
+	_TEST_Boot();
+	_TEST_Boot();
+	_TEST_Check( "" );
+
+	// An unknown format is still wiped
+	_TEST_SetMagicWord( 0x12345678 );
+	_TEST_Boot();
+	ATMO_HOST_CHECK( flash[ATMO_CRASTFS_EXTRA1_OFFSET] == 0xFF, "unknown format not wiped" );
+	_TEST_Boot();
+
+	// Application records get what is left of the first block and no more
+	uint8_t appRecord[TEST_BLOCK_SIZE - ATMO_CRASTFS_SIZE];
+	uint8_t appRecordRead[sizeof( appRecord )];
+	memset( appRecord, 0x5A, sizeof( appRecord ) );
+	ATMO_HOST_CHECK( ATMO_CRASTFS_FILESYSTEM_AddRecord( "app", sizeof( appRecord ) ) == ATMO_FILESYSTEM_Status_Success, "app record doesn't fit" );
+	ATMO_HOST_CHECK( ATMO_CRASTFS_FILESYSTEM_AddRecord( "more", 1 ) == ATMO_FILESYSTEM_Status_Invalid, "record past the first block accepted" );
+	_TEST_Write( "app", appRecord, sizeof( appRecord ) );
+	_TEST_Boot();
+	_TEST_Read( "app", appRecordRead, sizeof( appRecordRead ) );
+	ATMO_HOST_CHECK( memcmp( appRecord, appRecordRead, sizeof( appRecord ) ) == 0, "app record changed" );
+
+	printf( "ok: %u byte image, %d records\n", ( unsigned int )ATMO_CRASTFS_SIZE, ATMO_CRASTFS_NUM_FILES );
+	return 0;
+}
@@ -0,0 +1,227 @@
+/**
+ ******************************************************************************
+ * @file    test_http_keepalive.c
+ * @author
+ * @version
+ * @date
+ * @brief   Connection reuse test for the HTTP client against a local server
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Runs transactions against a scripted server on 127.0.0.1 over real sockets
+// and counts the connections it accepts, to check a connection is reused
+// exactly when the previous response ended cleanly, also over a long run of
+// transactions. Also posts a body larger than the packet buffer, which is only
+// possible if it is sent from the caller's buffer instead of being copied in.
+
+#include "host/atmo_host.h"
+#include "host/tcpclient_host.h"
+#include "host/http_server_host.h"
+#include <string.h>
+#include "../http/http.h"
+
+#define TEST_TIMEOUT_MS (5000)
+#define TEST_POST_BODY_LEN (3000)
+#define TEST_NUM_REUSED (1000)
+
+typedef struct
+{
+	volatile ATMO_BOOL_t done;
+	ATMO_HTTP_Status_t status;
+	unsigned int respCode;
+	char body[256];
+} TEST_Result_t;
+
+static ATMO_DriverInstanceHandle_t httpInstance;
+static uint8_t packetBuf[1024];
+static unsigned int serverPort;
+static char postBody[TEST_POST_BODY_LEN];
+
+static ATMO_BOOL_t _TEST_PostBodyIntact( const char *body, unsigned int bodyLen )
+{
+	if ( bodyLen != TEST_POST_BODY_LEN )
+	{
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < bodyLen; i++ )
+	{
+		if ( body[i] != ( char )( 'a' + ( i % 26 ) ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void _TEST_ServerHandler( const char *method, const char *path, const char *body, unsigned int bodyLen, ATMO_HOST_HTTP_SERVER_Reply_t *reply, void *arg )
+{
+	if ( strcmp( path, "/plain" ) == 0 )
+	{
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n";
+		reply->fragments[1] = "hello";
+	}
+	else if ( strcmp( path, "/trailer" ) == 0 )
+	{
+		// The trailer comes in its own packet after the last chunk
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n";
+		reply->fragments[1] = "4\r\ndefg\r\n0\r\n";
+		reply->fragments[2] = "X-Checksum: 1234\r\n\r\n";
+	}
+	else if ( strcmp( path, "/extra" ) == 0 )
+	{
+		// Bytes after the end of the response, the stream is out of step
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\nHTTP/1.1 200 OK\r\n";
+	}
+	else if ( strcmp( path, "/post" ) == 0 && strcmp( method, "POST" ) == 0 )
+	{
+		reply->fragments[0] = _TEST_PostBodyIntact( body, bodyLen ) ? "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nsame" : "HTTP/1.1 200 OK\r\nContent-Length: 7\r\n\r\ngarbled";
+	}
+	else if ( strcmp( path, "/close" ) == 0 )
+	{
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok";
+		reply->close = true;
+	}
+	else if ( strcmp( path, "/drop" ) == 0 )
+	{
+		// Keep-alive response, but the server goes away anyway
+		reply->fragments[0] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+		reply->close = true;
+	}
+	else
+	{
+		reply->fragments[0] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+	}
+}
+
+static void _TEST_ResponseCb( ATMO_DriverInstanceHandle_t instance, ATMO_HTTP_Status_t status, unsigned int respCode, const uint8_t *respData, unsigned int respDataLen, void *arg )
+{
+	TEST_Result_t *result = ( TEST_Result_t * )arg;
+	result->status = status;
+	result->respCode = respCode;
+	snprintf( result->body, sizeof( result->body ), "%.*s", ( int )respDataLen, ( respData != NULL ) ? ( const char * )respData : "" );
+	result->done = true;
+}
+
+static TEST_Result_t _TEST_Run( const char *path, const char *body, unsigned int bodyLen )
+{
+	char url[64];
+	TEST_Result_t result;
+	memset( &result, 0, sizeof( result ) );
+	snprintf( url, sizeof( url ), "http://127.0.0.1:%u%s", serverPort, path );
+
+	ATMO_HTTP_Transaction_t transaction = { url, ( body != NULL ) ? ATMO_HTTP_POST : ATMO_HTTP_GET, "text/plain", body, bodyLen, NULL, 0 };
+	ATMO_HOST_CHECK( ATMO_HTTP_PerformAsync( httpInstance, &transaction, TEST_TIMEOUT_MS, _TEST_ResponseCb, &result ) == ATMO_HTTP_Status_Success, "%s not started", path );
+	ATMO_HOST_CHECK( ATMO_HOST_RunUntil( &result.done, TEST_TIMEOUT_MS + 1000 ), "%s never completed", path );
+	ATMO_HOST_CHECK( result.status == ATMO_HTTP_Status_Success, "%s failed with %d", path, result.status );
+	return result;
+}
+
+static void _TEST_Expect( const char *path, const char *body, unsigned int numAccepted )
+{
+	TEST_Result_t result = _TEST_Run( path, NULL, 0 );
+
+	// Give anything the server sent after the response time to arrive
+	volatile ATMO_BOOL_t never = false;
+	ATMO_HOST_RunUntil( &never, 50 );
+	ATMO_HOST_CHECK( result.respCode == 200 && strcmp( result.body, body ) == 0, "%s returned %u '%s'", path, result.respCode, result.body );
+	ATMO_HOST_CHECK( ATMO_HOST_HTTP_SERVER_NumAccepted() == numAccepted, "%s: %u connections, expected %u", path, ATMO_HOST_HTTP_SERVER_NumAccepted(), numAccepted );
+}
+
+int main( int argc, char **argv )
+{
+	ATMO_DriverInstanceHandle_t tcpInstance = 0;
+
+	ATMO_Init();
+	serverPort = ATMO_HOST_HTTP_SERVER_Start( _TEST_ServerHandler, NULL );
+	ATMO_HOST_TCP_CLIENT_AddDriverInstance( &tcpInstance );
+	ATMO_HOST_CHECK( ATMO_HTTP_Init( tcpInstance, packetBuf, sizeof( packetBuf ), &httpInstance ) == ATMO_HTTP_Status_Success, "http init" );
+
+	// Content-Length responses keep the connection
+	_TEST_Expect( "/plain", "hello", 1 );
+	_TEST_Expect( "/plain", "hello", 1 );
+
+	// A chunked response only ends after its trailer, which must not be left for the next response
+	_TEST_Expect( "/trailer", "abcdefg", 1 );
+	_TEST_Expect( "/plain", "hello", 1 );
+
+	// Data past the end of a response gives up the connection
+	_TEST_Expect( "/extra", "abc", 1 );
+	_TEST_Expect( "/plain", "hello", 2 );
+
+	// So does Connection: close
+	_TEST_Expect( "/close", "ok", 2 );
+	_TEST_Expect( "/plain", "hello", 3 );
+
+	// A kept connection the server closed is replaced
+	_TEST_Expect( "/drop", "ok", 3 );
+	_TEST_Expect( "/plain", "hello", 4 );
+
+	// A long run of clean responses never opens another connection
+	for ( unsigned int i = 0; i < TEST_NUM_REUSED; i++ )
+	{
+		TEST_Result_t result = _TEST_Run( "/plain", NULL, 0 );
+		ATMO_HOST_CHECK( result.respCode == 200 && strcmp( result.body, "hello" ) == 0, "transaction %u returned %u '%s'", i, result.respCode, result.body );
+		ATMO_HOST_CHECK( ATMO_HOST_HTTP_SERVER_NumAccepted() == 4, "transaction %u: %u connections, expected 4", i, ATMO_HOST_HTTP_SERVER_NumAccepted() );
+	}
+
+	// The body goes out as its own segment from the caller's buffer, on the kept connection
+	for ( unsigned int i = 0; i < sizeof( postBody ); i++ )
+	{
+		postBody[i] = ( char )( 'a' + ( i % 26 ) );
+	}
+
+	ATMO_HOST_CHECK( sizeof( postBody ) > sizeof( packetBuf ), "post body fits in the packet buffer" );
+	TEST_Result_t result = _TEST_Run( "/post", postBody, sizeof( postBody ) );
+	ATMO_HOST_CHECK( result.respCode == 200 && strcmp( result.body, "same" ) == 0, "/post returned %u '%s'", result.respCode, result.body );
+	ATMO_HOST_CHECK( ATMO_HOST_HTTP_SERVER_NumAccepted() == 4, "/post: %u connections, expected 4", ATMO_HOST_HTTP_SERVER_NumAccepted() );
+
+	unsigned int numSegments = 0;
+	const ATMO_TCP_CLIENT_Segment_t *segments = ATMO_HOST_TCP_CLIENT_LastWrite( &numSegments );
+	ATMO_HOST_CHECK( numSegments == 2, "/post written in %u segments", numSegments );
+	ATMO_HOST_CHECK( segments[0].data == packetBuf && segments[0].dataLen < sizeof( packetBuf ), "/post headers not from the packet buffer" );
+	ATMO_HOST_CHECK( segments[1].data == ( const uint8_t * )postBody && segments[1].dataLen == sizeof( postBody ), "/post body was copied" );
+
+	// The blocking wrapper runs the same transaction from its own tick loop
+	char url[64];
+	unsigned int respCode = 0;
+	unsigned int respDataLen = 0;
+	char respData[16];
+	snprintf( url, sizeof( url ), "http://127.0.0.1:%u/plain", serverPort );
+	ATMO_HTTP_Transaction_t transaction = { url, ATMO_HTTP_GET, NULL, NULL, 0, NULL, 0 };
+	ATMO_HOST_CHECK( ATMO_HTTP_Perform( httpInstance, &transaction, &respCode, &respDataLen, TEST_TIMEOUT_MS ) == ATMO_HTTP_Status_Success, "blocking perform" );
+	ATMO_HOST_CHECK( respCode == 200 && respDataLen == 6, "blocking perform returned %u, %u bytes", respCode, respDataLen );
+	ATMO_HOST_CHECK( ATMO_HTTP_GetRespData( httpInstance, ( uint8_t * )respData, sizeof( respData ) ) == ATMO_HTTP_Status_Success && strcmp( respData, "hello" ) == 0, "blocking perform data" );
+	ATMO_HOST_CHECK( ATMO_HOST_HTTP_SERVER_NumAccepted() == 4, "blocking perform: %u connections, expected 4", ATMO_HOST_HTTP_SERVER_NumAccepted() );
+
+	ATMO_HOST_HTTP_SERVER_Stop();
+	printf( "ok: %u requests on %u connections\n", ATMO_HOST_HTTP_SERVER_NumRequests(), ATMO_HOST_HTTP_SERVER_NumAccepted() );
+	return 0;
+}
@@ -0,0 +1,372 @@
+/**
+ ******************************************************************************
+ * @file    test_sensorlog.c
+ * @author
+ * @version
+ * @date
+ * @brief   Wraparound and power loss test for the sensor log
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+// Logs a random walk on a small flash model and reads it back: whole log,
+// after wrapping around many times, random time ranges, after a reboot, and
+// after power cuts that tear the program or erase in progress. Whatever is read
+// back must be an unbroken run of what was logged, and a cut may only lose the
+// samples that were not written yet.
+
+#include "host/atmo_host.h"
+#include <string.h>
+#include "../sensorlog/sensorlog.h"
+
+#define TEST_BLOCK_SIZE (2048)
+#define TEST_NUM_BLOCKS (8)
+#define TEST_PROG_SIZE (8)
+#define TEST_SENSOR_ID (2)
+#define TEST_MAX_SAMPLES (200000)
+#define TEST_POWER_CUTS (1000)
+
+static uint8_t flash[TEST_BLOCK_SIZE * TEST_NUM_BLOCKS];
+static long opsUntilCut = -1; /**< Flash operations left before power is cut, -1 never cuts */
+static ATMO_BOOL_t powerLost = false;
+static ATMO_DriverInstanceHandle_t blockInstance;
+
+static ATMO_SENSORLOG_Sample_t logged[TEST_MAX_SAMPLES];
+static int numLogged = 0;
+static ATMO_SENSORLOG_Sample_t readBack[TEST_MAX_SAMPLES];
+static int numReadBack = 0;
+static int16_t walkX, walkY, walkZ;
+
+/**
+ * Count a flash operation
+ *
+ * @return 0 to carry on, 1 if power is cut during this operation, -1 if it is already off
+ */
+static int _TEST_FlashOp( void )
+{
+	if ( powerLost )
+	{
+		return -1;
+	}
+
+	if ( opsUntilCut > 0 && --opsUntilCut == 0 )
+	{
+		powerLost = true;
+		return 1;
+	}
+
+	return 0;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashInit( ATMO_DriverInstanceData_t *instance )
+{
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashRead( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	if ( powerLost )
+	{
+		return ATMO_BLOCK_Status_Fail;
+	}
+
+	memcpy( buffer, &flash[block * TEST_BLOCK_SIZE + offset], size );
+	return ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashProgram( ATMO_DriverInstanceData_t *instance, uint32_t block, uint32_t offset, void *buffer, uint32_t size )
+{
+	ATMO_HOST_CHECK( offset % TEST_PROG_SIZE == 0 && size % TEST_PROG_SIZE == 0 && offset + size <= TEST_BLOCK_SIZE, "bad program %u+%u", offset, size );
+
+	int cut = _TEST_FlashOp();
+
+	if ( cut < 0 )
+	{
+		return ATMO_BLOCK_Status_Fail;
+	}
+
+	// A cut program stops part way, with the byte it was on half written
+	const uint8_t *data = ( const uint8_t * )buffer;
+	uint8_t *dest = &flash[block * TEST_BLOCK_SIZE + offset];
+	uint32_t numWritten = cut ? ( uint32_t )rand() % ( size + 1 ) : size;
+
+	for ( uint32_t i = 0; i < numWritten; i++ )
+	{
+		dest[i] &= data[i];
+	}
+
+	if ( cut && numWritten < size )
+	{
+		dest[numWritten] &= data[numWritten] | ( uint8_t )rand();
+	}
+
+	return cut ? ATMO_BLOCK_Status_Fail : ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashErase( ATMO_DriverInstanceData_t *instance, uint32_t block )
+{
+	int cut = _TEST_FlashOp();
+
+	if ( cut < 0 )
+	{
+		return ATMO_BLOCK_Status_Fail;
+	}
+
+	memset( &flash[block * TEST_BLOCK_SIZE], 0xFF, cut ? ( uint32_t )rand() % ( TEST_BLOCK_SIZE + 1 ) : TEST_BLOCK_SIZE );
+	return cut ? ATMO_BLOCK_Status_Fail : ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashSync( ATMO_DriverInstanceData_t *instance )
+{
+	return powerLost ? ATMO_BLOCK_Status_Fail : ATMO_BLOCK_Status_Success;
+}
+
+static ATMO_BLOCK_Status_t _TEST_FlashGetDeviceInfo( ATMO_DriverInstanceData_t *instance, ATMO_BLOCK_DeviceInfo_t *info )
+{
+	info->blockCount = TEST_NUM_BLOCKS;
+	info->blockSize = TEST_BLOCK_SIZE;
+	info->progSize = TEST_PROG_SIZE;
+	info->readSize = 1;
+	return ATMO_BLOCK_Status_Success;
+}
+
+static const ATMO_BLOCK_DriverInstance_t testFlashDriver =
+{
+	_TEST_FlashInit,
+	_TEST_FlashRead,
+	_TEST_FlashProgram,
+	_TEST_FlashErase,
+	_TEST_FlashSync,
+	_TEST_FlashGetDeviceInfo
+};
+
+static void _TEST_Boot( void )
+{
+	ATMO_SENSORLOG_Config_t config = { blockInstance, 0, TEST_NUM_BLOCKS, TEST_SENSOR_ID, 0 };
+	ATMO_HOST_ResetUptime();
+	ATMO_HOST_CHECK( ATMO_SENSORLOG_Init( &config ) == ATMO_SENSORLOG_Status_Success, "init" );
+}
+
+static ATMO_SENSORLOG_Info_t _TEST_Info( void )
+{
+	ATMO_SENSORLOG_Info_t info;
+	ATMO_SENSORLOG_GetInfo( &info );
+	return info;
+}
+
+static void _TEST_Log( int numSamples )
+{
+	for ( int i = 0; i < numSamples && !powerLost; i++ )
+	{
+		// Irregular timing with the odd long gap, and the odd jump in value
+		ATMO_HOST_AdvanceMs( 1 + ( ( rand() % 8 == 0 ) ? rand() % 600 : rand() % 20 ) );
+		ATMO_BOOL_t jump = ( rand() % 10 ) == 0;
+		walkX += jump ? ( rand() % 2000 - 1000 ) : ( rand() % 40 - 20 );
+		walkY += rand() % 20 - 10;
+		walkZ += jump ? rand() % 300 : 0;
+
+		ATMO_HOST_CHECK( numLogged < TEST_MAX_SAMPLES, "reference full" );
+		logged[numLogged].timeMs = _TEST_Info().nowMs;
+		logged[numLogged].x = walkX;
+		logged[numLogged].y = walkY;
+		logged[numLogged].z = walkZ;
+		numLogged++;
+
+		ATMO_SENSORLOG_PushSample( TEST_SENSOR_ID, walkX, walkY, walkZ );
+
+		// Other sensors are not logged
+		ATMO_SENSORLOG_PushSample( TEST_SENSOR_ID - 1, 0, 0, 0 );
+	}
+}
+
+static void _TEST_ReadRange( uint32_t fromMs, uint32_t toMs, uint32_t chunk )
+{
+	ATMO_SENSORLOG_Cursor_t cursor;
+	uint32_t numRead = 0;
+	numReadBack = 0;
+
+	if ( ATMO_SENSORLOG_Seek( fromMs, &cursor ) != ATMO_SENSORLOG_Status_Success )
+	{
+		return;
+	}
+
+	while ( ATMO_SENSORLOG_Read( &cursor, toMs, &readBack[numReadBack], chunk, &numRead ) == ATMO_SENSORLOG_Status_Success )
+	{
+		ATMO_HOST_CHECK( numRead > 0, "read returned success without samples" );
+		numReadBack += numRead;
+	}
+}
+
+static int _TEST_FindLogged( uint32_t timeMs )
+{
+	int lo = 0, hi = numLogged - 1;
+
+	while ( lo <= hi )
+	{
+		int mid = ( lo + hi ) / 2;
+
+		if ( logged[mid].timeMs == timeMs )
+		{
+			return mid;
+		}
+
+		if ( ( int32_t )( logged[mid].timeMs - timeMs ) < 0 )
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Check what was read back is an unbroken run of what was logged
+ *
+ * @return index in the reference of the last sample read back
+ */
+static int _TEST_CheckContiguous( const char *what )
+{
+	ATMO_HOST_CHECK( numReadBack > 0, "%s: nothing read back", what );
+
+	int first = _TEST_FindLogged( readBack[0].timeMs );
+	ATMO_HOST_CHECK( first >= 0, "%s: first sample was never logged", what );
+	ATMO_HOST_CHECK( first + numReadBack <= numLogged, "%s: more samples than were logged", what );
+
+	for ( int i = 0; i < numReadBack; i++ )
+	{
+		ATMO_HOST_CHECK( memcmp( &readBack[i], &logged[first + i], sizeof( ATMO_SENSORLOG_Sample_t ) ) == 0, "%s: sample %d differs", what, i );
+	}
+
+	return first + numReadBack - 1;
+}
+
+static void _TEST_ReadAllAndCheck( const char *what, uint32_t chunk )
+{
+	_TEST_ReadRange( 0, _TEST_Info().nowMs, chunk );
+	ATMO_HOST_CHECK( _TEST_CheckContiguous( what ) == numLogged - 1, "%s: newest sample missing", what );
+}
+
+int main( int argc, char **argv )
+{
+	srand( ATMO_HOST_Seed( argc, argv ) );
+	ATMO_BLOCK_AddDriverInstance( &testFlashDriver, NULL, &blockInstance );
+	memset( flash, 0xFF, sizeof( flash ) );
+
+	// Before the log wraps
+	_TEST_Boot();
+	_TEST_Log( 300 );
+	ATMO_HOST_CHECK( ATMO_SENSORLOG_Flush() == ATMO_SENSORLOG_Status_Success, "flush" );
+	_TEST_ReadAllAndCheck( "no wrap", 7 );
+	ATMO_HOST_CHECK( numReadBack == numLogged, "no wrap: %d of %d samples", numReadBack, numLogged );
+
+	// Wrapped many times over, the oldest pages go
+	_TEST_Log( 20000 );
+	ATMO_SENSORLOG_Flush();
+	ATMO_SENSORLOG_Info_t info = _TEST_Info();
+	ATMO_HOST_CHECK( info.numPages == TEST_NUM_BLOCKS && info.pagesDropped > 0, "%u pages, %u dropped", info.numPages, info.pagesDropped );
+	_TEST_ReadAllAndCheck( "wrap", 64 );
+	ATMO_HOST_CHECK( readBack[0].timeMs == info.oldestMs, "oldest sample %u, log says %u", readBack[0].timeMs, info.oldestMs );
+	printf( "wrap: %d of %d samples kept, %.2f bytes per sample\n", numReadBack, numLogged, ( double )( TEST_NUM_BLOCKS - 1 ) * TEST_BLOCK_SIZE / numReadBack );
+
+	// Random ranges, with bounds on and next to sample times
+	int numKept = numReadBack;
+
+	for ( int i = 0; i < 300; i++ )
+	{
+		int from = numLogged - numKept + rand() % numKept;
+		int to = from + rand() % ( numLogged - from );
+		uint32_t fromMs = logged[from].timeMs - ( rand() % 2 );
+		uint32_t toMs = logged[to].timeMs + ( rand() % 2 );
+		int expected = 0, expectedFirst = -1;
+
+		for ( int k = numLogged - numKept; k < numLogged; k++ )
+		{
+			if ( ( int32_t )( logged[k].timeMs - fromMs ) >= 0 && ( int32_t )( logged[k].timeMs - toMs ) <= 0 )
+			{
+				expectedFirst = ( expectedFirst < 0 ) ? k : expectedFirst;
+				expected++;
+			}
+		}
+
+		_TEST_ReadRange( fromMs, toMs, 1 + rand() % 20 );
+		ATMO_HOST_CHECK( numReadBack == expected, "range %u-%u: %d samples, expected %d", fromMs, toMs, numReadBack, expected );
+		ATMO_HOST_CHECK( expected == 0 || memcmp( readBack, &logged[expectedFirst], sizeof( ATMO_SENSORLOG_Sample_t ) * expected ) == 0, "range %u-%u differs", fromMs, toMs );
+	}
+
+	// A reboot keeps the samples and carries the log time on
+	_TEST_Boot();
+	_TEST_ReadRange( 0, 0x7FFFFFFF, 50 );
+	ATMO_HOST_CHECK( numReadBack == numKept, "reboot: %d of %d samples", numReadBack, numKept );
+	_TEST_Log( 500 );
+	ATMO_SENSORLOG_Flush();
+	_TEST_ReadAllAndCheck( "after reboot", 50 );
+
+	// Power cuts
+	int numCuts = 0, mostLost = 0;
+
+	for ( int i = 0; i < TEST_POWER_CUTS; i++ )
+	{
+		opsUntilCut = 1 + rand() % 400;
+		powerLost = false;
+		_TEST_Log( 200 + rand() % 2000 );
+
+		ATMO_BOOL_t wasCut = powerLost;
+		opsUntilCut = -1;
+		powerLost = false;
+		_TEST_Boot();
+
+		_TEST_ReadRange( 0, _TEST_Info().nowMs, 1 + rand() % 30 );
+		int last = _TEST_CheckContiguous( "power cut" );
+		int numLost = numLogged - 1 - last;
+
+		// Without a cut only the unflushed chunk goes, a cut can take the chunk being written too
+		ATMO_HOST_CHECK( numLost <= ( wasCut ? 2 * ATMO_SENSORLOG_SAMPLES_PER_CHUNK + 1 : ATMO_SENSORLOG_SAMPLES_PER_CHUNK ), "%d samples lost", numLost );
+		numCuts += wasCut ? 1 : 0;
+		mostLost = ( numLost > mostLost ) ? numLost : mostLost;
+
+		// Forget what never made it to flash, and keep the reference from growing
+		numLogged = last + 1;
+
+		if ( numLogged > TEST_MAX_SAMPLES / 2 )
+		{
+			memmove( logged, &logged[numLogged - 30000], 30000 * sizeof( ATMO_SENSORLOG_Sample_t ) );
+			numLogged = 30000;
+		}
+
+		_TEST_Log( 50 );
+		ATMO_SENSORLOG_Flush();
+		_TEST_ReadAllAndCheck( "after power cut", 9 );
+	}
+
+	printf( "ok: %d power cuts, at most %d samples lost (%d per chunk)\n", numCuts, mostLost, ( int )ATMO_SENSORLOG_SAMPLES_PER_CHUNK );
+	return 0;
+}
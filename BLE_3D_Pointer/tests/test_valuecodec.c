@@ -0,0 +1,215 @@
+/**
+ ******************************************************************************
+ * @file    test_valuecodec.c
+ * @author
+ * @version
+ * @date
+ * @brief   Round trip fuzz test for the binary value codec
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Atmosphere IoT Corp. nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#include "host/atmo_host.h"
+#include <string.h>
+#include "../atmo/atmo_valuecodec.h"
+
+#define TEST_ITERATIONS (200000)
+
+static ATMO_BOOL_t _TEST_ValuesEqual( ATMO_Value_t *a, ATMO_Value_t *b )
+{
+	if ( a->type != b->type )
+	{
+		return false;
+	}
+
+	switch ( a->type )
+	{
+		case ATMO_DATATYPE_VOID:
+			return true;
+
+		case ATMO_DATATYPE_STRING:
+			return strcmp( ( char * )a->data, ( char * )b->data ) == 0;
+
+		default:
+			return a->size == b->size && memcmp( a->data, b->data, a->size ) == 0;
+	}
+}
+
+static void _TEST_RandomValue( ATMO_Value_t *value )
+{
+	switch ( rand() % 11 )
+	{
+		case 0:
+			ATMO_CreateValueVoid( value );
+			break;
+
+		case 1:
+			ATMO_CreateValueChar( value, ( char )rand() );
+			break;
+
+		case 2:
+			ATMO_CreateValueBool( value, rand() & 1 );
+			break;
+
+		case 3:
+			ATMO_CreateValueInt( value, rand() - RAND_MAX / 2 );
+			break;
+
+		case 4:
+			ATMO_CreateValueUnsignedInt( value, ( unsigned int )rand() * 7 );
+			break;
+
+		case 5:
+			ATMO_CreateValueFloat( value, rand() / 3.0f );
+			break;
+
+		case 6:
+			ATMO_CreateValueDouble( value, rand() / 7.0 );
+			break;
+
+		case 7:
+		{
+			char str[31];
+			int len = rand() % 30;
+
+			for ( int i = 0; i < len; i++ )
+			{
+				str[i] = 'a' + rand() % 26;
+			}
+
+			str[len] = '\0';
+			ATMO_CreateValueString( value, str );
+			break;
+		}
+
+		case 8:
+		{
+			uint8_t data[32];
+			int len = rand() % 32;
+
+			for ( int i = 0; i < len; i++ )
+			{
+				data[i] = ( uint8_t )rand();
+			}
+
+			ATMO_CreateValueBinary( value, data, len );
+			break;
+		}
+
+		case 9:
+		{
+			ATMO_3dFloatVector_t vector = { rand() / 3.0f, -rand() / 5.0f, 1.5f };
+			ATMO_CreateValue3dVectorFloat( value, &vector );
+			break;
+		}
+
+		default:
+		{
+			ATMO_3dDoubleVector_t vector = { rand() / 3.0, -rand() / 5.0, 1.5 };
+			ATMO_CreateValue3dVectorDouble( value, &vector );
+			break;
+		}
+	}
+}
+
+static void _TEST_RoundTrip( ATMO_Value_t *value )
+{
+	uint8_t buf[512];
+	unsigned int needed = 0, encodedLen = 0, decodedLen = 0;
+	ATMO_Value_t decoded;
+
+	ATMO_HOST_CHECK( ATMO_VALUECODEC_Encode( value, NULL, 0, &needed ) == ATMO_Status_Success, "size query" );
+	ATMO_HOST_CHECK( ATMO_VALUECODEC_Encode( value, buf, sizeof( buf ), &encodedLen ) == ATMO_Status_Success && encodedLen == needed,
+	                 "encoded %u bytes, size query said %u", encodedLen, needed );
+
+	if ( encodedLen > 1 )
+	{
+		ATMO_HOST_CHECK( ATMO_VALUECODEC_Encode( value, buf, encodedLen - 1, &decodedLen ) == ATMO_Status_OutOfMemory, "short buffer accepted" );
+		ATMO_VALUECODEC_Encode( value, buf, sizeof( buf ), &encodedLen );
+	}
+
+	ATMO_InitValue( &decoded );
+	ATMO_HOST_CHECK( ATMO_VALUECODEC_Decode( &decoded, buf, encodedLen, &decodedLen ) == ATMO_Status_Success && decodedLen == encodedLen, "decode" );
+	ATMO_HOST_CHECK( _TEST_ValuesEqual( value, &decoded ), "type %d does not round trip", value->type );
+	ATMO_FreeValue( &decoded );
+
+	// Truncated input must fail or stay inside what it was given
+	for ( unsigned int len = 0; len < encodedLen; len++ )
+	{
+		ATMO_InitValue( &decoded );
+
+		if ( ATMO_VALUECODEC_Decode( &decoded, buf, len, &decodedLen ) == ATMO_Status_Success )
+		{
+			ATMO_HOST_CHECK( decodedLen <= len, "read past a truncated buffer" );
+		}
+
+		ATMO_FreeValue( &decoded );
+	}
+
+	// So must garbage, the sanitizers catch anything that reads out of bounds
+	for ( int i = 0; i < 8; i++ )
+	{
+		buf[rand() % encodedLen] = ( uint8_t )rand();
+	}
+
+	ATMO_InitValue( &decoded );
+
+	if ( ATMO_VALUECODEC_Decode( &decoded, buf, encodedLen, &decodedLen ) == ATMO_Status_Success )
+	{
+		ATMO_HOST_CHECK( decodedLen <= encodedLen, "read past a corrupted buffer" );
+	}
+
+	ATMO_FreeValue( &decoded );
+}
+
+int main( int argc, char **argv )
+{
+	srand( ATMO_HOST_Seed( argc, argv ) );
+
+	for ( int i = 0; i < TEST_ITERATIONS; i++ )
+	{
+		ATMO_Value_t value;
+		ATMO_InitValue( &value );
+		_TEST_RandomValue( &value );
+		_TEST_RoundTrip( &value );
+		ATMO_FreeValue( &value );
+	}
+
+	// Lists are not part of the format
+	{
+		const uint8_t list[] = { ATMO_DATATYPE_LIST, 1, ATMO_DATATYPE_BOOL, 1 };
+		ATMO_Value_t decoded;
+		unsigned int decodedLen = 0;
+		ATMO_InitValue( &decoded );
+		ATMO_HOST_CHECK( ATMO_VALUECODEC_Decode( &decoded, list, sizeof( list ), &decodedLen ) == ATMO_Status_InvalidInput, "list accepted" );
+		ATMO_FreeValue( &decoded );
+	}
+
+	printf( "ok\n" );
+	return 0;
+}
@@ -0,0 +1,312 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace DobotBLEDemo.Tests
+{
+    // Frames are built by hand in the layout described in ble_stream.h. The
+    // delta coded vectors were produced with the device's atmo_samplecodec.c.
+    public static class SensorStreamParserTests
+    {
+        private static int failures = 0;
+
+        public static int Main()
+        {
+            Run(nameof(RawFrame), RawFrame);
+            Run(nameof(SequenceWrap), SequenceWrap);
+            Run(nameof(GapCounting), GapCounting);
+            Run(nameof(DuplicateFrame), DuplicateFrame);
+            Run(nameof(TruncatedFrames), TruncatedFrames);
+            Run(nameof(LogFrame), LogFrame);
+            Run(nameof(LogSequenceSeparate), LogSequenceSeparate);
+            Run(nameof(DeltaFrame), DeltaFrame);
+            Run(nameof(DeltaLogFrame), DeltaLogFrame);
+            Run(nameof(TruncatedDeltaFrames), TruncatedDeltaFrames);
+            Run(nameof(MalformedDeltaFrames), MalformedDeltaFrames);
+
+            Console.WriteLine(failures == 0 ? "All tests passed" : failures + " failure(s)");
+            return failures == 0 ? 0 : 1;
+        }
+
+        private static void Run(string name, Action test)
+        {
+            try
+            {
+                test();
+                Console.WriteLine("PASS " + name);
+            }
+            catch (Exception e)
+            {
+                failures++;
+                Console.WriteLine("FAIL " + name + ": " + e.Message);
+            }
+        }
+
+        private static void Check(bool condition, string message)
+        {
+            if (!condition)
+            {
+                throw new Exception(message);
+            }
+        }
+
+        private static void CheckEqual<T>(T expected, T actual, string what)
+        {
+            if (!EqualityComparer<T>.Default.Equals(expected, actual))
+            {
+                throw new Exception(what + ": expected " + expected + ", got " + actual);
+            }
+        }
+
+        private static byte[] Frame(ushort sequence, byte sensorId, uint timestampMs, params byte[] samples)
+        {
+            return Frame(sequence, sensorId, 0, timestampMs, samples);
+        }
+
+        private static byte[] Frame(ushort sequence, byte sensorId, byte count, uint timestampMs, byte[] samples)
+        {
+            var frame = new List<byte>();
+            frame.AddRange(BitConverter.GetBytes(sequence));
+            frame.Add(sensorId);
+            frame.Add(count);
+            frame.AddRange(BitConverter.GetBytes(timestampMs));
+            frame.AddRange(samples);
+            return frame.ToArray();
+        }
+
+        private static byte[] RawSamples(params short[] values)
+        {
+            var bytes = new List<byte>();
+            foreach (short value in values)
+            {
+                bytes.AddRange(BitConverter.GetBytes(value));
+            }
+            return bytes.ToArray();
+        }
+
+        private static byte[] LiveFrame(ushort sequence)
+        {
+            return Frame(sequence, 1, 1, 1000, RawSamples(1, 2, 3));
+        }
+
+        private static void RawFrame()
+        {
+            var parser = new SensorStreamParser();
+            var frame = parser.Parse(Frame(0x1234, 2, 2, 5000, RawSamples(1, -2, 3, short.MinValue, short.MaxValue, 0)));
+
+            Check(frame != null, "frame rejected");
+            CheckEqual((ushort)0x1234, frame.Sequence, "sequence");
+            CheckEqual((byte)2, frame.SensorId, "sensor ID");
+            Check(!frame.IsLog && !frame.IsDelta, "flags");
+            CheckEqual(5000u, frame.TimestampMs, "timestamp");
+            CheckEqual(2, frame.Samples.Count, "sample count");
+            CheckEqual((short)-2, frame.Samples[0].Y, "sample 0 y");
+            CheckEqual(short.MinValue, frame.Samples[1].X, "sample 1 x");
+            CheckEqual(short.MaxValue, frame.Samples[1].Y, "sample 1 y");
+            CheckEqual(5000u, frame.Samples[1].TimestampMs, "sample 1 timestamp");
+            CheckEqual(1UL, parser.FramesReceived, "received");
+        }
+
+        private static void SequenceWrap()
+        {
+            var parser = new SensorStreamParser();
+            foreach (ushort sequence in new ushort[] { 0xFFFE, 0xFFFF, 0x0000, 0x0001 })
+            {
+                Check(parser.Parse(LiveFrame(sequence)) != null, "frame rejected");
+            }
+
+            CheckEqual(4UL, parser.FramesReceived, "received");
+            CheckEqual(0UL, parser.FramesLost, "lost across the wrap");
+
+            // Frames 0x0002 and 0x0003 missing, then a gap across the next wrap
+            parser.Parse(LiveFrame(0x0004));
+            CheckEqual(2UL, parser.FramesLost, "lost after wrap");
+
+            parser.Reset();
+            parser.Parse(LiveFrame(0xFFFD));
+            parser.Parse(LiveFrame(0x0001));
+            CheckEqual(3UL, parser.FramesLost, "gap spanning the wrap");
+        }
+
+        private static void GapCounting()
+        {
+            var parser = new SensorStreamParser();
+            parser.Parse(LiveFrame(10));
+            parser.Parse(LiveFrame(11));
+            parser.Parse(LiveFrame(14));
+
+            CheckEqual(3UL, parser.FramesReceived, "received");
+            CheckEqual(2UL, parser.FramesLost, "lost");
+            CheckEqual(0.4, parser.LossRatio, "loss ratio");
+
+            parser.Reset();
+            CheckEqual(0UL, parser.FramesReceived, "received after reset");
+            CheckEqual(0.0, parser.LossRatio, "loss ratio after reset");
+
+            // The first frame after a reset never counts as a gap
+            parser.Parse(LiveFrame(500));
+            CheckEqual(0UL, parser.FramesLost, "lost after reset");
+        }
+
+        private static void DuplicateFrame()
+        {
+            var parser = new SensorStreamParser();
+            parser.Parse(LiveFrame(7));
+            parser.Parse(LiveFrame(7));
+            parser.Parse(LiveFrame(6));
+            parser.Parse(LiveFrame(8));
+
+            CheckEqual(0UL, parser.FramesLost, "late and duplicate frames are no loss");
+        }
+
+        private static void TruncatedFrames()
+        {
+            var parser = new SensorStreamParser();
+            byte[] full = Frame(1, 0, 2, 0, RawSamples(1, 2, 3, 4, 5, 6));
+
+            Check(parser.Parse(null) == null, "null accepted");
+            for (int length = 0; length < full.Length; length++)
+            {
+                byte[] truncated = new byte[length];
+                Array.Copy(full, truncated, length);
+                Check(parser.Parse(truncated) == null, "truncated to " + length + " bytes accepted");
+            }
+
+            CheckEqual(0UL, parser.FramesReceived, "truncated frames counted");
+            Check(parser.Parse(full) != null, "full frame rejected");
+
+            // An empty frame is still a valid frame
+            Check(parser.Parse(Frame(2, 0, 0, 0, new byte[0])) != null, "empty frame rejected");
+            CheckEqual(2UL, parser.FramesReceived, "received");
+        }
+
+        private static void LogFrame()
+        {
+            var parser = new SensorStreamParser();
+            byte[] samples = new byte[16];
+            Array.Copy(BitConverter.GetBytes((ushort)0), 0, samples, 0, 2);
+            Array.Copy(RawSamples(1, 2, 3), 0, samples, 2, 6);
+            Array.Copy(BitConverter.GetBytes((ushort)65535), 0, samples, 8, 2);
+            Array.Copy(RawSamples(-4, -5, -6), 0, samples, 10, 6);
+
+            var frame = parser.Parse(Frame(0, 0x83, 2, 100000, samples));
+
+            Check(frame != null, "frame rejected");
+            Check(frame.IsLog && !frame.IsDelta, "flags");
+            CheckEqual((byte)3, frame.SensorId, "sensor ID");
+            CheckEqual(100000u, frame.Samples[0].TimestampMs, "sample 0 timestamp");
+            CheckEqual((short)3, frame.Samples[0].Z, "sample 0 z");
+            CheckEqual(165535u, frame.Samples[1].TimestampMs, "sample 1 timestamp");
+            CheckEqual((short)-4, frame.Samples[1].X, "sample 1 x");
+
+            // Log samples are 8 bytes, a log frame sized for 6 byte samples is truncated
+            Check(parser.Parse(Frame(1, 0x83, 2, 0, new byte[12])) == null, "short log frame accepted");
+        }
+
+        private static void LogSequenceSeparate()
+        {
+            var parser = new SensorStreamParser();
+            byte[] logSample = new byte[8];
+
+            parser.Parse(LiveFrame(100));
+            parser.Parse(Frame(0, 0x80, 1, 0, logSample));
+            parser.Parse(Frame(1, 0x80, 1, 0, logSample));
+            parser.Parse(LiveFrame(101));
+            parser.Parse(Frame(3, 0x80, 1, 0, logSample));
+
+            CheckEqual(2UL, parser.FramesReceived, "live received");
+            CheckEqual(0UL, parser.FramesLost, "live loss disturbed by log frames");
+            CheckEqual(3UL, parser.LogFramesReceived, "log received");
+            CheckEqual(1UL, parser.LogFramesLost, "log lost");
+
+            // A new read starts over at 0
+            parser.Parse(Frame(0, 0x80, 1, 0, logSample));
+            CheckEqual(1UL, parser.LogFramesLost, "log lost after restart");
+        }
+
+        // Samples (1000, -32768, 32767, 5), (1010, 32767, -32768, -5), (1300, 0, 1, -1)
+        private static readonly byte[] DeltaSamples =
+        {
+            0, 255, 255, 3, 254, 255, 3, 10, 10, 254, 255, 7, 253, 255, 7, 19, 162, 2, 253, 255, 3, 130, 128, 4, 8
+        };
+
+        private static void CheckDeltaSamples(SensorStreamFrame frame)
+        {
+            CheckEqual(3, frame.Samples.Count, "sample count");
+            CheckEqual(1000u, frame.Samples[0].TimestampMs, "sample 0 timestamp");
+            CheckEqual(short.MinValue, frame.Samples[0].X, "sample 0 x");
+            CheckEqual(short.MaxValue, frame.Samples[0].Y, "sample 0 y");
+            CheckEqual((short)5, frame.Samples[0].Z, "sample 0 z");
+            CheckEqual(1010u, frame.Samples[1].TimestampMs, "sample 1 timestamp");
+            CheckEqual(short.MaxValue, frame.Samples[1].X, "sample 1 x");
+            CheckEqual(short.MinValue, frame.Samples[1].Y, "sample 1 y");
+            CheckEqual((short)-5, frame.Samples[1].Z, "sample 1 z");
+            CheckEqual(1300u, frame.Samples[2].TimestampMs, "sample 2 timestamp");
+            CheckEqual((short)0, frame.Samples[2].X, "sample 2 x");
+            CheckEqual((short)1, frame.Samples[2].Y, "sample 2 y");
+            CheckEqual((short)-1, frame.Samples[2].Z, "sample 2 z");
+        }
+
+        private static void DeltaFrame()
+        {
+            var parser = new SensorStreamParser();
+            var frame = parser.Parse(Frame(0x1234, 0x42, 3, 1000, DeltaSamples));
+
+            Check(frame != null, "frame rejected");
+            Check(frame.IsDelta && !frame.IsLog, "flags");
+            CheckEqual((byte)2, frame.SensorId, "sensor ID");
+            CheckDeltaSamples(frame);
+
+            parser.Parse(Frame(0x1236, 0x42, 3, 1000, DeltaSamples));
+            CheckEqual(2UL, parser.FramesReceived, "received");
+            CheckEqual(1UL, parser.FramesLost, "lost");
+        }
+
+        private static void DeltaLogFrame()
+        {
+            var parser = new SensorStreamParser();
+            var frame = parser.Parse(Frame(0, 0xC2, 3, 1000, DeltaSamples));
+
+            Check(frame != null, "frame rejected");
+            Check(frame.IsDelta && frame.IsLog, "flags");
+            CheckDeltaSamples(frame);
+            CheckEqual(1UL, parser.LogFramesReceived, "log received");
+            CheckEqual(0UL, parser.FramesReceived, "live received");
+        }
+
+        private static void TruncatedDeltaFrames()
+        {
+            var parser = new SensorStreamParser();
+            byte[] full = Frame(1, 0x42, 3, 1000, DeltaSamples);
+
+            for (int length = 0; length < full.Length; length++)
+            {
+                byte[] truncated = new byte[length];
+                Array.Copy(full, truncated, length);
+                Check(parser.Parse(truncated) == null, "truncated to " + length + " bytes accepted");
+            }
+
+            CheckEqual(0UL, parser.FramesReceived, "truncated frames counted");
+        }
+
+        private static void MalformedDeltaFrames()
+        {
+            var parser = new SensorStreamParser();
+
+            // Axis difference wider than 17 bits
+            Check(parser.Parse(Frame(1, 0x40, 1, 0, new byte[] { 0, 0x80, 0x80, 0x08, 0, 0 })) == null, "wide axis difference accepted");
+
+            // Time difference with more than 32 bits
+            Check(parser.Parse(Frame(2, 0x40, 1, 0, new byte[] { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F, 0, 0, 0 })) == null, "over-long varint accepted");
+
+            // Varint longer than 5 bytes
+            Check(parser.Parse(Frame(3, 0x40, 1, 0, new byte[] { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0, 0, 0 })) == null, "6 byte varint accepted");
+
+            // Time difference using all 32 bits wraps like on the device
+            var frame = parser.Parse(Frame(4, 0x40, 1, 10, new byte[] { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0, 0, 0 }));
+            Check(frame != null, "32 bit time difference rejected");
+            CheckEqual(9u, frame.Samples[0].TimestampMs, "wrapped timestamp");
+
+            CheckEqual(1UL, parser.FramesReceived, "malformed frames counted");
+        }
+    }
+}
@@ -0,0 +1,230 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace DobotBLEDemo
+{
+    public struct SensorSample
+    {
+        // Device time of the sample, only carried by log and delta coded
+        // frames. Raw live frames set it to the frame timestamp.
+        public uint TimestampMs;
+        public short X;
+        public short Y;
+        public short Z;
+    }
+
+    public class SensorStreamFrame
+    {
+        public ushort Sequence;
+        public byte SensorId;
+        // Replayed from the device's sensor log rather than sampled live
+        public bool IsLog;
+        // Samples were delta coded (Set Encoding 1)
+        public bool IsDelta;
+        public uint TimestampMs;
+        public List<SensorSample> Samples = new List<SensorSample>();
+    }
+
+    // Parses notifications of the device's sensor streaming service and keeps
+    // track of frame loss using the frame sequence number. Live frames and log
+    // frames are numbered separately, log reads restart at sequence 0.
+    public class SensorStreamParser
+    {
+        public const int HeaderLength = 8;
+        public const int SampleLength = 6;
+        public const int LogSampleLength = 8;
+        public const byte LogFrameFlag = 0x80;
+        public const byte DeltaFrameFlag = 0x40;
+        public const byte SensorIdMask = 0x3F;
+
+        private bool haveSequence = false;
+        private ushort expectedSequence = 0;
+        private bool haveLogSequence = false;
+        private ushort expectedLogSequence = 0;
+
+        public ulong FramesReceived { get; private set; }
+        public ulong FramesLost { get; private set; }
+        public ulong LogFramesReceived { get; private set; }
+        public ulong LogFramesLost { get; private set; }
+
+        public double LossRatio
+        {
+            get
+            {
+                ulong total = FramesReceived + FramesLost;
+                return total == 0 ? 0.0 : (double)FramesLost / total;
+            }
+        }
+
+        public void Reset()
+        {
+            haveSequence = false;
+            expectedSequence = 0;
+            FramesReceived = 0;
+            FramesLost = 0;
+            haveLogSequence = false;
+            expectedLogSequence = 0;
+            LogFramesReceived = 0;
+            LogFramesLost = 0;
+        }
+
+        public SensorStreamFrame Parse(byte[] data)
+        {
+            if (data == null || data.Length < HeaderLength)
+            {
+                return null;
+            }
+
+            SensorStreamFrame frame = new SensorStreamFrame();
+            frame.Sequence = BitConverter.ToUInt16(data, 0);
+            frame.SensorId = (byte)(data[2] & SensorIdMask);
+            frame.IsLog = (data[2] & LogFrameFlag) != 0;
+            frame.IsDelta = (data[2] & DeltaFrameFlag) != 0;
+            frame.TimestampMs = BitConverter.ToUInt32(data, 4);
+
+            int count = data[3];
+            bool valid = frame.IsDelta ? DecodeDeltaSamples(data, count, frame) : DecodeRawSamples(data, count, frame);
+            if (!valid)
+            {
+                return null;
+            }
+
+            if (frame.IsLog)
+            {
+                // A log read starts over at 0
+                if (frame.Sequence == 0)
+                {
+                    haveLogSequence = false;
+                }
+
+                LogFramesLost += Track(frame.Sequence, ref haveLogSequence, ref expectedLogSequence);
+                LogFramesReceived++;
+            }
+            else
+            {
+                FramesLost += Track(frame.Sequence, ref haveSequence, ref expectedSequence);
+                FramesReceived++;
+            }
+
+            return frame;
+        }
+
+        private static bool DecodeRawSamples(byte[] data, int count, SensorStreamFrame frame)
+        {
+            int sampleLength = frame.IsLog ? LogSampleLength : SampleLength;
+            if (data.Length < HeaderLength + count * sampleLength)
+            {
+                return false;
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                int offset = HeaderLength + i * sampleLength;
+                SensorSample sample;
+                sample.TimestampMs = frame.TimestampMs;
+                if (frame.IsLog)
+                {
+                    sample.TimestampMs += BitConverter.ToUInt16(data, offset);
+                    offset += 2;
+                }
+                sample.X = BitConverter.ToInt16(data, offset);
+                sample.Y = BitConverter.ToInt16(data, offset + 2);
+                sample.Z = BitConverter.ToInt16(data, offset + 4);
+                frame.Samples.Add(sample);
+            }
+
+            return true;
+        }
+
+        // Same coding as ATMO_SAMPLECODEC_Decode on the device: per sample a
+        // varint time difference and zigzag varint x, y, z differences, the
+        // first sample against the frame timestamp and zero.
+        private static bool DecodeDeltaSamples(byte[] data, int count, SensorStreamFrame frame)
+        {
+            int offset = HeaderLength;
+            SensorSample prev = new SensorSample();
+            prev.TimestampMs = frame.TimestampMs;
+
+            for (int i = 0; i < count; i++)
+            {
+                uint[] fields = new uint[4];
+                for (int j = 0; j < fields.Length; j++)
+                {
+                    int fieldLength = DecodeVarint(data, offset, out fields[j]);
+
+                    // Axis differences are 17 bits once zigzag coded
+                    if (fieldLength == 0 || (j > 0 && fields[j] > 0x1FFFF))
+                    {
+                        return false;
+                    }
+
+                    offset += fieldLength;
+                }
+
+                SensorSample sample;
+                sample.TimestampMs = unchecked(prev.TimestampMs + fields[0]);
+                sample.X = unchecked((short)(prev.X + UnZigZag(fields[1])));
+                sample.Y = unchecked((short)(prev.Y + UnZigZag(fields[2])));
+                sample.Z = unchecked((short)(prev.Z + UnZigZag(fields[3])));
+                frame.Samples.Add(sample);
+                prev = sample;
+            }
+
+            return true;
+        }
+
+        private static int DecodeVarint(byte[] data, int offset, out uint value)
+        {
+            const int MaxVarintLength = 5;
+            uint result = 0;
+            value = 0;
+
+            for (int i = 0; offset + i < data.Length && i < MaxVarintLength; i++)
+            {
+                byte b = data[offset + i];
+                result |= (uint)(b & 0x7F) << (7 * i);
+
+                if ((b & 0x80) == 0)
+                {
+                    // The last group of a 32 bit value only has 4 bits
+                    if (i == MaxVarintLength - 1 && b > 0x0F)
+                    {
+                        return 0;
+                    }
+
+                    value = result;
+                    return i + 1;
+                }
+            }
+
+            return 0;
+        }
+
+        private static int UnZigZag(uint value)
+        {
+            return (int)(value >> 1) ^ -(int)(value & 1);
+        }
+
+        // Returns the number of frames skipped before this one
+        private static ulong Track(ushort sequence, ref bool haveSequence, ref ushort expected)
+        {
+            if (!haveSequence)
+            {
+                haveSequence = true;
+                expected = (ushort)(sequence + 1);
+                return 0;
+            }
+
+            // Sequence numbers wrap at 16 bits, anything behind is a duplicate or
+            // reordered frame that neither counts nor moves the expectation back
+            ushort gap = (ushort)(sequence - expected);
+            if (gap >= 0x8000)
+            {
+                return 0;
+            }
+
+            expected = (ushort)(sequence + 1);
+            return gap;
+        }
+    }
+}